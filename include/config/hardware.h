@@ -44,11 +44,16 @@
 #define WATCHDOG_TIMEOUT_S 30
 
 // ========== TASK STACK SIZES ==========
-#define TASK_STACK_SIZE_CAN_RX 4096
-#define TASK_STACK_SIZE_CHARGER_COMM 4096
+// Bytes; TASK_PROFILER reports each task's high water mark against these
+#define TASK_STACK_SIZE_CAN_RX 6144
+#define TASK_STACK_SIZE_CAN_TX 4096
+#define TASK_STACK_SIZE_CAN_ALERT 3072
+#define TASK_STACK_SIZE_CAN_DISPATCH 4096
+#define TASK_STACK_SIZE_CHARGER_COMM 6144
 #define TASK_STACK_SIZE_UI 4096
-#define TASK_STACK_SIZE_OCPP 8192
+#define TASK_STACK_SIZE_OCPP 10240 // WebSocket + TLS
 #define TASK_STACK_SIZE_WATCHDOG 2048
+#define TASK_STACK_SIZE_LOG 5120 // snprintf of floats + one line buffer (3.7 KB peak on the native build)
 
 // ========== TASK PRIORITIES ==========
 #define TASK_PRIORITY_WATCHDOG 6
@@ -56,3 +61,4 @@
 #define TASK_PRIORITY_CHARGER_COMM 4
 #define TASK_PRIORITY_OCPP 3
 #define TASK_PRIORITY_UI 2
+#define TASK_PRIORITY_LOG 1 // deferred Serial lines: only idle time blocks on the UART
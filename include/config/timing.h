@@ -12,19 +12,68 @@
 #define CHARGER_RESPONSE_TIMEOUT_MS 3000
 #define HEARTBEAT_INTERVAL_MS 100
 #define SOC_REQUEST_INTERVAL_MS 2000
-#define GROUP_REQUEST_INTERVAL_MS 500
+
+// ========== CAN SCHEDULING ==========
+#define CHARGER_TX_TICK_MS 50            // Periodic TX timer period
+#define CAN_DISPATCH_IDLE_TIMEOUT_MS 100 // Dispatcher safety wake-up if no RX notification
+#define CHARGER_POLL_BUS_BUDGET_PCT 5    // CAN1 bit time the polled requests + responses may use
+#define CHARGER_POLL_BURST 4             // Token bucket depth, in request/response pairs
+#define CHARGER_POLL_MAX_PER_TICK 4      // Polled requests per TX tick at most
+#define CHARGER_POLL_STATS_WINDOW_MS 5000
+#define CAN_STATS_WINDOW_MS 1000         // Bus load averaging window
+#define CAN2_EFLG_POLL_MS 100            // MCP2515 error flag check when no overrun is suspected
+#define CAN2_REINIT_AFTER_BUSOFFS 3      // Bus-offs within the window before a full reconfiguration
+#define CAN2_BUSOFF_WINDOW_MS 5000
+#define CAN1_TX_CONTROLLER_QUEUE 1       // TWAI driver TX queue; the CAN_TX lanes hold the backlog
+#define CAN1_TX_RETRY_MS 1               // Controller queue full: retry after the frame on the wire
+#define CAN1_TX_DOWN_RETRY_MS 10         // Controller stopped / bus-off
+#define CAN1_TX_IDLE_TIMEOUT_MS 100      // TX task safety wake-up if no enqueue notification
+#define CAN1_ALERT_POLL_MS 100           // Alert task also reads the controller state this often
+#define CAN1_BUSOFF_BACKOFF_MIN_MS 10    // Wait before recovering a repeat bus-off, doubled each time
+#define CAN1_BUSOFF_BACKOFF_MAX_MS 1000
+#define CAN1_BUSOFF_STABLE_MS 5000       // Running this long after a recovery resets the backoff
 
 // ========== ENERGY CALCULATION ==========
 #define ENERGY_CALC_INTERVAL_MS 1000
+#define ENERGY_MAX_GAP_MS 1000 // Terminal power frames further apart are not integrated
+
+// ========== SIGNAL HISTORY ==========
+// Per tier: bucket length and ring size (buckets x period = span kept)
+#define HISTORY_TIER0_PERIOD_S 1
+#define HISTORY_TIER0_BUCKETS 600 // 10 min
+#define HISTORY_TIER1_PERIOD_S 10
+#define HISTORY_TIER1_BUCKETS 720 // 2 h
+#define HISTORY_TIER2_PERIOD_S 120
+#define HISTORY_TIER2_BUCKETS 720 // 24 h
+#define HISTORY_MAX_BYTES 56000   // static RAM the history may use (checked at compile time)
 
 // ========== HEALTH MONITORING ==========
 #define HEALTH_CHECK_INTERVAL_MS 10000
+#define TASK_PROFILER_SAMPLE_MS 5000 // run time counters sampled this often (short CPU window)
+#define TASK_PROFILER_HISTORY 12     // samples kept: long CPU window = 60 s
+#define DLOG_DRAIN_MS 20             // LOG task prints the queued lines this often
 
 // ========== OCPP CONFIGURATION ==========
 #define OCPP_METER_VALUE_INTERVAL_S 10
 #define OCPP_HEARTBEAT_INTERVAL_S 60
 #define OCPP_RECONNECT_INTERVAL_MS 5000
 #define OCPP_MAX_RECONNECT_ATTEMPTS 10
+#define OCPP_BUS_STATS_INTERVAL_S 900 // CanBusStats DataTransfer period (also sent on faults)
+#define OCPP_DIAGNOSTICS_INTERVAL_S 900 // Diagnostics DataTransfer period (task CPU / stack)
+#define OCPP_TICK_ACTIVE_MS 10   // mocpp_loop() period while booting, in a transaction or draining
+#define OCPP_TICK_IDLE_MS 200    // idle charger: incoming CALLs wait at most this long in the socket
+#define OCPP_TICK_HOLD_MS 2000   // stay at the active tick this long after an event / active pass
+#define OCPP_EVENT_QUEUE_LEN 16
+#define OCPP_VEHICLE_INFO_SLOTS 2 // VehicleInfo batches handed to the OCPP task, not yet sent
+#define OCPP_OUTBOX_DRAIN_INTERVAL_MS 1000 // Queued DataTransfers replayed at most this often after reconnect
+#define OCPP_OUTBOX_ACK_TIMEOUT_MS 60000   // No CALLRESULT: resend (longer than MicroOcpp's request timeout)
+#define OCPP_OUTBOX_MAX_ATTEMPTS 5         // Then the record is dropped (e.g. the CSMS answers CALLERROR)
+
+// VehicleInfo while the EV waits in Preparing: first sample sent at once,
+// later samples batched into one VehicleTelemetry frame
+#define VEHICLE_INFO_FIRST_MS 3000
+#define VEHICLE_INFO_SAMPLE_MS 5000
+#define VEHICLE_INFO_BATCH_SAMPLES 4 // samples per DataTransfer (20 s at 5 s sampling)
 
 // ========== FEATURE FLAGS ==========
 #define ENABLE_OTA_UPDATES 1
@@ -32,3 +81,18 @@
 #define ENABLE_DIAGNOSTICS 1
 #define ENABLE_WATCHDOG 1
 #define ENABLE_CRASH_RECOVERY 1
+
+// TWAI hardware + software acceptance filter on CAN1 (0 = pass every frame, e.g. for bus captures)
+#ifndef CAN1_ACCEPTANCE_FILTER
+#define CAN1_ACCEPTANCE_FILTER 1
+#endif
+
+// Copy raw CAN payloads into the lastXxxData buffers used by the console hex views
+#ifndef CAN_DECODE_CAPTURE_RAW
+#define CAN_DECODE_CAPTURE_RAW 1
+#endif
+
+// Scope timers on the hot paths (core/perf_trace.h); 0 compiles them out
+#ifndef PERF_TRACE_ENABLED
+#define PERF_TRACE_ENABLED 1
+#endif
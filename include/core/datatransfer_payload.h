@@ -0,0 +1,103 @@
+#pragma once
+
+/**
+ * @file datatransfer_payload.h
+ * @brief Static arena holding the "data" text of the custom DataTransfer messages
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * All message types share one compile-time sized arena of DT_ARENA_BYTES,
+ * enough for the largest message. stage*() writes the data text with
+ * JsonWriter (or base64 for VehicleTelemetry) after the newest staged text
+ * and returns a ticket. The OCPP payload builder later asks for the text by
+ * ticket and links it into the DataTransfer document without copying.
+ *
+ * A text queued in MicroOcpp is held (hold()) until its CALLRESULT
+ * (release()). When staging needs the space of a text still held, that
+ * text is appended to the flash outbox first: its request then finds no
+ * text and is dropped, and the outbox replays it, so a burst queued behind
+ * slow requests is delayed, never lost. A text that was sent but not yet
+ * answered may then arrive twice (at-least-once, as the outbox).
+ *
+ * CanBusStats and Diagnostics (task CPU / stack, see task_profiler.h) are
+ * rendered when staged too, so they report the moment of the event (e.g.
+ * the bus at "SessionEnd"), not the time the request happens to be built.
+ *
+ * Data text keeps the JSON shape of the former ArduinoJson payloads, so
+ * the server side is unchanged (VehicleTelemetry: see telemetry_frame.h).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "telemetry_frame.h"
+#include "../drivers/can_bus_stats.h"
+#include "task_profiler.h"
+
+enum DataTransferMessage : uint8_t
+{
+    DT_VEHICLE_TELEMETRY,
+    DT_SESSION_SUMMARY,
+    DT_BMS_ALERT,
+    DT_BUS_STATS,
+    DT_DIAGNOSTICS,
+    DT_MESSAGES
+};
+
+// Worst-case data text per message type (checked: a payload that does not fit is not sent)
+#define DT_VEHICLE_TELEMETRY_BYTES TELEMETRY_FRAME_MAX_B64
+#define DT_SESSION_SUMMARY_BYTES 384
+#define DT_BMS_ALERT_BYTES 256
+// header + per bus ~230 bytes of counters + one id row of at most 80 chars
+// ([29-bit id, tx, then 6 x uint32])
+#define DT_BUS_STATS_BYTES (128 + CAN_BUS_COUNT * (256 + CAN_STATS_MAX_IDS * 80))
+// header + cores + one row per task: ["name",core,prio,cpu,cpu,free,size]
+#define DT_DIAGNOSTICS_BYTES (128 + TASK_PROFILER_CORES * 32 + TASK_PROFILER_MAX_TASKS * 64)
+
+// Shared by all messages: the largest fits alone, small ones queue side by side
+#define DT_ARENA_BYTES DT_BUS_STATS_BYTES
+#define DT_ARENA_ENTRIES 8 // staged texts kept at most
+
+typedef uint32_t DataTransferTicket; // 0 = nothing staged
+
+struct DataTransferStats
+{
+    uint32_t staged;
+    uint32_t tooLarge; // data did not fit DT_*_BYTES: not sent
+    uint32_t spilled;  // space needed while still queued: moved to the outbox
+    uint32_t lost;     // ... and the outbox refused it
+    uint16_t maxLen;   // longest data text staged
+    uint16_t maxBytes; // DT_*_BYTES
+};
+
+namespace DATATRANSFER
+{
+    /// Stage the data text of one message; returns its ticket, 0 if it did not fit
+    DataTransferTicket stageVehicleTelemetry(const VehicleInfoBatch &batch, uint32_t nowMs);
+    /// Session profile from the signal history over the last `durationMin` minutes
+    DataTransferTicket stageSessionSummary(float finalSoc, float energyWh, float durationMin);
+    DataTransferTicket stageBmsAlert(const char *alertType, const char *message, uint32_t uptimeMs);
+    /// CAN_STATS of both buses now
+    DataTransferTicket stageBusStats(const char *reason, uint32_t uptimeS);
+    /// Latest TASK_PROFILER sample now (one staging task: uses a static snapshot)
+    DataTransferTicket stageDiagnostics(const char *reason, uint32_t uptimeS);
+
+    /// Data text of a staged message (payload builder), nullptr once it was evicted
+    const char *data(DataTransferMessage type, DataTransferTicket ticket);
+
+    /// The text is queued in a MicroOcpp request: spill it to the outbox before reusing its space
+    void hold(DataTransferTicket ticket);
+    /// Its request was answered: the space may be reused
+    void release(DataTransferTicket ticket);
+
+    const char *messageId(DataTransferMessage type);
+
+    /// Static bytes of the arena
+    size_t arenaBytes();
+
+    DataTransferStats stats(DataTransferMessage type);
+    void resetStats();
+
+    /// Per message: staged, longest, too large, spilled (console 'd')
+    void printStats();
+
+} // namespace DATATRANSFER
@@ -0,0 +1,159 @@
+#pragma once
+
+/**
+ * @file deferred_log.h
+ * @brief Deferred Serial logging: hot paths queue (format, args), a low-priority task prints
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * Serial.printf() blocks its caller until the line is in the 128-byte UART
+ * FIFO: at 115200 baud a 100-character line holds a decode or CAN task for
+ * several milliseconds. DLOG() instead copies the format pointer and up to
+ * DLOG_MAX_ARGS arguments (32-bit integers, floats, string pointers) into a
+ * bounded lock-free multi-producer ring and returns. The LOG task formats
+ * and writes the lines at TASK_PRIORITY_LOG, taking serialMutex for each
+ * batch; a full ring drops the new line and counts it, and the next batch
+ * reports the count.
+ *
+ *   DLOG("[BMS] ChargingAh received: raw=0x%08X (%.3fAh)\n", raw, ah);
+ *
+ * The format must be a string literal and %s arguments must outlive the
+ * line (literals, static tables): only the pointers are queued. Arguments
+ * are type-checked against the format like Serial.printf(). Floats are
+ * kept as float, integers as 32 bits (the ESP32 long); the l / ll / z
+ * length modifiers are honoured when the line is formatted.
+ *
+ * Lines from DLOG() and direct Serial prints can appear out of order with
+ * each other; lines from DLOG() keep the order they were queued in.
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <type_traits>
+
+#ifndef DLOG_CAPACITY
+#define DLOG_CAPACITY 64 // lines queued (52 B each on the ESP32), must be a power of two
+#endif
+#define DLOG_MAX_ARGS 8
+#define DLOG_LINE_MAX 192 // longer lines are cut
+
+enum DlogArgType : uint8_t
+{
+    DLOG_ARG_INT,
+    DLOG_ARG_UINT,
+    DLOG_ARG_FLOAT,
+    DLOG_ARG_STR,
+    DLOG_ARG_PTR
+};
+
+union DlogArg
+{
+    int32_t i;
+    uint32_t u;
+    float f;
+    const char *s;
+    const void *p;
+};
+
+struct DlogRecord
+{
+    const char *format;
+    uint8_t argc;
+    uint8_t types[DLOG_MAX_ARGS];
+    DlogArg args[DLOG_MAX_ARGS];
+};
+
+struct DlogStats
+{
+    uint32_t queued;    // lines accepted
+    uint32_t written;   // lines printed
+    uint32_t dropped;   // ring full
+    uint32_t highWater; // most lines waiting at once
+};
+
+/// Extra destination for each formatted line (e.g. remote logging)
+typedef void (*DlogSink)(const char *line, size_t len);
+
+namespace DEFERRED_LOG
+{
+    template <typename T>
+    inline uint8_t packArg(DlogArg &a, T v)
+    {
+        if constexpr (std::is_floating_point<T>::value)
+        {
+            a.f = (float)v;
+            return DLOG_ARG_FLOAT;
+        }
+        else if constexpr (std::is_same<T, const char *>::value || std::is_same<T, char *>::value)
+        {
+            a.s = v;
+            return DLOG_ARG_STR;
+        }
+        else if constexpr (std::is_pointer<T>::value)
+        {
+            a.p = (const void *)v;
+            return DLOG_ARG_PTR;
+        }
+        else if constexpr (std::is_enum<T>::value)
+        {
+            a.i = (int32_t)v;
+            return DLOG_ARG_INT;
+        }
+        else
+        {
+            static_assert(std::is_integral<T>::value, "DLOG arguments: integers, floats and pointers only");
+            if constexpr (std::is_signed<T>::value)
+            {
+                a.i = (int32_t)v;
+                return DLOG_ARG_INT;
+            }
+            else
+            {
+                a.u = (uint32_t)v;
+                return DLOG_ARG_UINT;
+            }
+        }
+    }
+
+    /// Queue a record (any task); false if the ring was full and it was dropped
+    bool push(const DlogRecord &record);
+
+    template <typename... Args>
+    inline bool log(const char *format, Args... args)
+    {
+        static_assert(sizeof...(Args) <= DLOG_MAX_ARGS, "DLOG takes at most DLOG_MAX_ARGS arguments");
+        DlogRecord r;
+        r.format = format;
+        r.argc = 0;
+        ((r.types[r.argc] = packArg(r.args[r.argc], args), r.argc++), ...);
+        return push(r);
+    }
+
+    /// Start the LOG task
+    bool init();
+
+    /// Print everything queued now, from the calling task (replay, shutdown)
+    void flush();
+
+    /// Format one record into out (always terminated); returns the length
+    size_t format(const DlogRecord &record, char *out, size_t size);
+
+    /// Also hand each printed line to sink (nullptr: Serial only)
+    void setSink(DlogSink sink);
+
+    void getStats(DlogStats &out);
+
+    /// Queue fill, lines written / dropped (console 'g')
+    void printStats();
+
+} // namespace DEFERRED_LOG
+
+// The dead printf call only type-checks the arguments against the format
+#define DLOG(format, ...)                                  \
+    do                                                     \
+    {                                                      \
+        if (false)                                         \
+            Serial.printf(format, ##__VA_ARGS__);          \
+        DEFERRED_LOG::log(format, ##__VA_ARGS__);          \
+    } while (0)
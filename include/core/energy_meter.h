@@ -0,0 +1,78 @@
+#pragma once
+
+/**
+ * @file energy_meter.h
+ * @brief Per-frame trapezoidal energy integration on RX timestamps
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * Every terminal power frame (0x00433F01) is one sample P(t) = V * I taken
+ * at the frame's RX time in microseconds. The interval between two
+ * consecutive samples is integrated with the trapezoidal rule into a double
+ * accumulator, so the result does not depend on when loop() happens to run
+ * and keeps sub-Wh resolution over a full session.
+ *
+ * Intervals longer than ENERGY_MAX_GAP_MS (lost frames, charger silent) are
+ * not integrated; they are counted with their duration so the uncovered
+ * time of a session can be reported. Samples outside the plausible
+ * terminal range are rejected and integration restarts at the next one.
+ */
+
+#include <stdint.h>
+#include "../config/timing.h"
+
+struct EnergyMeterStats
+{
+    double energyWh;
+    double meteredSeconds; // time covered by integrated intervals
+    double gapSeconds;     // time skipped by gap detection while metering
+    uint32_t samples;      // frames seen while metering
+    uint32_t gaps;         // intervals skipped by gap detection
+    uint32_t rejected;     // implausible V/I samples (integration restarts after them)
+};
+
+/// Integration engine, independent of tasks and clocks (used directly by the bench)
+class EnergyIntegrator
+{
+public:
+    explicit EnergyIntegrator(uint32_t maxGapUs = ENERGY_MAX_GAP_MS * 1000UL);
+
+    /// Zero the accumulator and statistics and forget the previous sample
+    void reset();
+
+    /// Start/stop metering; a new interval starts at the first frame after enabling
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_; }
+
+    /// Feed one frame (64-bit RX time: no wrap, any gap length is seen as a gap)
+    void addSample(uint64_t t_us, float volt, float curr);
+
+    double energyWh() const { return stats_.energyWh; }
+    const EnergyMeterStats &stats() const { return stats_; }
+
+private:
+    static bool plausible(float volt, float curr);
+
+    uint32_t maxGapUs_;
+    bool enabled_;
+    bool haveLast_;
+    uint64_t lastUs_;
+    double lastPowerW_;
+    EnergyMeterStats stats_;
+};
+
+namespace ENERGY_METER
+{
+    /// Terminal power frame decoded (CAN1 decode path)
+    void onTerminalPower(uint64_t rx_us, float volt, float curr);
+
+    /// Charge gate open/closed (ChargingCore)
+    void setMetering(bool on);
+
+    /// New transaction: zero the session energy
+    void reset();
+
+    double energyWh();
+    EnergyMeterStats stats();
+
+} // namespace ENERGY_METER
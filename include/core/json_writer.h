@@ -0,0 +1,61 @@
+#pragma once
+
+/**
+ * @file json_writer.h
+ * @brief Minimal streaming JSON writer into a caller-owned buffer
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * Writes compact JSON text directly into a fixed buffer: no document tree,
+ * no String, no heap. Commas are inserted per nesting level; numbers are
+ * formatted without printf. Once the buffer is full every further call is
+ * ignored and finish() returns 0, so a payload is either complete or not
+ * sent at all.
+ *
+ *   JsonWriter w(buf, sizeof(buf));
+ *   w.beginObject().add("reason", reason).add("uptime", uptimeS);
+ *   w.beginArray("buses") ... .end();
+ *   const size_t len = w.end().finish();
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define JSON_WRITER_MAX_DEPTH 16
+
+class JsonWriter
+{
+public:
+    JsonWriter(char *buf, size_t cap);
+
+    /// Containers; pass a key inside objects, nullptr inside arrays / at the top
+    JsonWriter &beginObject(const char *key = nullptr);
+    JsonWriter &beginArray(const char *key = nullptr);
+    JsonWriter &end();
+
+    /// Members (key != nullptr) or array elements (key == nullptr)
+    JsonWriter &add(const char *key, const char *value); // escaped, nullptr -> null
+    JsonWriter &add(const char *key, uint32_t value);
+    JsonWriter &add(const char *key, int32_t value);
+    JsonWriter &add(const char *key, float value, uint8_t decimals = 2); // NaN / inf -> null
+
+    /// Text length once every container is closed, 0 if anything did not fit
+    size_t finish();
+
+    bool overflowed() const { return overflow_; }
+
+private:
+    void member(const char *key);
+    void put(char c);
+    void put(const char *s);
+    void putEscaped(const char *s);
+    void putUnsigned(uint64_t v);
+
+    char *buf_;
+    size_t cap_;
+    size_t len_;
+    uint8_t depth_;
+    uint32_t needComma_; // bit n: level n already has an element
+    char closers_[JSON_WRITER_MAX_DEPTH];
+    bool overflow_;
+};
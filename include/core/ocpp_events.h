@@ -0,0 +1,92 @@
+#pragma once
+
+/**
+ * @file ocpp_events.h
+ * @brief Event queue and adaptive tick of the OCPP task
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * The OCPP task blocks on this queue instead of sleeping a fixed 10 ms.
+ * Other tasks post what the OCPP side must react to (plug change, charger
+ * health change, BMS alert, a VehicleInfo batch to send) and the task
+ * wakes at once; MicroOcpp, its request queue and the flash outbox are
+ * only touched from the OCPP task. A VehicleInfo batch is copied into one
+ * of OCPP_VEHICLE_INFO_SLOTS slots and the event names the slot. Without
+ * events the wait times out after tickMs(): OCPP_TICK_ACTIVE_MS while
+ * something is in progress, OCPP_TICK_IDLE_MS once the charger has been
+ * idle for OCPP_TICK_HOLD_MS.
+ *
+ * wait() also accounts the task's time: blocked in the queue vs running
+ * between two waits (console 'w').
+ */
+
+#include <stdint.h>
+#include "telemetry_frame.h"
+
+enum OcppEventType : uint8_t
+{
+    OCPP_EVENT_PLUG,           // value = plugged
+    OCPP_EVENT_CHARGER_HEALTH, // value = healthy
+    OCPP_EVENT_BMS_ALERT,      // alertType, message
+    OCPP_EVENT_VEHICLE_INFO,   // slot
+    OCPP_EVENT_TYPES
+};
+
+struct OcppEvent
+{
+    OcppEventType type;
+    bool value;
+    const char *alertType; // string literals: kept by pointer
+    const char *message;
+    uint64_t postedUs;     // esp_timer_get_time() at post
+    uint8_t slot;          // OCPP_EVENT_VEHICLE_INFO: batch slot
+};
+
+struct OcppLoopStats
+{
+    uint32_t wakeups;          // returns from wait()
+    uint32_t eventWakeups;     // ... with an event
+    uint32_t events[OCPP_EVENT_TYPES];
+    uint32_t dropped;          // queue full
+    uint32_t maxQueued;
+    uint32_t maxLatencyUs;     // post -> taken by the OCPP task
+    uint64_t latencySumUs;
+    uint64_t busyUs;           // running between waits
+    uint64_t blockedUs;        // inside wait()
+    uint64_t idleTickUs;       // blocked with the idle tick
+    uint32_t maxBusyUs;        // longest single pass
+    uint32_t tickMs;           // last tick used
+};
+
+namespace OCPP_EVENTS
+{
+    /// Create the queue (before any task posts)
+    bool init();
+
+    /// Any task; never blocks. False (and counted) if the queue is full
+    bool post(const OcppEvent &event);
+    bool postPlug(bool plugged);
+    bool postChargerHealth(bool healthy);
+    bool postBmsAlert(const char *alertType, const char *message);
+    /// One posting task (loop); false if the slots or the queue are full
+    bool postVehicleInfo(const VehicleInfoBatch &batch);
+
+    /// OCPP task: the batch of an OCPP_EVENT_VEHICLE_INFO event (frees its slot)
+    bool takeVehicleInfo(const OcppEvent &event, VehicleInfoBatch &out);
+
+    /// OCPP task: tick for the next wait given whether anything is in progress
+    uint32_t tickMs(bool active);
+
+    /// OCPP task: block up to `timeoutMs` for an event; false on timeout
+    bool wait(OcppEvent &event, uint32_t timeoutMs);
+
+    /// OCPP task: next queued event without blocking (not counted as a wakeup)
+    bool take(OcppEvent &event);
+
+    OcppLoopStats stats();
+    void resetStats();
+
+    /// Wakeups, busy / blocked time and event latency (console 'w')
+    void printStats();
+
+} // namespace OCPP_EVENTS
@@ -0,0 +1,76 @@
+#pragma once
+
+/**
+ * @file ocpp_outbox.h
+ * @brief Flash-backed outbound queue for custom DataTransfers while offline
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * Append-only log on the "ocpplog" data partition (partitions.csv). The
+ * partition is a ring of 4 KB sectors, written strictly in order, so every
+ * sector is erased equally often. Each sector starts with a header holding
+ * its erase sequence and a wear counter; records never span sectors:
+ *
+ *   [seq u32][len u16][type u8][magic u8][crc32 u32][state u32][data, 4-aligned]
+ *
+ * Data is programmed before its header, so a header on flash means the
+ * data was complete. Delivery clears `state` in place (a NOR write, no
+ * erase); a sector whose records are all delivered gets its `retired`
+ * word cleared the same way, so a reboot only scans live sectors. When
+ * the ring is full the oldest sector is erased, pending records in it
+ * are counted as dropped.
+ *
+ * The OCPP task replays the queue in order, one record in flight at a time
+ * (ocpp_manager.cpp); live messages are queued behind it until it is empty.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "datatransfer_payload.h"
+
+#define OCPP_OUTBOX_PARTITION "ocpplog"
+#define OCPP_OUTBOX_SECTOR_BYTES 4096
+#define OCPP_OUTBOX_MAX_DATA DT_BUS_STATS_BYTES // largest data text queued
+
+struct OutboxRecord
+{
+    uint32_t seq;
+    DataTransferMessage type;
+};
+
+struct OutboxStats
+{
+    bool ready;         // partition found and recovered
+    uint16_t sectors;
+    uint32_t pending;
+    uint32_t usedBytes; // flash from the oldest pending record to the write position
+    uint32_t appended;
+    uint32_t delivered;
+    uint32_t dropped;   // overwritten while pending, or given up on
+    uint32_t corrupt;   // failed CRC (torn write), skipped
+    uint32_t rejected;  // append failed: no partition, too large or flash error
+};
+
+namespace OCPP_OUTBOX
+{
+    /// Find the partition and rebuild the queue from flash; false = outbox disabled
+    bool init();
+
+    bool append(DataTransferMessage type, const char *data, size_t len);
+
+    /// No record pending; false if that cannot be told in time (outbox busy)
+    bool empty();
+
+    /// Oldest pending record: data copied to `out` (NUL-terminated), returns its length, 0 if none
+    size_t peek(OutboxRecord &rec, char *out, size_t cap);
+
+    /// Mark the oldest record delivered / dropped; ignored unless it is still `seq`
+    bool ack(uint32_t seq);
+    bool discard(uint32_t seq);
+
+    OutboxStats stats();
+
+    /// Queue state and sector wear (console 'o')
+    void printStats();
+
+} // namespace OCPP_OUTBOX
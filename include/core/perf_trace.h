@@ -0,0 +1,133 @@
+#pragma once
+
+/**
+ * @file perf_trace.h
+ * @brief Scope timers on the hot paths, recorded into per-core rings
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * PERF_TRACE_SCOPE(id) reads the CPU cycle counter where it is placed and
+ * again at the end of the enclosing scope, then appends one 12-byte
+ * record (end cycles, duration, id) to the ring of the core it ran on.
+ * Slots are claimed with a relaxed fetch_add, so tasks preempting each
+ * other on a core never share one; the oldest records are overwritten.
+ * No lock, no Serial, no heap on the recording side.
+ *
+ * Console 'f' prints count / mean / max per scope; 'F' dumps the rings
+ * as Chrome trace-event JSON between "#PERFTRACE" marker lines, which
+ * scripts/perftrace.py extracts from a serial log for Perfetto
+ * (ui.perfetto.dev) or chrome://tracing. Both pause recording while
+ * they read.
+ *
+ * Cycle counters are per core and 32 bits wide (17.9 s at 240 MHz). The
+ * dump places each core's records on the esp_timer clock by reading that
+ * core's counter next to esp_timer_get_time() and walking back through
+ * the ring, so gaps of more than 8.9 s between two records of one core
+ * put everything older at the wrong time.
+ *
+ * With PERF_TRACE_ENABLED 0 (config/timing.h) the macro expands to
+ * nothing and no ring is allocated.
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "../config/timing.h"
+
+#if PERF_TRACE_ENABLED
+#include <atomic>
+#endif
+
+#ifndef PERF_TRACE_CAPACITY
+#define PERF_TRACE_CAPACITY 512 // records per core (6 KB), must be a power of two
+#endif
+#define PERF_TRACE_CORES portNUM_PROCESSORS
+
+enum PerfTraceId : uint16_t
+{
+    PERF_CHARGER_RX,    // handleChargerMessage()
+    PERF_BMS_RX,        // BMS frame decode (dispatchBmsFrame)
+    PERF_CHARGER_POLL,  // CHARGER_POLL::service(): due requests built and queued
+    PERF_MOCPP_LOOP,    // mocpp_loop()
+    PERF_MAIN_LOOP,     // loop() body
+    PERF_CHARGING_CORE, // ChargingCore::poll()
+    PERF_TRACE_IDS
+};
+
+struct PerfTraceRecord
+{
+    uint32_t endCycles;
+    uint32_t cycles;
+    uint16_t id;
+    uint16_t reserved;
+};
+static_assert(sizeof(PerfTraceRecord) == 12, "PerfTraceRecord must stay 12 bytes");
+
+#if PERF_TRACE_ENABLED
+
+static_assert((PERF_TRACE_CAPACITY & (PERF_TRACE_CAPACITY - 1)) == 0, "PERF_TRACE_CAPACITY must be a power of two");
+
+struct alignas(64) PerfTraceRing
+{
+    std::atomic<uint32_t> head; // records ever written
+    PerfTraceRecord records[PERF_TRACE_CAPACITY];
+};
+
+extern PerfTraceRing perfTraceRings[PERF_TRACE_CORES];
+extern volatile bool perfTraceArmed;
+
+namespace PERF_TRACE
+{
+    inline void record(PerfTraceId id, uint32_t startCycles)
+    {
+        if (!perfTraceArmed)
+            return;
+        const uint32_t end = ESP.getCycleCount();
+        PerfTraceRing &ring = perfTraceRings[xPortGetCoreID()];
+        const uint32_t slot = ring.head.fetch_add(1, std::memory_order_relaxed) & (PERF_TRACE_CAPACITY - 1);
+        ring.records[slot] = {end, end - startCycles, id, 0};
+    }
+} // namespace PERF_TRACE
+
+class PerfTraceScope
+{
+public:
+    explicit PerfTraceScope(PerfTraceId id) : id_(id), start_(ESP.getCycleCount()) {}
+    ~PerfTraceScope() { PERF_TRACE::record(id_, start_); }
+    PerfTraceScope(const PerfTraceScope &) = delete;
+    PerfTraceScope &operator=(const PerfTraceScope &) = delete;
+
+private:
+    PerfTraceId id_;
+    uint32_t start_;
+};
+
+#define PERF_TRACE_CONCAT_(a, b) a##b
+#define PERF_TRACE_CONCAT(a, b) PERF_TRACE_CONCAT_(a, b)
+#define PERF_TRACE_SCOPE(id) PerfTraceScope PERF_TRACE_CONCAT(perfTraceScope_, __LINE__)(id)
+
+#else
+
+#define PERF_TRACE_SCOPE(id) \
+    do                       \
+    {                        \
+    } while (0)
+
+#endif // PERF_TRACE_ENABLED
+
+namespace PERF_TRACE
+{
+    /// Records written since boot / clear(), all cores
+    uint32_t recorded();
+
+    /// Count / mean / max per scope from the rings (console 'f')
+    void printSummary();
+
+    /// Chrome trace-event JSON of the rings over Serial (console 'F')
+    void dump();
+
+    /// Forget all records
+    void clear();
+
+    const char *name(PerfTraceId id);
+
+} // namespace PERF_TRACE
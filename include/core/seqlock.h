@@ -0,0 +1,89 @@
+#pragma once
+
+/**
+ * @file seqlock.h
+ * @brief Single-writer sequence lock with wait-free readers
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * The writer bumps the sequence to an odd value, stores the payload and
+ * bumps it back to even. A reader copies the payload between two sequence
+ * loads and retries if the sequence was odd or changed, so it always
+ * returns a value written by one publish() call and never blocks the
+ * writer.
+ *
+ * The payload is kept as 32-bit atomic words accessed with relaxed loads
+ * and stores, so the concurrent copy is not a data race; the fences order
+ * those word accesses against the sequence counter.
+ */
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+template <typename T>
+class Seqlock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock payload must be trivially copyable");
+    static_assert(sizeof(T) % sizeof(uint32_t) == 0, "Seqlock payload size must be a multiple of 4 bytes");
+
+    static constexpr size_t WORDS = sizeof(T) / sizeof(uint32_t);
+
+public:
+    Seqlock() : seq_(0)
+    {
+        for (size_t i = 0; i < WORDS; i++)
+            words_[i].store(0, std::memory_order_relaxed);
+    }
+
+    /// Publish a new value (single writer only)
+    void publish(const T &value)
+    {
+        uint32_t w[WORDS];
+        memcpy(w, &value, sizeof(T));
+
+        const uint32_t s = seq_.load(std::memory_order_relaxed);
+        seq_.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++)
+            words_[i].store(w[i], std::memory_order_relaxed);
+        seq_.store(s + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy a consistent value (any number of readers)
+     * @return sequence number of the copy (even; 0 = never published)
+     */
+    uint32_t read(T &out) const
+    {
+        uint32_t w[WORDS];
+        uint32_t s0, s1;
+        do
+        {
+            s0 = seq_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; i++)
+                w[i] = words_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            s1 = seq_.load(std::memory_order_relaxed);
+        } while ((s0 & 1) || s0 != s1);
+
+        memcpy(&out, w, sizeof(T));
+        return s0;
+    }
+
+    T read() const
+    {
+        T out;
+        read(out);
+        return out;
+    }
+
+    /// Sequence of the last completed publish (even), cheap change detection
+    uint32_t sequence() const { return seq_.load(std::memory_order_acquire) & ~(uint32_t)1; }
+
+private:
+    std::atomic<uint32_t> seq_;
+    std::atomic<uint32_t> words_[WORDS];
+};
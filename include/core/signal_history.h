@@ -0,0 +1,152 @@
+#pragma once
+
+/**
+ * @file signal_history.h
+ * @brief Fixed-memory multi-resolution history of terminal V / I, charger temperature and SOC
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * The decoders record every sample at its frame's RX time. Each tier keeps
+ * one open accumulator per channel (min / max / sum); when a sample falls
+ * into a later bucket the accumulator is written to the tier's ring as
+ * min / max / mean and starts over. An insert touches HISTORY_TIERS
+ * accumulators and at most HISTORY_TIERS ring slots: O(1), no heap.
+ *
+ * Bucket n of a tier lives in slot n % buckets. The slot tag records which
+ * lap of the ring it holds, so time without samples (charger off, nothing
+ * plugged) needs no filling and simply reads back as empty.
+ *
+ * Values are stored as int16 hundredths (-327.67 .. 327.67): 10 mV, 10 mA,
+ * 0.01 °C, 0.01 % per step. With the default tiers (1 s x 10 min,
+ * 10 s x 2 h, 2 min x 24 h) the store takes ~53 KB of static RAM.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../config/timing.h"
+
+enum HistoryChannel : uint8_t
+{
+    HIST_TERMINAL_VOLT, // V, terminal power broadcast
+    HIST_TERMINAL_CURR, // A, terminal power broadcast
+    HIST_CHARGER_TEMP,  // °C, module telemetry 0x80
+    HIST_SOC,           // %, from the BMS Ah counters
+    HIST_CHANNELS
+};
+
+#define HISTORY_TIERS 3
+
+struct HistoryTierSpec
+{
+    uint32_t periodS;
+    uint16_t buckets;
+};
+
+inline constexpr HistoryTierSpec HISTORY_TIER_SPECS[HISTORY_TIERS] = {
+    {HISTORY_TIER0_PERIOD_S, HISTORY_TIER0_BUCKETS},
+    {HISTORY_TIER1_PERIOD_S, HISTORY_TIER1_BUCKETS},
+    {HISTORY_TIER2_PERIOD_S, HISTORY_TIER2_BUCKETS}};
+
+inline constexpr size_t HISTORY_TOTAL_BUCKETS = HISTORY_TIER0_BUCKETS + HISTORY_TIER1_BUCKETS + HISTORY_TIER2_BUCKETS;
+
+/// One bucket of one channel, as returned by queries
+struct HistoryPoint
+{
+    uint32_t startS; // bucket start, seconds since boot (RX time base)
+    float min;
+    float max;
+    float mean;
+};
+
+/// Aggregate over a time range
+struct HistorySummary
+{
+    float min;
+    float max;
+    float mean;       // mean of the bucket means (time-weighted, buckets are equal length)
+    float first;      // mean of the oldest / newest bucket in range
+    float last;
+    uint32_t buckets; // buckets with data, 0 = nothing recorded in range
+    uint8_t tier;     // tier the summary was computed from
+};
+
+/// Storage and bucketing, independent of tasks and clocks (used directly by the bench)
+class SignalHistory
+{
+public:
+    SignalHistory() { reset(); }
+
+    /// Add one sample taken at tS (seconds since boot)
+    void record(HistoryChannel ch, float value, uint32_t tS);
+
+    /**
+     * @brief Buckets of one tier with data for `ch` that start in [fromS, toS]
+     * Includes the open bucket. Buckets older than the tier's span are gone.
+     * @return points written to `out` (oldest first)
+     */
+    size_t query(HistoryChannel ch, uint8_t tier, uint32_t fromS, uint32_t toS,
+                 HistoryPoint *out, size_t maxPoints) const;
+
+    /// Finest tier whose span still reaches back to fromS at time nowS
+    static uint8_t tierFor(uint32_t fromS, uint32_t nowS);
+
+    void reset();
+
+    static constexpr size_t memoryBytes();
+
+private:
+    struct Bucket
+    {
+        uint16_t tag;                   // lap + 1 of the bucket held, 0 = never written
+        int16_t v[HIST_CHANNELS][3];    // min, max, mean in hundredths; HIST_NO_DATA = not sampled
+    };
+
+    struct Accumulator
+    {
+        uint32_t bucket; // absolute bucket number (tS / period)
+        uint32_t count;  // 0 = open bucket empty
+        float min;
+        float max;
+        float sum;
+    };
+
+    void flush(uint8_t tier, HistoryChannel ch, const Accumulator &a);
+    bool readSlot(uint8_t tier, HistoryChannel ch, uint32_t bucket, HistoryPoint &p) const;
+
+    Bucket buckets_[HISTORY_TOTAL_BUCKETS];
+    Accumulator acc_[HISTORY_TIERS][HIST_CHANNELS];
+};
+
+constexpr size_t SignalHistory::memoryBytes()
+{
+    return sizeof(SignalHistory);
+}
+
+namespace SIGNAL_HISTORY
+{
+    /// Decoded sample (decode path); rxUs = CanMessage::timestamp_us of its frame
+    void record(HistoryChannel ch, float value, uint64_t rxUs);
+
+    /// See SignalHistory::query (any task; copies a few buckets per lock)
+    size_t query(HistoryChannel ch, uint8_t tier, uint32_t fromS, uint32_t toS,
+                 HistoryPoint *out, size_t maxPoints);
+
+    /// min / max / mean of `ch` over [fromS, toS] from the finest tier that covers it
+    HistorySummary summarize(HistoryChannel ch, uint32_t fromS, uint32_t toS);
+
+    /// Current time in the history's time base (seconds since boot)
+    uint32_t nowS();
+
+    size_t memoryBytes();
+    const char *channelName(HistoryChannel ch);
+
+    /// Forget everything (no recording in progress)
+    void reset();
+
+    /// Budget, fill and per-tier summaries (console 'h')
+    void print();
+
+    /// One tier as CSV: startS,channel,min,max,mean (console 'H')
+    void dump(uint8_t tier);
+
+} // namespace SIGNAL_HISTORY
@@ -0,0 +1,127 @@
+#pragma once
+
+/**
+ * @file spsc_ring.h
+ * @brief Lock-free single-producer / single-consumer ring buffer
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * Shared by the CAN drivers: the RX task is the only producer and the
+ * dispatcher the only consumer. Indices are free-running 32-bit counters
+ * masked by N - 1, published with release stores and read with acquire
+ * loads so a slot is never observed before its payload is written.
+ *
+ * The producer never touches the tail index: when the ring is full the
+ * NEW item is dropped and counted, instead of advancing the consumer's
+ * tail ("drop oldest"), which would race with an in-progress pop.
+ */
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+template <typename T, size_t N>
+class SpscRing
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+    static_assert(N <= 0x80000000UL, "SpscRing size must fit the 32-bit index space");
+
+public:
+    static constexpr size_t capacity() { return N; }
+
+    /**
+     * @brief Append an item (producer only)
+     * @return false if the ring was full and the item was dropped
+     */
+    bool push(const T &item)
+    {
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        const uint32_t tail = tail_.load(std::memory_order_acquire);
+        if (head - tail >= N)
+        {
+            overflows_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        buf_[head & MASK] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Remove the oldest item (consumer only)
+     * @return false if the ring is empty
+     */
+    bool pop(T &out)
+    {
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        const uint32_t head = head_.load(std::memory_order_acquire);
+        if (head == tail)
+            return false;
+        out = buf_[tail & MASK];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Copy the oldest item without removing it (consumer only)
+     * @return false if the ring is empty
+     */
+    bool peek(T &out) const
+    {
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        const uint32_t head = head_.load(std::memory_order_acquire);
+        if (head == tail)
+            return false;
+        out = buf_[tail & MASK];
+        return true;
+    }
+
+    /**
+     * @brief Remove up to max items in one call (consumer only)
+     * @return Number of items copied to out
+     */
+    size_t popN(T *out, size_t max)
+    {
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        const uint32_t head = head_.load(std::memory_order_acquire);
+        size_t n = head - tail;
+        if (n > max)
+            n = max;
+        for (size_t i = 0; i < n; i++)
+            out[i] = buf_[(tail + i) & MASK];
+        tail_.store(tail + (uint32_t)n, std::memory_order_release);
+        return n;
+    }
+
+    /**
+     * @brief Discard everything currently queued (consumer only)
+     */
+    void clear()
+    {
+        tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    /// Approximate item count (exact from either endpoint's own thread)
+    size_t size() const
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    /// Fill level 0-100 %
+    uint8_t usagePercent() const { return (uint8_t)((size() * 100) / N); }
+
+    /// Items dropped because the ring was full
+    uint32_t overflowCount() const { return overflows_.load(std::memory_order_relaxed); }
+
+    void resetOverflowCount() { overflows_.store(0, std::memory_order_relaxed); }
+
+private:
+    static constexpr uint32_t MASK = (uint32_t)(N - 1);
+
+    std::atomic<uint32_t> head_{0}; // written by producer only
+    std::atomic<uint32_t> tail_{0}; // written by consumer only
+    std::atomic<uint32_t> overflows_{0};
+    T buf_[N];
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+/**
+ * @file task_profiler.h
+ * @brief Per-task CPU and stack use from the FreeRTOS trace facility
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * A software timer samples uxTaskGetSystemState() every
+ * TASK_PROFILER_SAMPLE_MS: each task's run time counter and stack high
+ * water mark. CPU shares come from counter deltas over two sliding
+ * windows, the last sample period and the last TASK_PROFILER_HISTORY
+ * periods, as % of one core. A core's load is 100 % minus its IDLE task
+ * (on the native build, which has no idle tasks: the sum of the tasks
+ * pinned to it).
+ *
+ * Stack sizes are not in TaskStatus_t: tasks created by the firmware are
+ * registered with track() and shown as used / size; other tasks (IDLE,
+ * timer service, WiFi, lwIP) only with their high water mark.
+ *
+ * Without configGENERATE_RUN_TIME_STATS the counters read 0; stacks are
+ * still reported and CPU shows as unavailable. On the native build the
+ * counters are thread CPU time and the stacks are host stacks.
+ */
+
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define TASK_PROFILER_MAX_TASKS 24 // ~18 on the ESP32 with WiFi up
+#define TASK_PROFILER_CORES portNUM_PROCESSORS
+#define TASK_PROFILER_NO_CPU 0xFFFF // window not covered yet / no run time stats
+
+struct TaskProfile
+{
+    char name[configMAX_TASK_NAME_LEN];
+    int8_t core;              // -1 = no affinity
+    uint8_t priority;
+    uint16_t cpuShortPermille; // of one core, last TASK_PROFILER_SAMPLE_MS
+    uint16_t cpuLongPermille;  // last TASK_PROFILER_HISTORY samples
+    uint32_t stackBytes;       // 0 = not tracked
+    uint32_t stackFreeMin;     // high water mark, bytes
+};
+
+struct ProfilerSnapshot
+{
+    uint32_t samples;
+    uint32_t shortWindowMs; // actual span of each window
+    uint32_t longWindowMs;
+    bool runTimeStats;
+    uint8_t taskCount;
+    uint8_t untracked; // tasks beyond TASK_PROFILER_MAX_TASKS
+    uint16_t coreShortPermille[TASK_PROFILER_CORES];
+    uint16_t coreLongPermille[TASK_PROFILER_CORES];
+    TaskProfile tasks[TASK_PROFILER_MAX_TASKS];
+};
+
+namespace TASK_PROFILER
+{
+    /// Start the sampling timer (first sample right away)
+    bool init();
+
+    /// Stack size a task was created with, for used / size
+    void track(TaskHandle_t task, uint32_t stackBytes);
+
+    /// Take a sample now (timer callback)
+    void sample();
+
+    /// Latest sample; false before the first
+    bool snapshot(ProfilerSnapshot &out);
+
+    /// Per-core load and per-task CPU / stack table (console 'c')
+    void print();
+
+} // namespace TASK_PROFILER
@@ -0,0 +1,122 @@
+#pragma once
+
+/**
+ * @file telemetry.h
+ * @brief Consistent, lock-free telemetry snapshots for cross-task readers
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * The CAN decoders keep updating the shared globals under dataMutex and then
+ * publish the measurement tuple of their bus through a Seqlock: one writer
+ * per bus (charger decode for CAN1, BMS decode for CAN2). Readers in loop(),
+ * the OCPP meter callbacks and the console get a coherent V/I/P/T or
+ * SOC/limits tuple without taking dataMutex, so they never see a voltage
+ * from one frame paired with a current from another and never block the
+ * decode path.
+ *
+ * Every decoded signal also records the RX time of the frame it came from
+ * (TELEMETRY::stamp with CanMessage::timestamp_us). Timeouts and rates use
+ * ageMs() / rxUs() instead of a millis() taken when the decoder or loop()
+ * happened to run, so queueing and task scheduling do not skew them.
+ */
+
+#include <stdint.h>
+
+/// Charger bus (CAN1) measurements, published by the charger decoder
+struct ChargerTelemetry
+{
+    float terminalVolt;  // V, terminal broadcast
+    float terminalCurr;  // A, terminal broadcast
+    float terminalPower; // W, terminalVolt * terminalCurr of the same frame
+    float outputVolt;    // V, module telemetry (0x84)
+    float outputCurr;    // A, module telemetry (0x82)
+    float outputTemp;    // °C, module telemetry (0x80)
+    uint64_t terminalRxUs; // RX time of the terminal frame behind terminalVolt / terminalCurr
+};
+
+/// BMS bus (CAN2) values, published by the BMS decoders
+struct BmsTelemetry
+{
+    float vmax;          // V, BMS request
+    float imax;          // A, BMS request
+    float socPercent;    // %, from the Ah counters
+    float rangeKm;
+    float batteryAh;
+    uint32_t vehicleModel; // 0=Unknown, 1=Classic, 2=Pro, 3=Max
+    uint64_t requestRxUs;  // RX time of the BMS request behind vmax / imax
+    uint64_t socRxUs;      // RX time of the ChargingAh frame behind socPercent
+};
+
+struct TelemetrySnapshot
+{
+    ChargerTelemetry charger;
+    BmsTelemetry bms;
+    uint32_t chargerSeq; // Seqlock sequence of each half, 0 = never published
+    uint32_t bmsSeq;
+};
+
+/// Signals whose RX time is tracked (TELEMETRY::stamp / ageMs)
+enum TelemetrySignal : uint8_t
+{
+    TSIG_CHARGER_STATUS,    // control response 0x32
+    TSIG_CHARGER_VMAX,      // control response 0x00
+    TSIG_CHARGER_IMAX,      // control response 0x03
+    TSIG_OUTPUT_VOLT,       // module telemetry 0x84
+    TSIG_OUTPUT_CURR,       // module telemetry 0x82
+    TSIG_OUTPUT_TEMP,       // module telemetry 0x80
+    TSIG_METRIC79,          // module telemetry 0x79
+    TSIG_METRIC83,          // module telemetry 0x83
+    TSIG_TERMINAL_POWER,    // terminal broadcast, V / I
+    TSIG_TERMINAL_STATUS,   // terminal broadcast, charging state
+    TSIG_HEARTBEAT,         // terminal heartbeat
+    TSIG_BMS_REQUEST,       // BMS Vmax / Imax / permission flags
+    TSIG_BMS_CHARGE_AH,     // ChargingAh response
+    TSIG_BMS_DISCHARGE_AH,  // DischargingAh response
+    TSIG_BATTERY_PRESENT,   // any frame showing the pack (BMS request, plausible V echo)
+    TSIG_COUNT
+};
+
+/// RX time and RX -> decoded latency of one signal
+struct SignalTiming
+{
+    uint64_t rxUs;         // esp_timer_get_time() of the latest frame, 0 = never received
+    uint32_t decodeUs;     // RX -> stamp() of the latest frame
+    uint32_t maxDecodeUs;  // worst RX -> stamp() since reset
+    uint32_t updates;
+};
+
+namespace TELEMETRY
+{
+    /// Record that `sig` was decoded from a frame received at rxUs (decoders in canDispatchTask)
+    void stamp(TelemetrySignal sig, uint64_t rxUs);
+
+    /// RX time of the latest frame carrying `sig`, 0 = never received (any task)
+    uint64_t rxUs(TelemetrySignal sig);
+
+    /// Microseconds since that frame was received, UINT64_MAX = never received
+    uint64_t ageUs(TelemetrySignal sig);
+
+    /// Milliseconds since that frame was received, UINT32_MAX = never received
+    uint32_t ageMs(TelemetrySignal sig);
+
+    SignalTiming timing(TelemetrySignal sig);
+    const char *signalName(TelemetrySignal sig);
+
+    /// Forget all RX times and latencies (writer task or with decoding stopped)
+    void resetSignals();
+
+    /// Signal ages and decode latencies to Serial
+    void printSignalAges();
+
+    /// Copy the charger globals into the charger snapshot (CAN1 decoder, dataMutex held)
+    void publishCharger();
+
+    /// Copy the BMS globals into the BMS snapshot (CAN2 decoders, dataMutex held)
+    void publishBms();
+
+    /// Wait-free consistent copies (any task)
+    ChargerTelemetry charger();
+    BmsTelemetry bms();
+    TelemetrySnapshot snapshot();
+
+} // namespace TELEMETRY
@@ -0,0 +1,98 @@
+#pragma once
+
+/**
+ * @file telemetry_frame.h
+ * @brief Compact binary VehicleInfo frame: batched, delta + varint encoded
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * Replaces the JSON-in-a-JSON-string VehicleInfo DataTransfer. Samples taken
+ * while the EV waits in Preparing are collected into a fixed batch and sent
+ * as one frame, base64 encoded into the DataTransfer "data" field
+ * (messageId "VehicleTelemetry"). Nothing here allocates.
+ *
+ * Frame layout (version 1):
+ *
+ *   u8      version (TELEMETRY_FRAME_VERSION)
+ *   u8      vehicle model (1 Classic, 2 Pro, 3 Max, else unknown)
+ *   u8      sample count n (1..255, VEHICLE_INFO_BATCH_SAMPLES when full)
+ *   n x     varint  time: sample 0 = its age in ms when the frame was
+ *                   built, sample k = ms after sample k-1
+ *           zigzag  SOC 0.1 %, max current 0.1 A, voltage 0.01 V,
+ *                   current 0.01 A, temperature 0.1 °C, range 0.1 km;
+ *                   sample 0 absolute, sample k the delta to sample k-1
+ *
+ * Varints are LEB128 (7 bits per byte, low group first). A model change
+ * closes the batch, so the model is per frame.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../config/timing.h"
+
+#define TELEMETRY_FRAME_VERSION 1
+#define TELEMETRY_FRAME_FIELDS 6
+
+// Worst case of a full batch: header + per sample a 5-byte time and six 5-byte fields
+#define TELEMETRY_FRAME_MAX_BYTES (3 + VEHICLE_INFO_BATCH_SAMPLES * 5 * (1 + TELEMETRY_FRAME_FIELDS))
+#define TELEMETRY_FRAME_MAX_B64 (((TELEMETRY_FRAME_MAX_BYTES + 2) / 3) * 4 + 1)
+
+static_assert(VEHICLE_INFO_BATCH_SAMPLES >= 1 && VEHICLE_INFO_BATCH_SAMPLES <= 255,
+              "VEHICLE_INFO_BATCH_SAMPLES out of range");
+
+/// One VehicleInfo sample (units as on the wire before scaling)
+struct VehicleSample
+{
+    uint32_t tMs;       // millis() when taken
+    float soc;          // %
+    float maxCurrent;   // A, BMS request limit
+    float voltage;      // V, terminal
+    float current;      // A, terminal
+    float temperature;  // °C, charger output
+    float rangeKm;
+};
+
+/// Fixed batch of samples for one vehicle model
+class VehicleInfoBatch
+{
+public:
+    VehicleInfoBatch() { clear(); }
+
+    void clear();
+
+    /// False when the batch is full or the model differs (flush, clear, add again)
+    bool add(uint8_t model, const VehicleSample &s);
+
+    size_t count() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    bool full() const { return count_ >= VEHICLE_INFO_BATCH_SAMPLES; }
+    uint8_t model() const { return model_; }
+    const VehicleSample &last() const { return samples_[count_ ? count_ - 1 : 0]; }
+
+    /**
+     * @brief Encode the batch (layout above)
+     * @param nowMs millis() at encode time, for the age of sample 0
+     * @return bytes written, 0 if empty or `cap` is too small
+     */
+    size_t encode(uint32_t nowMs, uint8_t *out, size_t cap) const;
+
+private:
+    VehicleSample samples_[VEHICLE_INFO_BATCH_SAMPLES];
+    uint8_t count_;
+    uint8_t model_;
+};
+
+namespace TELEMETRY_FRAME
+{
+    /// Standard base64 with padding, NUL terminated; returns length, 0 if `cap` too small
+    size_t toBase64(const uint8_t *in, size_t len, char *out, size_t cap);
+
+    /**
+     * @brief Decode a frame back into samples (server reference, bench round trip)
+     * tMs is rebuilt relative to `builtMs`, the time the frame was encoded.
+     * @return samples decoded, 0 on a malformed frame
+     */
+    size_t decode(const uint8_t *in, size_t len, uint32_t builtMs, uint8_t &model,
+                  VehicleSample *out, size_t maxSamples);
+
+} // namespace TELEMETRY_FRAME
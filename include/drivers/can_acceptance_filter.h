@@ -0,0 +1,99 @@
+#pragma once
+
+/**
+ * @file can_acceptance_filter.h
+ * @brief Compile-time TWAI acceptance filter for a set of extended CAN ids
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * The ESP32 TWAI controller has one SJA1000-style acceptance filter, used
+ * either as a single 32-bit code/mask (ID[28:0] + RTR for extended frames)
+ * or as two 16-bit code/masks that only see ID[28:13]. Mask bit 1 = don't
+ * care. buildTwaiFilter() tries the single filter and every split of the id
+ * set over the two dual filters, and keeps the configuration that lets the
+ * fewest extended ids through. The hardware filter is a superset of the
+ * wanted ids, so receivers still check the exact list in software
+ * (canIdListContains).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct CanAcceptanceFilter
+{
+    uint32_t code;
+    uint32_t mask;        // 1 = don't care
+    bool single;          // single 32-bit filter, else two 16-bit filters
+    uint32_t acceptedIds; // extended ids (data frames) that pass
+};
+
+constexpr uint8_t canPopcount(uint32_t v)
+{
+    uint8_t n = 0;
+    for (; v; v &= v - 1)
+        n++;
+    return n;
+}
+
+/// Hardware filter decision for an extended data frame (mirrors the TWAI layout)
+constexpr bool twaiFilterAccepts(const CanAcceptanceFilter &f, uint32_t id)
+{
+    if (f.single)
+        return (((id << 3) ^ f.code) & ~f.mask) == 0;
+    const uint16_t hi = (uint16_t)(id >> 13);
+    return ((hi ^ (uint16_t)(f.code >> 16)) & ~(uint16_t)(f.mask >> 16)) == 0 ||
+           ((hi ^ (uint16_t)f.code) & ~(uint16_t)f.mask) == 0;
+}
+
+/// Narrowest TWAI filter passing every id of `ids` (29-bit, extended frames)
+template <size_t N>
+constexpr CanAcceptanceFilter buildTwaiFilter(const uint32_t (&ids)[N])
+{
+    static_assert(N > 0 && N <= 16, "id set size out of range");
+
+    // Single filter: ID[28:0] in bits 31..3, RTR (bit 2) must be 0, bits 1..0 unused
+    uint32_t diff = 0;
+    for (size_t i = 1; i < N; i++)
+        diff |= ids[i] ^ ids[0];
+    CanAcceptanceFilter best{ids[0] << 3, (diff << 3) | 0x3, true, 1U << canPopcount(diff)};
+
+    // Dual filter: each half covers ID[28:13] of one group, ID[12:0] pass freely
+    for (uint32_t split = 0; split < (1U << (N - 1)); split++)
+    {
+        uint16_t code[2] = {0, 0}, mask[2] = {0, 0};
+        bool used[2] = {false, false};
+        for (size_t i = 0; i < N; i++)
+        {
+            const int g = (i < N - 1 && (split >> i) & 1) ? 1 : 0;
+            const uint16_t hi = (uint16_t)(ids[i] >> 13);
+            if (!used[g])
+                code[g] = hi;
+            mask[g] |= (uint16_t)(hi ^ code[g]);
+            used[g] = true;
+        }
+        if (!used[1])
+        {
+            code[1] = code[0];
+            mask[1] = mask[0];
+        }
+
+        uint32_t groups = (1U << canPopcount(mask[0])) + (1U << canPopcount(mask[1]));
+        if (((code[0] ^ code[1]) & ~mask[0] & ~mask[1]) == 0)
+            groups -= 1U << canPopcount(mask[0] & mask[1]); // overlap counted once
+        const uint32_t accepted = groups << 13;
+        if (accepted < best.acceptedIds)
+            best = {((uint32_t)code[0] << 16) | code[1], ((uint32_t)mask[0] << 16) | mask[1], false, accepted};
+    }
+    return best;
+}
+
+template <size_t N>
+constexpr bool canIdListContains(const uint32_t (&ids)[N], uint32_t id)
+{
+    for (size_t i = 0; i < N; i++)
+    {
+        if (ids[i] == id)
+            return true;
+    }
+    return false;
+}
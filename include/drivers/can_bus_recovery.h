@@ -0,0 +1,119 @@
+#pragma once
+
+/**
+ * @file can_bus_recovery.h
+ * @brief CAN1 bus-off recovery state machine driven by TWAI alerts
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * A bus-off is recovered in place with twai_initiate_recovery(): the
+ * controller waits for 128 x 11 recessive bits (5.6 ms at 250 kbit/s),
+ * reports TWAI_ALERT_BUS_RECOVERED and is restarted with twai_start().
+ * The driver stays installed, so the RX ring, the acceptance filter and
+ * the CAN_TX safety lane survive the outage.
+ *
+ * The first bus-off is recovered immediately. A bus-off within
+ * CAN1_BUSOFF_STABLE_MS of the previous recovery waits a backoff that
+ * doubles from CAN1_BUSOFF_BACKOFF_MIN_MS up to CAN1_BUSOFF_BACKOFF_MAX_MS,
+ * so a node that keeps destroying the bus does not monopolise it.
+ *
+ * The controller state read back after every alert wait is authoritative:
+ * a missed BUS_OFF / BUS_RECOVERED alert or a stopped controller is picked
+ * up from twai_get_status_info().
+ */
+
+#include <stdint.h>
+#include <driver/twai.h>
+#include "../config/timing.h"
+
+// Alerts the recovery consumes (enabled in the TWAI general config)
+#define CAN1_RECOVERY_ALERTS                                                                  \
+    (TWAI_ALERT_BUS_OFF | TWAI_ALERT_BUS_RECOVERED | TWAI_ALERT_RECOVERY_IN_PROGRESS |        \
+     TWAI_ALERT_ERR_PASS | TWAI_ALERT_ERR_ACTIVE | TWAI_ALERT_ABOVE_ERR_WARN | TWAI_ALERT_BELOW_ERR_WARN)
+
+// Time-to-recover histogram bucket upper bounds (milliseconds); last bucket is open-ended
+#define CAN_RECOVERY_BUCKETS 10
+inline constexpr uint32_t CAN_RECOVERY_EDGES_MS[CAN_RECOVERY_BUCKETS - 1] = {2, 5, 10, 20, 50, 100, 200, 500, 1000};
+
+/// Outage durations (fault detected -> controller running again)
+struct CanRecoveryHistogram
+{
+    uint32_t buckets[CAN_RECOVERY_BUCKETS];
+    uint32_t samples;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+
+    void record(uint32_t us);
+};
+
+enum CanRecoveryState : uint8_t
+{
+    CAN_REC_RUNNING,    // controller running (error-active or -passive)
+    CAN_REC_BACKOFF,    // bus-off, waiting before twai_initiate_recovery()
+    CAN_REC_RECOVERING, // waiting for TWAI_ALERT_BUS_RECOVERED
+    CAN_REC_RESTART     // stopped, twai_start() due
+};
+
+enum CanRecoveryAction : uint8_t
+{
+    CAN_REC_NONE,
+    CAN_REC_INITIATE, // call twai_initiate_recovery()
+    CAN_REC_START     // call twai_start()
+};
+
+struct CanBusOffStats
+{
+    uint32_t busOffs;
+    uint32_t recoveries;
+    uint32_t stopped;       // found stopped without a bus-off
+    uint32_t errorPassive;  // TWAI_ALERT_ERR_PASS while running
+    uint32_t errorWarnings; // TWAI_ALERT_ABOVE_ERR_WARN
+    uint32_t actionFailures;
+    uint32_t backoffMs; // applied to the latest bus-off
+    CanRecoveryHistogram recovery;
+};
+
+/// Recovery decisions, independent of tasks and clocks (used directly by the bench)
+class CanBusOffRecovery
+{
+public:
+    CanBusOffRecovery() { reset(); }
+
+    /// Alerts returned by twai_read_alerts()
+    void onAlerts(uint32_t alerts, uint64_t nowUs);
+
+    /// Controller state from twai_get_status_info()
+    void onState(twai_state_t state, uint64_t nowUs);
+
+    /// Driver call due now, if any
+    CanRecoveryAction next(uint64_t nowUs) const;
+
+    /// Outcome of the action returned by next()
+    void complete(CanRecoveryAction action, bool ok, uint64_t nowUs);
+
+    /// Microseconds until next() has an action, UINT32_MAX when waiting for an alert
+    uint32_t waitUs(uint64_t nowUs) const;
+
+    CanRecoveryState state() const { return state_; }
+    bool errorPassive() const { return errorPassive_; }
+
+    /// Start of the current outage (valid while state() != CAN_REC_RUNNING)
+    uint64_t downSinceUs() const { return downSinceUs_; }
+
+    const CanBusOffStats &stats() const { return stats_; }
+    void resetStats();
+    void reset();
+
+private:
+    void enterBusOff(uint64_t nowUs);
+
+    CanRecoveryState state_;
+    bool errorPassive_;
+    bool recoveredOnce_;
+    uint32_t backoffMs_;
+    uint64_t downSinceUs_;
+    uint64_t actionAtUs_;
+    uint64_t recoveredUs_;
+    CanBusOffStats stats_;
+};
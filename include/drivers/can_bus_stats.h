@@ -0,0 +1,89 @@
+#pragma once
+
+/**
+ * @file can_bus_stats.h
+ * @brief Per-bus load and per-ID timing statistics for CAN1 / CAN2
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * Every frame decoded by the dispatcher and every frame a driver transmits
+ * is counted with its worst-case bit length (canFrameBits), giving frames/s,
+ * bits/s and load over CAN_STATS_WINDOW_MS windows plus the peak window.
+ *
+ * Each CAN id seen on a bus gets a slot with its inter-arrival times, taken
+ * from the frame's RX timestamp: min / mean / max, and the jitter as the
+ * p99 of |interval - running mean| from a log-linear histogram (4
+ * sub-buckets per octave), so a 100 ms frame with a few ms of jitter is
+ * resolved to a fraction of a millisecond.
+ * Ring drops and controller overruns are read from the drivers when a
+ * snapshot is taken.
+ */
+
+#include <stdint.h>
+#include "can_dispatcher.h"
+#include "../config/timing.h"
+
+#define CAN_STATS_MAX_IDS 12      // tracked ids per bus; further ids only count in the totals
+#define CAN_STATS_HIST_BUCKETS 82 // < 16 us, 20 octaves x 4 up to ~16.7 s, overflow
+
+/// Worst-case bits on the wire for one data frame (stuffing + 3 bit IFS)
+constexpr uint32_t canFrameBits(uint8_t dlc, bool extended)
+{
+    return extended ? 67U + 8U * dlc + (54U + 8U * dlc - 1U) / 4U
+                    : 47U + 8U * dlc + (34U + 8U * dlc - 1U) / 4U;
+}
+
+/// Inter-arrival statistics of one CAN id
+struct CanIdStats
+{
+    uint32_t id;
+    bool extended;
+    bool tx;              // transmitted by us
+    uint32_t frames;
+    uint32_t minUs;       // inter-arrival, 0 until two frames were seen
+    uint32_t maxUs;
+    uint32_t meanUs;
+    uint32_t jitterP99Us; // p99 of |interval - mean| (bucket upper edge)
+    uint32_t p99Us;       // mean + jitterP99Us, capped at maxUs
+};
+
+/// Load and health of one bus
+struct CanBusStats
+{
+    uint32_t rxFrames;
+    uint32_t txFrames;
+    uint64_t bits;             // rx + tx, worst-case stuffing
+    float framesPerSec;        // last complete window
+    float bitsPerSec;
+    float loadPercent;
+    float peakLoadPercent;     // busiest window since reset
+    uint32_t ringDrops;        // driver RX ring full
+    uint32_t controllerMissed; // TWAI: rx_missed_count / MCP2515: RX0OVR + RX1OVR
+    uint32_t rx0Overruns;      // MCP2515 only
+    uint32_t rx1Overruns;      // MCP2515 only
+    uint32_t rejected;         // CAN1: passed the hardware filter, dropped in software
+    uint32_t untracked;        // frames of ids beyond CAN_STATS_MAX_IDS
+    uint8_t idCount;
+    CanIdStats ids[CAN_STATS_MAX_IDS];
+};
+
+namespace CAN_STATS
+{
+    /// Frame received (dispatcher); t_us is its RX timestamp (low 32 bits, micros() domain)
+    void onRx(CanBus bus, uint32_t id, uint8_t dlc, bool extended, uint32_t t_us);
+
+    /// Frame transmitted successfully (driver send path)
+    void onTx(CanBus bus, uint32_t id, uint8_t dlc, bool extended);
+
+    /// Consistent copy of one bus, with driver drop counters filled in
+    void snapshot(CanBus bus, CanBusStats &out);
+
+    /// Load of the last complete window and the peak since reset (percent)
+    void busLoad(CanBus bus, float &loadPercent, float &peakPercent);
+
+    void reset();
+
+    /// Print both buses to Serial
+    void print();
+
+} // namespace CAN_STATS
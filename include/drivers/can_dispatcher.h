@@ -0,0 +1,84 @@
+#pragma once
+
+/**
+ * @file can_dispatcher.h
+ * @brief Event-driven CAN RX dispatcher (driver rings → decoders)
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * The RX tasks push frames into their driver ring and notify the dispatcher
+ * task, which drains both rings and runs the decoders immediately instead of
+ * waiting for the next charger control cycle. RX → decode latency is tracked
+ * per bus in a fixed-bucket histogram.
+ *
+ * Frames are popped a burst of 8 at a time and the decoders get a const
+ * CanMessage& into that burst, without converting it to another type.
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+
+struct CanMessage;
+
+// Latency histogram bucket upper bounds (microseconds); last bucket is open-ended
+#define CAN_LATENCY_BUCKETS 12
+
+enum CanBus : uint8_t
+{
+    CAN_BUS_CHARGER = 0, // CAN1 - TWAI
+    CAN_BUS_BMS = 1,     // CAN2 - MCP2515
+    CAN_BUS_COUNT = 2
+};
+
+/// RX timestamp → decode complete latency statistics for one bus
+struct CanLatencyStats
+{
+    uint32_t buckets[CAN_LATENCY_BUCKETS];
+    uint32_t samples;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+};
+
+namespace CAN_DISPATCH
+{
+    /**
+     * @brief Wake the dispatcher after a frame was pushed (task context)
+     */
+    void notify();
+
+    /**
+     * @brief Wake the dispatcher from an ISR
+     * @param[out] woken Set to pdTRUE if a context switch is required
+     */
+    void notifyFromISR(BaseType_t *woken);
+
+    /**
+     * @brief Run the decoder for one frame (no latency accounting)
+     * Used by the dispatcher task and by the native trace replay.
+     * @param bus Bus the frame was received on
+     * @param frame Received frame
+     */
+    void dispatchFrame(CanBus bus, const CanMessage &frame);
+
+    /**
+     * @brief Get latency statistics for one bus
+     * @param bus Bus index
+     * @return Copy of the current statistics
+     */
+    CanLatencyStats getLatencyStats(CanBus bus);
+
+    /**
+     * @brief Clear latency statistics for both buses
+     */
+    void resetLatencyStats();
+
+    /**
+     * @brief Print latency histograms for both buses to Serial
+     */
+    void printLatencyHistogram();
+
+} // namespace CAN_DISPATCH
+
+// Dispatcher task (drains CAN1/CAN2 rings on notification)
+void canDispatchTask(void *arg);
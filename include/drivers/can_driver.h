@@ -21,8 +21,6 @@
 
 // ========== DATA STRUCTURES ==========
 
-// RxBufItem is defined in header.h for backward compatibility
-
 /// CAN driver status
 struct CanStatus
 {
@@ -0,0 +1,30 @@
+#pragma once
+
+/**
+ * @file can_frame.h
+ * @brief Received CAN frame shared by both drivers, the dispatcher and the decoders
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * The RX tasks write CanMessage straight into their driver ring. The
+ * dispatcher drains it in bursts (receiveMessages) and hands the decoders
+ * a const reference to each frame, with no conversion to another type.
+ *
+ * timestamp_us is the 64-bit esp_timer_get_time() of the reception (the
+ * MCP2515 INT edge for CAN2, twai_receive() return for CAN1). It travels
+ * with the frame through the dispatcher into TELEMETRY::stamp(), so signal
+ * ages and rates are measured from RX time, not from when a task got to
+ * decode the frame. The low 32 bits equal micros() at that instant.
+ */
+
+#include <stdint.h>
+
+// Unified CAN message structure (hardware-agnostic)
+struct CanMessage
+{
+    uint32_t id;
+    uint8_t dlc;
+    uint8_t data[8];
+    bool extended;
+    uint64_t timestamp_us; // esp_timer_get_time() at RX (never wraps)
+};
@@ -11,19 +11,8 @@
 #include <mcp2515.h>
 #include <stdint.h>
 #include "../../include/header.h"
-
-#ifndef CAN_MESSAGE_STRUCT
-#define CAN_MESSAGE_STRUCT
-// Unified CAN message structure (hardware-agnostic)
-struct CanMessage
-{
-    uint32_t id;
-    uint8_t dlc;
-    uint8_t data[8];
-    bool extended;
-    uint32_t timestamp_ms;
-};
-#endif
+#include "can_frame.h"
+#include "can_bus_recovery.h"
 
 // Driver status
 struct CanMcp2515Status
@@ -34,6 +23,32 @@ struct CanMcp2515Status
     uint32_t total_tx_messages;
     uint32_t error_count;
     uint32_t last_activity_ms;
+    uint32_t rx_overflows; // Frames dropped because the RX ring was full
+    uint32_t rx0_overruns; // EFLG.RX0OVR events (frame lost in the chip)
+    uint32_t rx1_overruns; // EFLG.RX1OVR events
+    uint32_t mailbox_sends;    // TXB2 periodic frames requested
+    uint32_t mailbox_loads;    // ... that needed changed bytes written first
+    uint32_t mailbox_aborts;   // pending TXB2 request aborted before a load
+    uint32_t mailbox_spi_us;   // SPI bus time used by the mailbox
+    uint32_t mailbox_saved_us; // vs one library sendMessage() per period
+    uint32_t mailbox_saved_us_per_min;
+};
+
+// Error recovery paths, cheapest first
+enum Mcp2515RecoveryPath : uint8_t
+{
+    MCP_REC_PASSIVE,     // error-passive: clear ERRIF, keep receiving
+    MCP_REC_MODE_TOGGLE, // bus-off: configuration mode and back (clears TEC / REC)
+    MCP_REC_REINIT,      // bitrate, filters and masks reprogrammed
+    MCP_REC_PATHS
+};
+
+struct CanMcp2515RecoveryStats
+{
+    uint32_t runs[MCP_REC_PATHS];
+    uint32_t failures[MCP_REC_PATHS]; // did not clear the error (next path taken)
+    // Error seen -> error-active again (passive) or controller back in normal mode
+    CanRecoveryHistogram time[MCP_REC_PATHS];
 };
 
 namespace CAN_MCP2515
@@ -66,6 +81,19 @@ namespace CAN_MCP2515
      */
     bool sendMessage(uint32_t id, const uint8_t *data, uint8_t length, bool is_extended = true);
 
+    /**
+     * @brief Set the payload of the periodic TXB2 frame (no SPI access)
+     * The first call (or a new id / length / period) configures the frame;
+     * the CAN2 task then sends the latest payload every periodMs, writing
+     * only the bytes that changed since the last send.
+     * @param id CAN message ID
+     * @param data Payload (0-8 bytes)
+     * @param length Payload length
+     * @param is_extended true for 29-bit ID, false for 11-bit ID
+     * @param periodMs Transmit period
+     */
+    void updateMailbox(uint32_t id, const uint8_t *data, uint8_t length, bool is_extended, uint32_t periodMs);
+
     /**
      * @brief Receive CAN message (non-blocking)
      * @param[out] msg Pointer to CanMessage structure to fill
@@ -74,11 +102,12 @@ namespace CAN_MCP2515
     bool receiveMessage(CanMessage *msg);
 
     /**
-     * @brief Pop frame from buffer (legacy compatibility)
-     * @param[out] out RxBufItem structure
-     * @return true if message available
+     * @brief Receive a burst of CAN messages (non-blocking)
+     * @param[out] msgs Destination array
+     * @param max Capacity of msgs
+     * @return Number of messages received (0 if queue empty)
      */
-    bool popFrame(RxBufItem &out);
+    size_t receiveMessages(CanMessage *msgs, size_t max);
 
     /**
      * @brief Get driver status
@@ -108,4 +137,29 @@ namespace CAN_MCP2515
      */
     bool isHealthy();
 
+    /**
+     * @brief Drain RXB0/RXB1 into the RX ring until INT deasserts, check
+     *        EFLG when due and recover from error states in place
+     *        (CAN2 RX task, recovery mutex held)
+     * Error-passive keeps receiving; bus-off toggles configuration mode; the
+     * full reconfiguration is left for a toggle that fails and for
+     * CAN2_REINIT_AFTER_BUSOFFS bus-offs within CAN2_BUSOFF_WINDOW_MS.
+     * @return EFLG error-state bits seen (TXBO / TXEP / RXEP), 0 if none
+     */
+    uint8_t serviceRx();
+
+    /**
+     * @brief Send the TXB2 mailbox frame if due (CAN2 RX task, recovery mutex held)
+     * @return Milliseconds until the next send (CAN2_EFLG_POLL_MS if unused)
+     */
+    uint32_t serviceMailbox();
+
+    CanMcp2515RecoveryStats getRecoveryStats();
+    void resetRecoveryStats();
+
+    /**
+     * @brief Print per-path recovery counters and time-to-recover histograms
+     */
+    void printRecoveryStats();
+
 } // namespace CAN_MCP2515
@@ -0,0 +1,197 @@
+#pragma once
+
+/**
+ * @file can_signal_table.h
+ * @brief Compile-time CAN signal table with a perfect-hash lookup
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * Each entry describes one (CAN id, function code) message: up to two
+ * numeric fields (byte offset, encoding, scale, target variable), an
+ * optional raw-payload capture buffer, an optional hook for effects that
+ * are not a plain scaled store (status strings, plug detection), and the
+ * TelemetrySignal stamped with the frame's RX time.
+ *
+ * CanSignalIndex is built by a constexpr search. A per-id "has function
+ * code" bit is read from a 32-bit mask by a few id bits, so broadcasts
+ * (CAN_FUNC_NONE) key on the id alone without touching memory; then a
+ * multiplicative hash with no collisions over the table's (id, code) keys
+ * gives one multiply, one shift and one indexed load. Only a coded frame
+ * with an unknown code takes a second probe, for its CAN_FUNC_ANY entry.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "../config/timing.h"
+#include "../core/telemetry.h"
+
+#define CAN_FUNC_NONE 0xFF // broadcast, data[1] is not a function code
+#define CAN_FUNC_ANY 0xFE  // catch-all for codes without their own entry
+
+#if CAN_DECODE_CAPTURE_RAW
+#define CAN_RAW(buf) (buf)
+#else
+#define CAN_RAW(buf) nullptr
+#endif
+
+enum class CanFieldEnc : uint8_t
+{
+    NONE,
+    U16_BE,
+    U32_BE,
+    F32_BE
+};
+
+struct CanField
+{
+    CanFieldEnc enc;
+    uint8_t offset;
+    float scale; // integer encodings only; F32_BE is stored as-is
+    float *target;
+};
+
+typedef void (*CanSignalHook)(const uint8_t *data);
+
+struct CanSignal
+{
+    uint32_t id;
+    uint8_t func;     // data[1] function code, CAN_FUNC_NONE if the frame has none
+    uint8_t min_dlc;
+    CanField field[2];
+    uint8_t *raw;       // 8-byte raw payload capture (nullptr = off)
+    CanSignalHook hook; // runs after the fields, nullptr = none
+    TelemetrySignal signal; // stamped with CanMessage::timestamp_us before the hook, TSIG_COUNT = none
+};
+
+template <unsigned BITS>
+struct CanSignalIndex
+{
+    static constexpr size_t SLOTS = (size_t)1 << BITS;
+
+    uint32_t mult;       // 0 = no usable index found
+    uint32_t codedMask;  // bit (id >> codedShift) & 31 set: the id's frames carry a function code
+    uint8_t codedShift;
+    uint8_t slot[SLOTS]; // table index + 1, 0 = empty
+
+    constexpr bool coded(uint32_t id) const
+    {
+        return (codedMask >> ((id >> codedShift) & 31)) & 1;
+    }
+
+    constexpr uint32_t hash(uint32_t id, uint8_t func) const
+    {
+        return ((id ^ ((uint32_t)func << 24)) * mult) >> (32 - BITS);
+    }
+};
+
+/// Codes are distinct per id and a broadcast id has no other entries
+template <size_t N>
+constexpr bool canSignalKeysValid(const CanSignal (&table)[N])
+{
+    for (size_t i = 0; i < N; i++)
+    {
+        for (size_t j = i + 1; j < N; j++)
+        {
+            if (table[j].id != table[i].id)
+                continue;
+            if (table[i].func == table[j].func || table[i].func == CAN_FUNC_NONE || table[j].func == CAN_FUNC_NONE)
+                return false;
+        }
+    }
+    return true;
+}
+
+/// Pick the id bits that tell coded from broadcast ids, then a multiplier
+/// that maps every (id, code) key of `table` to its own slot
+template <unsigned BITS, size_t N>
+constexpr CanSignalIndex<BITS> buildCanSignalIndex(const CanSignal (&table)[N])
+{
+    static_assert(N < CanSignalIndex<BITS>::SLOTS, "signal table too large for index");
+    if (!canSignalKeysValid(table))
+        return CanSignalIndex<BITS>{};
+
+    CanSignalIndex<BITS> idx{};
+    bool split = false;
+    for (uint8_t shift = 0; shift < 28 && !split; shift++)
+    {
+        uint32_t coded = 0, plain = 0;
+        for (size_t i = 0; i < N; i++)
+        {
+            const uint32_t bit = 1UL << ((table[i].id >> shift) & 31);
+            (table[i].func == CAN_FUNC_NONE ? plain : coded) |= bit;
+        }
+        if ((coded & plain) == 0)
+        {
+            idx.codedShift = shift;
+            idx.codedMask = coded;
+            split = true;
+        }
+    }
+    if (!split)
+        return CanSignalIndex<BITS>{};
+
+    for (uint32_t attempt = 0; attempt < 4096; attempt++)
+    {
+        for (size_t s = 0; s < CanSignalIndex<BITS>::SLOTS; s++)
+            idx.slot[s] = 0;
+        idx.mult = (uint32_t)(0x9E3779B9UL * (2 * attempt + 1)); // odd multipliers only
+        bool ok = true;
+        for (size_t i = 0; i < N && ok; i++)
+        {
+            const uint32_t s = idx.hash(table[i].id, table[i].func);
+            if (idx.slot[s] != 0)
+                ok = false;
+            else
+                idx.slot[s] = (uint8_t)(i + 1);
+        }
+        if (ok)
+            return idx;
+    }
+    return CanSignalIndex<BITS>{};
+}
+
+template <unsigned BITS, size_t N>
+inline const CanSignal *probeCanSignal(const CanSignal (&table)[N], const CanSignalIndex<BITS> &idx,
+                                       uint32_t id, uint8_t func)
+{
+    const uint8_t i = idx.slot[idx.hash(id, func)];
+    if (i == 0)
+        return nullptr;
+    const CanSignal &s = table[i - 1];
+    return (s.id == id && s.func == func) ? &s : nullptr;
+}
+
+/// One probe; an unknown code on a coded id falls back to its CAN_FUNC_ANY entry
+template <unsigned BITS, size_t N>
+inline const CanSignal *findCanSignal(const CanSignal (&table)[N], const CanSignalIndex<BITS> &idx,
+                                      uint32_t id, uint8_t func)
+{
+    if (!idx.coded(id))
+        return probeCanSignal(table, idx, id, CAN_FUNC_NONE);
+    const CanSignal *s = probeCanSignal(table, idx, id, func);
+    return s ? s : probeCanSignal(table, idx, id, CAN_FUNC_ANY);
+}
+
+inline float canFieldValue(const CanField &f, const uint8_t *data)
+{
+    const uint8_t *b = data + f.offset;
+    switch (f.enc)
+    {
+    case CanFieldEnc::U16_BE:
+        return (float)(((uint16_t)b[0] << 8) | b[1]) * f.scale;
+    case CanFieldEnc::U32_BE:
+        return (float)(((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) |
+                       ((uint32_t)b[2] << 8) | (uint32_t)b[3]) *
+               f.scale;
+    case CanFieldEnc::F32_BE:
+    {
+        const uint8_t tmp[4] = {b[3], b[2], b[1], b[0]};
+        float v;
+        memcpy(&v, tmp, sizeof(v));
+        return v; // already in engineering units, scale unused
+    }
+    default:
+        return 0.0f;
+    }
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+/**
+ * @file can_trace.h
+ * @brief CAN flight recorder: compact binary trace of every received frame
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * Both RX tasks append each frame to a RAM ring (oldest records are
+ * overwritten). The ring can be dumped over Serial on demand or streamed
+ * live for long captures; scripts/cantrace.py turns the serial log into a
+ * .cantrace file that the native build replays with `program replay`.
+ *
+ * Record layout (16 bytes, little-endian):
+ *   word0  bits 0-27 timestamp_ms (wraps after ~74 h), bits 28-31 dlc
+ *   word1  bits 0-28 CAN id, bit 29 extended, bit 30 bus (0 = charger, 1 = BMS)
+ *   data[8]
+ */
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "can_dispatcher.h"
+#include "can_twai_driver.h"
+
+#ifndef CAN_TRACE_CAPACITY
+#define CAN_TRACE_CAPACITY 1024 // records (16 KB), must be a power of two
+#endif
+
+#define CAN_TRACE_FILE_MAGIC 0x43525443UL // "CTRC"
+#define CAN_TRACE_VERSION 1
+
+struct CanTraceRecord
+{
+    uint32_t time_dlc;
+    uint32_t id_flags;
+    uint8_t data[8];
+};
+static_assert(sizeof(CanTraceRecord) == 16, "CanTraceRecord must stay 16 bytes");
+
+/// .cantrace file header, followed by record_count records
+struct CanTraceFileHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t record_count;
+    uint32_t dropped;
+};
+static_assert(sizeof(CanTraceFileHeader) == 16, "CanTraceFileHeader must stay 16 bytes");
+
+namespace CAN_TRACE
+{
+    inline CanTraceRecord pack(CanBus bus, const CanMessage &msg)
+    {
+        CanTraceRecord r;
+        const uint8_t dlc = msg.dlc > 8 ? 8 : msg.dlc;
+        r.time_dlc = ((uint32_t)(msg.timestamp_us / 1000) & 0x0FFFFFFFUL) | ((uint32_t)dlc << 28);
+        r.id_flags = (msg.id & 0x1FFFFFFFUL) |
+                     (msg.extended ? (1UL << 29) : 0) |
+                     (bus == CAN_BUS_BMS ? (1UL << 30) : 0);
+        memcpy(r.data, msg.data, 8);
+        return r;
+    }
+
+    inline CanBus unpack(const CanTraceRecord &r, CanMessage &msg)
+    {
+        msg.id = r.id_flags & 0x1FFFFFFFUL;
+        msg.extended = (r.id_flags >> 29) & 1;
+        msg.dlc = (uint8_t)(r.time_dlc >> 28);
+        memcpy(msg.data, r.data, 8);
+        msg.timestamp_us = (uint64_t)(r.time_dlc & 0x0FFFFFFFUL) * 1000ULL; // wrapped, see replay
+        return ((r.id_flags >> 30) & 1) ? CAN_BUS_BMS : CAN_BUS_CHARGER;
+    }
+
+    /**
+     * @brief Append one received frame (called from the RX tasks)
+     * No-op while recording is disabled.
+     */
+    void record(CanBus bus, const CanMessage &msg);
+
+    /**
+     * @brief Enable / disable recording (enabled at boot)
+     */
+    void setEnabled(bool enabled);
+    bool isEnabled();
+
+    /**
+     * @brief Total frames recorded since boot / last clear
+     */
+    uint32_t recordedCount();
+
+    /**
+     * @brief Copy the newest records, oldest first
+     * @param out Destination
+     * @param max Capacity of out
+     * @return Number of records copied
+     */
+    size_t snapshot(CanTraceRecord *out, size_t max);
+
+    /**
+     * @brief Drop all records
+     */
+    void clear();
+
+    /**
+     * @brief Print the ring contents to Serial as hex lines ("T <32 hex>")
+     * Recording is paused while the dump runs.
+     */
+    void dump();
+
+    /**
+     * @brief Live streaming: every new record is printed by pollStream()
+     */
+    void setStreaming(bool enabled);
+    bool isStreaming();
+
+    /**
+     * @brief Print records recorded since the last call (UI task, ~100 ms)
+     */
+    void pollStream();
+
+} // namespace CAN_TRACE
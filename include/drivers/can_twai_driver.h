@@ -11,19 +11,12 @@
 #include <driver/twai.h>
 #include <stdint.h>
 #include "../../include/header.h"
+#include "can_frame.h"
+#include "can_bus_recovery.h"
 
-#ifndef CAN_MESSAGE_STRUCT
-#define CAN_MESSAGE_STRUCT
-// Unified CAN message structure (hardware-agnostic)
-struct CanMessage
-{
-    uint32_t id;
-    uint8_t dlc;
-    uint8_t data[8];
-    bool extended;
-    uint32_t timestamp_ms;
-};
-#endif
+// Ids consumed by the charger decoders (signal table in charger_interface.cpp).
+// The TWAI acceptance filter and the software check behind it are built from this list.
+inline constexpr uint32_t CAN1_RX_IDS[] = {ID_CTRL_RESP, ID_TELEM_RESP, ID_TERM_POWER, ID_TERM_STATUS, ID_HEARTBEAT};
 
 // Driver status
 struct CanTwaiStatus
@@ -34,6 +27,8 @@ struct CanTwaiStatus
     uint32_t total_tx_messages;
     uint32_t error_count;
     uint32_t last_activity_ms;
+    uint32_t rx_overflows; // Frames dropped because the RX ring was full
+    uint32_t rx_rejected;  // Passed the hardware filter but not in CAN1_RX_IDS
 };
 
 namespace CAN_TWAI
@@ -66,6 +61,17 @@ namespace CAN_TWAI
      */
     bool sendMessage(uint32_t id, const uint8_t *data, uint8_t length, bool is_extended = true);
 
+    /**
+     * @brief Hand a frame to the controller without waiting (can1_tx_task)
+     * @param id CAN message ID
+     * @param data Pointer to data buffer (0-8 bytes)
+     * @param length Data length (0-8)
+     * @param is_extended true for 29-bit ID, false for 11-bit ID
+     * @return ESP_OK, ESP_ERR_TIMEOUT / ESP_FAIL if the controller queue is full,
+     *         ESP_ERR_INVALID_STATE if the controller is stopped or bus-off
+     */
+    esp_err_t transmit(uint32_t id, const uint8_t *data, uint8_t length, bool is_extended = true);
+
     /**
      * @brief Receive CAN message (non-blocking)
      * @param[out] msg Pointer to CanMessage structure to fill
@@ -74,11 +80,12 @@ namespace CAN_TWAI
     bool receiveMessage(CanMessage *msg);
 
     /**
-     * @brief Pop frame from buffer (legacy compatibility)
-     * @param[out] out RxBufItem structure
-     * @return true if message available
+     * @brief Receive a burst of CAN messages (non-blocking)
+     * @param[out] msgs Destination array
+     * @param max Capacity of msgs
+     * @return Number of messages received (0 if queue empty)
      */
-    bool popFrame(RxBufItem &out);
+    size_t receiveMessages(CanMessage *msgs, size_t max);
 
     /**
      * @brief Get driver status
@@ -108,4 +115,38 @@ namespace CAN_TWAI
      */
     bool isHealthy();
 
+    /**
+     * @brief Software acceptance check behind the hardware filter
+     * @param id CAN identifier
+     * @param extended true for a 29-bit identifier
+     * @return true if the frame is one the charger decoders consume
+     */
+    bool acceptsFrame(uint32_t id, bool extended);
+
+    /**
+     * @brief One pass of the bus-off recovery (CAN1 alert task)
+     * Waits up to waitMs for TWAI alerts, reads the controller state back
+     * and issues the twai_initiate_recovery() / twai_start() that is due.
+     * @param waitMs Alert wait (0 = poll)
+     * @return Milliseconds the next pass may wait
+     */
+    uint32_t serviceRecovery(uint32_t waitMs);
+
+    /**
+     * @brief Recovery state
+     * @param[out] downMs Optional: length of the current outage (0 while running)
+     */
+    CanRecoveryState recoveryState(uint32_t *downMs = nullptr);
+
+    CanBusOffStats getRecoveryStats();
+    void resetRecoveryStats();
+
+    /**
+     * @brief Print bus-off / error-passive counters and the recovery histogram
+     */
+    void printRecoveryStats();
+
 } // namespace CAN_TWAI
+
+// CAN1 alert task (bus-off recovery without a driver reinstall)
+void can1_alert_task(void *arg);
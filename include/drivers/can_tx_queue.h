@@ -0,0 +1,172 @@
+#pragma once
+
+/**
+ * @file can_tx_queue.h
+ * @brief Non-blocking CAN1 transmit queue with priority lanes
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * Senders (chargerCommTask, console) only enqueue; can1_tx_task moves the
+ * frames to the TWAI controller, whose own queue is one frame deep. The
+ * safety lane (charge start/stop commands) is always drained before the
+ * periodic lane (polls), so a command waits behind at most the frame the
+ * controller is already sending instead of a backlog of polls.
+ *
+ * A frame with a coalescing key replaces a pending frame of the same lane,
+ * id and key in place (its queue position and age are kept): a poll that
+ * could not go out yet is superseded by the next one rather than queued
+ * twice, and a newer start/stop command replaces an unsent older one.
+ * The frame handed to the controller stays at the head of its lane until
+ * complete() names it by its token: it is never coalesced into (a newer
+ * frame with its key queues behind it), and frames that arrive meanwhile,
+ * e.g. a safety command during a poll, are not popped in its place.
+ * When the controller is down the periodic lane is flushed, safety frames
+ * stay queued until they are sent or superseded.
+ *
+ * A frame handed to the controller is not yet on the wire: its lane is
+ * remembered in handover order, and onController() (alert task, on
+ * TWAI_ALERT_TX_SUCCESS / TX_FAILED) retires the frames the controller has
+ * finished as delivered, or as lost when they failed or a bus-off
+ * discarded them.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <driver/twai.h>
+#include "../config/timing.h"
+
+#define CAN_TX_LANE_DEPTH 8
+#define CAN_TX_NO_COALESCE 0xFFFF
+#define CAN_TX_WIRE_DEPTH (CAN1_TX_CONTROLLER_QUEUE + 2) // controller queue + TX buffer + one handover in the race window
+
+// Alerts that wake can1_alert_task to account TX completions (enabled in the TWAI general config)
+#define CAN1_TX_ALERTS (TWAI_ALERT_TX_SUCCESS | TWAI_ALERT_TX_FAILED)
+
+enum CanTxLane : uint8_t
+{
+    CAN_TX_SAFETY = 0,   // commands, drained first
+    CAN_TX_PERIODIC = 1, // polls
+    CAN_TX_LANES = 2
+};
+
+struct CanTxFrame
+{
+    uint32_t id;
+    uint8_t dlc;
+    uint8_t data[8];
+    bool extended;
+    uint16_t key;      // CAN_TX_NO_COALESCE or e.g. the function code
+    uint32_t queuedUs; // enqueue time of the first frame in this slot
+    uint32_t seq;      // set by enqueue(), renewed when coalesced into
+};
+
+/// Names the frame front() handed out, for complete()
+struct CanTxToken
+{
+    uint8_t lane;
+    uint8_t slot;
+    uint32_t seq;
+};
+
+/// Per-lane accounting
+struct CanTxLaneStats
+{
+    uint32_t queued;    // frames accepted by enqueue()
+    uint32_t coalesced; // replaced a pending frame instead of queueing
+    uint32_t dropped;   // lane full
+    uint32_t handed;    // accepted into the controller's TX queue
+    uint32_t delivered; // handed and then sent on the wire (TX_SUCCESS)
+    uint32_t lost;      // handed and then failed or discarded by a bus-off
+    uint32_t flushed;   // never handed: dropped while the controller was down
+    uint32_t maxWaitUs; // enqueue -> controller, worst case
+    uint64_t totalWaitUs;
+    uint8_t depth;
+    uint8_t peakDepth;
+};
+
+/// Two-lane queue, independent of tasks and clocks (used directly by the bench)
+class CanTxQueue
+{
+public:
+    CanTxQueue() { clear(); }
+
+    /// Queue or coalesce a frame; false if its lane is full
+    bool enqueue(CanTxLane lane, const CanTxFrame &frame, uint32_t nowUs);
+
+    /// Copy the next frame for the controller (safety lane first) and mark it in flight
+    bool front(CanTxFrame &out, CanTxToken &token);
+
+    /// Outcome for the frame front() returned: handed removes it, else it is kept for a retry
+    void complete(const CanTxToken &token, bool handed, uint32_t nowUs);
+
+    /// Drop every queued frame of one lane, counted as flushed
+    void flush(CanTxLane lane);
+
+    /// Frames handed to the controller so far; snapshot it before reading the controller status
+    uint32_t handedCount() const { return handed_; }
+
+    /**
+     * @brief Retire the frames the controller has finished, oldest first
+     * @param handedBefore handedCount() taken before the status was read
+     * @param pending Frames still in the controller (twai_status_info_t::msgs_to_tx)
+     * @param failedTotal Its cumulative tx_failed_count, charged to the oldest frames
+     * @param running false once stopped or bus-off: everything it held is lost
+     */
+    void onController(uint32_t handedBefore, uint32_t pending, uint32_t failedTotal, bool running);
+
+    bool empty() const { return lanes_[CAN_TX_SAFETY].count == 0 && lanes_[CAN_TX_PERIODIC].count == 0; }
+
+    void stats(CanTxLane lane, CanTxLaneStats &out) const;
+    void resetStats();
+    void clear();
+
+private:
+    struct Lane
+    {
+        CanTxFrame slots[CAN_TX_LANE_DEPTH];
+        uint8_t head;
+        uint8_t count;
+        uint32_t inFlightSeq; // seq of the head frame while the controller has it, else 0
+        CanTxLaneStats stats;
+    };
+
+    void pop(Lane &l);
+    void retire(bool delivered);
+
+    Lane lanes_[CAN_TX_LANES];
+    uint32_t nextSeq_;
+    uint8_t wire_[CAN_TX_WIRE_DEPTH]; // lane of each frame the controller holds, by handover count
+    uint32_t handed_;
+    uint32_t retired_;
+    uint32_t failedSeen_; // controller tx_failed_count already charged
+};
+
+namespace CAN_TX
+{
+    /**
+     * @brief Queue a CAN1 frame for can1_tx_task (never blocks)
+     * @param lane CAN_TX_SAFETY for commands, CAN_TX_PERIODIC for polls
+     * @param id CAN identifier
+     * @param data Payload (0-8 bytes)
+     * @param length Payload length
+     * @param is_extended true for a 29-bit identifier
+     * @param key Coalescing key, CAN_TX_NO_COALESCE to always queue
+     * @return false if the lane was full
+     */
+    bool send(CanTxLane lane, uint32_t id, const uint8_t *data, uint8_t length, bool is_extended,
+              uint16_t key = CAN_TX_NO_COALESCE);
+
+    void stats(CanTxLane lane, CanTxLaneStats &out);
+    void resetStats();
+
+    /// Alert task: account the frames the controller finished since the last call
+    uint32_t handedCount();
+    void onController(uint32_t handedBefore, const twai_status_info_t &info);
+
+    /// Print both lanes to Serial
+    void printStats();
+
+} // namespace CAN_TX
+
+// CAN1 TX task (drains the lanes into the TWAI controller)
+void can1_tx_task(void *arg);
@@ -0,0 +1,167 @@
+#pragma once
+
+/**
+ * @file charger_poll.h
+ * @brief Deadline-based scheduler for the charger's polled function codes
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * Every polled function code (data[1] of a 0x068181FE / 0x068182FE request)
+ * has its own period for the idle and charging modes and a priority. Each
+ * control tick the scheduler sends the codes whose deadline has passed,
+ * most urgent first, as long as the request + expected response fit in a
+ * token bucket sized from a bus-load budget (percent of CAN1 bit time).
+ * Codes held back by the budget stay due and are counted as deferred.
+ * When the configured periods need more than the budget, all of them are
+ * stretched by the same factor so low priorities slow down instead of
+ * starving. Priority 0 codes (commands) bypass the budget.
+ *
+ * A period of 0 means the code is only sent on demand (requestOnce()).
+ * Achieved request/response rates and bus time per code are measured over
+ * a rolling window for the diagnostics.
+ */
+
+#include <stdint.h>
+#include "can_bus_stats.h"
+#include "../config/timing.h"
+
+#define CHARGER_POLL_MAX_CODES 8
+
+/// Static configuration of one polled function code
+struct ChargerPollSpec
+{
+    uint32_t reqId;
+    uint8_t func;
+    uint8_t priority;          // 0 = command, never budgeted; then lower = more urgent
+    uint16_t periodIdleMs;     // 0 = on demand only
+    uint16_t periodChargingMs; // 0 = on demand only
+};
+
+/// Per-code scheduling statistics
+struct ChargerPollStats
+{
+    uint8_t func;
+    uint32_t periodMs;     // effective period in the current mode (0 = on demand)
+    uint32_t sent;         // requests queued for transmission (CAN_TX)
+    uint32_t responses;    // matching responses decoded
+    uint32_t declined;     // due, but nothing went out (builder skipped it or TX lane full)
+    uint32_t deferred;     // due, but held back by the bus budget or the per-tick cap
+    uint32_t maxLateMs;    // worst transmit delay past the deadline
+    uint32_t lastRespMs;   // millis() of the last response (0 = never)
+    float txHz;            // achieved request rate over the last window
+    float rxHz;            // achieved refresh (response) rate over the last window
+    float busPercent;      // request + response bus time over the last window
+};
+
+// Charger code table (charger_interface.cpp)
+extern const ChargerPollSpec chargerPolls[];
+extern const uint8_t NUM_CHARGER_POLLS;
+
+/// Scheduling engine, independent of tasks and clocks (used directly by the bench)
+class ChargerPollScheduler
+{
+public:
+    ChargerPollScheduler();
+
+    /// Install the code table (copied); resets all deadlines and statistics
+    void configure(const ChargerPollSpec *specs, uint8_t count, uint32_t bitrate, uint8_t budgetPercent);
+
+    void setBudgetPercent(uint8_t percent);
+    uint8_t budgetPercent() const { return budgetPercent_; }
+
+    /// Switch between idle and charging periods; shortened periods apply at once
+    void setCharging(bool charging, uint32_t nowMs);
+    bool isCharging() const { return charging_; }
+
+    /// Send a code at the next tick regardless of its period
+    void requestOnce(uint8_t func);
+
+    /// Start a control tick: refill the bucket, roll the statistics window
+    void beginTick(uint32_t nowMs);
+
+    /// Most urgent due code that fits the budget, or -1
+    int pickDue();
+
+    /// Report the outcome of pickDue(): sent = false if no frame went out
+    void complete(int index, bool sent);
+
+    /// Finish the tick: codes still due are counted as deferred
+    void endTick();
+
+    void onResponse(uint8_t func, uint32_t nowMs);
+
+    const ChargerPollSpec &spec(int index) const { return specs_[index]; }
+    uint8_t count() const { return count_; }
+
+    /// Copy per-code statistics; returns the number of entries written
+    uint8_t stats(ChargerPollStats *out, uint8_t max) const;
+
+    /// Total polling bus time over the last window (percent)
+    float busPercent() const;
+
+    /// Factor applied to the periods to fit the budget (1.0 = as configured)
+    float stretch() const { return stretch256_ / 256.0f; }
+
+    void resetStats();
+
+private:
+    struct Slot
+    {
+        uint32_t nextDueMs;
+        bool pending; // requestOnce()
+        uint32_t windowSent;
+        uint32_t windowResp;
+        ChargerPollStats stats;
+    };
+
+    void updateStretch();
+    uint32_t periodOf(uint8_t index) const;
+    uint32_t phaseOf(uint8_t index, uint32_t nowMs) const;
+    bool isDue(uint8_t index) const;
+    int findFunc(uint8_t func) const;
+
+    ChargerPollSpec specs_[CHARGER_POLL_MAX_CODES];
+    Slot slots_[CHARGER_POLL_MAX_CODES];
+    uint8_t count_;
+    bool charging_;
+    uint8_t budgetPercent_;
+    uint32_t bitrate_;
+    uint32_t costBits_;   // request + response frame
+    uint32_t stretch256_; // period scale, 8.8 fixed point
+    uint32_t bucketBits_; // tokens available
+    uint32_t bucketCarry_; // sub-bit remainder of the refill (bit-ms)
+    uint32_t nowMs_;
+    uint32_t lastRefillMs_;
+    uint32_t windowStartMs_;
+    bool started_;
+};
+
+namespace CHARGER_POLL
+{
+    /// Builds the payload for one code; return false to skip this slot
+    typedef bool (*BuildFn)(uint8_t func, uint8_t data[8]);
+
+    /// Install the charger's code table (chargerCommTask start)
+    void init(const ChargerPollSpec *specs, uint8_t count);
+
+    /// Queue the due codes for this tick; returns the number queued
+    uint8_t service(BuildFn build);
+
+    /// Charge gate open/closed (ChargingCore)
+    void setCharging(bool charging);
+
+    /// One-shot request of an on-demand code (e.g. 0x79 / 0x83 for the console)
+    void requestOnce(uint8_t func);
+
+    /// Response with a function code decoded (CAN1 decode path)
+    void onResponse(uint8_t func);
+
+    void setBudgetPercent(uint8_t percent);
+
+    uint8_t stats(ChargerPollStats *out, uint8_t max);
+    void resetStats();
+
+    /// Print per-code rates and bus utilisation to Serial
+    void printStats();
+
+} // namespace CHARGER_POLL
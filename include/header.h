@@ -10,7 +10,9 @@
 // =========================================================
 // CAN ID CONSTANTS
 // =========================================================
+#define ID_CTRL_REQ 0x068181FEUL
 #define ID_CTRL_RESP 0x0681817EUL
+#define ID_TELEM_REQ 0x068182FEUL
 #define ID_TELEM_RESP 0x0681827EUL
 #define ID_TERM_POWER 0x00433F01UL
 #define ID_TERM_STATUS 0x00473F01UL
@@ -61,12 +63,7 @@ extern float metric79_scaled;
 extern uint32_t metric83_raw;
 extern float metric83_scaled;
 
-extern unsigned long lastBMS;
 extern uint8_t heating;
-extern unsigned long lastHeartbeat;
-extern unsigned long lastChargerResponse;
-extern unsigned long lastTerminalPower;  // NEW: Track terminal data CAN messages
-extern unsigned long lastTerminalStatus; // NEW: Track terminal status CAN messages
 
 extern const char *chargerStatus;
 extern const char *terminalchargerStatus;
@@ -105,33 +102,12 @@ extern uint32_t cachedRawI;
 // =========================================================
 // STRUCTURES
 // =========================================================
-// Legacy RxBufItem for backward compatibility with existing code
-struct RxBufItem
-{
-    uint32_t id;
-    uint8_t dlc;
-    uint8_t data[8];
-    bool ext;
-    bool rtr;
-};
-
-struct Group
-{
-    uint32_t reqId;
-    uint32_t respId;
-    uint8_t funcs[5];
-    uint8_t funcCount;
-    unsigned long period;
-    unsigned long lastReq;
-    uint8_t funcIndex;
-};
+// Received frame, as queued by the CAN drivers (drivers/can_frame.h)
+struct CanMessage;
 
 // CAN Update Flag
 extern volatile bool updateCAN;
 
-// Groups
-extern Group groups[];
-
 // =========================================================
 // CHARGER HEALTH MONITORING
 // =========================================================
@@ -142,19 +118,16 @@ void initGlobals();
 void can1_rx_task(void *arg);  // CAN1 - ISO1050 - Charger
 void can2_rx_task(void *arg);  // CAN2 - MCP2515 - BMS
 void chargerCommTask(void *arg);
-void handleBMSMessage(const twai_message_t &msg);
-void handleChargerMessage(const twai_message_t &msg);
+void handleBMSMessage(const CanMessage &msg);
+void handleChargerMessage(const CanMessage &msg); // msg.timestamp_us: esp_timer_get_time() at RX
 void requestSOCFromBMS();
-void handleSOCMessage(const twai_message_t &msg);
+void handleSOCMessage(const CanMessage &msg);
 void requestChargingAh();        // NEW: Request total charging Ah
 void requestDischargingAh();     // NEW: Request total discharging Ah
-void handleChargingAhMessage(const twai_message_t &msg);    // NEW
-void handleDischargingAhMessage(const twai_message_t &msg); // NEW
+void handleChargingAhMessage(const CanMessage &msg);    // NEW
+void handleDischargingAhMessage(const CanMessage &msg); // NEW
 
-bool popFrame(RxBufItem &out);
-void pushFrame(const twai_message_t &msg);
-void sendGroupRequest(Group &g);
-void sendChargerFeedback();
+void sendChargerFeedback(); // Refresh the 0x18FF50E5 payload; the CAN2 task sends it from TXB2
 
 void printDecodedData();
 void printMenu();
@@ -184,14 +157,18 @@ inline void safePrintln(const char *str = "")
     }
 }
 
+// Serial.printf() has no va_list form: format here, then print
+inline void safePrintf(const char *format, ...) __attribute__((format(printf, 1, 2)));
 inline void safePrintf(const char *format, ...)
 {
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
     if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) == pdTRUE)
     {
-        va_list args;
-        va_start(args, format);
-        Serial.printf(format, args);
-        va_end(args);
+        Serial.print(line);
         xSemaphoreGive(serialMutex);
     }
 }
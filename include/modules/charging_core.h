@@ -0,0 +1,31 @@
+#pragma once
+
+/**
+ * @file charging_core.h
+ * @brief Plug detection, safety supervision and energy accumulation
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * This is the charging logic that used to live inline in loop(). It only
+ * depends on the shared CAN state in header.h and the MicroOcpp transaction
+ * API, so it runs unchanged on target and in the native simulator.
+ */
+
+namespace ChargingCore
+{
+
+    /**
+     * @brief Run one pass of the charging logic
+     * Call every loop() iteration (~10 ms). Handles hybrid plug disconnect
+     * detection, VehicleInfo publishing, BMS permission and charger health
+     * supervision, and energy accumulation behind the transaction gate.
+     */
+    void poll();
+
+    /**
+     * @brief Clear all internal timers and edge-detection state
+     * Used by the native harness between independent runs.
+     */
+    void reset();
+
+} // namespace ChargingCore
@@ -2,6 +2,7 @@
 #define OCPP_CLIENT_H
 
 #include <MicroOcpp.h>
+#include "../core/telemetry_frame.h"
 
 /**
  * @file ocpp_client.h
@@ -24,15 +25,32 @@ namespace ocpp
      */
     void poll();
 
+    /**
+     * Block until an event arrives or the adaptive tick expires, then handle
+     * the queued events (OCPP task loop, see core/ocpp_events.h)
+     */
+    void waitForWork();
+
+    /**
+     * Called from other tasks: queued for the OCPP task, which wakes at once
+     * (MicroOcpp is only driven from the OCPP task)
+     */
+    void notifyPlugChanged(bool plugged);
+    void notifyChargerHealth(bool healthy);
+    void notifyBMSAlert(const char* alertType, const char* message);
+    void notifyVehicleInfo(const VehicleInfoBatch& batch); // copied; sent with sendVehicleInfo()
+
     /**
      * Check if OCPP is connected
      */
     bool isConnected();
 
     /**
-     * Send vehicle info via DataTransfer (before transaction starts)
+     * Send a batch of vehicle info samples via DataTransfer (before transaction starts)
+     * as one base64 VehicleTelemetry frame (see telemetry_frame.h). OCPP task only:
+     * offline it appends to the flash outbox
      */
-    void sendVehicleInfo(float soc, float maxCurrent, float voltage, float current, float temperature, uint8_t model, float range);
+    void sendVehicleInfo(const VehicleInfoBatch& batch);
 
     /**
      * Send session summary via DataTransfer (after transaction ends)
@@ -44,6 +62,19 @@ namespace ocpp
      */
     void sendBMSAlert(const char* alertType, const char* message);
 
+    /**
+     * Send CAN bus load and per-ID timing via DataTransfer
+     * @param reason "Periodic", "ChargerOffline", "SessionEnd", ...
+     */
+    void sendBusStats(const char* reason);
+
+    /**
+     * Send per-core load and per-task CPU / stack use via DataTransfer
+     * ("Diagnostics", latest TASK_PROFILER sample)
+     * @param reason "Periodic", ...
+     */
+    void sendDiagnostics(const char* reason);
+
 } // namespace ocpp
 
 #endif // OCPP_CLIENT_H
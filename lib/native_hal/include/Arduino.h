@@ -0,0 +1,108 @@
+#pragma once
+
+/**
+ * @file Arduino.h (native shim)
+ * @brief Arduino-ESP32 core surface used by the firmware, for host builds
+ *
+ * Provides timing (backed by sim_clock), GPIO/interrupt stubs routed to the
+ * simulated peripherals, a stdout-backed Serial and the FreeRTOS headers the
+ * ESP32 core pulls in implicitly.
+ */
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/timers.h"
+
+#define IRAM_ATTR
+
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+// ========== TIMING ==========
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// ========== GPIO ==========
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void detachInterrupt(uint8_t pin);
+#define digitalPinToInterrupt(p) (p)
+
+// ========== SERIAL ==========
+class HardwareSerial
+{
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    int available();
+    int read();
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buf, size_t len);
+
+    size_t print(const char *s);
+    size_t print(char c);
+    size_t print(int v);
+    size_t print(unsigned int v);
+    size_t print(long v);
+    size_t print(unsigned long v);
+    size_t print(double v, int digits = 2);
+
+    size_t println();
+    size_t println(const char *s);
+    size_t println(char c);
+    size_t println(int v);
+    size_t println(unsigned int v);
+    size_t println(long v);
+    size_t println(unsigned long v);
+    size_t println(double v, int digits = 2);
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    void flush();
+};
+
+extern HardwareSerial Serial;
+
+// ========== SYSTEM ==========
+class EspClass
+{
+public:
+    [[noreturn]] void restart();
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+
+    /// Nanoseconds (CLOCK_MONOTONIC) in place of CPU cycles: getCpuFrequencyMhz() is 1000
+    static inline uint32_t getCycleCount()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+    }
+};
+
+extern EspClass ESP;
+
+uint32_t getCpuFrequencyMhz();
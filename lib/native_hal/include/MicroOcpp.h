@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ * @file MicroOcpp.h (native shim)
+ * @brief The handful of MicroOcpp 1.2 calls made from CAN/charging code
+ *
+ * The native build has no WebSocket backend; transaction state is a plain
+ * flag per connector that the simulation harness drives through the sim::
+ * controls below.
+ */
+
+#include <stdint.h>
+
+bool isTransactionActive(unsigned int connectorId = 1);
+bool isTransactionRunning(unsigned int connectorId = 1);
+bool ocppPermitsCharge(unsigned int connectorId = 1);
+bool isOperative(unsigned int connectorId = 1);
+bool endTransaction(const char *idTag = nullptr, const char *reason = nullptr, unsigned int connectorId = 1);
+bool beginTransaction(const char *idTag, unsigned int connectorId = 1);
+void mocpp_loop();
+
+namespace sim
+{
+    /// Force the simulated transaction state of connector 1
+    void setOcppTransaction(bool running, bool permitsCharge);
+    /// Number of endTransaction() calls since start (replay assertions)
+    uint32_t ocppEndTransactionCount();
+    const char *ocppLastStopReason();
+} // namespace sim
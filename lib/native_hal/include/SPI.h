@@ -0,0 +1,39 @@
+#pragma once
+
+/**
+ * @file SPI.h (native shim)
+ * @brief Arduino SPI surface; transfers go to the simulated MCP2515 while
+ *        its chip-select pin is held low
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SPI_MODE0 0x00
+#define MSBFIRST 1
+
+class SPISettings
+{
+public:
+    SPISettings() {}
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode)
+    {
+        (void)clock;
+        (void)bitOrder;
+        (void)dataMode;
+    }
+};
+
+class SPIClass
+{
+public:
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1);
+    void end() {}
+    void beginTransaction(SPISettings settings) { (void)settings; }
+    void endTransaction() {}
+    uint8_t transfer(uint8_t data);
+    void transferBytes(const uint8_t *data, uint8_t *out, uint32_t size);
+    void writeBytes(const uint8_t *data, uint32_t size);
+};
+
+extern SPIClass SPI;
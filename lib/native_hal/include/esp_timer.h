@@ -0,0 +1,10 @@
+#pragma once
+
+/**
+ * @file esp_timer.h (native shim)
+ */
+
+#include <stdint.h>
+
+/// Microseconds since boot (sim clock)
+int64_t esp_timer_get_time();
@@ -0,0 +1,55 @@
+#pragma once
+
+/**
+ * @file FreeRTOS.h (native shim)
+ * @brief Minimal FreeRTOS type/constant surface for host builds
+ *
+ * One tick is one millisecond. Tasks, semaphores, queues and timers are
+ * implemented on std::thread / std::mutex in native_hal/src/freertos_shim.cpp.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFUL)
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t)(((TickType_t)(xTimeInMs) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+#define configMAX_PRIORITIES 25
+#define configMAX_TASK_NAME_LEN 16
+#define configUSE_TRACE_FACILITY 1
+#define configGENERATE_RUN_TIME_STATS 1 // µs of thread CPU time (pthread CPU clocks)
+#define configTASKLIST_INCLUDE_COREID 1
+#define portNUM_PROCESSORS 2
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+// Critical sections map onto one process-wide recursive lock
+typedef struct
+{
+    int unused;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+void native_enter_critical();
+void native_exit_critical();
+#define portENTER_CRITICAL(mux) ((void)(mux), native_enter_critical())
+#define portEXIT_CRITICAL(mux) ((void)(mux), native_exit_critical())
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux), native_enter_critical())
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux), native_exit_critical())
+#define taskENTER_CRITICAL(mux) ((void)(mux), native_enter_critical())
+#define taskEXIT_CRITICAL(mux) ((void)(mux), native_exit_critical())
+
+#define portYIELD_FROM_ISR(x) ((void)(x))
+
+BaseType_t xPortGetCoreID();
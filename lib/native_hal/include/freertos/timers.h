@@ -0,0 +1,21 @@
+#pragma once
+
+/**
+ * @file timers.h (native shim)
+ * @brief FreeRTOS software timers, serviced by one daemon thread like the
+ *        FreeRTOS timer task
+ */
+
+#include "FreeRTOS.h"
+
+struct NativeTimer;
+typedef NativeTimer *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t);
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t autoReload,
+                           void *timerId, TimerCallbackFunction_t callback);
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticksToWait);
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticksToWait);
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticksToWait);
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t newPeriod, TickType_t ticksToWait);
+void *pvTimerGetTimerID(TimerHandle_t timer);
@@ -0,0 +1,168 @@
+#pragma once
+
+/**
+ * @file mcp2515.h (native shim)
+ * @brief autowp/arduino-mcp2515 class surface backed by a simulated chip
+ *
+ * The chip model (native_hal/src/mcp2515_chip.cpp) holds the two RX buffers,
+ * three TX buffers, six acceptance filters / two masks and EFLG, and is
+ * attached to the simulated BMS bus. INT is held low while a CANINTF flag
+ * enabled in CANINTE is set; CANINTE is 0 at power-on and set by reset()
+ * or a raw SPI write. Raw SPI instructions reach the chip while its CS pin
+ * is low (see SPI.h).
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+// ========== SocketCAN frame (linux/can.h subset used by the library) ==========
+typedef uint32_t canid_t;
+
+#define CAN_EFF_FLAG 0x80000000UL
+#define CAN_RTR_FLAG 0x40000000UL
+#define CAN_ERR_FLAG 0x20000000UL
+#define CAN_SFF_MASK 0x000007FFUL
+#define CAN_EFF_MASK 0x1FFFFFFFUL
+#define CAN_ERR_MASK 0x1FFFFFFFUL
+#define CAN_MAX_DLEN 8
+
+struct can_frame
+{
+    canid_t can_id;
+    uint8_t can_dlc;
+    uint8_t __pad;
+    uint8_t __res0;
+    uint8_t __res1;
+    uint8_t data[CAN_MAX_DLEN] __attribute__((aligned(8)));
+};
+
+enum CAN_CLOCK
+{
+    MCP_20MHZ,
+    MCP_16MHZ,
+    MCP_8MHZ
+};
+
+enum CAN_SPEED
+{
+    CAN_5KBPS,
+    CAN_10KBPS,
+    CAN_20KBPS,
+    CAN_31K25BPS,
+    CAN_33KBPS,
+    CAN_40KBPS,
+    CAN_50KBPS,
+    CAN_80KBPS,
+    CAN_83K3BPS,
+    CAN_95KBPS,
+    CAN_100KBPS,
+    CAN_125KBPS,
+    CAN_200KBPS,
+    CAN_250KBPS,
+    CAN_500KBPS,
+    CAN_1000KBPS
+};
+
+class MCP2515
+{
+public:
+    enum ERROR
+    {
+        ERROR_OK = 0,
+        ERROR_FAIL = 1,
+        ERROR_ALLTXBUSY = 2,
+        ERROR_FAILINIT = 3,
+        ERROR_FAILTX = 4,
+        ERROR_NOMSG = 5
+    };
+
+    enum MASK
+    {
+        MASK0,
+        MASK1
+    };
+
+    enum RXF
+    {
+        RXF0 = 0,
+        RXF1 = 1,
+        RXF2 = 2,
+        RXF3 = 3,
+        RXF4 = 4,
+        RXF5 = 5
+    };
+
+    enum RXBn
+    {
+        RXB0 = 0,
+        RXB1 = 1
+    };
+
+    enum TXBn
+    {
+        TXB0 = 0,
+        TXB1 = 1,
+        TXB2 = 2
+    };
+
+    enum CANINTF : uint8_t
+    {
+        CANINTF_RX0IF = 0x01,
+        CANINTF_RX1IF = 0x02,
+        CANINTF_TX0IF = 0x04,
+        CANINTF_TX1IF = 0x08,
+        CANINTF_TX2IF = 0x10,
+        CANINTF_ERRIF = 0x20,
+        CANINTF_WAKIF = 0x40,
+        CANINTF_MERRF = 0x80
+    };
+
+    enum EFLG : uint8_t
+    {
+        EFLG_RX1OVR = (1 << 7),
+        EFLG_RX0OVR = (1 << 6),
+        EFLG_TXBO = (1 << 5),
+        EFLG_TXEP = (1 << 4),
+        EFLG_RXEP = (1 << 3),
+        EFLG_TXWAR = (1 << 2),
+        EFLG_RXWAR = (1 << 1),
+        EFLG_EWARN = (1 << 0)
+    };
+
+    static const uint8_t EFLG_ERRORMASK = EFLG_RX1OVR | EFLG_RX0OVR | EFLG_TXBO | EFLG_TXEP | EFLG_RXEP;
+
+    explicit MCP2515(const uint8_t _CS, const uint32_t _SPI_CLOCK = 10000000UL, void *_SPI = nullptr);
+
+    ERROR reset();
+    ERROR setConfigMode();
+    ERROR setListenOnlyMode();
+    ERROR setSleepMode();
+    ERROR setLoopbackMode();
+    ERROR setNormalMode();
+    ERROR setClkOut(int divisor);
+    ERROR setBitrate(const CAN_SPEED canSpeed);
+    ERROR setBitrate(const CAN_SPEED canSpeed, const CAN_CLOCK canClock);
+    ERROR setFilterMask(const MASK num, const bool ext, const uint32_t ulData);
+    ERROR setFilter(const RXF num, const bool ext, const uint32_t ulData);
+    ERROR sendMessage(const TXBn txbn, const struct can_frame *frame);
+    ERROR sendMessage(const struct can_frame *frame);
+    ERROR readMessage(const RXBn rxbn, struct can_frame *frame);
+    ERROR readMessage(struct can_frame *frame);
+    bool checkReceive();
+    bool checkError();
+    uint8_t getErrorFlags();
+    void clearRXnOVRFlags();
+    uint8_t getInterrupts();
+    uint8_t getInterruptMask();
+    void clearInterrupts();
+    void clearTXInterrupts();
+    uint8_t getStatus();
+    void clearRXnOVR();
+    void clearMERR();
+    void clearERRIF();
+    uint8_t errorCountRX();
+    uint8_t errorCountTX();
+
+private:
+    uint8_t cs;
+};
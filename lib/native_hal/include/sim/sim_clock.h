@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ * @file sim_clock.h
+ * @brief Time base for millis()/micros()/esp_timer_get_time() on the host
+ *
+ * Real mode follows std::chrono::steady_clock from process start.
+ * Virtual mode freezes time and only moves when the harness advances it,
+ * which makes replay deterministic and faster than real time. vTaskDelay()
+ * in virtual mode advances the clock instead of sleeping, so single-threaded
+ * harness code may call firmware functions that delay.
+ */
+
+#include <stdint.h>
+
+namespace sim
+{
+    /// Switch between wall-clock and harness-driven time (keeps the current value)
+    void useVirtualClock(bool enable);
+    bool isVirtualClock();
+
+    /// Virtual mode only: set / advance the clock
+    void setClockUs(uint64_t us);
+    void advanceClockUs(uint64_t us);
+
+    /// Current simulated time in microseconds
+    uint64_t clockUs();
+
+} // namespace sim
@@ -0,0 +1,35 @@
+#pragma once
+
+/**
+ * @file sim_flash.h
+ * @brief Harness controls for the file-backed flash partitions
+ */
+
+#include <stdint.h>
+
+namespace sim
+{
+    /**
+     * Back data partition `label` with the file at `path`. A new or
+     * shorter file is extended to `size` bytes of erased flash (0xFF);
+     * existing contents are kept, so a second attach is a reboot.
+     */
+    bool flashAttach(const char *label, const char *path, uint32_t size);
+    void flashDetach(const char *label);
+
+    /// Flash operations since attach / reset, for timing models in benchmarks
+    struct FlashCounters
+    {
+        uint64_t bytesRead;
+        uint64_t bytesWritten;
+        uint32_t reads;
+        uint32_t writes;
+        uint32_t pagesProgrammed; // 256-byte pages touched by writes
+        uint32_t sectorsErased;
+        uint32_t minSectorErases; // over all sectors of the partition
+        uint32_t maxSectorErases;
+    };
+    FlashCounters flashCounters(const char *label);
+    void flashResetCounters(const char *label);
+
+} // namespace sim
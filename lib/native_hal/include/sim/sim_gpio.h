@@ -0,0 +1,18 @@
+#pragma once
+
+/**
+ * @file sim_gpio.h
+ * @brief Drive simulated GPIO inputs (e.g. the MCP2515 INT line)
+ */
+
+#include <stdint.h>
+
+namespace sim
+{
+    /// Set an input pin level; fires an attached ISR on the matching edge
+    void setPinLevel(uint8_t pin, int level);
+
+    /// Register a hook called when firmware writes an output pin (SPI chip select)
+    void onPinWrite(uint8_t pin, void (*hook)(uint8_t pin, int level));
+
+} // namespace sim
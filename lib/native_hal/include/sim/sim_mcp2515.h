@@ -0,0 +1,33 @@
+#pragma once
+
+/**
+ * @file sim_mcp2515.h
+ * @brief Harness controls for the simulated MCP2515
+ */
+
+#include <stdint.h>
+
+namespace sim
+{
+    /// GPIO the chip drives as its active-low INT output
+    void mcp2515SetIntPin(uint8_t pin);
+
+    /// Force raw EFLG bits (e.g. RX0OVR); error-state bits follow TEC / REC
+    void mcp2515InjectErrorFlags(uint8_t eflg);
+
+    /// REC = 128: error-passive (RXEP, ERRIF) until the next frame is received
+    void mcp2515InjectErrorPassive();
+
+    /// TEC past 255: bus-off (TXBO, ERRIF) until configuration mode is entered
+    void mcp2515InjectBusOff();
+
+    /// Frames lost because both RX buffers were full
+    uint32_t mcp2515RxOverflowCount();
+
+    /// SPI transactions (CS low periods) issued to the chip since start
+    uint32_t mcp2515SpiTransactions();
+
+    /// SPI bytes clocked: raw transfers plus library frame transmits
+    uint32_t mcp2515SpiBytes();
+
+} // namespace sim
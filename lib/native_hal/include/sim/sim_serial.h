@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+ * @file sim_serial.h
+ * @brief Host control over the simulated Serial port
+ */
+
+#include <stdint.h>
+
+namespace sim
+{
+    /// Suppress Serial output (benchmarks and replay runs)
+    void setSerialMuted(bool muted);
+    bool isSerialMuted();
+
+    /// Hold Serial writers the way a UART at this baud rate would (0 = never)
+    void setSerialBaud(uint32_t baud);
+
+    /// Queue console input as if typed on the serial monitor
+    void injectSerialInput(const char *text);
+
+    /// Forward stdin lines to Serial input from a background thread
+    void startSerialStdinReader();
+
+} // namespace sim
@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+ * @file sim_twai.h
+ * @brief Harness controls for the simulated TWAI controller (CAN1 faults)
+ */
+
+#include <stdint.h>
+
+namespace sim
+{
+    /// TEC past 255: the controller goes bus-off (TWAI_ALERT_BUS_OFF)
+    void twaiInjectBusOff();
+
+    /// TEC = 128: error-passive (TWAI_ALERT_ERR_PASS)
+    void twaiInjectErrorPassive();
+
+    /**
+     * Hold the bus faulty (e.g. CANH shorted to CANL). While set nothing is
+     * received, a transmit drives the controller bus-off, and a recovery
+     * cannot count its 128 x 11 recessive bits until the fault clears.
+     */
+    void twaiSetBusFault(bool fault);
+
+} // namespace sim
@@ -0,0 +1,50 @@
+#pragma once
+
+/**
+ * @file virtual_bus.h
+ * @brief In-process CAN buses connecting the firmware drivers to simulated nodes
+ *
+ * Two buses exist: CHARGER (TWAI / ISO1050) and BMS (MCP2515). Every frame
+ * put on a bus is delivered synchronously to every attached node except the
+ * sender, in attach order. Nodes are the fake TWAI controller, the MCP2515
+ * chip model and whatever devices the harness attaches (charger module, BMS,
+ * trace replayer).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace sim
+{
+    enum BusId : uint8_t
+    {
+        BUS_CHARGER = 0,
+        BUS_BMS = 1,
+        BUS_COUNT = 2
+    };
+
+    struct BusFrame
+    {
+        uint32_t id;
+        uint8_t dlc;
+        uint8_t data[8];
+        bool extended;
+        bool rtr;
+    };
+
+    typedef void (*BusListener)(const BusFrame &frame, void *ctx);
+
+    /// Attach a node; returns its node id (used as sender id)
+    int busAttach(BusId bus, BusListener listener, void *ctx);
+    void busDetach(BusId bus, int node);
+
+    /// Put a frame on the bus from node `sender` (-1 = anonymous injector)
+    void busSend(BusId bus, const BusFrame &frame, int sender = -1);
+
+    /// Frames carried since start (all senders)
+    uint32_t busFrameCount(BusId bus);
+
+    /// Drop every node (between bench runs)
+    void busReset();
+
+} // namespace sim
@@ -0,0 +1,316 @@
+/**
+ * @file arduino_shim.cpp
+ * @brief Arduino core functions for the native build: timing, GPIO, Serial, ESP
+ */
+
+#include "Arduino.h"
+#include "sim/sim_clock.h"
+#include "sim/sim_gpio.h"
+#include "sim/sim_serial.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+// ========== TIMING ==========
+unsigned long millis()
+{
+    return (unsigned long)(uint32_t)(sim::clockUs() / 1000ULL);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)(uint32_t)sim::clockUs();
+}
+
+void delay(uint32_t ms)
+{
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    if (sim::isVirtualClock())
+    {
+        sim::advanceClockUs(us);
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+// ========== GPIO ==========
+namespace
+{
+    const uint8_t NUM_PINS = 40;
+
+    struct PinState
+    {
+        std::atomic<int> level{HIGH};
+        uint8_t mode = INPUT;
+        void (*isr)() = nullptr;
+        int isrMode = 0;
+        void (*writeHook)(uint8_t, int) = nullptr;
+    };
+
+    PinState pins[NUM_PINS];
+    std::mutex pinMutex;
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin < NUM_PINS)
+        pins[pin].mode = mode;
+}
+
+int digitalRead(uint8_t pin)
+{
+    return pin < NUM_PINS ? pins[pin].level.load() : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin >= NUM_PINS)
+        return;
+    pins[pin].level.store(value ? HIGH : LOW);
+    if (pins[pin].writeHook)
+        pins[pin].writeHook(pin, value ? HIGH : LOW);
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode)
+{
+    if (pin >= NUM_PINS)
+        return;
+    std::lock_guard<std::mutex> lock(pinMutex);
+    pins[pin].isr = isr;
+    pins[pin].isrMode = mode;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    if (pin >= NUM_PINS)
+        return;
+    std::lock_guard<std::mutex> lock(pinMutex);
+    pins[pin].isr = nullptr;
+}
+
+namespace sim
+{
+    void setPinLevel(uint8_t pin, int level)
+    {
+        if (pin >= NUM_PINS)
+            return;
+        int prev = pins[pin].level.exchange(level ? HIGH : LOW);
+        if (prev == (level ? HIGH : LOW))
+            return;
+
+        void (*isr)() = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(pinMutex);
+            int mode = pins[pin].isrMode;
+            bool falling = prev == HIGH && !level;
+            if ((mode == CHANGE) || (mode == FALLING && falling) || (mode == RISING && !falling))
+                isr = pins[pin].isr;
+        }
+        if (isr)
+            isr();
+    }
+
+    void onPinWrite(uint8_t pin, void (*hook)(uint8_t pin, int level))
+    {
+        if (pin < NUM_PINS)
+            pins[pin].writeHook = hook;
+    }
+}
+
+// ========== SERIAL ==========
+namespace
+{
+    std::atomic<bool> serialMuted{false};
+    std::mutex serialInMutex;
+    std::deque<char> serialIn;
+
+    // UART model for setSerialBaud(): the 128-byte TX FIFO drains at 10 bits
+    // per byte and a write blocks until what is left of it fits
+    const uint64_t UART_FIFO_BYTES = 128;
+    std::atomic<uint32_t> serialBaud{0};
+    std::mutex uartMutex;
+    uint64_t uartIdleNs = 0; // steady clock time the FIFO runs empty
+
+    void paceUart(size_t bytes)
+    {
+        const uint32_t baud = serialBaud.load(std::memory_order_relaxed);
+        if (baud == 0 || bytes == 0)
+            return;
+        const uint64_t byteNs = 10ULL * 1000000000ULL / baud;
+        uint64_t until;
+        {
+            std::lock_guard<std::mutex> lock(uartMutex);
+            const uint64_t now = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count();
+            if (uartIdleNs < now)
+                uartIdleNs = now;
+            uartIdleNs += bytes * byteNs;
+            until = uartIdleNs - UART_FIFO_BYTES * byteNs;
+        }
+        std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(until)));
+    }
+}
+
+namespace sim
+{
+    void setSerialMuted(bool muted)
+    {
+        serialMuted.store(muted);
+    }
+
+    bool isSerialMuted()
+    {
+        return serialMuted.load();
+    }
+
+    void setSerialBaud(uint32_t baud)
+    {
+        serialBaud.store(baud);
+    }
+
+    void injectSerialInput(const char *text)
+    {
+        std::lock_guard<std::mutex> lock(serialInMutex);
+        while (*text)
+            serialIn.push_back(*text++);
+    }
+
+    void startSerialStdinReader()
+    {
+        std::thread([]
+                    {
+                        std::string line;
+                        while (std::getline(std::cin, line))
+                        {
+                            line.push_back('\n');
+                            injectSerialInput(line.c_str());
+                        }
+                    })
+            .detach();
+    }
+}
+
+int HardwareSerial::available()
+{
+    std::lock_guard<std::mutex> lock(serialInMutex);
+    return (int)serialIn.size();
+}
+
+int HardwareSerial::read()
+{
+    std::lock_guard<std::mutex> lock(serialInMutex);
+    if (serialIn.empty())
+        return -1;
+    char c = serialIn.front();
+    serialIn.pop_front();
+    return (uint8_t)c;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    paceUart(1);
+    if (serialMuted.load(std::memory_order_relaxed))
+        return 1;
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t len)
+{
+    paceUart(len);
+    if (serialMuted.load(std::memory_order_relaxed))
+        return len;
+    return fwrite(buf, 1, len, stdout);
+}
+
+size_t HardwareSerial::print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+size_t HardwareSerial::print(char c) { return write((uint8_t)c); }
+size_t HardwareSerial::print(int v) { return printf("%d", v); }
+size_t HardwareSerial::print(unsigned int v) { return printf("%u", v); }
+size_t HardwareSerial::print(long v) { return printf("%ld", v); }
+size_t HardwareSerial::print(unsigned long v) { return printf("%lu", v); }
+size_t HardwareSerial::print(double v, int digits) { return printf("%.*f", digits, v); }
+
+size_t HardwareSerial::println() { return print("\r\n"); }
+size_t HardwareSerial::println(const char *s) { return print(s) + println(); }
+size_t HardwareSerial::println(char c) { return print(c) + println(); }
+size_t HardwareSerial::println(int v) { return print(v) + println(); }
+size_t HardwareSerial::println(unsigned int v) { return print(v) + println(); }
+size_t HardwareSerial::println(long v) { return print(v) + println(); }
+size_t HardwareSerial::println(unsigned long v) { return print(v) + println(); }
+size_t HardwareSerial::println(double v, int digits) { return print(v, digits) + println(); }
+
+size_t HardwareSerial::printf(const char *format, ...)
+{
+    va_list args;
+    if (serialBaud.load(std::memory_order_relaxed) != 0)
+    {
+        va_start(args, format);
+        const int len = vsnprintf(nullptr, 0, format, args);
+        va_end(args);
+        paceUart(len > 0 ? (size_t)len : 0);
+    }
+    if (serialMuted.load(std::memory_order_relaxed))
+        return 0;
+    va_start(args, format);
+    int n = vprintf(format, args);
+    va_end(args);
+    return n > 0 ? (size_t)n : 0;
+}
+
+void HardwareSerial::flush()
+{
+    fflush(stdout);
+}
+
+// ========== SYSTEM ==========
+void EspClass::restart()
+{
+    fflush(stdout);
+    fprintf(stderr, "[SIM] ESP.restart() requested - exiting\n");
+    exit(3);
+}
+
+uint32_t EspClass::getFreeHeap() { return 200 * 1024; }
+uint32_t EspClass::getMinFreeHeap() { return 180 * 1024; }
+uint32_t EspClass::getMaxAllocHeap() { return 110 * 1024; }
+
+uint32_t getCpuFrequencyMhz() { return 1000; }
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
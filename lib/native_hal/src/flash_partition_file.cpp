@@ -0,0 +1,219 @@
+/**
+ * @file flash_partition_file.cpp
+ * @brief esp_partition_* on host files with NOR program / erase semantics
+ */
+
+#include "esp_partition.h"
+#include "sim/sim_flash.h"
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const uint32_t SECTOR_BYTES = 4096;
+    const uint32_t PAGE_BYTES = 256;
+
+    struct FilePartition
+    {
+        esp_partition_t part;
+        FILE *file;
+        sim::FlashCounters counters;
+        std::vector<uint32_t> sectorErases;
+    };
+
+    std::mutex m;
+    std::vector<FilePartition *> partitions;
+
+    FilePartition *byLabel(const char *label)
+    {
+        for (FilePartition *p : partitions)
+        {
+            if (strncmp(p->part.label, label, sizeof(p->part.label)) == 0)
+                return p;
+        }
+        return nullptr;
+    }
+
+    FilePartition *byPartition(const esp_partition_t *part)
+    {
+        for (FilePartition *p : partitions)
+        {
+            if (&p->part == part)
+                return p;
+        }
+        return nullptr;
+    }
+
+    bool inRange(const FilePartition *p, size_t offset, size_t size)
+    {
+        return offset <= p->part.size && size <= p->part.size - offset;
+    }
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    std::lock_guard<std::mutex> lock(m);
+    for (FilePartition *p : partitions)
+    {
+        if (p->part.type != type)
+            continue;
+        if (subtype != ESP_PARTITION_SUBTYPE_ANY && p->part.subtype != subtype)
+            continue;
+        if (label && strncmp(p->part.label, label, sizeof(p->part.label)) != 0)
+            continue;
+        return &p->part;
+    }
+    return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    std::lock_guard<std::mutex> lock(m);
+    FilePartition *p = byPartition(partition);
+    if (!p || !dst || !inRange(p, src_offset, size))
+        return ESP_ERR_INVALID_ARG;
+    if (fseek(p->file, (long)src_offset, SEEK_SET) != 0 || fread(dst, 1, size, p->file) != size)
+        return ESP_FAIL;
+    p->counters.reads++;
+    p->counters.bytesRead += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    std::lock_guard<std::mutex> lock(m);
+    FilePartition *p = byPartition(partition);
+    if (!p || !src || !inRange(p, dst_offset, size))
+        return ESP_ERR_INVALID_ARG;
+    if (size == 0)
+        return ESP_OK;
+
+    // Programming only clears bits
+    std::vector<uint8_t> cells(size);
+    if (fseek(p->file, (long)dst_offset, SEEK_SET) != 0 || fread(cells.data(), 1, size, p->file) != size)
+        return ESP_FAIL;
+    const uint8_t *in = (const uint8_t *)src;
+    for (size_t i = 0; i < size; i++)
+        cells[i] &= in[i];
+    if (fseek(p->file, (long)dst_offset, SEEK_SET) != 0 || fwrite(cells.data(), 1, size, p->file) != size)
+        return ESP_FAIL;
+
+    p->counters.writes++;
+    p->counters.bytesWritten += size;
+    p->counters.pagesProgrammed += (uint32_t)((dst_offset + size - 1) / PAGE_BYTES - dst_offset / PAGE_BYTES + 1);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    std::lock_guard<std::mutex> lock(m);
+    FilePartition *p = byPartition(partition);
+    if (!p || !inRange(p, offset, size) || offset % SECTOR_BYTES || size % SECTOR_BYTES)
+        return ESP_ERR_INVALID_ARG;
+
+    static const std::vector<uint8_t> erased(SECTOR_BYTES, 0xFF);
+    for (size_t s = offset; s < offset + size; s += SECTOR_BYTES)
+    {
+        if (fseek(p->file, (long)s, SEEK_SET) != 0 || fwrite(erased.data(), 1, SECTOR_BYTES, p->file) != SECTOR_BYTES)
+            return ESP_FAIL;
+        p->sectorErases[s / SECTOR_BYTES]++;
+        p->counters.sectorsErased++;
+    }
+    return ESP_OK;
+}
+
+namespace sim
+{
+    bool flashAttach(const char *label, const char *path, uint32_t size)
+    {
+        flashDetach(label);
+        if (size == 0 || size % SECTOR_BYTES)
+            return false;
+
+        FILE *f = fopen(path, "r+b");
+        if (!f)
+            f = fopen(path, "w+b");
+        if (!f)
+            return false;
+
+        // Extend with erased flash
+        fseek(f, 0, SEEK_END);
+        long have = ftell(f);
+        std::vector<uint8_t> erased(SECTOR_BYTES, 0xFF);
+        while (have >= 0 && (uint32_t)have < size)
+        {
+            const size_t n = size - (uint32_t)have < SECTOR_BYTES ? size - (uint32_t)have : SECTOR_BYTES;
+            if (fwrite(erased.data(), 1, n, f) != n)
+            {
+                fclose(f);
+                return false;
+            }
+            have += (long)n;
+        }
+        fflush(f);
+
+        FilePartition *p = new FilePartition();
+        p->part.flash_chip = nullptr;
+        p->part.type = ESP_PARTITION_TYPE_DATA;
+        p->part.subtype = ESP_PARTITION_SUBTYPE_ANY;
+        p->part.address = 0;
+        p->part.size = size;
+        snprintf(p->part.label, sizeof(p->part.label), "%s", label);
+        p->part.encrypted = false;
+        p->file = f;
+        p->counters = {};
+        p->sectorErases.assign(size / SECTOR_BYTES, 0);
+
+        std::lock_guard<std::mutex> lock(m);
+        partitions.push_back(p);
+        return true;
+    }
+
+    void flashDetach(const char *label)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        for (size_t i = 0; i < partitions.size(); i++)
+        {
+            if (strncmp(partitions[i]->part.label, label, sizeof(partitions[i]->part.label)) == 0)
+            {
+                fclose(partitions[i]->file);
+                delete partitions[i];
+                partitions.erase(partitions.begin() + i);
+                return;
+            }
+        }
+    }
+
+    FlashCounters flashCounters(const char *label)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        FlashCounters c = {};
+        FilePartition *p = byLabel(label);
+        if (!p)
+            return c;
+        c = p->counters;
+        c.minSectorErases = UINT32_MAX;
+        c.maxSectorErases = 0;
+        for (uint32_t e : p->sectorErases)
+        {
+            c.minSectorErases = e < c.minSectorErases ? e : c.minSectorErases;
+            c.maxSectorErases = e > c.maxSectorErases ? e : c.maxSectorErases;
+        }
+        return c;
+    }
+
+    void flashResetCounters(const char *label)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        FilePartition *p = byLabel(label);
+        if (!p)
+            return;
+        p->counters = {};
+        p->sectorErases.assign(p->sectorErases.size(), 0);
+    }
+
+} // namespace sim
@@ -0,0 +1,652 @@
+/**
+ * @file freertos_shim.cpp
+ * @brief FreeRTOS tasks, notifications, semaphores, queues and timers on the C++ thread library
+ *
+ * Priorities and core affinity are recorded but not enforced; the host
+ * scheduler decides. Blocking timeouts are measured in wall-clock time, so
+ * code that waits on another task behaves the same in virtual clock mode.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/timers.h"
+#include "sim/sim_clock.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    std::recursive_mutex criticalMutex;
+
+    template <typename Lock, typename Pred>
+    bool waitTicks(std::condition_variable &cv, Lock &lock, TickType_t ticks, Pred pred)
+    {
+        if (ticks == portMAX_DELAY)
+        {
+            cv.wait(lock, pred);
+            return true;
+        }
+        return cv.wait_for(lock, std::chrono::milliseconds(ticks), pred);
+    }
+
+    struct TaskExit
+    {
+    };
+}
+
+void native_enter_critical()
+{
+    criticalMutex.lock();
+}
+
+void native_exit_critical()
+{
+    criticalMutex.unlock();
+}
+
+// ========== TASKS ==========
+// Host stack of a task: the ESP32 figure is far too small for glibc, so
+// every task gets a fixed extra on top of it
+#define NATIVE_STACK_EXTRA_BYTES (256 * 1024)
+#define NATIVE_STACK_FILL 0xA5 // tskSTACK_FILL_BYTE
+
+struct NativeTask
+{
+    std::string name;
+    TaskFunction_t fn = nullptr;
+    void *param = nullptr;
+    UBaseType_t priority = 0;
+    BaseType_t coreId = 0;
+
+    std::mutex notifyMutex;
+    std::condition_variable notifyCv;
+    uint32_t notifyValue = 0;
+
+    // Trace facility (guarded by registryMutex)
+    UBaseType_t number = 0;
+    pthread_t thread = {};
+    bool alive = false;
+    uint64_t exitCpuUs = 0;
+    uint8_t *stackLow = nullptr; // painted stack, nullptr for foreign threads
+    size_t stackBytes = 0;
+    size_t stackEntry = 0; // offset of the task function's frame (glibc keeps TLS above it)
+    uint32_t stackDepth = 0; // as requested
+};
+
+namespace
+{
+    std::mutex registryMutex;
+    std::vector<NativeTask *> registry;
+    UBaseType_t lastTaskNumber = 0;
+    const std::chrono::steady_clock::time_point shimStart = std::chrono::steady_clock::now();
+
+    uint64_t threadCpuUs(clockid_t clock)
+    {
+        timespec ts;
+        if (clock_gettime(clock, &ts) != 0)
+            return 0;
+        return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+    }
+
+    // Keeps the CPU time of a thread that is gone; runs before the thread is
+    // reaped, and waits for a uxTaskGetSystemState() reading its clock
+    struct TaskExitRecorder
+    {
+        NativeTask *task = nullptr;
+        ~TaskExitRecorder()
+        {
+            if (!task)
+                return;
+            std::lock_guard<std::mutex> lock(registryMutex);
+            task->exitCpuUs = threadCpuUs(CLOCK_THREAD_CPUTIME_ID);
+            task->alive = false;
+        }
+    };
+    thread_local TaskExitRecorder exitRecorder;
+
+    void registerThread(NativeTask *task)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        task->number = ++lastTaskNumber;
+        task->thread = pthread_self();
+        task->alive = true;
+        registry.push_back(task);
+        exitRecorder.task = task;
+    }
+
+    // Minimum free stack: the requested depth less the most the host thread
+    // has used (0 if that is more than the ESP32 task would have had)
+    uint32_t stackUntouched(const NativeTask *task)
+    {
+        if (!task->stackLow)
+            return 0;
+        // Word at a time (the stack is page aligned), then the bytes of the first touched word
+        static const uint64_t FILL_WORD = 0x0101010101010101ULL * NATIVE_STACK_FILL;
+        const uint64_t *word = (const uint64_t *)task->stackLow;
+        size_t n = 0;
+        while (n + 8 <= task->stackBytes && word[n / 8] == FILL_WORD)
+            n += 8;
+        while (n < task->stackBytes && task->stackLow[n] == NATIVE_STACK_FILL)
+            n++;
+        const size_t used = task->stackEntry > n ? task->stackEntry - n : 0;
+        return used < task->stackDepth ? (uint32_t)(task->stackDepth - used) : 0;
+    }
+}
+
+static thread_local NativeTask *currentTask = nullptr;
+
+static NativeTask *selfTask()
+{
+    if (!currentTask)
+    {
+        // Threads not created through xTaskCreate (main, std::thread benches)
+        currentTask = new NativeTask();
+        currentTask->name = "main";
+        registerThread(currentTask);
+    }
+    return currentTask;
+}
+
+static void *taskEntry(void *arg)
+{
+    NativeTask *task = (NativeTask *)arg;
+    uint8_t frame;
+    task->stackEntry = (size_t)(&frame - task->stackLow);
+    currentTask = task;
+    registerThread(task);
+    try
+    {
+        task->fn(task->param);
+    }
+    catch (const TaskExit &)
+    {
+    }
+    return nullptr;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth,
+                                   void *param, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t coreId)
+{
+    NativeTask *task = new NativeTask();
+    task->name = name ? name : "";
+    task->fn = fn;
+    task->param = param;
+    task->priority = priority;
+    task->coreId = coreId == tskNO_AFFINITY ? 0 : coreId;
+
+    // Painted stack with a guard page below it: an overflow faults
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t bytes = ((size_t)stackDepth + NATIVE_STACK_EXTRA_BYTES + page - 1) / page * page;
+    void *map = mmap(nullptr, bytes + page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (map == MAP_FAILED)
+    {
+        delete task;
+        return pdFAIL;
+    }
+    mprotect(map, page, PROT_NONE);
+    task->stackLow = (uint8_t *)map + page;
+    task->stackBytes = bytes;
+    task->stackDepth = stackDepth;
+    memset(task->stackLow, NATIVE_STACK_FILL, bytes);
+
+    if (handle)
+        *handle = task;
+
+    // Stack memory stays mapped after the thread ends (tasks are never freed)
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, task->stackLow, bytes);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_t thread;
+    const int rc = pthread_create(&thread, &attr, taskEntry, task);
+    pthread_attr_destroy(&attr);
+    return rc == 0 ? pdPASS : pdFAIL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth,
+                       void *param, UBaseType_t priority, TaskHandle_t *handle)
+{
+    return xTaskCreatePinnedToCore(fn, name, stackDepth, param, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    // Host threads cannot be killed from outside; only self-deletion is honoured
+    if (task == nullptr || task == currentTask)
+        throw TaskExit();
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (sim::isVirtualClock())
+    {
+        sim::advanceClockUs((uint64_t)ticks * 1000ULL);
+        std::this_thread::yield();
+        return;
+    }
+    if (ticks == 0)
+    {
+        std::this_thread::yield();
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *previousWakeTime, TickType_t increment)
+{
+    TickType_t target = *previousWakeTime + increment;
+    TickType_t now = xTaskGetTickCount();
+    *previousWakeTime = target;
+    if ((int32_t)(target - now) > 0)
+    {
+        vTaskDelay(target - now);
+        return pdTRUE;
+    }
+    return pdFALSE;
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return (TickType_t)(sim::clockUs() / 1000ULL);
+}
+
+TickType_t xTaskGetTickCountFromISR()
+{
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return selfTask();
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+    return (task ? task : selfTask())->name.c_str();
+}
+
+UBaseType_t uxTaskGetNumberOfTasks()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    UBaseType_t n = 0;
+    for (const NativeTask *t : registry)
+        n += t->alive ? 1 : 0;
+    return n;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *statusArray, UBaseType_t arraySize, uint32_t *totalRunTime)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    UBaseType_t n = 0;
+    for (const NativeTask *t : registry)
+        n += t->alive ? 1 : 0;
+    if (n > arraySize)
+        return 0; // as FreeRTOS: nothing filled in
+
+    n = 0;
+    for (NativeTask *t : registry)
+    {
+        if (!t->alive)
+            continue;
+        clockid_t clock;
+        const uint64_t cpuUs = pthread_getcpuclockid(t->thread, &clock) == 0 ? threadCpuUs(clock) : 0;
+
+        TaskStatus_t &s = statusArray[n++];
+        s.xHandle = t;
+        s.pcTaskName = t->name.c_str();
+        s.xTaskNumber = t->number;
+        s.eCurrentState = t == currentTask ? eRunning : eBlocked;
+        s.uxCurrentPriority = t->priority;
+        s.uxBasePriority = t->priority;
+        s.ulRunTimeCounter = (uint32_t)cpuUs;
+        s.pxStackBase = (StackType_t *)t->stackLow;
+        s.usStackHighWaterMark = stackUntouched(t);
+        s.xCoreID = t->coreId;
+    }
+    if (totalRunTime)
+    {
+        *totalRunTime = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - shimStart)
+                            .count();
+    }
+    return n;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    NativeTask *t = task ? task : selfTask();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return stackUntouched(t);
+}
+
+BaseType_t xPortGetCoreID()
+{
+    return selfTask()->coreId;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    if (!task)
+        return pdFAIL;
+    {
+        std::lock_guard<std::mutex> lock(task->notifyMutex);
+        task->notifyValue++;
+    }
+    task->notifyCv.notify_one();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higherPriorityTaskWoken)
+{
+    xTaskNotifyGive(task);
+    if (higherPriorityTaskWoken)
+        *higherPriorityTaskWoken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait)
+{
+    NativeTask *self = selfTask();
+    std::unique_lock<std::mutex> lock(self->notifyMutex);
+    waitTicks(self->notifyCv, lock, ticksToWait, [self]
+              { return self->notifyValue > 0; });
+
+    uint32_t value = self->notifyValue;
+    if (value > 0)
+        self->notifyValue = clearCountOnExit ? 0 : value - 1;
+    return value;
+}
+
+// ========== SEMAPHORES ==========
+struct NativeSemaphore
+{
+    std::mutex m;
+    std::condition_variable cv;
+    UBaseType_t count;
+    UBaseType_t maxCount;
+};
+
+static SemaphoreHandle_t createSemaphore(UBaseType_t maxCount, UBaseType_t initialCount)
+{
+    NativeSemaphore *sem = new NativeSemaphore();
+    sem->count = initialCount;
+    sem->maxCount = maxCount;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return createSemaphore(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return createSemaphore(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount)
+{
+    return createSemaphore(maxCount, initialCount);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    delete sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticksToWait)
+{
+    if (!sem)
+        return pdFALSE;
+    std::unique_lock<std::mutex> lock(sem->m);
+    if (!waitTicks(sem->cv, lock, ticksToWait, [sem]
+                   { return sem->count > 0; }))
+        return pdFALSE;
+    sem->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (!sem)
+        return pdFALSE;
+    {
+        std::lock_guard<std::mutex> lock(sem->m);
+        if (sem->count >= sem->maxCount)
+            return pdFALSE;
+        sem->count++;
+    }
+    sem->cv.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *higherPriorityTaskWoken)
+{
+    if (higherPriorityTaskWoken)
+        *higherPriorityTaskWoken = pdFALSE;
+    return xSemaphoreGive(sem);
+}
+
+// ========== QUEUES ==========
+struct NativeQueue
+{
+    std::mutex m;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    std::vector<uint8_t> storage;
+    UBaseType_t head = 0;
+    UBaseType_t count = 0;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    NativeQueue *q = new NativeQueue();
+    q->length = length;
+    q->itemSize = itemSize;
+    q->storage.resize((size_t)length * itemSize);
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticksToWait)
+{
+    if (!q)
+        return pdFALSE;
+    {
+        std::unique_lock<std::mutex> lock(q->m);
+        if (!waitTicks(q->notFull, lock, ticksToWait, [q]
+                       { return q->count < q->length; }))
+            return pdFALSE;
+        UBaseType_t slot = (q->head + q->count) % q->length;
+        memcpy(&q->storage[(size_t)slot * q->itemSize], item, q->itemSize);
+        q->count++;
+    }
+    q->notEmpty.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *higherPriorityTaskWoken)
+{
+    if (higherPriorityTaskWoken)
+        *higherPriorityTaskWoken = pdFALSE;
+    return xQueueSend(q, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticksToWait)
+{
+    if (!q)
+        return pdFALSE;
+    {
+        std::unique_lock<std::mutex> lock(q->m);
+        if (!waitTicks(q->notEmpty, lock, ticksToWait, [q]
+                       { return q->count > 0; }))
+            return pdFALSE;
+        memcpy(item, &q->storage[(size_t)q->head * q->itemSize], q->itemSize);
+        q->head = (q->head + 1) % q->length;
+        q->count--;
+    }
+    q->notFull.notify_one();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    std::lock_guard<std::mutex> lock(q->m);
+    return q->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q)
+{
+    std::lock_guard<std::mutex> lock(q->m);
+    return q->length - q->count;
+}
+
+// ========== TIMERS ==========
+struct NativeTimer
+{
+    std::string name;
+    TickType_t period;
+    bool autoReload;
+    void *id;
+    TimerCallbackFunction_t callback;
+    bool active = false;
+    TickType_t nextDue = 0;
+};
+
+namespace
+{
+    std::mutex timerMutex;
+    std::condition_variable timerCv;
+    std::vector<NativeTimer *> timers;
+    bool timerDaemonStarted = false;
+
+    void timerDaemon(void *)
+    {
+        std::unique_lock<std::mutex> lock(timerMutex);
+        while (true)
+        {
+            // Poll at 1 ms granularity so virtual clock advances are seen too
+            timerCv.wait_for(lock, std::chrono::milliseconds(1));
+
+            TickType_t now = xTaskGetTickCount();
+            std::vector<NativeTimer *> due;
+            for (NativeTimer *t : timers)
+            {
+                if (t->active && (int32_t)(now - t->nextDue) >= 0)
+                {
+                    due.push_back(t);
+                    if (t->autoReload)
+                        t->nextDue += t->period;
+                    else
+                        t->active = false;
+                }
+            }
+
+            lock.unlock();
+            for (NativeTimer *t : due)
+                t->callback(t);
+            lock.lock();
+        }
+    }
+
+    void ensureTimerDaemon()
+    {
+        if (!timerDaemonStarted)
+        {
+            timerDaemonStarted = true;
+            xTaskCreate(timerDaemon, "Tmr Svc", 2048, nullptr, 1, nullptr);
+        }
+    }
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t autoReload,
+                           void *timerId, TimerCallbackFunction_t callback)
+{
+    if (period == 0 || !callback)
+        return nullptr;
+
+    NativeTimer *t = new NativeTimer();
+    t->name = name ? name : "";
+    t->period = period;
+    t->autoReload = autoReload != 0;
+    t->id = timerId;
+    t->callback = callback;
+
+    std::lock_guard<std::mutex> lock(timerMutex);
+    timers.push_back(t);
+    ensureTimerDaemon();
+    return t;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticksToWait)
+{
+    (void)ticksToWait;
+    if (!timer)
+        return pdFAIL;
+    std::lock_guard<std::mutex> lock(timerMutex);
+    timer->nextDue = xTaskGetTickCount() + timer->period;
+    timer->active = true;
+    return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticksToWait)
+{
+    (void)ticksToWait;
+    if (!timer)
+        return pdFAIL;
+    std::lock_guard<std::mutex> lock(timerMutex);
+    timer->active = false;
+    return pdPASS;
+}
+
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticksToWait)
+{
+    (void)ticksToWait;
+    if (!timer)
+        return pdFAIL;
+    std::lock_guard<std::mutex> lock(timerMutex);
+    for (size_t i = 0; i < timers.size(); i++)
+    {
+        if (timers[i] == timer)
+        {
+            timers.erase(timers.begin() + i);
+            break;
+        }
+    }
+    delete timer;
+    return pdPASS;
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t newPeriod, TickType_t ticksToWait)
+{
+    (void)ticksToWait;
+    if (!timer || newPeriod == 0)
+        return pdFAIL;
+    std::lock_guard<std::mutex> lock(timerMutex);
+    timer->period = newPeriod;
+    timer->nextDue = xTaskGetTickCount() + newPeriod;
+    timer->active = true;
+    return pdPASS;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t timer)
+{
+    return timer ? timer->id : nullptr;
+}
@@ -0,0 +1,850 @@
+/**
+ * @file mcp2515_chip.cpp
+ * @brief MCP2515 behavioural model behind the autowp MCP2515 class
+ *
+ * Acceptance: RXB0 uses MASK0 with RXF0/RXF1, RXB1 uses MASK1 with RXF2..RXF5.
+ * Rollover (BUKT) is off at power-on and enabled by reset(), matching the
+ * library. A frame arriving for a full buffer with nowhere to roll over sets
+ * RXnOVR in EFLG and is lost.
+ *
+ * Raw SPI instructions (READ, WRITE, BIT MODIFY, READ STATUS, RX STATUS,
+ * READ RX BUFFER, LOAD TX BUFFER, RTS, RESET) are decoded between the
+ * chip-select edges for the registers the firmware uses. A buffer whose
+ * TXREQ is set by RTS or a TXBnCTRL write goes on the bus when CS rises,
+ * in normal mode and not bus-off. Library calls are counted as the number
+ * of SPI transactions the real library issues for them; SPI bytes are
+ * counted for raw transfers and library frame transmits.
+ *
+ * TEC / REC drive the EFLG error-state bits (warning at 96, passive at 128,
+ * TXBO for bus-off); every change of those bits sets ERRIF. A received
+ * frame decrements REC (to 119 from error-passive), a transmitted one TEC.
+ * Bus-off neither receives nor transmits and holds until the controller
+ * passes through configuration mode, which clears both counters (the
+ * automatic 128 x 11 recessive bit recovery is not modelled).
+ */
+
+#include "mcp2515.h"
+#include "SPI.h"
+#include "Arduino.h"
+#include "sim/sim_gpio.h"
+#include "sim/sim_mcp2515.h"
+#include "sim/virtual_bus.h"
+#include <mutex>
+
+namespace
+{
+    enum Mode
+    {
+        MODE_NORMAL,
+        MODE_SLEEP,
+        MODE_LOOPBACK,
+        MODE_LISTENONLY,
+        MODE_CONFIG
+    };
+
+    struct Filter
+    {
+        uint32_t id;
+        bool ext;
+    };
+
+    // SPI instructions and register addresses
+    enum : uint8_t
+    {
+        INSTR_WRITE = 0x02,
+        INSTR_READ = 0x03,
+        INSTR_BIT_MODIFY = 0x05,
+        INSTR_LOAD_TX = 0x40,
+        INSTR_RTS = 0x80,
+        INSTR_READ_STATUS = 0xA0,
+        INSTR_RX_STATUS = 0xB0,
+        INSTR_RESET = 0xC0,
+        REG_CANSTAT = 0x0E,
+        REG_CANCTRL = 0x0F,
+        REG_TEC = 0x1C,
+        REG_REC = 0x1D,
+        REG_CANINTE = 0x2B,
+        REG_CANINTF = 0x2C,
+        REG_EFLG = 0x2D,
+        REG_TXB0CTRL = 0x30,
+        TXB_REGS = 14, // CTRL, SIDH, SIDL, EID8, EID0, DLC, D0..D7
+        TXBCTRL_TXREQ = 0x08,
+        REG_RXB0CTRL = 0x60,
+        REG_RXB1CTRL = 0x70,
+        RXBCTRL_BUKT = 0x04,
+        SIDL_IDE = 0x08
+    };
+
+    struct Chip
+    {
+        std::mutex m;
+        Mode mode = MODE_CONFIG;
+        bool rollover = false;
+        Filter filters[6] = {};
+        uint32_t masks[2] = {0, 0};
+        can_frame rxb[2] = {};
+        uint8_t txb[3][TXB_REGS] = {};
+        uint8_t txPending = 0; // buffers to send when CS rises
+        uint8_t canintf = 0;
+        uint8_t caninte = 0; // power-on: no interrupt sources, INT stays high
+        uint8_t eflg = 0;
+        uint8_t tec = 0;
+        uint8_t rec = 0;
+        bool busOff = false;
+        uint32_t rxOverflows = 0;
+        uint32_t spiTransactions = 0;
+        uint32_t spiBytes = 0;
+        int busNode = -1;
+        int intPin = -1;
+
+        // Raw SPI transaction in progress (CS low)
+        bool csLow = false;
+        uint32_t spiCount = 0; // bytes clocked in this transaction
+        uint8_t spiOp = 0;
+        uint8_t spiAddr = 0;
+        uint8_t spiMask = 0;
+        uint8_t spiClearFlag = 0; // RXnIF cleared when READ RX BUFFER ends
+    };
+
+    Chip chip;
+
+    bool matches(const Filter &f, uint32_t mask, const sim::BusFrame &frame)
+    {
+        if (f.ext != frame.extended)
+            return false;
+        uint32_t m = frame.extended ? (mask & CAN_EFF_MASK) : (mask & CAN_SFF_MASK);
+        return ((frame.id ^ f.id) & m) == 0;
+    }
+
+    void updateIntLine()
+    {
+        if (chip.intPin < 0)
+            return;
+        bool asserted = (chip.canintf & chip.caninte) != 0;
+        sim::setPinLevel((uint8_t)chip.intPin, asserted ? LOW : HIGH);
+    }
+
+    // EFLG error-state bits from TEC / REC; ERRIF when they change (chip.m held)
+    void updateErrorState()
+    {
+        uint8_t state = 0;
+        if (chip.busOff)
+            state |= MCP2515::EFLG_TXBO;
+        if (chip.tec >= 128)
+            state |= MCP2515::EFLG_TXEP;
+        if (chip.rec >= 128)
+            state |= MCP2515::EFLG_RXEP;
+        if (chip.tec >= 96)
+            state |= MCP2515::EFLG_TXWAR;
+        if (chip.rec >= 96)
+            state |= MCP2515::EFLG_RXWAR;
+        if (chip.tec >= 96 || chip.rec >= 96)
+            state |= MCP2515::EFLG_EWARN;
+        if ((chip.eflg & 0x3F) != state)
+            chip.canintf |= MCP2515::CANINTF_ERRIF;
+        chip.eflg = (uint8_t)((chip.eflg & 0xC0) | state);
+    }
+
+    void store(int n, const sim::BusFrame &frame)
+    {
+        can_frame &f = chip.rxb[n];
+        f.can_id = frame.id | (frame.extended ? CAN_EFF_FLAG : 0) | (frame.rtr ? CAN_RTR_FLAG : 0);
+        f.can_dlc = frame.dlc;
+        memcpy(f.data, frame.data, 8);
+        chip.canintf |= (n == 0) ? MCP2515::CANINTF_RX0IF : MCP2515::CANINTF_RX1IF;
+    }
+
+    // --- Register file (chip.m held) ---
+    uint8_t statusByte()
+    {
+        // READ STATUS layout: bit0 RX0IF, bit1 RX1IF, bit2 TX0REQ, bit3 TX0IF,
+        // bit4 TX1REQ, bit5 TX1IF, bit6 TX2REQ, bit7 TX2IF
+        uint8_t s = 0;
+        for (int n = 0; n < 3; n++)
+        {
+            if (chip.txb[n][0] & TXBCTRL_TXREQ)
+                s |= (uint8_t)(0x04 << (2 * n));
+        }
+        if (chip.canintf & MCP2515::CANINTF_RX0IF)
+            s |= 0x01;
+        if (chip.canintf & MCP2515::CANINTF_RX1IF)
+            s |= 0x02;
+        if (chip.canintf & MCP2515::CANINTF_TX0IF)
+            s |= 0x08;
+        if (chip.canintf & MCP2515::CANINTF_TX1IF)
+            s |= 0x20;
+        if (chip.canintf & MCP2515::CANINTF_TX2IF)
+            s |= 0x80;
+        return s;
+    }
+
+    // SIDH, SIDL, EID8, EID0, DLC, D0..D7 of one receive buffer
+    uint8_t rxBufferByte(int n, uint8_t offset)
+    {
+        const can_frame &f = chip.rxb[n];
+        const bool ext = (f.can_id & CAN_EFF_FLAG) != 0;
+        const bool rtr = (f.can_id & CAN_RTR_FLAG) != 0;
+        const uint32_t id = f.can_id & (ext ? CAN_EFF_MASK : CAN_SFF_MASK);
+        const uint32_t sid = ext ? id >> 18 : id;
+        switch (offset)
+        {
+        case 0:
+            return (uint8_t)(sid >> 3);
+        case 1:
+            return (uint8_t)(((sid & 0x07) << 5) | (ext ? SIDL_IDE | ((id >> 16) & 0x03) : (rtr ? 0x10 : 0)));
+        case 2:
+            return ext ? (uint8_t)(id >> 8) : 0;
+        case 3:
+            return ext ? (uint8_t)id : 0;
+        case 4:
+            return (uint8_t)((f.can_dlc & 0x0F) | (ext && rtr ? 0x40 : 0));
+        default:
+            return offset < 13 ? f.data[offset - 5] : 0;
+        }
+    }
+
+    // TXBn register index for addr, -1 outside the transmit buffers
+    int txbIndex(uint8_t addr, int &n)
+    {
+        n = (addr - REG_TXB0CTRL) >> 4;
+        const int offset = addr & 0x0F;
+        if (addr < REG_TXB0CTRL || n > 2 || offset >= TXB_REGS)
+            return -1;
+        return offset;
+    }
+
+    uint8_t readRegister(uint8_t addr)
+    {
+        int txbn;
+        const int txOffset = txbIndex(addr, txbn);
+        if (txOffset >= 0)
+            return chip.txb[txbn][txOffset];
+        if (addr >= REG_RXB0CTRL + 1 && addr <= REG_RXB0CTRL + 13)
+            return rxBufferByte(0, addr - REG_RXB0CTRL - 1);
+        if (addr >= REG_RXB1CTRL + 1 && addr <= REG_RXB1CTRL + 13)
+            return rxBufferByte(1, addr - REG_RXB1CTRL - 1);
+        switch (addr)
+        {
+        case REG_CANSTAT:
+        case REG_CANCTRL:
+            return (uint8_t)(chip.mode << 5);
+        case REG_TEC:
+            return chip.tec;
+        case REG_REC:
+            return chip.rec;
+        case REG_CANINTE:
+            return chip.caninte;
+        case REG_CANINTF:
+            return chip.canintf;
+        case REG_EFLG:
+            return chip.eflg;
+        case REG_RXB0CTRL:
+            return chip.rollover ? RXBCTRL_BUKT : 0;
+        default:
+            return 0;
+        }
+    }
+
+    void writeRegister(uint8_t addr, uint8_t value)
+    {
+        int txbn;
+        const int txOffset = txbIndex(addr, txbn);
+        if (txOffset == 0)
+        {
+            // Setting TXREQ requests a transmission, clearing it aborts a pending one
+            const bool request = (value & TXBCTRL_TXREQ) && !(chip.txb[txbn][0] & TXBCTRL_TXREQ);
+            chip.txb[txbn][0] = value & 0x0B;
+            if (request)
+                chip.txPending |= (uint8_t)(1 << txbn);
+            else if (!(value & TXBCTRL_TXREQ))
+                chip.txPending &= (uint8_t)~(1 << txbn);
+            return;
+        }
+        if (txOffset > 0)
+        {
+            chip.txb[txbn][txOffset] = value;
+            return;
+        }
+        switch (addr)
+        {
+        case REG_CANINTE:
+            chip.caninte = value;
+            break;
+        case REG_CANINTF:
+            chip.canintf = value;
+            break;
+        case REG_EFLG:
+            // Only RX0OVR / RX1OVR are writable
+            chip.eflg = (uint8_t)((chip.eflg & 0x3F) | (value & 0xC0));
+            break;
+        case REG_RXB0CTRL:
+            chip.rollover = (value & RXBCTRL_BUKT) != 0;
+            break;
+        default:
+            break;
+        }
+    }
+
+    void resetRegisters()
+    {
+        chip.mode = MODE_CONFIG;
+        for (Filter &f : chip.filters)
+            f = {0, false};
+        chip.masks[0] = chip.masks[1] = 0;
+        chip.canintf = 0;
+        chip.caninte = 0;
+        chip.eflg = 0;
+        chip.tec = chip.rec = 0;
+        chip.busOff = false;
+        chip.rollover = false;
+        memset(chip.txb, 0, sizeof(chip.txb));
+        chip.txPending = 0;
+    }
+
+    // Frame held by TXBn (CTRL at [0], then the RX buffer layout)
+    sim::BusFrame txbFrame(int n)
+    {
+        const uint8_t *r = chip.txb[n];
+        sim::BusFrame f = {};
+        uint32_t id = ((uint32_t)r[1] << 3) | (r[2] >> 5);
+        f.extended = (r[2] & SIDL_IDE) != 0;
+        if (f.extended)
+            id = (id << 18) | ((uint32_t)(r[2] & 0x03) << 16) | ((uint32_t)r[3] << 8) | r[4];
+        f.id = id;
+        f.rtr = (r[5] & 0x40) != 0;
+        f.dlc = r[5] & 0x0F;
+        if (f.dlc > 8)
+            f.dlc = 8;
+        memcpy(f.data, &r[6], 8);
+        return f;
+    }
+
+    // --- Raw SPI: one byte clocked while CS is low (chip.m held) ---
+    uint8_t spiByte(uint8_t in)
+    {
+        const uint32_t n = chip.spiCount++;
+        chip.spiBytes++;
+        if (n == 0)
+        {
+            chip.spiOp = in;
+            if ((in & 0xF8) == INSTR_LOAD_TX && (in & 0x07) <= 5)
+            {
+                // LOAD TX BUFFER 0100 0abc: ab = buffer, c = start at D0
+                chip.spiOp = INSTR_WRITE;
+                chip.spiAddr = (uint8_t)(REG_TXB0CTRL + ((in >> 1) & 0x03) * 0x10 + ((in & 0x01) ? 6 : 1));
+                chip.spiCount = 2; // data follows the instruction directly
+            }
+            else if ((in & 0xF8) == INSTR_RTS)
+            {
+                // RTS 1000 0nnn: one bit per buffer
+                for (int b = 0; b < 3; b++)
+                {
+                    if (in & (1 << b))
+                        writeRegister((uint8_t)(REG_TXB0CTRL + b * 0x10), chip.txb[b][0] | TXBCTRL_TXREQ);
+                }
+            }
+            else if ((in & 0xF9) == 0x90)
+            {
+                // READ RX BUFFER 1001 0nm0: n = buffer, m = start at D0
+                const int buf = (in >> 2) & 1;
+                chip.spiAddr = (uint8_t)((buf ? REG_RXB1CTRL : REG_RXB0CTRL) + ((in & 0x02) ? 6 : 1));
+                chip.spiClearFlag = buf ? MCP2515::CANINTF_RX1IF : MCP2515::CANINTF_RX0IF;
+            }
+            else if (in == INSTR_RESET)
+            {
+                resetRegisters();
+            }
+            return 0xFF;
+        }
+
+        switch (chip.spiOp)
+        {
+        case INSTR_READ:
+            if (n == 1)
+            {
+                chip.spiAddr = in;
+                return 0xFF;
+            }
+            return readRegister(chip.spiAddr++);
+        case INSTR_WRITE:
+            if (n == 1)
+                chip.spiAddr = in;
+            else
+                writeRegister(chip.spiAddr++, in);
+            return 0xFF;
+        case INSTR_BIT_MODIFY:
+            if (n == 1)
+                chip.spiAddr = in;
+            else if (n == 2)
+                chip.spiMask = in;
+            else if (n == 3)
+                writeRegister(chip.spiAddr, (uint8_t)((readRegister(chip.spiAddr) & ~chip.spiMask) | (in & chip.spiMask)));
+            return 0xFF;
+        case INSTR_READ_STATUS:
+            return statusByte();
+        case INSTR_RX_STATUS:
+            return (uint8_t)((chip.canintf & (MCP2515::CANINTF_RX0IF | MCP2515::CANINTF_RX1IF)) << 6);
+        default:
+            if (chip.spiClearFlag)
+                return readRegister(chip.spiAddr++);
+            return 0xFF;
+        }
+    }
+
+    // Send the buffers whose TXREQ was set in this transaction
+    void transmitPending()
+    {
+        sim::BusFrame frames[3];
+        int count = 0, node;
+        {
+            std::lock_guard<std::mutex> lock(chip.m);
+            if (chip.mode != MODE_NORMAL || chip.busOff)
+                return; // stays requested
+            for (int n = 0; n < 3; n++)
+            {
+                if (!(chip.txPending & (1 << n)))
+                    continue;
+                frames[count++] = txbFrame(n);
+                chip.txb[n][0] &= (uint8_t)~TXBCTRL_TXREQ;
+                chip.canintf |= (uint8_t)(MCP2515::CANINTF_TX0IF << n);
+                if (chip.tec > 0)
+                    chip.tec--;
+            }
+            updateErrorState();
+            chip.txPending = 0;
+            node = chip.busNode;
+        }
+        for (int i = 0; i < count; i++)
+            sim::busSend(sim::BUS_BMS, frames[i], node);
+    }
+
+    void onChipSelect(uint8_t pin, int level)
+    {
+        (void)pin;
+        {
+            std::lock_guard<std::mutex> lock(chip.m);
+            if (level == LOW)
+            {
+                if (!chip.csLow)
+                {
+                    chip.csLow = true;
+                    chip.spiCount = 0;
+                    chip.spiClearFlag = 0;
+                    chip.spiTransactions++;
+                }
+                return;
+            }
+            if (!chip.csLow)
+                return;
+            chip.csLow = false;
+            // READ RX BUFFER releases the buffer when CS rises after the read
+            if (chip.spiClearFlag && chip.spiCount > 1)
+                chip.canintf &= (uint8_t)~chip.spiClearFlag;
+        }
+        transmitPending();
+        updateIntLine();
+    }
+
+    void onBusFrame(const sim::BusFrame &frame, void *)
+    {
+        {
+            std::lock_guard<std::mutex> lock(chip.m);
+            if ((chip.mode != MODE_NORMAL && chip.mode != MODE_LISTENONLY) || chip.busOff)
+                return;
+
+            // Received without error, whether or not a filter accepts it
+            if (chip.rec > 127)
+                chip.rec = 119;
+            else if (chip.rec > 0)
+                chip.rec--;
+            updateErrorState();
+
+            bool hit0 = matches(chip.filters[0], chip.masks[0], frame) ||
+                        matches(chip.filters[1], chip.masks[0], frame);
+            bool hit1 = false;
+            for (int i = 2; i < 6 && !hit1; i++)
+                hit1 = matches(chip.filters[i], chip.masks[1], frame);
+
+            if (hit0)
+            {
+                if (!(chip.canintf & MCP2515::CANINTF_RX0IF))
+                    store(0, frame);
+                else if (chip.rollover && !(chip.canintf & MCP2515::CANINTF_RX1IF))
+                    store(1, frame);
+                else
+                {
+                    chip.eflg |= MCP2515::EFLG_RX0OVR;
+                    chip.canintf |= MCP2515::CANINTF_ERRIF;
+                    chip.rxOverflows++;
+                }
+            }
+            else if (hit1)
+            {
+                if (!(chip.canintf & MCP2515::CANINTF_RX1IF))
+                    store(1, frame);
+                else
+                {
+                    chip.eflg |= MCP2515::EFLG_RX1OVR;
+                    chip.canintf |= MCP2515::CANINTF_ERRIF;
+                    chip.rxOverflows++;
+                }
+            }
+        }
+        updateIntLine();
+    }
+}
+
+SPIClass SPI;
+
+void SPIClass::begin(int8_t sck, int8_t miso, int8_t mosi, int8_t ss)
+{
+    (void)sck;
+    (void)miso;
+    (void)mosi;
+    (void)ss;
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+    std::lock_guard<std::mutex> lock(chip.m);
+    return chip.csLow ? spiByte(data) : 0xFF;
+}
+
+void SPIClass::transferBytes(const uint8_t *data, uint8_t *out, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++)
+    {
+        uint8_t b = transfer(data ? data[i] : 0xFF);
+        if (out)
+            out[i] = b;
+    }
+}
+
+void SPIClass::writeBytes(const uint8_t *data, uint32_t size)
+{
+    transferBytes(data, nullptr, size);
+}
+
+namespace sim
+{
+    void mcp2515SetIntPin(uint8_t pin)
+    {
+        chip.intPin = pin;
+        updateIntLine();
+    }
+
+    void mcp2515InjectErrorFlags(uint8_t eflg)
+    {
+        std::lock_guard<std::mutex> lock(chip.m);
+        chip.eflg |= eflg;
+    }
+
+    void mcp2515InjectErrorPassive()
+    {
+        {
+            std::lock_guard<std::mutex> lock(chip.m);
+            if (chip.busOff || chip.rec >= 128)
+                return;
+            chip.rec = 128;
+            updateErrorState();
+        }
+        updateIntLine();
+    }
+
+    void mcp2515InjectBusOff()
+    {
+        {
+            std::lock_guard<std::mutex> lock(chip.m);
+            if (chip.busOff)
+                return;
+            chip.tec = 255;
+            chip.busOff = true;
+            updateErrorState();
+        }
+        updateIntLine();
+    }
+
+    uint32_t mcp2515RxOverflowCount()
+    {
+        std::lock_guard<std::mutex> lock(chip.m);
+        return chip.rxOverflows;
+    }
+
+    uint32_t mcp2515SpiTransactions()
+    {
+        std::lock_guard<std::mutex> lock(chip.m);
+        return chip.spiTransactions;
+    }
+
+    uint32_t mcp2515SpiBytes()
+    {
+        std::lock_guard<std::mutex> lock(chip.m);
+        return chip.spiBytes;
+    }
+}
+
+MCP2515::MCP2515(const uint8_t _CS, const uint32_t _SPI_CLOCK, void *_SPI) : cs(_CS)
+{
+    (void)_SPI_CLOCK;
+    (void)_SPI;
+    sim::onPinWrite(cs, onChipSelect);
+    std::lock_guard<std::mutex> lock(chip.m);
+    if (chip.busNode < 0)
+        chip.busNode = sim::busAttach(sim::BUS_BMS, onBusFrame, nullptr);
+}
+
+MCP2515::ERROR MCP2515::reset()
+{
+    {
+        // RESET instruction, then BUKT and the interrupt enables the library sets
+        std::lock_guard<std::mutex> lock(chip.m);
+        resetRegisters();
+        chip.rollover = true;
+        chip.caninte = CANINTF_RX0IF | CANINTF_RX1IF | CANINTF_ERRIF | CANINTF_MERRF;
+        chip.spiTransactions += 12;
+    }
+    updateIntLine();
+    return ERROR_OK;
+}
+
+static MCP2515::ERROR setMode(Mode mode)
+{
+    {
+        std::lock_guard<std::mutex> lock(chip.m);
+        chip.mode = mode;
+        chip.spiTransactions += 2; // modify CANCTRL, read back CANSTAT
+        if (mode == MODE_CONFIG)
+        {
+            // Configuration mode clears the error counters (and bus-off)
+            chip.tec = chip.rec = 0;
+            chip.busOff = false;
+            updateErrorState();
+        }
+    }
+    updateIntLine();
+    return MCP2515::ERROR_OK;
+}
+
+MCP2515::ERROR MCP2515::setConfigMode() { return setMode(MODE_CONFIG); }
+MCP2515::ERROR MCP2515::setListenOnlyMode() { return setMode(MODE_LISTENONLY); }
+MCP2515::ERROR MCP2515::setSleepMode() { return setMode(MODE_SLEEP); }
+MCP2515::ERROR MCP2515::setLoopbackMode() { return setMode(MODE_LOOPBACK); }
+MCP2515::ERROR MCP2515::setNormalMode() { return setMode(MODE_NORMAL); }
+
+MCP2515::ERROR MCP2515::setClkOut(int divisor)
+{
+    (void)divisor;
+    return ERROR_OK;
+}
+
+MCP2515::ERROR MCP2515::setBitrate(const CAN_SPEED canSpeed)
+{
+    return setBitrate(canSpeed, MCP_16MHZ);
+}
+
+MCP2515::ERROR MCP2515::setBitrate(const CAN_SPEED canSpeed, const CAN_CLOCK canClock)
+{
+    (void)canSpeed;
+    (void)canClock;
+    std::lock_guard<std::mutex> lock(chip.m);
+    chip.spiTransactions += 3;
+    return chip.mode == MODE_CONFIG ? ERROR_OK : ERROR_FAIL;
+}
+
+MCP2515::ERROR MCP2515::setFilterMask(const MASK num, const bool ext, const uint32_t ulData)
+{
+    (void)ext;
+    std::lock_guard<std::mutex> lock(chip.m);
+    chip.spiTransactions += 3; // setConfigMode + setRegisters
+    if (chip.mode != MODE_CONFIG)
+        return ERROR_FAIL;
+    chip.masks[num] = ulData;
+    return ERROR_OK;
+}
+
+MCP2515::ERROR MCP2515::setFilter(const RXF num, const bool ext, const uint32_t ulData)
+{
+    std::lock_guard<std::mutex> lock(chip.m);
+    chip.spiTransactions += 3;
+    if (chip.mode != MODE_CONFIG)
+        return ERROR_FAIL;
+    chip.filters[num] = {ulData, ext};
+    return ERROR_OK;
+}
+
+MCP2515::ERROR MCP2515::sendMessage(const TXBn txbn, const struct can_frame *frame)
+{
+    (void)txbn;
+    if (frame->can_dlc > CAN_MAX_DLEN)
+        return ERROR_FAILTX;
+
+    int node;
+    {
+        std::lock_guard<std::mutex> lock(chip.m);
+        chip.spiTransactions += 3; // load buffer, request, read back TXBnCTRL
+        chip.spiBytes += 2 + 5 + frame->can_dlc + 4 + 3;
+        if (chip.mode != MODE_NORMAL)
+            return ERROR_FAILTX;
+        if (chip.busOff)
+            return ERROR_FAILTX;
+        node = chip.busNode;
+    }
+
+    sim::BusFrame out = {};
+    out.extended = (frame->can_id & CAN_EFF_FLAG) != 0;
+    out.rtr = (frame->can_id & CAN_RTR_FLAG) != 0;
+    out.id = frame->can_id & (out.extended ? CAN_EFF_MASK : CAN_SFF_MASK);
+    out.dlc = frame->can_dlc;
+    memcpy(out.data, frame->data, frame->can_dlc);
+    sim::busSend(sim::BUS_BMS, out, node);
+
+    {
+        std::lock_guard<std::mutex> lock(chip.m);
+        chip.canintf |= CANINTF_TX0IF << txbn;
+        if (chip.tec > 0)
+            chip.tec--;
+        updateErrorState();
+    }
+    updateIntLine();
+    return ERROR_OK;
+}
+
+MCP2515::ERROR MCP2515::sendMessage(const struct can_frame *frame)
+{
+    // Transmission completes synchronously on the virtual bus, so TXB0 is always free
+    {
+        std::lock_guard<std::mutex> lock(chip.m);
+        chip.spiTransactions++; // TXB0CTRL checked for a free buffer
+        chip.spiBytes += 3;
+    }
+    return sendMessage(TXB0, frame);
+}
+
+MCP2515::ERROR MCP2515::readMessage(const RXBn rxbn, struct can_frame *frame)
+{
+    uint8_t flag = rxbn == RXB0 ? CANINTF_RX0IF : CANINTF_RX1IF;
+    {
+        std::lock_guard<std::mutex> lock(chip.m);
+        if (!(chip.canintf & flag))
+            return ERROR_NOMSG;
+        // Header, RXBnCTRL, data, then CANINTF modified to release the buffer
+        chip.spiTransactions += 4;
+        *frame = chip.rxb[rxbn];
+        chip.canintf &= (uint8_t)~flag;
+    }
+    updateIntLine();
+    return ERROR_OK;
+}
+
+MCP2515::ERROR MCP2515::readMessage(struct can_frame *frame)
+{
+    uint8_t intf;
+    {
+        std::lock_guard<std::mutex> lock(chip.m);
+        chip.spiTransactions++; // READ STATUS
+        intf = chip.canintf;
+    }
+    if (intf & CANINTF_RX0IF)
+        return readMessage(RXB0, frame);
+    if (intf & CANINTF_RX1IF)
+        return readMessage(RXB1, frame);
+    return ERROR_NOMSG;
+}
+
+bool MCP2515::checkReceive()
+{
+    std::lock_guard<std::mutex> lock(chip.m);
+    chip.spiTransactions++;
+    return (chip.canintf & (CANINTF_RX0IF | CANINTF_RX1IF)) != 0;
+}
+
+bool MCP2515::checkError()
+{
+    return (getErrorFlags() & EFLG_ERRORMASK) != 0;
+}
+
+uint8_t MCP2515::getErrorFlags()
+{
+    std::lock_guard<std::mutex> lock(chip.m);
+    chip.spiTransactions++;
+    return chip.eflg;
+}
+
+void MCP2515::clearRXnOVRFlags()
+{
+    std::lock_guard<std::mutex> lock(chip.m);
+    chip.spiTransactions++;
+    chip.eflg &= (uint8_t)~(EFLG_RX0OVR | EFLG_RX1OVR);
+}
+
+uint8_t MCP2515::getInterrupts()
+{
+    std::lock_guard<std::mutex> lock(chip.m);
+    chip.spiTransactions++;
+    return chip.canintf;
+}
+
+uint8_t MCP2515::getInterruptMask()
+{
+    std::lock_guard<std::mutex> lock(chip.m);
+    chip.spiTransactions++;
+    return chip.caninte;
+}
+
+void MCP2515::clearInterrupts()
+{
+    {
+        std::lock_guard<std::mutex> lock(chip.m);
+        chip.spiTransactions++;
+        chip.canintf = 0;
+    }
+    updateIntLine();
+}
+
+void MCP2515::clearTXInterrupts()
+{
+    std::lock_guard<std::mutex> lock(chip.m);
+    chip.spiTransactions++;
+    chip.canintf &= (uint8_t)~(CANINTF_TX0IF | CANINTF_TX1IF | CANINTF_TX2IF);
+}
+
+uint8_t MCP2515::getStatus()
+{
+    std::lock_guard<std::mutex> lock(chip.m);
+    chip.spiTransactions++;
+    return statusByte();
+}
+
+void MCP2515::clearRXnOVR()
+{
+    clearRXnOVRFlags();
+    clearERRIF();
+}
+
+void MCP2515::clearMERR()
+{
+    std::lock_guard<std::mutex> lock(chip.m);
+    chip.spiTransactions++;
+    chip.canintf &= (uint8_t)~CANINTF_MERRF;
+}
+
+void MCP2515::clearERRIF()
+{
+    std::lock_guard<std::mutex> lock(chip.m);
+    chip.spiTransactions++;
+    chip.canintf &= (uint8_t)~CANINTF_ERRIF;
+}
+
+uint8_t MCP2515::errorCountRX()
+{
+    std::lock_guard<std::mutex> lock(chip.m);
+    chip.spiTransactions++;
+    return chip.rec;
+}
+
+uint8_t MCP2515::errorCountTX()
+{
+    std::lock_guard<std::mutex> lock(chip.m);
+    chip.spiTransactions++;
+    return chip.tec;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file microocpp_stub.cpp
+ * @brief Connector-1 transaction flags standing in for MicroOcpp on the host
+ */
+
+#include "MicroOcpp.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+
+namespace
+{
+    std::atomic<bool> txRunning{false};
+    std::atomic<bool> permitsCharge{false};
+    std::atomic<uint32_t> endCount{0};
+    std::mutex reasonMutex;
+    std::string lastReason;
+}
+
+bool isTransactionActive(unsigned int connectorId)
+{
+    (void)connectorId;
+    return txRunning.load();
+}
+
+bool isTransactionRunning(unsigned int connectorId)
+{
+    (void)connectorId;
+    return txRunning.load();
+}
+
+bool ocppPermitsCharge(unsigned int connectorId)
+{
+    (void)connectorId;
+    return txRunning.load() && permitsCharge.load();
+}
+
+bool isOperative(unsigned int connectorId)
+{
+    (void)connectorId;
+    return true;
+}
+
+bool endTransaction(const char *idTag, const char *reason, unsigned int connectorId)
+{
+    (void)idTag;
+    (void)connectorId;
+    bool wasRunning = txRunning.exchange(false);
+    endCount.fetch_add(1);
+    std::lock_guard<std::mutex> lock(reasonMutex);
+    lastReason = reason ? reason : "";
+    return wasRunning;
+}
+
+bool beginTransaction(const char *idTag, unsigned int connectorId)
+{
+    (void)idTag;
+    (void)connectorId;
+    txRunning.store(true);
+    return true;
+}
+
+void mocpp_loop()
+{
+}
+
+namespace sim
+{
+    void setOcppTransaction(bool running, bool permits)
+    {
+        txRunning.store(running);
+        permitsCharge.store(permits);
+    }
+
+    uint32_t ocppEndTransactionCount()
+    {
+        return endCount.load();
+    }
+
+    const char *ocppLastStopReason()
+    {
+        std::lock_guard<std::mutex> lock(reasonMutex);
+        static thread_local std::string copy;
+        copy = lastReason;
+        return copy.c_str();
+    }
+}
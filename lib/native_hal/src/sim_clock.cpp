@@ -0,0 +1,61 @@
+/**
+ * @file sim_clock.cpp
+ * @brief Host time base: steady_clock in real mode, harness-driven in virtual mode
+ */
+
+#include "sim/sim_clock.h"
+#include "esp_timer.h"
+#include <atomic>
+#include <chrono>
+
+namespace
+{
+    const std::chrono::steady_clock::time_point processStart = std::chrono::steady_clock::now();
+    std::atomic<bool> virtualMode{false};
+    std::atomic<uint64_t> virtualUs{0};
+
+    uint64_t realUs()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now() - processStart)
+            .count();
+    }
+}
+
+namespace sim
+{
+    void useVirtualClock(bool enable)
+    {
+        if (enable && !virtualMode.load())
+        {
+            virtualUs.store(realUs());
+        }
+        virtualMode.store(enable);
+    }
+
+    bool isVirtualClock()
+    {
+        return virtualMode.load(std::memory_order_relaxed);
+    }
+
+    void setClockUs(uint64_t us)
+    {
+        virtualUs.store(us);
+    }
+
+    void advanceClockUs(uint64_t us)
+    {
+        virtualUs.fetch_add(us);
+    }
+
+    uint64_t clockUs()
+    {
+        return isVirtualClock() ? virtualUs.load(std::memory_order_relaxed) : realUs();
+    }
+
+} // namespace sim
+
+int64_t esp_timer_get_time()
+{
+    return (int64_t)sim::clockUs();
+}
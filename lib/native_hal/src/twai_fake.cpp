@@ -0,0 +1,368 @@
+/**
+ * @file twai_fake.cpp
+ * @brief ESP32 TWAI controller model attached to the simulated charger bus
+ *
+ * Implements the driver state machine (stopped / running / bus-off /
+ * recovering), the hardware acceptance filter, the RX queue with
+ * rx_missed_count on overflow, and the alert mask.
+ *
+ * Error states are driven by the sim_twai.h injectors. A recovery started
+ * by twai_initiate_recovery() completes 128 x 11 bit times (at the
+ * installed bitrate, on the sim clock) after the bus is free of faults;
+ * the controller then returns to stopped with TWAI_ALERT_BUS_RECOVERED.
+ * Each transmit that reaches the bus decrements TEC.
+ */
+
+#include "driver/twai.h"
+#include "sim/sim_clock.h"
+#include "sim/sim_twai.h"
+#include "sim/virtual_bus.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+
+namespace
+{
+    std::mutex m;
+    std::condition_variable rxCv;
+    std::condition_variable alertCv;
+
+    bool installed = false;
+    int busNode = -1;
+    twai_general_config_t general;
+    twai_filter_config_t filter;
+    twai_status_info_t status;
+    std::deque<twai_message_t> rxQueue;
+    uint32_t pendingAlerts = 0;
+
+    // Error confinement
+    uint32_t bitNs = 4000;
+    bool busFault = false;
+    uint64_t faultClearedUs = 0;
+    uint64_t recoveryStartUs = 0;
+
+    void raiseAlert(uint32_t alert)
+    {
+        if (general.alerts_enabled & alert)
+        {
+            pendingAlerts |= alert;
+            alertCv.notify_all();
+        }
+    }
+
+    void enterBusOff()
+    {
+        status.tx_error_counter = 256;
+        status.state = TWAI_STATE_BUS_OFF;
+        status.msgs_to_tx = 0;
+        raiseAlert(TWAI_ALERT_ABOVE_ERR_WARN | TWAI_ALERT_ERR_PASS | TWAI_ALERT_BUS_OFF);
+    }
+
+    // Recovery needs 128 occurrences of 11 recessive bits on a fault-free bus
+    void advanceRecovery()
+    {
+        if (status.state != TWAI_STATE_RECOVERING || busFault)
+            return;
+        const uint64_t from = recoveryStartUs > faultClearedUs ? recoveryStartUs : faultClearedUs;
+        if (sim::clockUs() < from + 128ULL * 11 * bitNs / 1000)
+            return;
+        status.tx_error_counter = 0;
+        status.rx_error_counter = 0;
+        status.state = TWAI_STATE_STOPPED;
+        raiseAlert(TWAI_ALERT_BUS_RECOVERED);
+    }
+
+    // ESP32 acceptance filter: code/mask aligned to the SJA1000 ACR/AMR layout,
+    // mask bit 1 = don't care
+    bool filterAccepts(const twai_message_t &msg)
+    {
+        uint32_t code = filter.acceptance_code;
+        uint32_t mask = filter.acceptance_mask;
+
+        if (filter.single_filter)
+        {
+            uint32_t bits = msg.extd ? ((msg.identifier << 3) | (msg.rtr ? 0x4 : 0))
+                                     : ((msg.identifier << 21) | (msg.rtr ? 0x100000 : 0) |
+                                        (msg.data_length_code > 0 ? (uint32_t)msg.data[0] << 8 : 0) |
+                                        (msg.data_length_code > 1 ? msg.data[1] : 0));
+            return ((bits ^ code) & ~mask) == 0;
+        }
+
+        // Dual filter: extended frames compare ID[28:13] against each half
+        uint16_t hi;
+        if (msg.extd)
+            hi = (uint16_t)(msg.identifier >> 13);
+        else
+            hi = (uint16_t)((msg.identifier << 5) | (msg.rtr ? 0x10 : 0));
+        bool f1 = ((hi ^ (uint16_t)(code >> 16)) & ~(uint16_t)(mask >> 16)) == 0;
+        bool f2 = ((hi ^ (uint16_t)code) & ~(uint16_t)mask) == 0;
+        return f1 || f2;
+    }
+
+    void onBusFrame(const sim::BusFrame &frame, void *)
+    {
+        twai_message_t msg = {};
+        msg.identifier = frame.id;
+        msg.extd = frame.extended;
+        msg.rtr = frame.rtr;
+        msg.data_length_code = frame.dlc;
+        memcpy(msg.data, frame.data, 8);
+
+        std::lock_guard<std::mutex> lock(m);
+        if (status.state != TWAI_STATE_RUNNING || busFault || !filterAccepts(msg))
+            return;
+
+        if (rxQueue.size() >= general.rx_queue_len)
+        {
+            status.rx_missed_count++;
+            raiseAlert(TWAI_ALERT_RX_QUEUE_FULL);
+            return;
+        }
+        rxQueue.push_back(msg);
+        status.msgs_to_rx = rxQueue.size();
+        raiseAlert(TWAI_ALERT_RX_DATA);
+        rxCv.notify_one();
+    }
+
+    template <typename Pred>
+    bool waitFor(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, TickType_t ticks, Pred pred)
+    {
+        if (ticks == portMAX_DELAY)
+        {
+            cv.wait(lock, pred);
+            return true;
+        }
+        if (ticks == 0)
+            return pred(); // polling call: no timed wait (it costs the host timer slack)
+        return cv.wait_for(lock, std::chrono::milliseconds(ticks), pred);
+    }
+}
+
+esp_err_t twai_driver_install(const twai_general_config_t *g_config,
+                              const twai_timing_config_t *t_config,
+                              const twai_filter_config_t *f_config)
+{
+    if (!g_config || !f_config)
+        return ESP_ERR_INVALID_ARG;
+
+    std::lock_guard<std::mutex> lock(m);
+    if (installed)
+        return ESP_ERR_INVALID_STATE;
+
+    general = *g_config;
+    filter = *f_config;
+    status = {};
+    status.state = TWAI_STATE_STOPPED;
+    // 80 MHz APB clock, 1 + tseg_1 + tseg_2 quanta per bit
+    if (t_config && t_config->brp)
+        bitNs = (uint32_t)(1000ULL * t_config->brp * (1 + t_config->tseg_1 + t_config->tseg_2) / 80);
+    rxQueue.clear();
+    pendingAlerts = 0;
+    recoveryStartUs = faultClearedUs = 0; // the harness may restart the sim clock between runs
+    installed = true;
+    busNode = sim::busAttach(sim::BUS_CHARGER, onBusFrame, nullptr);
+    return ESP_OK;
+}
+
+esp_err_t twai_driver_uninstall()
+{
+    std::lock_guard<std::mutex> lock(m);
+    if (!installed || (status.state != TWAI_STATE_STOPPED && status.state != TWAI_STATE_BUS_OFF))
+        return ESP_ERR_INVALID_STATE;
+    sim::busDetach(sim::BUS_CHARGER, busNode);
+    installed = false;
+    rxQueue.clear();
+    return ESP_OK;
+}
+
+esp_err_t twai_start()
+{
+    std::lock_guard<std::mutex> lock(m);
+    if (!installed || status.state != TWAI_STATE_STOPPED)
+        return ESP_ERR_INVALID_STATE;
+    status.state = TWAI_STATE_RUNNING;
+    return ESP_OK;
+}
+
+esp_err_t twai_stop()
+{
+    std::lock_guard<std::mutex> lock(m);
+    if (!installed || status.state != TWAI_STATE_RUNNING)
+        return ESP_ERR_INVALID_STATE;
+    status.state = TWAI_STATE_STOPPED;
+    rxQueue.clear();
+    return ESP_OK;
+}
+
+esp_err_t twai_transmit(const twai_message_t *message, TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    if (!message || message->data_length_code > TWAI_FRAME_MAX_DLC)
+        return ESP_ERR_INVALID_ARG;
+
+    {
+        std::lock_guard<std::mutex> lock(m);
+        if (!installed || status.state != TWAI_STATE_RUNNING)
+            return ESP_ERR_INVALID_STATE;
+        if (busFault)
+        {
+            // Accepted into the TX queue, then every retransmission fails
+            status.tx_failed_count++;
+            raiseAlert(TWAI_ALERT_BUS_ERROR | TWAI_ALERT_TX_FAILED);
+            enterBusOff();
+            return ESP_OK;
+        }
+    }
+
+    sim::BusFrame frame = {};
+    frame.id = message->identifier;
+    frame.extended = message->extd;
+    frame.rtr = message->rtr;
+    frame.dlc = message->data_length_code;
+    memcpy(frame.data, message->data, message->data_length_code);
+    sim::busSend(sim::BUS_CHARGER, frame, busNode);
+
+    std::lock_guard<std::mutex> lock(m);
+    raiseAlert(TWAI_ALERT_TX_SUCCESS | TWAI_ALERT_TX_IDLE);
+    if (status.tx_error_counter > 0)
+    {
+        status.tx_error_counter--;
+        if (status.tx_error_counter == 127)
+            raiseAlert(TWAI_ALERT_ERR_ACTIVE);
+        else if (status.tx_error_counter == 95)
+            raiseAlert(TWAI_ALERT_BELOW_ERR_WARN);
+    }
+    return ESP_OK;
+}
+
+esp_err_t twai_receive(twai_message_t *message, TickType_t ticks_to_wait)
+{
+    if (!message)
+        return ESP_ERR_INVALID_ARG;
+
+    std::unique_lock<std::mutex> lock(m);
+    if (!installed)
+        return ESP_ERR_INVALID_STATE;
+    if (!waitFor(rxCv, lock, ticks_to_wait, []
+                 { return !rxQueue.empty(); }))
+        return ESP_ERR_TIMEOUT;
+
+    *message = rxQueue.front();
+    rxQueue.pop_front();
+    status.msgs_to_rx = rxQueue.size();
+    return ESP_OK;
+}
+
+esp_err_t twai_read_alerts(uint32_t *alerts, TickType_t ticks_to_wait)
+{
+    if (!alerts)
+        return ESP_ERR_INVALID_ARG;
+
+    std::unique_lock<std::mutex> lock(m);
+    if (!installed)
+        return ESP_ERR_INVALID_STATE;
+
+    // A recovery finishes on the sim clock: look again every millisecond
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ticks_to_wait);
+    while (true)
+    {
+        advanceRecovery();
+        if (pendingAlerts != 0)
+            break;
+        const auto now = std::chrono::steady_clock::now();
+        if (ticks_to_wait != portMAX_DELAY && now >= deadline)
+        {
+            *alerts = 0;
+            return ESP_ERR_TIMEOUT;
+        }
+        auto slice = ticks_to_wait == portMAX_DELAY ? std::chrono::steady_clock::duration(std::chrono::hours(1))
+                                                     : deadline - now;
+        if (status.state == TWAI_STATE_RECOVERING && slice > std::chrono::milliseconds(1))
+            slice = std::chrono::milliseconds(1);
+        alertCv.wait_for(lock, slice);
+    }
+    *alerts = pendingAlerts;
+    pendingAlerts = 0;
+    return ESP_OK;
+}
+
+esp_err_t twai_reconfigure_alerts(uint32_t alerts_enabled, uint32_t *current_alerts)
+{
+    std::lock_guard<std::mutex> lock(m);
+    if (!installed)
+        return ESP_ERR_INVALID_STATE;
+    general.alerts_enabled = alerts_enabled;
+    if (current_alerts)
+        *current_alerts = pendingAlerts;
+    pendingAlerts &= alerts_enabled;
+    return ESP_OK;
+}
+
+esp_err_t twai_initiate_recovery()
+{
+    std::lock_guard<std::mutex> lock(m);
+    if (!installed || status.state != TWAI_STATE_BUS_OFF)
+        return ESP_ERR_INVALID_STATE;
+    status.state = TWAI_STATE_RECOVERING;
+    recoveryStartUs = sim::clockUs();
+    raiseAlert(TWAI_ALERT_RECOVERY_IN_PROGRESS);
+    advanceRecovery();
+    return ESP_OK;
+}
+
+esp_err_t twai_get_status_info(twai_status_info_t *status_info)
+{
+    if (!status_info)
+        return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> lock(m);
+    if (!installed)
+        return ESP_ERR_INVALID_STATE;
+    advanceRecovery();
+    *status_info = status;
+    return ESP_OK;
+}
+
+esp_err_t twai_clear_transmit_queue()
+{
+    return installed ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t twai_clear_receive_queue()
+{
+    std::lock_guard<std::mutex> lock(m);
+    if (!installed)
+        return ESP_ERR_INVALID_STATE;
+    rxQueue.clear();
+    status.msgs_to_rx = 0;
+    return ESP_OK;
+}
+
+namespace sim
+{
+    void twaiInjectBusOff()
+    {
+        std::lock_guard<std::mutex> lock(m);
+        if (installed && status.state == TWAI_STATE_RUNNING)
+            enterBusOff();
+    }
+
+    void twaiInjectErrorPassive()
+    {
+        std::lock_guard<std::mutex> lock(m);
+        if (!installed || status.state != TWAI_STATE_RUNNING || status.tx_error_counter >= 128)
+            return;
+        status.tx_error_counter = 128;
+        raiseAlert(TWAI_ALERT_ABOVE_ERR_WARN | TWAI_ALERT_ERR_PASS);
+    }
+
+    void twaiSetBusFault(bool fault)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        if (busFault && !fault)
+            faultClearedUs = sim::clockUs();
+        busFault = fault;
+        advanceRecovery();
+    }
+}
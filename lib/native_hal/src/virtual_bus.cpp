@@ -0,0 +1,89 @@
+/**
+ * @file virtual_bus.cpp
+ * @brief Synchronous in-process CAN buses
+ */
+
+#include "sim/virtual_bus.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct Node
+    {
+        int id;
+        sim::BusListener listener;
+        void *ctx;
+    };
+
+    struct Bus
+    {
+        std::mutex m;
+        std::vector<Node> nodes;
+        int nextId = 0;
+        std::atomic<uint32_t> frames{0};
+    };
+
+    Bus buses[sim::BUS_COUNT];
+}
+
+namespace sim
+{
+    int busAttach(BusId bus, BusListener listener, void *ctx)
+    {
+        Bus &b = buses[bus];
+        std::lock_guard<std::mutex> lock(b.m);
+        int id = b.nextId++;
+        b.nodes.push_back({id, listener, ctx});
+        return id;
+    }
+
+    void busDetach(BusId bus, int node)
+    {
+        Bus &b = buses[bus];
+        std::lock_guard<std::mutex> lock(b.m);
+        for (size_t i = 0; i < b.nodes.size(); i++)
+        {
+            if (b.nodes[i].id == node)
+            {
+                b.nodes.erase(b.nodes.begin() + i);
+                return;
+            }
+        }
+    }
+
+    void busSend(BusId bus, const BusFrame &frame, int sender)
+    {
+        Bus &b = buses[bus];
+        std::vector<Node> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(b.m);
+            snapshot = b.nodes;
+        }
+        b.frames.fetch_add(1, std::memory_order_relaxed);
+
+        // Deliver outside the lock: listeners may answer on the same bus
+        for (const Node &n : snapshot)
+        {
+            if (n.id != sender)
+                n.listener(frame, n.ctx);
+        }
+    }
+
+    uint32_t busFrameCount(BusId bus)
+    {
+        return buses[bus].frames.load(std::memory_order_relaxed);
+    }
+
+    void busReset()
+    {
+        for (Bus &b : buses)
+        {
+            std::lock_guard<std::mutex> lock(b.m);
+            b.nodes.clear();
+            b.frames.store(0);
+        }
+    }
+
+} // namespace sim
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+CAN trace tool for the firmware flight recorder (drivers/can_trace.h).
+
+  cantrace.py extract <serial.log> <out.cantrace>
+      Collect every "T <32 hex>" line (console 'r' dump or 'R' live stream)
+      from a serial monitor log into a binary .cantrace file.
+
+  cantrace.py show <file.cantrace> [--limit N]
+      Print records as text: time, bus, id, dlc, data.
+
+Replay a capture on the host with the native build:
+  pio run -e native && .pio/build/native/program replay <file.cantrace>
+"""
+
+import re
+import struct
+import sys
+
+MAGIC = 0x43525443  # "CTRC"
+VERSION = 1
+RECORD_SIZE = 16
+HEADER = struct.Struct("<IHHII")
+
+LINE_RE = re.compile(r"^T ([0-9A-Fa-f]{32})\s*$")
+DROPPED_RE = re.compile(r"dropped=(\d+)")
+
+
+def extract(log_path, out_path):
+    records = []
+    dropped = 0
+    with open(log_path, "r", errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            m = LINE_RE.match(line)
+            if m:
+                records.append(bytes.fromhex(m.group(1)))
+            elif line.startswith("#CANTRACE"):
+                d = DROPPED_RE.search(line)
+                if d:
+                    dropped += int(d.group(1))
+
+    with open(out_path, "wb") as f:
+        f.write(HEADER.pack(MAGIC, VERSION, RECORD_SIZE, len(records), dropped))
+        for r in records:
+            f.write(r)
+
+    print(f"{len(records)} records ({dropped} dropped on target) -> {out_path}")
+
+
+def show(path, limit):
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, version, size, count, dropped = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or version != VERSION or size != RECORD_SIZE:
+        sys.exit(f"{path}: not a v{VERSION} .cantrace file")
+
+    print(f"# {count} records, {dropped} dropped")
+    for i in range(min(count, limit) if limit else count):
+        off = HEADER.size + i * RECORD_SIZE
+        w0, w1 = struct.unpack_from("<II", data, off)
+        payload = data[off + 8:off + 16]
+        t_ms = w0 & 0x0FFFFFFF
+        dlc = w0 >> 28
+        can_id = w1 & 0x1FFFFFFF
+        ext = (w1 >> 29) & 1
+        bus = "BMS" if (w1 >> 30) & 1 else "CHG"
+        ident = f"{can_id:08X}" if ext else f"{can_id:03X}"
+        print(f"{t_ms / 1000:12.3f} {bus} {ident} [{dlc}] {payload[:dlc].hex(' ').upper()}")
+
+
+def main(argv):
+    if len(argv) >= 4 and argv[1] == "extract":
+        extract(argv[2], argv[3])
+    elif len(argv) >= 3 and argv[1] == "show":
+        limit = int(argv[4]) if len(argv) >= 5 and argv[3] == "--limit" else 0
+        show(argv[2], limit)
+    else:
+        sys.exit(__doc__)
+
+
+if __name__ == "__main__":
+    main(sys.argv)
@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""
+Hot-path scope timer dump (core/perf_trace.h) to a Chrome trace file.
+
+  perftrace.py extract <serial.log> <out.json> [--all]
+      Take the last console 'F' dump ("#PERFTRACE v1" ... "#PERFTRACE END")
+      from a serial monitor log, check it parses and write it as JSON.
+      With --all, every dump in the log goes into one file.
+
+Open the result in https://ui.perfetto.dev or chrome://tracing: one track
+per core, one slice per traced scope, times in µs since boot.
+"""
+
+import json
+import re
+import sys
+
+HEADER_RE = re.compile(r"^#PERFTRACE v1 records=(\d+) overwritten=(\d+) mhz=(\d+)")
+
+
+def dumps(log_path):
+    """Yield (header match, JSON text) for each complete dump in the log."""
+    header = None
+    body = []
+    with open(log_path, "r", errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            m = HEADER_RE.match(line)
+            if m:
+                header, body = m, []
+            elif line == "#PERFTRACE END":
+                if header:
+                    yield header, "\n".join(body)
+                header = None
+            elif header:
+                body.append(line)
+
+
+def extract(log_path, out_path, keep_all):
+    found = []
+    for header, text in dumps(log_path):
+        try:
+            found.append((header, json.loads(text)))
+        except json.JSONDecodeError as e:
+            print(f"skipping a dump that does not parse ({e}): serial line dropped?", file=sys.stderr)
+    if not found:
+        sys.exit(f"{log_path}: no complete #PERFTRACE dump")
+
+    if not keep_all:
+        found = found[-1:]
+    events = []
+    for _, trace in found:
+        events.extend(trace["traceEvents"])
+    with open(out_path, "w") as f:
+        json.dump({"displayTimeUnit": "ns", "traceEvents": events}, f)
+
+    slices = sum(1 for e in events if e.get("ph") == "X")
+    overwritten = sum(int(h.group(2)) for h, _ in found)
+    print(f"{slices} slices from {len(found)} dump(s) ({overwritten} overwritten on target) -> {out_path}")
+
+
+def main(argv):
+    if len(argv) >= 4 and argv[1] == "extract":
+        extract(argv[2], argv[3], "--all" in argv[4:])
+    else:
+        sys.exit(__doc__)
+
+
+if __name__ == "__main__":
+    main(sys.argv)
@@ -0,0 +1,430 @@
+#include "../../include/core/datatransfer_payload.h"
+#include "../../include/core/json_writer.h"
+#include "../../include/core/ocpp_outbox.h"
+#include "../../include/core/signal_history.h"
+#include "../../include/header.h"
+#include <math.h>
+#include <string.h>
+
+// =========================================================
+// ARENA
+// =========================================================
+// Staged texts in staging order; each one is contiguous, a new one goes
+// after the newest or, once that end is full, back at offset 0. The
+// spinlock only covers the entry list: texts are written and spilled by
+// the one staging task, outside it.
+static portMUX_TYPE arenaMux = portMUX_INITIALIZER_UNLOCKED;
+
+class PayloadArena
+{
+public:
+    struct Entry
+    {
+        DataTransferTicket ticket;
+        uint16_t off;
+        uint16_t bytes; // text + NUL, 4-aligned
+        DataTransferMessage type;
+        bool held; // queued in MicroOcpp, not answered yet
+    };
+
+    /// Largest free run for the next text (empty: the whole buffer)
+    void freeRun(size_t &off, size_t &cap) const
+    {
+        portENTER_CRITICAL(&arenaMux);
+        if (count_ == 0)
+        {
+            off = 0;
+            cap = DT_ARENA_BYTES;
+        }
+        else
+        {
+            const Entry &oldest = entries_[first_];
+            const Entry &newest = entries_[(first_ + count_ - 1) % DT_ARENA_ENTRIES];
+            const size_t end = newest.off + newest.bytes;
+            if (newest.off < oldest.off) // wrapped: between the newest and the oldest
+            {
+                off = end;
+                cap = oldest.off - end;
+            }
+            else if (DT_ARENA_BYTES - end >= oldest.off) // after the newest, or back at 0
+            {
+                off = end;
+                cap = DT_ARENA_BYTES - end;
+            }
+            else
+            {
+                off = 0;
+                cap = oldest.off;
+            }
+            if (count_ == DT_ARENA_ENTRIES)
+                cap = 0;
+        }
+        portEXIT_CRITICAL(&arenaMux);
+    }
+
+    char *at(size_t off) { return text_ + off; }
+
+    DataTransferTicket add(DataTransferMessage type, size_t off, size_t len)
+    {
+        portENTER_CRITICAL(&arenaMux);
+        if (++last_ == 0)
+            ++last_;
+        Entry &e = entries_[(first_ + count_) % DT_ARENA_ENTRIES];
+        e.ticket = last_;
+        e.off = (uint16_t)off;
+        e.bytes = (uint16_t)((len + 1 + 3) & ~(size_t)3);
+        e.type = type;
+        e.held = false;
+        count_++;
+        const DataTransferTicket ticket = last_;
+        portEXIT_CRITICAL(&arenaMux);
+        return ticket;
+    }
+
+    /// Remove the oldest text; false if there is none
+    bool popOldest(Entry &out)
+    {
+        portENTER_CRITICAL(&arenaMux);
+        const bool any = count_ > 0;
+        if (any)
+        {
+            out = entries_[first_];
+            first_ = (first_ + 1) % DT_ARENA_ENTRIES;
+            count_--;
+        }
+        portEXIT_CRITICAL(&arenaMux);
+        return any;
+    }
+
+    const char *get(DataTransferTicket ticket) const
+    {
+        const char *text = nullptr;
+        portENTER_CRITICAL(&arenaMux);
+        const Entry *e = find(ticket);
+        if (e)
+            text = text_ + e->off;
+        portEXIT_CRITICAL(&arenaMux);
+        return text;
+    }
+
+    void setHeld(DataTransferTicket ticket, bool held)
+    {
+        portENTER_CRITICAL(&arenaMux);
+        Entry *e = const_cast<Entry *>(find(ticket));
+        if (e)
+            e->held = held;
+        portEXIT_CRITICAL(&arenaMux);
+    }
+
+private:
+    const Entry *find(DataTransferTicket ticket) const
+    {
+        for (uint8_t i = 0; ticket != 0 && i < count_; i++)
+        {
+            const Entry &e = entries_[(first_ + i) % DT_ARENA_ENTRIES];
+            if (e.ticket == ticket)
+                return &e;
+        }
+        return nullptr;
+    }
+
+    alignas(4) char text_[DT_ARENA_BYTES] = {};
+    Entry entries_[DT_ARENA_ENTRIES] = {};
+    uint8_t first_ = 0;
+    uint8_t count_ = 0;
+    DataTransferTicket last_ = 0;
+};
+
+static PayloadArena arena;
+static_assert(DT_VEHICLE_TELEMETRY_BYTES <= DT_ARENA_BYTES && DT_SESSION_SUMMARY_BYTES <= DT_ARENA_BYTES &&
+                  DT_BMS_ALERT_BYTES <= DT_ARENA_BYTES && DT_BUS_STATS_BYTES <= DT_ARENA_BYTES &&
+                  DT_DIAGNOSTICS_BYTES <= DT_ARENA_BYTES,
+              "every message must fit the empty arena");
+
+static DataTransferStats dtStats[DT_MESSAGES];
+
+static const char *MESSAGE_IDS[DT_MESSAGES] = {"VehicleTelemetry", "SessionSummary", "BMSAlert", "CanBusStats",
+                                                "Diagnostics"};
+static const uint16_t MAX_BYTES[DT_MESSAGES] = {DT_VEHICLE_TELEMETRY_BYTES, DT_SESSION_SUMMARY_BYTES,
+                                                DT_BMS_ALERT_BYTES, DT_BUS_STATS_BYTES, DT_DIAGNOSTICS_BYTES};
+
+static void bump(DataTransferMessage type, uint32_t DataTransferStats::*counter)
+{
+    portENTER_CRITICAL(&arenaMux);
+    dtStats[type].*counter += 1;
+    portEXIT_CRITICAL(&arenaMux);
+}
+
+// Free the oldest text. One still queued in MicroOcpp goes to the outbox:
+// its request then finds no text and is dropped, the outbox replays it
+static bool evictOldest()
+{
+    PayloadArena::Entry e;
+    if (!arena.popOldest(e))
+        return false;
+    if (!e.held)
+        return true;
+    const char *text = arena.at(e.off);
+    if (OCPP_OUTBOX::append(e.type, text, strlen(text)))
+    {
+        bump(e.type, &DataTransferStats::spilled);
+    }
+    else
+    {
+        bump(e.type, &DataTransferStats::lost);
+        Serial.printf("[OCPP] ❌ %s lost: arena full and outbox unavailable\n", MESSAGE_IDS[e.type]);
+    }
+    return true;
+}
+
+// Let build() write the text into free arena space, evicting the oldest
+// texts until it fits; 0 if it does not fit DT_*_BYTES
+template <typename Build>
+static DataTransferTicket stage(DataTransferMessage type, Build build)
+{
+    const size_t maxBytes = MAX_BYTES[type];
+    bump(type, &DataTransferStats::staged);
+    while (true)
+    {
+        size_t off, cap;
+        arena.freeRun(off, cap);
+        const size_t len = cap ? build(arena.at(off), cap < maxBytes ? cap : maxBytes) : 0;
+        if (len)
+        {
+            portENTER_CRITICAL(&arenaMux);
+            if (len > dtStats[type].maxLen)
+                dtStats[type].maxLen = (uint16_t)len;
+            portEXIT_CRITICAL(&arenaMux);
+            return arena.add(type, off, len);
+        }
+        if (cap >= maxBytes || !evictOldest())
+        {
+            bump(type, &DataTransferStats::tooLarge);
+            return 0;
+        }
+    }
+}
+
+// ids: [id, tx, frames, minUs, meanUs, p99Us, maxUs, jitterP99Us]
+static size_t renderBusStats(char *out, size_t cap, const char *reason, uint32_t uptimeS)
+{
+    JsonWriter w(out, cap);
+    w.beginObject().add("reason", reason).add("uptime", uptimeS).beginArray("buses");
+
+    CanBusStats s;
+    for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++)
+    {
+        CAN_STATS::snapshot((CanBus)bus, s);
+        w.beginObject()
+            .add("bus", (uint32_t)(bus + 1))
+            .add("load", s.loadPercent)
+            .add("peak", s.peakLoadPercent)
+            .add("fps", s.framesPerSec)
+            .add("rx", s.rxFrames)
+            .add("tx", s.txFrames)
+            .add("drops", s.ringDrops)
+            .add("missed", s.controllerMissed);
+        if (bus == CAN_BUS_BMS)
+            w.add("rx0ovr", s.rx0Overruns).add("rx1ovr", s.rx1Overruns);
+        w.add("rejected", s.rejected).add("untracked", s.untracked).beginArray("ids");
+        for (uint8_t i = 0; i < s.idCount; i++)
+        {
+            const CanIdStats &d = s.ids[i];
+            w.beginArray()
+                .add(nullptr, d.id)
+                .add(nullptr, (uint32_t)(d.tx ? 1 : 0))
+                .add(nullptr, d.frames)
+                .add(nullptr, d.minUs)
+                .add(nullptr, d.meanUs)
+                .add(nullptr, d.p99Us)
+                .add(nullptr, d.maxUs)
+                .add(nullptr, d.jitterP99Us)
+                .end();
+        }
+        w.end().end();
+    }
+    return w.end().end().finish();
+}
+
+static float cpuPercent(uint16_t permille)
+{
+    return permille == TASK_PROFILER_NO_CPU ? NAN : permille / 10.0f; // null
+}
+
+// cores: [busyShort, busyLong] in %; tasks: [name, core (-1 = any), prio,
+// cpuShort, cpuLong (% of one core), stackFreeMin, stackSize (0 = unknown)]
+static size_t renderDiagnostics(char *out, size_t cap, const char *reason, uint32_t uptimeS)
+{
+    static ProfilerSnapshot s; // staging task (OCPP) only
+    if (!TASK_PROFILER::snapshot(s))
+        return 0;
+
+    JsonWriter w(out, cap);
+    w.beginObject().add("reason", reason).add("uptime", uptimeS).beginArray("windowsS");
+    w.add(nullptr, (uint32_t)((s.shortWindowMs + 500) / 1000)).add(nullptr, (uint32_t)((s.longWindowMs + 500) / 1000)).end();
+    w.beginArray("cores");
+    for (uint8_t c = 0; c < TASK_PROFILER_CORES; c++)
+    {
+        w.beginArray()
+            .add(nullptr, cpuPercent(s.coreShortPermille[c]), 1)
+            .add(nullptr, cpuPercent(s.coreLongPermille[c]), 1)
+            .end();
+    }
+    w.end().beginArray("tasks");
+    for (uint8_t i = 0; i < s.taskCount; i++)
+    {
+        const TaskProfile &t = s.tasks[i];
+        w.beginArray()
+            .add(nullptr, t.name)
+            .add(nullptr, (int32_t)t.core)
+            .add(nullptr, (uint32_t)t.priority)
+            .add(nullptr, cpuPercent(t.cpuShortPermille), 1)
+            .add(nullptr, cpuPercent(t.cpuLongPermille), 1)
+            .add(nullptr, t.stackFreeMin)
+            .add(nullptr, t.stackBytes)
+            .end();
+    }
+    w.end();
+    if (s.untracked)
+        w.add("untracked", (uint32_t)s.untracked);
+    return w.end().finish();
+}
+
+static void addSummary(JsonWriter &w, const char *key, const HistorySummary &s, bool withMin)
+{
+    w.beginObject(key);
+    if (withMin)
+        w.add("min", s.min);
+    w.add("max", s.max).add("mean", s.mean).end();
+}
+
+namespace DATATRANSFER
+{
+    DataTransferTicket stageVehicleTelemetry(const VehicleInfoBatch &batch, uint32_t nowMs)
+    {
+        return stage(DT_VEHICLE_TELEMETRY, [&](char *out, size_t cap) -> size_t
+                     {
+            uint8_t bin[TELEMETRY_FRAME_MAX_BYTES];
+            const size_t binLen = batch.encode(nowMs, bin, sizeof(bin));
+            return binLen ? TELEMETRY_FRAME::toBase64(bin, binLen, out, cap) : 0; });
+    }
+
+    DataTransferTicket stageSessionSummary(float finalSoc, float energyWh, float durationMin)
+    {
+        // Session profile from the signal history (finest tier covering the session)
+        const uint32_t toS = SIGNAL_HISTORY::nowS();
+        const uint32_t spanS = (uint32_t)(durationMin * 60.0f);
+        const uint32_t fromS = toS > spanS ? toS - spanS : 0;
+        const HistorySummary volt = SIGNAL_HISTORY::summarize(HIST_TERMINAL_VOLT, fromS, toS);
+        const HistorySummary curr = SIGNAL_HISTORY::summarize(HIST_TERMINAL_CURR, fromS, toS);
+        const HistorySummary temp = SIGNAL_HISTORY::summarize(HIST_CHARGER_TEMP, fromS, toS);
+        const HistorySummary soc = SIGNAL_HISTORY::summarize(HIST_SOC, fromS, toS);
+
+        return stage(DT_SESSION_SUMMARY, [&](char *out, size_t cap) -> size_t
+                     {
+            JsonWriter w(out, cap);
+            w.beginObject()
+                .add("finalSoc", finalSoc)
+                .add("energyDelivered", energyWh)
+                .add("durationMinutes", durationMin);
+            if (soc.buckets)
+                w.add("startSoc", soc.first);
+            if (volt.buckets)
+                addSummary(w, "voltage", volt, true);
+            if (curr.buckets)
+                addSummary(w, "current", curr, false);
+            if (temp.buckets)
+                addSummary(w, "temperature", temp, false);
+            w.add("historyResolutionS", HISTORY_TIER_SPECS[volt.tier].periodS);
+            return w.end().finish(); });
+    }
+
+    DataTransferTicket stageBmsAlert(const char *alertType, const char *message, uint32_t uptimeMs)
+    {
+        return stage(DT_BMS_ALERT, [&](char *out, size_t cap) -> size_t
+                     {
+            JsonWriter w(out, cap);
+            w.beginObject().add("alertType", alertType).add("message", message).add("timestamp", uptimeMs);
+            return w.end().finish(); });
+    }
+
+    DataTransferTicket stageBusStats(const char *reason, uint32_t uptimeS)
+    {
+        return stage(DT_BUS_STATS, [&](char *out, size_t cap) -> size_t
+                     { return renderBusStats(out, cap, reason, uptimeS); });
+    }
+
+    DataTransferTicket stageDiagnostics(const char *reason, uint32_t uptimeS)
+    {
+        return stage(DT_DIAGNOSTICS, [&](char *out, size_t cap) -> size_t
+                     { return renderDiagnostics(out, cap, reason, uptimeS); });
+    }
+
+    const char *data(DataTransferMessage type, DataTransferTicket ticket)
+    {
+        return type < DT_MESSAGES ? arena.get(ticket) : nullptr;
+    }
+
+    void hold(DataTransferTicket ticket)
+    {
+        arena.setHeld(ticket, true);
+    }
+
+    void release(DataTransferTicket ticket)
+    {
+        arena.setHeld(ticket, false);
+    }
+
+    const char *messageId(DataTransferMessage type)
+    {
+        return type < DT_MESSAGES ? MESSAGE_IDS[type] : "?";
+    }
+
+    size_t arenaBytes()
+    {
+        return sizeof(arena);
+    }
+
+    DataTransferStats stats(DataTransferMessage type)
+    {
+        DataTransferStats s = {};
+        if (type >= DT_MESSAGES)
+            return s;
+        portENTER_CRITICAL(&arenaMux);
+        s = dtStats[type];
+        portEXIT_CRITICAL(&arenaMux);
+        s.maxBytes = MAX_BYTES[type];
+        return s;
+    }
+
+    void resetStats()
+    {
+        portENTER_CRITICAL(&arenaMux);
+        memset(dtStats, 0, sizeof(dtStats));
+        portEXIT_CRITICAL(&arenaMux);
+    }
+
+    void printStats()
+    {
+        DataTransferStats s[DT_MESSAGES];
+        for (uint8_t t = 0; t < DT_MESSAGES; t++)
+            s[t] = stats((DataTransferMessage)t);
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        Serial.println("\n========== DATATRANSFER ARENA ==========");
+        Serial.printf("Static: %u bytes shared by all messages, no heap per message beyond MicroOcpp's request\n",
+                      (unsigned)arenaBytes());
+        Serial.println("message           max bytes  staged  max len  too large  spilled  lost");
+        for (uint8_t t = 0; t < DT_MESSAGES; t++)
+        {
+            Serial.printf("%-17s %9u %7u %8u %10u %8u %5u\n", MESSAGE_IDS[t], s[t].maxBytes, s[t].staged,
+                          s[t].maxLen, s[t].tooLarge, s[t].spilled, s[t].lost);
+        }
+        Serial.println("========================================\n");
+
+        xSemaphoreGive(serialMutex);
+    }
+
+} // namespace DATATRANSFER
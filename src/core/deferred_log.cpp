@@ -0,0 +1,286 @@
+#include "../../include/core/deferred_log.h"
+#include "../../include/core/task_profiler.h"
+#include "../../include/config/hardware.h"
+#include "../../include/config/timing.h"
+#include "../../include/header.h"
+#include <atomic>
+#include <string.h>
+
+static_assert((DLOG_CAPACITY & (DLOG_CAPACITY - 1)) == 0, "DLOG_CAPACITY must be a power of two");
+
+#define DLOG_BATCH 8 // lines per serialMutex hold
+
+static const uint32_t DLOG_MASK = DLOG_CAPACITY - 1;
+
+// Bounded MPMC queue (per-slot sequence numbers), with one consumer at a
+// time. A slot's seq is kept relative to its index so the zeroed ring is
+// the empty state: for position pos (lap = pos & ~MASK) the slot is free
+// at seq == lap, holds a line at lap + 1 and is free for the next lap at
+// lap + DLOG_CAPACITY.
+struct DlogSlot
+{
+    std::atomic<uint32_t> seq;
+    DlogRecord record;
+};
+
+static DlogSlot ring[DLOG_CAPACITY];
+static std::atomic<uint32_t> enqueuePos{0};
+static std::atomic<uint32_t> dequeuePos{0};
+
+static std::atomic<uint32_t> queuedCount{0};
+static std::atomic<uint32_t> droppedCount{0};
+static std::atomic<uint32_t> highWater{0};
+static uint32_t writtenCount = 0; // consumer only
+static uint32_t droppedReported = 0;
+
+static SemaphoreHandle_t consumerMutex = nullptr;
+static DlogSink sink = nullptr;
+static TaskHandle_t logTask = nullptr;
+
+static bool pop(DlogRecord &out)
+{
+    const uint32_t pos = dequeuePos.load(std::memory_order_relaxed);
+    DlogSlot &slot = ring[pos & DLOG_MASK];
+    const uint32_t lap = pos & ~DLOG_MASK;
+    if (slot.seq.load(std::memory_order_acquire) != lap + 1)
+        return false;
+    out = slot.record;
+    slot.seq.store(lap + DLOG_CAPACITY, std::memory_order_release);
+    dequeuePos.store(pos + 1, std::memory_order_relaxed);
+    return true;
+}
+
+static bool hasLength(const char *spec, const char *modifier)
+{
+    return strstr(spec, modifier) != nullptr;
+}
+
+// One conversion with its queued argument, cast to what the spec expects
+static int formatArg(char *out, size_t size, const char *spec, char conv, uint8_t type, const DlogArg &a)
+{
+    switch (conv)
+    {
+    case 'e':
+    case 'E':
+    case 'f':
+    case 'F':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+    {
+        const double v = type == DLOG_ARG_FLOAT ? a.f : (type == DLOG_ARG_INT ? (double)a.i : (double)a.u);
+        return snprintf(out, size, spec, v);
+    }
+    case 's':
+        return snprintf(out, size, spec, type == DLOG_ARG_STR && a.s ? a.s : "(?)");
+    case 'p':
+        return snprintf(out, size, spec, a.p);
+    case 'n':
+        return 0;
+    default:
+        break;
+    }
+
+    const bool isSigned = conv == 'd' || conv == 'i';
+    const int64_t sv = type == DLOG_ARG_INT ? (int64_t)a.i : (type == DLOG_ARG_FLOAT ? (int64_t)a.f : (int64_t)a.u);
+    if (hasLength(spec, "ll") || hasLength(spec, "j"))
+        return isSigned ? snprintf(out, size, spec, (long long)sv) : snprintf(out, size, spec, (unsigned long long)(uint32_t)sv);
+    if (hasLength(spec, "l"))
+        return isSigned ? snprintf(out, size, spec, (long)sv) : snprintf(out, size, spec, (unsigned long)(uint32_t)sv);
+    if (hasLength(spec, "z"))
+        return snprintf(out, size, spec, (size_t)(uint32_t)sv);
+    return isSigned ? snprintf(out, size, spec, (int)sv) : snprintf(out, size, spec, (unsigned)sv);
+}
+
+// Print up to DLOG_BATCH queued lines (caller holds consumerMutex)
+static uint32_t printBatch()
+{
+    if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+        return 0;
+
+    char line[DLOG_LINE_MAX];
+    DlogRecord r;
+    uint32_t n = 0;
+    while (n < DLOG_BATCH && pop(r))
+    {
+        const size_t len = DEFERRED_LOG::format(r, line, sizeof(line));
+        Serial.write((const uint8_t *)line, len);
+        if (sink)
+            sink(line, len);
+        n++;
+    }
+    writtenCount += n;
+
+    const uint32_t dropped = droppedCount.load(std::memory_order_relaxed);
+    if (dropped != droppedReported)
+    {
+        Serial.printf("[LOG] ⚠️  %u lines dropped (queue full)\n", (unsigned)(dropped - droppedReported));
+        droppedReported = dropped;
+    }
+
+    xSemaphoreGive(serialMutex);
+    return n;
+}
+
+static void drain()
+{
+    if (xSemaphoreTake(consumerMutex, portMAX_DELAY) != pdTRUE)
+        return;
+    while (printBatch() == DLOG_BATCH)
+    {
+    }
+    xSemaphoreGive(consumerMutex);
+}
+
+static void logTaskFn(void *arg)
+{
+    while (true)
+    {
+        vTaskDelay(pdMS_TO_TICKS(DLOG_DRAIN_MS));
+        drain();
+    }
+}
+
+namespace DEFERRED_LOG
+{
+    bool push(const DlogRecord &record)
+    {
+        uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+        DlogSlot *slot;
+        while (true)
+        {
+            slot = &ring[pos & DLOG_MASK];
+            const int32_t diff = (int32_t)(slot->seq.load(std::memory_order_acquire) - (pos & ~DLOG_MASK));
+            if (diff == 0)
+            {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        slot->record = record;
+        slot->seq.store((pos & ~DLOG_MASK) + 1, std::memory_order_release);
+
+        queuedCount.fetch_add(1, std::memory_order_relaxed);
+        const uint32_t depth = pos + 1 - dequeuePos.load(std::memory_order_relaxed);
+        uint32_t high = highWater.load(std::memory_order_relaxed);
+        while (depth > high && !highWater.compare_exchange_weak(high, depth, std::memory_order_relaxed))
+        {
+        }
+        return true;
+    }
+
+    bool init()
+    {
+        if (consumerMutex == nullptr)
+            consumerMutex = xSemaphoreCreateMutex();
+        if (consumerMutex == nullptr)
+            return false;
+        if (logTask != nullptr)
+            return true;
+        if (xTaskCreatePinnedToCore(logTaskFn, "LOG", TASK_STACK_SIZE_LOG, nullptr, TASK_PRIORITY_LOG, &logTask, 1) != pdPASS)
+        {
+            logTask = nullptr;
+            return false;
+        }
+        TASK_PROFILER::track(logTask, TASK_STACK_SIZE_LOG);
+        return true;
+    }
+
+    void flush()
+    {
+        if (consumerMutex == nullptr)
+            consumerMutex = xSemaphoreCreateMutex();
+        if (consumerMutex != nullptr)
+            drain();
+    }
+
+    size_t format(const DlogRecord &record, char *out, size_t size)
+    {
+        if (size == 0)
+            return 0;
+        size_t n = 0;
+        uint8_t arg = 0;
+        const char *p = record.format;
+        while (*p && n + 1 < size)
+        {
+            if (*p != '%')
+            {
+                out[n++] = *p++;
+                continue;
+            }
+            if (p[1] == '%')
+            {
+                out[n++] = '%';
+                p += 2;
+                continue;
+            }
+
+            char spec[16];
+            size_t k = 0;
+            spec[k++] = *p++;
+            while (*p && !strchr("diouxXeEfFgGaAcspn", *p) && k < sizeof(spec) - 2)
+                spec[k++] = *p++;
+            if (!*p)
+                break;
+            const char conv = *p++;
+            spec[k++] = conv;
+            spec[k] = '\0';
+            if (arg >= record.argc)
+                continue;
+
+            const int w = formatArg(out + n, size - n, spec, conv, record.types[arg], record.args[arg]);
+            arg++;
+            if (w > 0)
+                n += (size_t)w < size - n ? (size_t)w : size - n - 1;
+        }
+        // A cut line still ends the way its format does
+        if (*p && n > 0 && record.format[strlen(record.format) - 1] == '\n')
+            out[n - 1] = '\n';
+        out[n] = '\0';
+        return n;
+    }
+
+    void setSink(DlogSink s)
+    {
+        sink = s;
+    }
+
+    void getStats(DlogStats &out)
+    {
+        out.queued = queuedCount.load(std::memory_order_relaxed);
+        out.written = writtenCount;
+        out.dropped = droppedCount.load(std::memory_order_relaxed);
+        out.highWater = highWater.load(std::memory_order_relaxed);
+    }
+
+    void printStats()
+    {
+        DlogStats s;
+        getStats(s);
+        const uint32_t waiting = enqueuePos.load(std::memory_order_relaxed) - dequeuePos.load(std::memory_order_relaxed);
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        Serial.println("\n============ DEFERRED LOG ============");
+        Serial.printf("Queue      : %u / %u lines waiting (peak %u)\n", (unsigned)waiting, DLOG_CAPACITY,
+                      (unsigned)s.highWater);
+        Serial.printf("Lines      : %u queued, %u written\n", (unsigned)s.queued, (unsigned)s.written);
+        Serial.printf("Dropped    : %u%s\n", (unsigned)s.dropped, s.dropped ? " ⚠️  (queue full)" : "");
+        Serial.printf("LOG task   : %s, every %u ms\n", logTask ? "running" : "not started", DLOG_DRAIN_MS);
+        Serial.println("======================================\n");
+
+        xSemaphoreGive(serialMutex);
+    }
+
+} // namespace DEFERRED_LOG
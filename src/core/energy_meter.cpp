@@ -0,0 +1,119 @@
+#include "../../include/core/energy_meter.h"
+#include <Arduino.h>
+#include <string.h>
+
+// =========================================================
+// INTEGRATOR
+// =========================================================
+EnergyIntegrator::EnergyIntegrator(uint32_t maxGapUs)
+    : maxGapUs_(maxGapUs), enabled_(false)
+{
+    reset();
+}
+
+void EnergyIntegrator::reset()
+{
+    haveLast_ = false;
+    lastUs_ = 0;
+    lastPowerW_ = 0.0;
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+void EnergyIntegrator::setEnabled(bool enabled)
+{
+    if (enabled && !enabled_)
+        haveLast_ = false; // never integrate across a closed gate
+    enabled_ = enabled;
+}
+
+// Same terminal window the plug detection and the old loop() integration used
+bool EnergyIntegrator::plausible(float volt, float curr)
+{
+    return volt > 56.0f && volt < 85.5f && curr >= 0.0f && curr < 300.0f;
+}
+
+void EnergyIntegrator::addSample(uint64_t t_us, float volt, float curr)
+{
+    if (!enabled_)
+        return;
+
+    stats_.samples++;
+
+    if (!plausible(volt, curr))
+    {
+        stats_.rejected++;
+        haveLast_ = false;
+        return;
+    }
+
+    const double powerW = (double)volt * (double)curr;
+
+    // A sample older than the previous one (reordered) only restarts the interval
+    if (haveLast_ && t_us > lastUs_)
+    {
+        const uint64_t dtUs = t_us - lastUs_;
+        if (dtUs > maxGapUs_)
+        {
+            stats_.gaps++;
+            stats_.gapSeconds += dtUs * 1e-6;
+        }
+        else
+        {
+            const double dtS = dtUs * 1e-6;
+            stats_.energyWh += 0.5 * (lastPowerW_ + powerW) * dtS / 3600.0;
+            stats_.meteredSeconds += dtS;
+        }
+    }
+
+    lastUs_ = t_us;
+    lastPowerW_ = powerW;
+    haveLast_ = true;
+}
+
+// =========================================================
+// FIRMWARE INSTANCE
+// =========================================================
+// Written by the CAN dispatcher, gated and read by loop(): short spinlock
+static EnergyIntegrator meter;
+static portMUX_TYPE meterMux = portMUX_INITIALIZER_UNLOCKED;
+
+namespace ENERGY_METER
+{
+    void onTerminalPower(uint64_t rx_us, float volt, float curr)
+    {
+        portENTER_CRITICAL(&meterMux);
+        meter.addSample(rx_us, volt, curr);
+        portEXIT_CRITICAL(&meterMux);
+    }
+
+    void setMetering(bool on)
+    {
+        portENTER_CRITICAL(&meterMux);
+        meter.setEnabled(on);
+        portEXIT_CRITICAL(&meterMux);
+    }
+
+    void reset()
+    {
+        portENTER_CRITICAL(&meterMux);
+        meter.reset();
+        portEXIT_CRITICAL(&meterMux);
+    }
+
+    double energyWh()
+    {
+        portENTER_CRITICAL(&meterMux);
+        const double wh = meter.energyWh();
+        portEXIT_CRITICAL(&meterMux);
+        return wh;
+    }
+
+    EnergyMeterStats stats()
+    {
+        portENTER_CRITICAL(&meterMux);
+        const EnergyMeterStats s = meter.stats();
+        portEXIT_CRITICAL(&meterMux);
+        return s;
+    }
+
+} // namespace ENERGY_METER
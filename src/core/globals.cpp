@@ -36,14 +36,9 @@ float metric79_scaled = 0.0f;
 uint32_t metric83_raw = 0;
 float metric83_scaled = 0.0f;
 
-unsigned long lastBMS = 0;
 uint8_t heating = 0;
-// CRITICAL: Initialize to 0 for proper timeout detection at boot
-// With millis() - 0, timeout will trigger immediately if no messages received
-unsigned long lastHeartbeat = 0;
-unsigned long lastChargerResponse = 0;
-unsigned long lastTerminalPower = 0;
-unsigned long lastTerminalStatus = 0;
+// Message timeouts (BMS, terminal power / status, heartbeat) use the RX time
+// of each signal: TELEMETRY::ageMs() reads "never received" as timed out
 bool chargerModuleOnline = false;     // Charger offline at boot
 
 const char *chargerStatus = "UNKNOWN";
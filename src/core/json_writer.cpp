@@ -0,0 +1,186 @@
+#include "../../include/core/json_writer.h"
+#include <math.h>
+
+JsonWriter::JsonWriter(char *buf, size_t cap)
+    : buf_(buf), cap_(cap), len_(0), depth_(0), needComma_(0), overflow_(cap == 0)
+{
+    if (cap_ > 0)
+        buf_[0] = '\0';
+}
+
+void JsonWriter::put(char c)
+{
+    // Keep one byte for the terminator
+    if (overflow_ || len_ + 1 >= cap_)
+    {
+        overflow_ = true;
+        return;
+    }
+    buf_[len_++] = c;
+}
+
+void JsonWriter::put(const char *s)
+{
+    while (*s)
+        put(*s++);
+}
+
+void JsonWriter::putEscaped(const char *s)
+{
+    static const char HEX[] = "0123456789abcdef";
+    put('"');
+    for (; *s; s++)
+    {
+        const unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\')
+        {
+            put('\\');
+            put((char)c);
+        }
+        else if (c == '\n')
+            put("\\n");
+        else if (c < 0x20)
+        {
+            put("\\u00");
+            put(HEX[c >> 4]);
+            put(HEX[c & 0x0F]);
+        }
+        else
+            put((char)c);
+    }
+    put('"');
+}
+
+void JsonWriter::putUnsigned(uint64_t v)
+{
+    char digits[20];
+    uint8_t n = 0;
+    do
+    {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n)
+        put(digits[--n]);
+}
+
+void JsonWriter::member(const char *key)
+{
+    const uint32_t bit = 1UL << depth_;
+    if (needComma_ & bit)
+        put(',');
+    needComma_ |= bit;
+    if (key)
+    {
+        putEscaped(key);
+        put(':');
+    }
+}
+
+JsonWriter &JsonWriter::beginObject(const char *key)
+{
+    if (depth_ + 1 >= JSON_WRITER_MAX_DEPTH)
+    {
+        overflow_ = true;
+        return *this;
+    }
+    member(key);
+    put('{');
+    closers_[++depth_] = '}';
+    needComma_ &= ~(1UL << depth_);
+    return *this;
+}
+
+JsonWriter &JsonWriter::beginArray(const char *key)
+{
+    if (depth_ + 1 >= JSON_WRITER_MAX_DEPTH)
+    {
+        overflow_ = true;
+        return *this;
+    }
+    member(key);
+    put('[');
+    closers_[++depth_] = ']';
+    needComma_ &= ~(1UL << depth_);
+    return *this;
+}
+
+JsonWriter &JsonWriter::end()
+{
+    if (depth_ == 0)
+    {
+        overflow_ = true;
+        return *this;
+    }
+    put(closers_[depth_--]);
+    return *this;
+}
+
+JsonWriter &JsonWriter::add(const char *key, const char *value)
+{
+    member(key);
+    if (value)
+        putEscaped(value);
+    else
+        put("null");
+    return *this;
+}
+
+JsonWriter &JsonWriter::add(const char *key, uint32_t value)
+{
+    member(key);
+    putUnsigned(value);
+    return *this;
+}
+
+JsonWriter &JsonWriter::add(const char *key, int32_t value)
+{
+    member(key);
+    if (value < 0)
+        put('-');
+    putUnsigned(value < 0 ? (uint64_t)(-(int64_t)value) : (uint64_t)value);
+    return *this;
+}
+
+JsonWriter &JsonWriter::add(const char *key, float value, uint8_t decimals)
+{
+    static const uint32_t POW10[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+    member(key);
+    if (decimals > 6)
+        decimals = 6;
+    if (isnan(value) || isinf(value) || fabsf(value) >= 1e12f)
+    {
+        put("null");
+        return *this;
+    }
+
+    // Fixed point, then trailing zeros of the fraction dropped
+    const uint32_t scale = POW10[decimals];
+    const uint64_t fixed = (uint64_t)(fabs((double)value) * scale + 0.5);
+    uint64_t frac = fixed % scale;
+    if (value < 0.0f && fixed > 0)
+        put('-');
+    putUnsigned(fixed / scale);
+    if (frac == 0)
+        return *this;
+
+    uint8_t digits = decimals;
+    while (frac % 10 == 0)
+    {
+        frac /= 10;
+        digits--;
+    }
+    put('.');
+    for (uint32_t p = POW10[digits - 1]; p > frac && p > 1; p /= 10)
+        put('0');
+    putUnsigned(frac);
+    return *this;
+}
+
+size_t JsonWriter::finish()
+{
+    if (overflow_ || depth_ != 0)
+        return 0;
+    buf_[len_] = '\0';
+    return len_;
+}
@@ -0,0 +1,216 @@
+#include "../../include/core/ocpp_events.h"
+#include "../../include/header.h"
+#include "../../include/config/timing.h"
+#include <esp_timer.h>
+#include <freertos/queue.h>
+#include <atomic>
+#include <string.h>
+
+static QueueHandle_t eventQueue = nullptr;
+
+static OcppLoopStats loopStats = {};
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Filled by the posting task, emptied by the OCPP task
+static VehicleInfoBatch vehicleInfoSlots[OCPP_VEHICLE_INFO_SLOTS];
+static std::atomic<bool> vehicleInfoFull[OCPP_VEHICLE_INFO_SLOTS];
+static uint8_t vehicleInfoNext = 0; // posting task only
+
+// OCPP task only
+static uint64_t lastWaitExitUs = 0;
+static uint64_t lastActiveUs = 0;
+
+static const char *EVENT_NAMES[OCPP_EVENT_TYPES] = {"plug", "charger health", "BMS alert", "vehicle info"};
+
+// Taken by the OCPP task at `nowUs`
+static void countEvent(const OcppEvent &e, uint64_t nowUs)
+{
+    const uint32_t latency = nowUs > e.postedUs ? (uint32_t)(nowUs - e.postedUs) : 0;
+    portENTER_CRITICAL(&statsMux);
+    if (e.type < OCPP_EVENT_TYPES)
+        loopStats.events[e.type]++;
+    loopStats.latencySumUs += latency;
+    if (latency > loopStats.maxLatencyUs)
+        loopStats.maxLatencyUs = latency;
+    portEXIT_CRITICAL(&statsMux);
+    lastActiveUs = nowUs;
+}
+
+namespace OCPP_EVENTS
+{
+    bool init()
+    {
+        if (eventQueue == nullptr)
+            eventQueue = xQueueCreate(OCPP_EVENT_QUEUE_LEN, sizeof(OcppEvent));
+        return eventQueue != nullptr;
+    }
+
+    bool post(const OcppEvent &event)
+    {
+        OcppEvent e = event;
+        e.postedUs = (uint64_t)esp_timer_get_time();
+        const bool ok = eventQueue && xQueueSend(eventQueue, &e, 0) == pdTRUE;
+        const uint32_t queued = eventQueue ? (uint32_t)uxQueueMessagesWaiting(eventQueue) : 0;
+
+        portENTER_CRITICAL(&statsMux);
+        if (!ok)
+            loopStats.dropped++;
+        else if (queued > loopStats.maxQueued)
+            loopStats.maxQueued = queued;
+        portEXIT_CRITICAL(&statsMux);
+        return ok;
+    }
+
+    bool postPlug(bool plugged)
+    {
+        return post({OCPP_EVENT_PLUG, plugged, nullptr, nullptr, 0, 0});
+    }
+
+    bool postChargerHealth(bool healthy)
+    {
+        return post({OCPP_EVENT_CHARGER_HEALTH, healthy, nullptr, nullptr, 0, 0});
+    }
+
+    bool postBmsAlert(const char *alertType, const char *message)
+    {
+        return post({OCPP_EVENT_BMS_ALERT, false, alertType, message, 0, 0});
+    }
+
+    bool postVehicleInfo(const VehicleInfoBatch &batch)
+    {
+        const uint8_t slot = vehicleInfoNext;
+        if (vehicleInfoFull[slot].load(std::memory_order_acquire))
+        {
+            portENTER_CRITICAL(&statsMux);
+            loopStats.dropped++;
+            portEXIT_CRITICAL(&statsMux);
+            return false;
+        }
+        vehicleInfoSlots[slot] = batch;
+        vehicleInfoFull[slot].store(true, std::memory_order_release);
+        if (!post({OCPP_EVENT_VEHICLE_INFO, false, nullptr, nullptr, 0, slot}))
+        {
+            vehicleInfoFull[slot].store(false, std::memory_order_relaxed);
+            return false;
+        }
+        vehicleInfoNext = (slot + 1) % OCPP_VEHICLE_INFO_SLOTS;
+        return true;
+    }
+
+    bool takeVehicleInfo(const OcppEvent &event, VehicleInfoBatch &out)
+    {
+        if (event.type != OCPP_EVENT_VEHICLE_INFO || event.slot >= OCPP_VEHICLE_INFO_SLOTS ||
+            !vehicleInfoFull[event.slot].load(std::memory_order_acquire))
+            return false;
+        out = vehicleInfoSlots[event.slot];
+        vehicleInfoFull[event.slot].store(false, std::memory_order_release);
+        return true;
+    }
+
+    uint32_t tickMs(bool active)
+    {
+        const uint64_t now = (uint64_t)esp_timer_get_time();
+        if (active)
+            lastActiveUs = now;
+        const uint32_t tick = now - lastActiveUs < OCPP_TICK_HOLD_MS * 1000ULL ? OCPP_TICK_ACTIVE_MS : OCPP_TICK_IDLE_MS;
+
+        portENTER_CRITICAL(&statsMux);
+        loopStats.tickMs = tick;
+        portEXIT_CRITICAL(&statsMux);
+        return tick;
+    }
+
+    bool wait(OcppEvent &event, uint32_t timeoutMs)
+    {
+        const uint64_t enter = (uint64_t)esp_timer_get_time();
+        const bool got = eventQueue && xQueueReceive(eventQueue, &event, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+        if (!eventQueue)
+            vTaskDelay(pdMS_TO_TICKS(timeoutMs));
+        const uint64_t exit = (uint64_t)esp_timer_get_time();
+
+        portENTER_CRITICAL(&statsMux);
+        if (lastWaitExitUs != 0)
+        {
+            const uint64_t busy = enter - lastWaitExitUs;
+            loopStats.busyUs += busy;
+            if (busy > loopStats.maxBusyUs)
+                loopStats.maxBusyUs = (uint32_t)busy;
+        }
+        loopStats.blockedUs += exit - enter;
+        if (timeoutMs >= OCPP_TICK_IDLE_MS)
+            loopStats.idleTickUs += exit - enter;
+        loopStats.wakeups++;
+        if (got)
+            loopStats.eventWakeups++;
+        portEXIT_CRITICAL(&statsMux);
+
+        lastWaitExitUs = exit;
+        if (got)
+            countEvent(event, exit);
+        return got;
+    }
+
+    bool take(OcppEvent &event)
+    {
+        if (!eventQueue || xQueueReceive(eventQueue, &event, 0) != pdTRUE)
+            return false;
+        countEvent(event, (uint64_t)esp_timer_get_time());
+        return true;
+    }
+
+    OcppLoopStats stats()
+    {
+        portENTER_CRITICAL(&statsMux);
+        const OcppLoopStats s = loopStats;
+        portEXIT_CRITICAL(&statsMux);
+        return s;
+    }
+
+    void resetStats()
+    {
+        portENTER_CRITICAL(&statsMux);
+        const uint32_t tick = loopStats.tickMs;
+        memset(&loopStats, 0, sizeof(loopStats));
+        loopStats.tickMs = tick;
+        portEXIT_CRITICAL(&statsMux);
+    }
+
+    void printStats()
+    {
+        const OcppLoopStats s = stats();
+        const uint64_t totalUs = s.busyUs + s.blockedUs;
+        uint32_t taken = 0;
+        for (uint8_t t = 0; t < OCPP_EVENT_TYPES; t++)
+            taken += s.events[t];
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        Serial.println("\n============ OCPP TASK LOOP ============");
+        if (totalUs == 0)
+        {
+            Serial.println("(not running yet)");
+        }
+        else
+        {
+            Serial.printf("Tick now:   %u ms (active %u / idle %u)\n", s.tickMs, OCPP_TICK_ACTIVE_MS, OCPP_TICK_IDLE_MS);
+            Serial.printf("Wakeups:    %u (%.1f/s), %u by an event\n", s.wakeups, s.wakeups * 1e6 / totalUs,
+                          s.eventWakeups);
+            Serial.printf("Running:    %.2f%% of %.1fs (longest pass %u µs)\n", 100.0 * s.busyUs / totalUs,
+                          totalUs / 1e6, s.maxBusyUs);
+            Serial.printf("Blocked:    %.2f%%, %.2f%% at the idle tick\n", 100.0 * s.blockedUs / totalUs,
+                          100.0 * s.idleTickUs / totalUs);
+            Serial.print("Events:    ");
+            for (uint8_t t = 0; t < OCPP_EVENT_TYPES; t++)
+                Serial.printf(" %s=%u", EVENT_NAMES[t], s.events[t]);
+            Serial.printf("  (dropped %u, max queued %u)\n", s.dropped, s.maxQueued);
+            if (taken)
+                Serial.printf("Latency:    mean %u µs, max %u µs (post -> OCPP task)\n",
+                              (unsigned)(s.latencySumUs / taken), s.maxLatencyUs);
+        }
+        Serial.println("========================================\n");
+
+        xSemaphoreGive(serialMutex);
+    }
+
+} // namespace OCPP_EVENTS
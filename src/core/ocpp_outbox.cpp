@@ -0,0 +1,489 @@
+#include "../../include/core/ocpp_outbox.h"
+#include "../../include/header.h"
+#include <esp_partition.h>
+#include <string.h>
+
+#define OUTBOX_SECTOR_MAGIC 0x314F4252UL // "RBO1"
+#define OUTBOX_RECORD_MAGIC 0xA5
+#define OUTBOX_ERASED32 0xFFFFFFFFUL
+#define OUTBOX_LOCK_MS 1000 // a sector erase takes up to a few hundred ms
+
+struct SectorHeader
+{
+    uint32_t magic;
+    uint32_t seq;     // erase order
+    uint32_t erases;  // wear counter, carried over each erase
+    uint32_t retired; // cleared once nothing in the sector is pending
+};
+
+struct RecordHeader
+{
+    uint32_t seq;
+    uint16_t len;
+    uint8_t type;
+    uint8_t magic;
+    uint32_t crc;   // first 8 header bytes + data
+    uint32_t state; // erased = pending, cleared = delivered / dropped
+};
+
+static_assert(sizeof(SectorHeader) == 16 && sizeof(RecordHeader) == 16, "flash layout");
+static_assert(OCPP_OUTBOX_MAX_DATA + sizeof(SectorHeader) + sizeof(RecordHeader) <= OCPP_OUTBOX_SECTOR_BYTES,
+              "largest record must fit one sector");
+static_assert(DT_DIAGNOSTICS_BYTES <= OCPP_OUTBOX_MAX_DATA, "every DataTransfer must fit a record");
+
+static const esp_partition_t *outboxPart = nullptr;
+static SemaphoreHandle_t outboxMutex = nullptr;
+static uint16_t sectorCount = 0;
+
+// Write position
+static uint16_t headSector = 0;
+static uint32_t headOffset = 0;
+static uint32_t headSectorSeq = 0;
+static uint32_t nextSeq = 1;
+
+// Oldest pending record (valid while stats.pending > 0)
+static uint16_t tailSector = 0;
+static uint32_t tailOffset = 0;
+static RecordHeader tailRecord;
+
+static OutboxStats outboxStats = {};
+
+// =========================================================
+// FLASH LAYOUT HELPERS
+// =========================================================
+static uint32_t crc32Update(uint32_t crc, const void *data, size_t len)
+{
+    static const uint32_t NIBBLE[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= p[i];
+        crc = (crc >> 4) ^ NIBBLE[crc & 0x0F];
+        crc = (crc >> 4) ^ NIBBLE[crc & 0x0F];
+    }
+    return crc;
+}
+
+static uint32_t recordCrc(const RecordHeader &h, const void *data)
+{
+    uint32_t crc = crc32Update(0xFFFFFFFFUL, &h, 8);
+    return ~crc32Update(crc, data, h.len);
+}
+
+static uint32_t sectorBase(uint16_t sector)
+{
+    return (uint32_t)sector * OCPP_OUTBOX_SECTOR_BYTES;
+}
+
+static uint32_t recordBytes(uint16_t len)
+{
+    return (sizeof(RecordHeader) + len + 3) & ~3UL;
+}
+
+static bool readSector(uint16_t sector, SectorHeader &h)
+{
+    return esp_partition_read(outboxPart, sectorBase(sector), &h, sizeof(h)) == ESP_OK &&
+           h.magic == OUTBOX_SECTOR_MAGIC && h.seq != OUTBOX_ERASED32;
+}
+
+enum RecordRead : uint8_t
+{
+    RECORD_OK,
+    RECORD_FREE,
+    RECORD_BAD // garbage header: the rest of the sector is unusable
+};
+
+static RecordRead readRecord(uint16_t sector, uint32_t offset, RecordHeader &h)
+{
+    if (offset + sizeof(RecordHeader) > OCPP_OUTBOX_SECTOR_BYTES)
+        return RECORD_FREE;
+    if (esp_partition_read(outboxPart, sectorBase(sector) + offset, &h, sizeof(h)) != ESP_OK)
+        return RECORD_BAD;
+    if (h.seq == OUTBOX_ERASED32 && h.magic == 0xFF)
+        return RECORD_FREE;
+    if (h.magic != OUTBOX_RECORD_MAGIC || h.len > OCPP_OUTBOX_MAX_DATA ||
+        offset + recordBytes(h.len) > OCPP_OUTBOX_SECTOR_BYTES)
+        return RECORD_BAD;
+    return RECORD_OK;
+}
+
+// Clear a word that is still erased (NOR program, no erase)
+static void clearWord(uint32_t address)
+{
+    const uint32_t zero = 0;
+    esp_partition_write(outboxPart, address, &zero, sizeof(zero));
+}
+
+static void retireSector(uint16_t sector)
+{
+    if (sector != headSector)
+        clearWord(sectorBase(sector) + offsetof(SectorHeader, retired));
+}
+
+// =========================================================
+// QUEUE POSITIONS
+// =========================================================
+// Move the tail forward from (tailSector, tailOffset) to the next pending record
+static void seekTail()
+{
+    while (outboxStats.pending > 0)
+    {
+        RecordHeader h;
+        const RecordRead r = readRecord(tailSector, tailOffset, h);
+        if (r == RECORD_OK && h.state == OUTBOX_ERASED32)
+        {
+            tailRecord = h;
+            return;
+        }
+        if (r == RECORD_OK)
+        {
+            tailOffset += recordBytes(h.len);
+            continue;
+        }
+
+        if (tailSector == headSector)
+        {
+            // Nothing readable left between tail and head
+            outboxStats.corrupt += outboxStats.pending;
+            outboxStats.pending = 0;
+            return;
+        }
+        retireSector(tailSector);
+        tailSector = (tailSector + 1) % sectorCount;
+        tailOffset = sizeof(SectorHeader);
+    }
+}
+
+// Pending records of `sector` from `offset` on
+static uint32_t countPending(uint16_t sector, uint32_t offset)
+{
+    uint32_t n = 0;
+    RecordHeader h;
+    while (readRecord(sector, offset, h) == RECORD_OK)
+    {
+        if (h.state == OUTBOX_ERASED32)
+            n++;
+        offset += recordBytes(h.len);
+    }
+    return n;
+}
+
+// Erase the next sector of the ring and write there from now on
+static bool openNextSector()
+{
+    const uint16_t next = (headSector + 1) % sectorCount;
+
+    if (outboxStats.pending > 0 && tailSector == next)
+    {
+        // Ring full: the oldest sector goes, with whatever is still pending in it
+        const uint32_t lost = countPending(next, tailOffset);
+        outboxStats.dropped += lost;
+        outboxStats.pending -= lost;
+        tailSector = (next + 1) % sectorCount;
+        tailOffset = sizeof(SectorHeader);
+        seekTail();
+    }
+
+    SectorHeader old;
+    const uint32_t erases = readSector(next, old) ? old.erases : 0;
+    if (esp_partition_erase_range(outboxPart, sectorBase(next), OCPP_OUTBOX_SECTOR_BYTES) != ESP_OK)
+        return false;
+
+    const SectorHeader h = {OUTBOX_SECTOR_MAGIC, ++headSectorSeq, erases + 1, OUTBOX_ERASED32};
+    if (esp_partition_write(outboxPart, sectorBase(next), &h, sizeof(h)) != ESP_OK)
+        return false;
+
+    headSector = next;
+    headOffset = sizeof(SectorHeader);
+    return true;
+}
+
+// Rebuild head, tail and counters from the sector and record headers
+static bool recover()
+{
+    SectorHeader h;
+    bool any = false;
+    for (uint16_t s = 0; s < sectorCount; s++)
+    {
+        if (readSector(s, h) && (!any || h.seq > headSectorSeq))
+        {
+            any = true;
+            headSector = s;
+            headSectorSeq = h.seq;
+        }
+    }
+    if (!any)
+    {
+        headSector = sectorCount - 1; // first sector used is 0
+        headSectorSeq = 0;
+        return openNextSector();
+    }
+
+    // Oldest first: the sector after the write sector wraps around to it
+    bool tailFound = false;
+    for (uint16_t k = 1; k <= sectorCount; k++)
+    {
+        const uint16_t s = (headSector + k) % sectorCount;
+        if (!readSector(s, h) || (h.retired != OUTBOX_ERASED32 && s != headSector))
+            continue;
+
+        uint32_t offset = sizeof(SectorHeader);
+        RecordHeader r;
+        RecordRead rr;
+        while ((rr = readRecord(s, offset, r)) == RECORD_OK)
+        {
+            if (r.seq >= nextSeq)
+                nextSeq = r.seq + 1;
+            if (r.state == OUTBOX_ERASED32)
+            {
+                if (!tailFound)
+                {
+                    tailFound = true;
+                    tailSector = s;
+                    tailOffset = offset;
+                    tailRecord = r;
+                }
+                outboxStats.pending++;
+            }
+            offset += recordBytes(r.len);
+        }
+        if (s != headSector)
+            continue;
+
+        // Write position: only behind fully erased space (a torn header
+        // leaves programmed bytes that a new record must not land on)
+        headOffset = offset;
+        bool clean = rr == RECORD_FREE;
+        uint8_t buf[64];
+        for (uint32_t o = offset; clean && o < OCPP_OUTBOX_SECTOR_BYTES; o += sizeof(buf))
+        {
+            const uint32_t n = OCPP_OUTBOX_SECTOR_BYTES - o < sizeof(buf) ? OCPP_OUTBOX_SECTOR_BYTES - o : sizeof(buf);
+            if (esp_partition_read(outboxPart, sectorBase(s) + o, buf, n) != ESP_OK)
+                clean = false;
+            for (uint32_t i = 0; clean && i < n; i++)
+                clean = buf[i] == 0xFF;
+        }
+        if (!clean)
+            return openNextSector();
+    }
+    return true;
+}
+
+// =========================================================
+// PUBLIC API
+// =========================================================
+namespace OCPP_OUTBOX
+{
+    bool init()
+    {
+        if (outboxMutex == nullptr)
+            outboxMutex = xSemaphoreCreateMutex();
+        if (!outboxMutex || xSemaphoreTake(outboxMutex, pdMS_TO_TICKS(OUTBOX_LOCK_MS)) != pdTRUE)
+            return false;
+
+        outboxStats = {};
+        nextSeq = 1;
+        outboxPart = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, OCPP_OUTBOX_PARTITION);
+        sectorCount = outboxPart ? (uint16_t)(outboxPart->size / OCPP_OUTBOX_SECTOR_BYTES) : 0;
+        outboxStats.sectors = sectorCount;
+        outboxStats.ready = sectorCount >= 2 && recover();
+        const OutboxStats s = outboxStats;
+        xSemaphoreGive(outboxMutex);
+
+        if (s.ready)
+            Serial.printf("[OUTBOX] ✅ %u sectors, %u DataTransfers pending\n", s.sectors, (unsigned)s.pending);
+        else
+            Serial.printf("[OUTBOX] ❌ No usable '%s' partition - offline DataTransfers are lost\n", OCPP_OUTBOX_PARTITION);
+        return s.ready;
+    }
+
+    bool append(DataTransferMessage type, const char *data, size_t len)
+    {
+        if (!outboxMutex || xSemaphoreTake(outboxMutex, pdMS_TO_TICKS(OUTBOX_LOCK_MS)) != pdTRUE)
+            return false;
+
+        bool ok = outboxStats.ready && data && len <= OCPP_OUTBOX_MAX_DATA;
+        const uint32_t bytes = recordBytes((uint16_t)len);
+        if (ok && headOffset + bytes > OCPP_OUTBOX_SECTOR_BYTES)
+            ok = openNextSector();
+
+        if (ok)
+        {
+            RecordHeader h;
+            h.seq = nextSeq;
+            h.len = (uint16_t)len;
+            h.type = type;
+            h.magic = OUTBOX_RECORD_MAGIC;
+            h.crc = recordCrc(h, data);
+            h.state = OUTBOX_ERASED32;
+
+            // Data first: a header on flash implies complete data
+            const uint32_t at = sectorBase(headSector) + headOffset;
+            ok = esp_partition_write(outboxPart, at + sizeof(h), data, len) == ESP_OK &&
+                 esp_partition_write(outboxPart, at, &h, offsetof(RecordHeader, state)) == ESP_OK;
+            if (ok)
+            {
+                if (outboxStats.pending++ == 0)
+                {
+                    tailSector = headSector;
+                    tailOffset = headOffset;
+                    tailRecord = h;
+                }
+                nextSeq++;
+                outboxStats.appended++;
+                headOffset += bytes;
+            }
+            else
+            {
+                // Partly programmed: nothing more goes into this sector
+                headOffset = OCPP_OUTBOX_SECTOR_BYTES;
+            }
+        }
+        if (!ok)
+            outboxStats.rejected++;
+
+        xSemaphoreGive(outboxMutex);
+        return ok;
+    }
+
+    bool empty()
+    {
+        if (!outboxMutex)
+            return true;
+        // Held across a sector erase: unknown counts as not empty, so live
+        // messages do not overtake queued ones meanwhile
+        if (xSemaphoreTake(outboxMutex, pdMS_TO_TICKS(OUTBOX_LOCK_MS)) != pdTRUE)
+            return false;
+        const bool none = outboxStats.pending == 0;
+        xSemaphoreGive(outboxMutex);
+        return none;
+    }
+
+    size_t peek(OutboxRecord &rec, char *out, size_t cap)
+    {
+        if (!outboxMutex || xSemaphoreTake(outboxMutex, pdMS_TO_TICKS(OUTBOX_LOCK_MS)) != pdTRUE)
+            return 0;
+
+        size_t len = 0;
+        while (outboxStats.pending > 0)
+        {
+            const RecordHeader h = tailRecord;
+            const bool fits = h.len < cap;
+            if (fits && esp_partition_read(outboxPart, sectorBase(tailSector) + tailOffset + sizeof(h), out, h.len) == ESP_OK &&
+                recordCrc(h, out) == h.crc && h.type < DT_MESSAGES)
+            {
+                out[h.len] = '\0';
+                rec.seq = h.seq;
+                rec.type = (DataTransferMessage)h.type;
+                len = h.len;
+                break;
+            }
+
+            // Torn or unreadable: skip it for good
+            clearWord(sectorBase(tailSector) + tailOffset + offsetof(RecordHeader, state));
+            outboxStats.corrupt++;
+            outboxStats.pending--;
+            tailOffset += recordBytes(h.len);
+            seekTail();
+        }
+
+        xSemaphoreGive(outboxMutex);
+        return len;
+    }
+
+    static bool consume(uint32_t seq, bool delivered)
+    {
+        if (!outboxMutex || xSemaphoreTake(outboxMutex, pdMS_TO_TICKS(OUTBOX_LOCK_MS)) != pdTRUE)
+            return false;
+
+        const bool ok = outboxStats.pending > 0 && tailRecord.seq == seq;
+        if (ok)
+        {
+            clearWord(sectorBase(tailSector) + tailOffset + offsetof(RecordHeader, state));
+            outboxStats.pending--;
+            if (delivered)
+                outboxStats.delivered++;
+            else
+                outboxStats.dropped++;
+            tailOffset += recordBytes(tailRecord.len);
+            if (outboxStats.pending > 0)
+                seekTail();
+            else if (tailSector != headSector)
+                retireSector(tailSector);
+        }
+
+        xSemaphoreGive(outboxMutex);
+        return ok;
+    }
+
+    bool ack(uint32_t seq)
+    {
+        return consume(seq, true);
+    }
+
+    bool discard(uint32_t seq)
+    {
+        return consume(seq, false);
+    }
+
+    OutboxStats stats()
+    {
+        OutboxStats s = {};
+        if (!outboxMutex || xSemaphoreTake(outboxMutex, pdMS_TO_TICKS(OUTBOX_LOCK_MS)) != pdTRUE)
+            return s;
+        s = outboxStats;
+        if (s.pending > 0)
+        {
+            const uint32_t sectors = (headSector + sectorCount - tailSector) % sectorCount;
+            s.usedBytes = sectors * OCPP_OUTBOX_SECTOR_BYTES + headOffset - tailOffset;
+        }
+        xSemaphoreGive(outboxMutex);
+        return s;
+    }
+
+    void printStats()
+    {
+        const OutboxStats s = stats();
+
+        // Wear from the sector headers (console only)
+        uint32_t minErases = UINT32_MAX, maxErases = 0, live = 0;
+        if (s.ready && xSemaphoreTake(outboxMutex, pdMS_TO_TICKS(OUTBOX_LOCK_MS)) == pdTRUE)
+        {
+            SectorHeader h;
+            for (uint16_t i = 0; i < sectorCount; i++)
+            {
+                const bool valid = readSector(i, h);
+                const uint32_t e = valid ? h.erases : 0;
+                minErases = e < minErases ? e : minErases;
+                maxErases = e > maxErases ? e : maxErases;
+                if (valid && h.retired == OUTBOX_ERASED32)
+                    live++;
+            }
+            xSemaphoreGive(outboxMutex);
+        }
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        Serial.println("\n============ OCPP OUTBOX ============");
+        if (!s.ready)
+        {
+            Serial.printf("❌ Disabled: no usable '%s' partition\n", OCPP_OUTBOX_PARTITION);
+        }
+        else
+        {
+            Serial.printf("Partition: %u sectors x %u B, %u live\n", s.sectors, OCPP_OUTBOX_SECTOR_BYTES, (unsigned)live);
+            Serial.printf("Pending:   %u records, %u B of flash\n", (unsigned)s.pending, (unsigned)s.usedBytes);
+            Serial.printf("Appended:  %u  Delivered: %u  Dropped: %u  Corrupt: %u  Rejected: %u\n",
+                          (unsigned)s.appended, (unsigned)s.delivered, (unsigned)s.dropped, (unsigned)s.corrupt,
+                          (unsigned)s.rejected);
+            Serial.printf("Wear:      %u..%u erases per sector\n", (unsigned)minErases, (unsigned)maxErases);
+        }
+        Serial.println("=====================================\n");
+
+        xSemaphoreGive(serialMutex);
+    }
+
+} // namespace OCPP_OUTBOX
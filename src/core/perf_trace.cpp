@@ -0,0 +1,275 @@
+#include "../../include/core/perf_trace.h"
+#include "../../include/header.h"
+#include <esp_timer.h>
+
+static const char *SCOPE_NAMES[PERF_TRACE_IDS] = {"handleChargerMessage", "dispatchBmsFrame", "CHARGER_POLL::service",
+                                                  "mocpp_loop", "loop", "ChargingCore::poll"};
+
+#if PERF_TRACE_ENABLED
+
+static const char *SCOPE_CATEGORIES[PERF_TRACE_IDS] = {"can", "can", "can", "ocpp", "main", "main"};
+
+PerfTraceRing perfTraceRings[PERF_TRACE_CORES];
+volatile bool perfTraceArmed = true;
+
+// Cycle counter of one core next to esp_timer, read on that core
+struct CoreClock
+{
+    uint32_t cycles;
+    int64_t us;
+};
+
+struct ClockRequest
+{
+    CoreClock clock;
+    TaskHandle_t waiter;
+    std::atomic<bool> done;
+};
+
+static void readCoreClock(void *arg)
+{
+    ClockRequest *req = (ClockRequest *)arg;
+    req->clock.cycles = ESP.getCycleCount();
+    req->clock.us = esp_timer_get_time();
+    // The caller may return as soon as it sees done: read all of `req` before
+    const TaskHandle_t waiter = req->waiter;
+    req->done.store(true, std::memory_order_release);
+    xTaskNotifyGive(waiter);
+    vTaskDelete(nullptr);
+}
+
+static bool coreClock(uint8_t core, CoreClock &out)
+{
+    ClockRequest req;
+    req.clock = {0, 0};
+    req.waiter = xTaskGetCurrentTaskHandle();
+    req.done.store(false, std::memory_order_relaxed);
+    if (core == xPortGetCoreID())
+    {
+        out.cycles = ESP.getCycleCount();
+        out.us = esp_timer_get_time();
+        return true;
+    }
+    if (xTaskCreatePinnedToCore(readCoreClock, "PERF_CLK", 2048, &req, configMAX_PRIORITIES - 1, nullptr, core) != pdPASS)
+        return false;
+    // `req` is on this stack: never return before the helper has written it.
+    // It runs at the top priority on the other core, so this is short
+    while (!req.done.load(std::memory_order_acquire))
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    out = req.clock;
+    return true;
+}
+
+// Stop recording and let scopes that already claimed a slot finish writing it
+static bool pause()
+{
+    const bool was = perfTraceArmed;
+    perfTraceArmed = false;
+    vTaskDelay(pdMS_TO_TICKS(2));
+    return was;
+}
+
+static uint32_t heldCount(const PerfTraceRing &ring, uint32_t &first)
+{
+    const uint32_t head = ring.head.load(std::memory_order_acquire);
+    const uint32_t count = head < PERF_TRACE_CAPACITY ? head : PERF_TRACE_CAPACITY;
+    first = head - count;
+    return count;
+}
+
+static void printMicros(const char *key, int64_t ns)
+{
+    if (ns < 0)
+        ns = 0;
+    Serial.printf(",\"%s\":%lld.%03u", key, (long long)(ns / 1000), (unsigned)(ns % 1000));
+}
+
+namespace PERF_TRACE
+{
+    uint32_t recorded()
+    {
+        uint32_t n = 0;
+        for (const PerfTraceRing &ring : perfTraceRings)
+            n += ring.head.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    void printSummary()
+    {
+        struct Totals
+        {
+            uint32_t count;
+            uint64_t cycles;
+            uint32_t maxCycles;
+        };
+        Totals totals[PERF_TRACE_IDS] = {};
+        uint32_t held = 0;
+
+        const bool armed = pause();
+        for (const PerfTraceRing &ring : perfTraceRings)
+        {
+            uint32_t first;
+            const uint32_t count = heldCount(ring, first);
+            held += count;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const PerfTraceRecord &r = ring.records[(first + i) & (PERF_TRACE_CAPACITY - 1)];
+                if (r.id >= PERF_TRACE_IDS)
+                    continue;
+                Totals &t = totals[r.id];
+                t.count++;
+                t.cycles += r.cycles;
+                if (r.cycles > t.maxCycles)
+                    t.maxCycles = r.cycles;
+            }
+        }
+        perfTraceArmed = armed;
+
+        const float nsPerCycle = 1000.0f / getCpuFrequencyMhz();
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        Serial.println("\n============ PERF TRACE ============");
+        Serial.printf("%u records held (%u per core), %u written\n", (unsigned)held, PERF_TRACE_CAPACITY,
+                      (unsigned)recorded());
+        Serial.println("scope                    count     mean µs      max µs");
+        for (uint8_t id = 0; id < PERF_TRACE_IDS; id++)
+        {
+            const Totals &t = totals[id];
+            if (t.count == 0)
+                continue;
+            Serial.printf("%-22s %7u %11.2f %11.2f\n", SCOPE_NAMES[id], (unsigned)t.count,
+                          (double)t.cycles / t.count * nsPerCycle / 1000.0, t.maxCycles * nsPerCycle / 1000.0);
+        }
+        Serial.println("F → dump as Chrome trace JSON (scripts/perftrace.py)");
+        Serial.println("====================================\n");
+
+        xSemaphoreGive(serialMutex);
+    }
+
+    void dump()
+    {
+        const bool armed = pause();
+        const uint32_t mhz = getCpuFrequencyMhz();
+
+        CoreClock clocks[PERF_TRACE_CORES];
+        bool clockOk[PERF_TRACE_CORES];
+        for (uint8_t c = 0; c < PERF_TRACE_CORES; c++)
+            clockOk[c] = coreClock(c, clocks[c]);
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+        {
+            perfTraceArmed = armed;
+            return;
+        }
+
+        uint32_t held = 0, overwritten = 0;
+        for (const PerfTraceRing &ring : perfTraceRings)
+        {
+            uint32_t first;
+            held += heldCount(ring, first);
+            overwritten += first;
+        }
+        Serial.printf("#PERFTRACE v1 records=%u overwritten=%u mhz=%u\n", (unsigned)held, (unsigned)overwritten,
+                      (unsigned)mhz);
+        Serial.println("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+        Serial.print("{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\",\"args\":{\"name\":\"charger\"}}");
+
+        for (uint8_t c = 0; c < PERF_TRACE_CORES; c++)
+        {
+            Serial.printf(",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"core %u\"}}",
+                          c, c);
+            uint32_t first;
+            const uint32_t count = heldCount(perfTraceRings[c], first);
+            if (count == 0 || !clockOk[c])
+                continue;
+
+            // Record ends relative to the oldest one (signed steps absorb
+            // the counter wrap), then anchored at the core's clock reading
+            const PerfTraceRecord *ring = perfTraceRings[c].records;
+            const uint32_t mask = PERF_TRACE_CAPACITY - 1;
+            int64_t newest = 0;
+            for (uint32_t i = 1; i < count; i++)
+                newest += (int32_t)(ring[(first + i) & mask].endCycles - ring[(first + i - 1) & mask].endCycles);
+            const uint32_t newestAge = clocks[c].cycles - ring[(first + count - 1) & mask].endCycles;
+
+            int64_t rel = 0;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const PerfTraceRecord &r = ring[(first + i) & mask];
+                if (i > 0)
+                    rel += (int32_t)(r.endCycles - ring[(first + i - 1) & mask].endCycles);
+                if (r.id >= PERF_TRACE_IDS)
+                    continue;
+                const int64_t ageCycles = (int64_t)newestAge + (newest - rel);
+                const int64_t endNs = clocks[c].us * 1000 - ageCycles * 1000 / mhz;
+                const int64_t durNs = (int64_t)r.cycles * 1000 / mhz;
+
+                Serial.printf(",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"name\":\"%s\",\"cat\":\"%s\"", c,
+                              SCOPE_NAMES[r.id], SCOPE_CATEGORIES[r.id]);
+                printMicros("ts", endNs - durNs);
+                printMicros("dur", durNs);
+                Serial.print("}");
+            }
+        }
+        Serial.println("\n]}");
+        Serial.println("#PERFTRACE END");
+        xSemaphoreGive(serialMutex);
+
+        perfTraceArmed = armed;
+    }
+
+    void clear()
+    {
+        const bool armed = pause();
+        for (PerfTraceRing &ring : perfTraceRings)
+            ring.head.store(0, std::memory_order_relaxed);
+        perfTraceArmed = armed;
+    }
+
+    const char *name(PerfTraceId id)
+    {
+        return id < PERF_TRACE_IDS ? SCOPE_NAMES[id] : "?";
+    }
+
+} // namespace PERF_TRACE
+
+#else
+
+static void printDisabled()
+{
+    if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+        return;
+    Serial.println("[PERF] Scope timers compiled out (PERF_TRACE_ENABLED 0)");
+    xSemaphoreGive(serialMutex);
+}
+
+namespace PERF_TRACE
+{
+    uint32_t recorded()
+    {
+        return 0;
+    }
+
+    void printSummary()
+    {
+        printDisabled();
+    }
+
+    void dump()
+    {
+        printDisabled();
+    }
+
+    void clear()
+    {
+    }
+
+    const char *name(PerfTraceId id)
+    {
+        return id < PERF_TRACE_IDS ? SCOPE_NAMES[id] : "?";
+    }
+
+} // namespace PERF_TRACE
+
+#endif // PERF_TRACE_ENABLED
@@ -0,0 +1,324 @@
+#include "../../include/core/signal_history.h"
+#include "../../include/header.h"
+#include <esp_timer.h>
+#include <math.h>
+#include <string.h>
+
+#define HIST_NO_DATA INT16_MIN
+#define HISTORY_QUERY_CHUNK 32 // buckets copied per lock
+
+static const size_t TIER_BASE[HISTORY_TIERS] = {
+    0, HISTORY_TIER0_BUCKETS, HISTORY_TIER0_BUCKETS + HISTORY_TIER1_BUCKETS};
+
+static int16_t toFixed(float v)
+{
+    float x = v * 100.0f;
+    if (x > 32767.0f)
+        x = 32767.0f;
+    if (x < -32767.0f)
+        x = -32767.0f;
+    return (int16_t)lroundf(x);
+}
+
+static float fromFixed(int16_t x)
+{
+    return x / 100.0f;
+}
+
+// Lap of the ring that holds `bucket`, as stored in the slot tag (never 0)
+static uint16_t lapTag(uint8_t tier, uint32_t bucket)
+{
+    return (uint16_t)((bucket / HISTORY_TIER_SPECS[tier].buckets) % 0xFFFFU + 1);
+}
+
+void SignalHistory::reset()
+{
+    memset(buckets_, 0, sizeof(buckets_));
+    memset(acc_, 0, sizeof(acc_));
+}
+
+void SignalHistory::record(HistoryChannel ch, float value, uint32_t tS)
+{
+    if (ch >= HIST_CHANNELS || isnan(value))
+        return;
+
+    for (uint8_t tier = 0; tier < HISTORY_TIERS; tier++)
+    {
+        const uint32_t bucket = tS / HISTORY_TIER_SPECS[tier].periodS;
+        Accumulator &a = acc_[tier][ch];
+
+        if (a.count > 0 && bucket > a.bucket)
+        {
+            flush(tier, ch, a);
+            a.count = 0;
+        }
+        if (a.count == 0)
+        {
+            a.bucket = bucket;
+            a.min = value;
+            a.max = value;
+            a.sum = 0.0f;
+        }
+        // A late sample for an older bucket is folded into the open one
+        if (value < a.min)
+            a.min = value;
+        if (value > a.max)
+            a.max = value;
+        a.sum += value;
+        a.count++;
+    }
+}
+
+void SignalHistory::flush(uint8_t tier, HistoryChannel ch, const Accumulator &a)
+{
+    const uint16_t tag = lapTag(tier, a.bucket);
+    Bucket &b = buckets_[TIER_BASE[tier] + a.bucket % HISTORY_TIER_SPECS[tier].buckets];
+
+    // Slot still holds an older lap: drop the other channels' stale values
+    if (b.tag != tag)
+    {
+        b.tag = tag;
+        for (uint8_t c = 0; c < HIST_CHANNELS; c++)
+            b.v[c][0] = b.v[c][1] = b.v[c][2] = HIST_NO_DATA;
+    }
+    b.v[ch][0] = toFixed(a.min);
+    b.v[ch][1] = toFixed(a.max);
+    b.v[ch][2] = toFixed(a.sum / a.count);
+}
+
+bool SignalHistory::readSlot(uint8_t tier, HistoryChannel ch, uint32_t bucket, HistoryPoint &p) const
+{
+    const Bucket &b = buckets_[TIER_BASE[tier] + bucket % HISTORY_TIER_SPECS[tier].buckets];
+    if (b.tag != lapTag(tier, bucket) || b.v[ch][2] == HIST_NO_DATA)
+        return false;
+    p.startS = bucket * HISTORY_TIER_SPECS[tier].periodS;
+    p.min = fromFixed(b.v[ch][0]);
+    p.max = fromFixed(b.v[ch][1]);
+    p.mean = fromFixed(b.v[ch][2]);
+    return true;
+}
+
+size_t SignalHistory::query(HistoryChannel ch, uint8_t tier, uint32_t fromS, uint32_t toS,
+                            HistoryPoint *out, size_t maxPoints) const
+{
+    if (ch >= HIST_CHANNELS || tier >= HISTORY_TIERS || fromS > toS)
+        return 0;
+
+    const HistoryTierSpec &spec = HISTORY_TIER_SPECS[tier];
+    const Accumulator &a = acc_[tier][ch];
+    const uint32_t last = toS / spec.periodS;
+    uint32_t first = fromS / spec.periodS;
+    if (last >= spec.buckets && first < last - spec.buckets + 1)
+        first = last - spec.buckets + 1; // older buckets have been overwritten
+
+    size_t n = 0;
+    for (uint32_t bucket = first; bucket <= last && n < maxPoints; bucket++)
+    {
+        HistoryPoint &p = out[n];
+        if (a.count > 0 && bucket == a.bucket)
+        {
+            p.startS = bucket * spec.periodS;
+            p.min = a.min;
+            p.max = a.max;
+            p.mean = a.sum / a.count;
+            n++;
+        }
+        else if (readSlot(tier, ch, bucket, p))
+        {
+            n++;
+        }
+    }
+    return n;
+}
+
+uint8_t SignalHistory::tierFor(uint32_t fromS, uint32_t nowS)
+{
+    const uint32_t back = nowS > fromS ? nowS - fromS : 0;
+    for (uint8_t tier = 0; tier < HISTORY_TIERS - 1; tier++)
+    {
+        if (back < HISTORY_TIER_SPECS[tier].periodS * (uint32_t)HISTORY_TIER_SPECS[tier].buckets)
+            return tier;
+    }
+    return HISTORY_TIERS - 1;
+}
+
+// =========================================================
+// FIRMWARE INSTANCE
+// =========================================================
+// Written by the CAN dispatcher, read by the console and OCPP: short
+// spinlock per insert, queries copy HISTORY_QUERY_CHUNK buckets per lock
+static SignalHistory history;
+static portMUX_TYPE historyMux = portMUX_INITIALIZER_UNLOCKED;
+
+static_assert(SignalHistory::memoryBytes() <= HISTORY_MAX_BYTES, "signal history exceeds HISTORY_MAX_BYTES");
+
+static const char *CHANNEL_NAMES[HIST_CHANNELS] = {"terminal V", "terminal A", "charger temp", "SOC %"};
+
+// Run fn(point) over [fromS, toS] of one tier, oldest first
+template <typename Fn>
+static void forEachPoint(HistoryChannel ch, uint8_t tier, uint32_t fromS, uint32_t toS, Fn fn)
+{
+    if (tier >= HISTORY_TIERS || fromS > toS)
+        return;
+    const HistoryTierSpec &spec = HISTORY_TIER_SPECS[tier];
+    const uint32_t span = spec.periodS * (uint32_t)spec.buckets;
+    if (toS >= span && fromS < toS - span)
+        fromS = toS - span;
+
+    HistoryPoint chunk[HISTORY_QUERY_CHUNK];
+    uint32_t bucket = fromS / spec.periodS;
+    const uint32_t last = toS / spec.periodS;
+    while (bucket <= last)
+    {
+        const uint32_t end = last - bucket >= HISTORY_QUERY_CHUNK ? bucket + HISTORY_QUERY_CHUNK - 1 : last;
+        portENTER_CRITICAL(&historyMux);
+        const size_t n = history.query(ch, tier, bucket * spec.periodS, end * spec.periodS, chunk, HISTORY_QUERY_CHUNK);
+        portEXIT_CRITICAL(&historyMux);
+        for (size_t i = 0; i < n; i++)
+            fn(chunk[i]);
+        if (end == last)
+            break;
+        bucket = end + 1;
+    }
+}
+
+static HistorySummary summarizeTier(HistoryChannel ch, uint8_t tier, uint32_t fromS, uint32_t toS)
+{
+    HistorySummary s = {};
+    s.tier = tier;
+    float meanSum = 0.0f;
+    forEachPoint(ch, tier, fromS, toS, [&](const HistoryPoint &p)
+                 {
+        if (s.buckets == 0 || p.min < s.min)
+            s.min = p.min;
+        if (s.buckets == 0 || p.max > s.max)
+            s.max = p.max;
+        if (s.buckets == 0)
+            s.first = p.mean;
+        s.last = p.mean;
+        meanSum += p.mean;
+        s.buckets++; });
+    if (s.buckets > 0)
+        s.mean = meanSum / s.buckets;
+    return s;
+}
+
+static void formatSpan(char *buf, size_t len, uint32_t seconds)
+{
+    if (seconds >= 3600)
+        snprintf(buf, len, "%.1f h", seconds / 3600.0f);
+    else
+        snprintf(buf, len, "%u min", seconds / 60);
+}
+
+namespace SIGNAL_HISTORY
+{
+    void record(HistoryChannel ch, float value, uint64_t rxUs)
+    {
+        const uint32_t tS = (uint32_t)(rxUs / 1000000ULL);
+        portENTER_CRITICAL(&historyMux);
+        history.record(ch, value, tS);
+        portEXIT_CRITICAL(&historyMux);
+    }
+
+    size_t query(HistoryChannel ch, uint8_t tier, uint32_t fromS, uint32_t toS,
+                 HistoryPoint *out, size_t maxPoints)
+    {
+        size_t n = 0;
+        forEachPoint(ch, tier, fromS, toS, [&](const HistoryPoint &p)
+                     {
+            if (n < maxPoints)
+                out[n++] = p; });
+        return n;
+    }
+
+    HistorySummary summarize(HistoryChannel ch, uint32_t fromS, uint32_t toS)
+    {
+        return summarizeTier(ch, SignalHistory::tierFor(fromS, nowS()), fromS, toS);
+    }
+
+    uint32_t nowS()
+    {
+        return (uint32_t)(esp_timer_get_time() / 1000000LL);
+    }
+
+    size_t memoryBytes()
+    {
+        return SignalHistory::memoryBytes();
+    }
+
+    const char *channelName(HistoryChannel ch)
+    {
+        return ch < HIST_CHANNELS ? CHANNEL_NAMES[ch] : "?";
+    }
+
+    void reset()
+    {
+        portENTER_CRITICAL(&historyMux);
+        history.reset();
+        portEXIT_CRITICAL(&historyMux);
+    }
+
+    void print()
+    {
+        const uint32_t now = nowS();
+        HistorySummary sums[HISTORY_TIERS][HIST_CHANNELS];
+        for (uint8_t tier = 0; tier < HISTORY_TIERS; tier++)
+        {
+            const uint32_t span = HISTORY_TIER_SPECS[tier].periodS * (uint32_t)HISTORY_TIER_SPECS[tier].buckets;
+            for (uint8_t ch = 0; ch < HIST_CHANNELS; ch++)
+                sums[tier][ch] = summarizeTier((HistoryChannel)ch, tier, now > span ? now - span : 0, now);
+        }
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        Serial.println("\n============ SIGNAL HISTORY ============");
+        Serial.printf("Memory: %u bytes static (budget %u), %u buckets x %u channels\n",
+                      (unsigned)memoryBytes(), (unsigned)HISTORY_MAX_BYTES,
+                      (unsigned)HISTORY_TOTAL_BUCKETS, (unsigned)HIST_CHANNELS);
+        for (uint8_t tier = 0; tier < HISTORY_TIERS; tier++)
+        {
+            const HistoryTierSpec &spec = HISTORY_TIER_SPECS[tier];
+            char span[16];
+            formatSpan(span, sizeof(span), spec.periodS * (uint32_t)spec.buckets);
+            Serial.printf("Tier %u: %us x %u (%s)\n", tier, spec.periodS, spec.buckets, span);
+            for (uint8_t ch = 0; ch < HIST_CHANNELS; ch++)
+            {
+                const HistorySummary &s = sums[tier][ch];
+                if (s.buckets == 0)
+                {
+                    Serial.printf("  %-12s no data\n", CHANNEL_NAMES[ch]);
+                    continue;
+                }
+                Serial.printf("  %-12s buckets=%-4u min=%8.2f max=%8.2f mean=%8.2f last=%8.2f\n",
+                              CHANNEL_NAMES[ch], s.buckets, s.min, s.max, s.mean, s.last);
+            }
+        }
+        Serial.println("========================================\n");
+
+        xSemaphoreGive(serialMutex);
+    }
+
+    void dump(uint8_t tier)
+    {
+        if (tier >= HISTORY_TIERS)
+            return;
+        const uint32_t now = nowS();
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        Serial.printf("#HISTORY tier=%u period=%us\n", tier, HISTORY_TIER_SPECS[tier].periodS);
+        Serial.println("startS,channel,min,max,mean");
+        for (uint8_t ch = 0; ch < HIST_CHANNELS; ch++)
+        {
+            forEachPoint((HistoryChannel)ch, tier, 0, now, [&](const HistoryPoint &p)
+                         { Serial.printf("%u,%u,%.2f,%.2f,%.2f\n", p.startS, ch, p.min, p.max, p.mean); });
+        }
+        Serial.println("#HISTORY END");
+
+        xSemaphoreGive(serialMutex);
+    }
+
+} // namespace SIGNAL_HISTORY
@@ -0,0 +1,275 @@
+#include "../../include/core/task_profiler.h"
+#include "../../include/header.h"
+#include "../../include/config/timing.h"
+#include <freertos/timers.h>
+#include <string.h>
+
+#define PROFILER_RING (TASK_PROFILER_HISTORY + 1)
+#define PROFILER_STATUS_CAPACITY (TASK_PROFILER_MAX_TASKS + 8)
+#define PROFILER_STACK_WARN_BYTES 512
+
+// Run time counter of one task at each of the last PROFILER_RING samples
+struct TaskSlot
+{
+    TaskHandle_t handle; // nullptr = free
+    uint32_t runTime[PROFILER_RING];
+    uint32_t seen; // consecutive samples this task was in
+};
+
+struct TrackedStack
+{
+    TaskHandle_t handle;
+    uint32_t bytes;
+};
+
+// Timer task only
+static TaskSlot slots[TASK_PROFILER_MAX_TASKS];
+static uint32_t totals[PROFILER_RING];
+static TaskStatus_t statusBuf[PROFILER_STATUS_CAPACITY];
+static uint32_t sampleCount = 0;
+
+// Shared with the readers
+static portMUX_TYPE profilerMux = portMUX_INITIALIZER_UNLOCKED;
+static TrackedStack tracked[TASK_PROFILER_MAX_TASKS];
+static ProfilerSnapshot latest;
+
+static TimerHandle_t sampleTimer = nullptr;
+
+static uint16_t permille(uint32_t part, uint32_t whole)
+{
+    if (whole == 0)
+        return TASK_PROFILER_NO_CPU;
+    const uint64_t p = (uint64_t)part * 1000ULL / whole;
+    return (uint16_t)(p > 1000 ? 1000 : p);
+}
+
+static TaskSlot *slotFor(TaskHandle_t handle)
+{
+    TaskSlot *free = nullptr;
+    for (TaskSlot &s : slots)
+    {
+        if (s.handle == handle)
+            return &s;
+        if (!free && s.handle == nullptr)
+            free = &s;
+    }
+    if (free)
+    {
+        free->handle = handle;
+        free->seen = 0;
+    }
+    return free;
+}
+
+static uint32_t trackedBytes(TaskHandle_t handle)
+{
+    uint32_t bytes = 0;
+    portENTER_CRITICAL(&profilerMux);
+    for (const TrackedStack &t : tracked)
+    {
+        if (t.handle == handle)
+            bytes = t.bytes;
+    }
+    portEXIT_CRITICAL(&profilerMux);
+    return bytes;
+}
+
+static void printPermille(uint16_t p)
+{
+    if (p == TASK_PROFILER_NO_CPU)
+        Serial.print("      -");
+    else
+        Serial.printf(" %5.1f%%", p / 10.0f);
+}
+
+static void onSampleTimer(TimerHandle_t)
+{
+    TASK_PROFILER::sample();
+}
+
+namespace TASK_PROFILER
+{
+    bool init()
+    {
+        if (sampleTimer == nullptr)
+        {
+            sampleTimer = xTimerCreate("PROFILER", pdMS_TO_TICKS(TASK_PROFILER_SAMPLE_MS), pdTRUE, nullptr,
+                                       onSampleTimer);
+            if (sampleTimer == nullptr || xTimerStart(sampleTimer, 0) != pdPASS)
+                return false;
+        }
+        sample();
+        return true;
+    }
+
+    void track(TaskHandle_t task, uint32_t stackBytes)
+    {
+        if (task == nullptr)
+            return;
+        portENTER_CRITICAL(&profilerMux);
+        for (TrackedStack &t : tracked)
+        {
+            if (t.handle == nullptr || t.handle == task)
+            {
+                t = {task, stackBytes};
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&profilerMux);
+    }
+
+    void sample()
+    {
+        static ProfilerSnapshot next;
+        uint32_t total = 0;
+        const UBaseType_t n = uxTaskGetSystemState(statusBuf, PROFILER_STATUS_CAPACITY, &total);
+
+        const uint32_t at = sampleCount % PROFILER_RING;
+        const uint32_t prev = (at + PROFILER_RING - 1) % PROFILER_RING;
+        totals[at] = total;
+        sampleCount++;
+
+        memset(&next, 0, sizeof(next));
+        next.samples = sampleCount;
+        next.runTimeStats = total != 0;
+        next.untracked = n == 0 ? (uint8_t)uxTaskGetNumberOfTasks() : 0;
+
+        bool hasIdle[TASK_PROFILER_CORES] = {};
+        uint32_t busyShort[TASK_PROFILER_CORES] = {}, busyLong[TASK_PROFILER_CORES] = {};
+        uint32_t longestSpan = 0;
+        bool present[TASK_PROFILER_MAX_TASKS] = {};
+
+        for (UBaseType_t i = 0; i < n; i++)
+        {
+            const TaskStatus_t &st = statusBuf[i];
+            TaskSlot *slot = slotFor(st.xHandle);
+            if (!slot || next.taskCount >= TASK_PROFILER_MAX_TASKS)
+            {
+                next.untracked++;
+                continue;
+            }
+            present[slot - slots] = true;
+            slot->runTime[at] = st.ulRunTimeCounter;
+            slot->seen++;
+
+            TaskProfile &p = next.tasks[next.taskCount++];
+            strncpy(p.name, st.pcTaskName, sizeof(p.name) - 1);
+#if configTASKLIST_INCLUDE_COREID
+            p.core = st.xCoreID >= 0 && st.xCoreID < TASK_PROFILER_CORES ? (int8_t)st.xCoreID : -1;
+#else
+            p.core = -1;
+#endif
+            p.priority = (uint8_t)st.uxCurrentPriority;
+            p.stackBytes = trackedBytes(st.xHandle);
+            p.stackFreeMin = st.usStackHighWaterMark;
+
+            // Windows: last sample period, and as many of the kept ones as the task was in
+            const uint32_t span = slot->seen - 1 < TASK_PROFILER_HISTORY ? slot->seen - 1 : TASK_PROFILER_HISTORY;
+            p.cpuShortPermille = p.cpuLongPermille = TASK_PROFILER_NO_CPU;
+            if (next.runTimeStats && span > 0)
+            {
+                const uint32_t from = (at + PROFILER_RING - span) % PROFILER_RING;
+                p.cpuShortPermille = permille(slot->runTime[at] - slot->runTime[prev], total - totals[prev]);
+                p.cpuLongPermille = permille(slot->runTime[at] - slot->runTime[from], total - totals[from]);
+                if (span > longestSpan)
+                {
+                    longestSpan = span;
+                    next.longWindowMs = (total - totals[from]) / 1000;
+                }
+                next.shortWindowMs = (total - totals[prev]) / 1000;
+            }
+
+            if (p.core < 0 || p.cpuShortPermille == TASK_PROFILER_NO_CPU)
+                continue;
+            if (strncmp(p.name, "IDLE", 4) == 0)
+            {
+                hasIdle[p.core] = true;
+                busyShort[p.core] = 1000 - p.cpuShortPermille;
+                busyLong[p.core] = 1000 - p.cpuLongPermille;
+            }
+            else if (!hasIdle[p.core])
+            {
+                busyShort[p.core] += p.cpuShortPermille;
+                busyLong[p.core] += p.cpuLongPermille;
+            }
+        }
+
+        // Tasks gone since the last sample free their slot
+        for (uint8_t i = 0; i < TASK_PROFILER_MAX_TASKS; i++)
+        {
+            if (!present[i])
+                slots[i].handle = nullptr;
+        }
+
+        for (uint8_t c = 0; c < TASK_PROFILER_CORES; c++)
+        {
+            const bool covered = next.runTimeStats && longestSpan > 0;
+            next.coreShortPermille[c] = covered ? (uint16_t)(busyShort[c] > 1000 ? 1000 : busyShort[c]) : TASK_PROFILER_NO_CPU;
+            next.coreLongPermille[c] = covered ? (uint16_t)(busyLong[c] > 1000 ? 1000 : busyLong[c]) : TASK_PROFILER_NO_CPU;
+        }
+
+        portENTER_CRITICAL(&profilerMux);
+        latest = next;
+        portEXIT_CRITICAL(&profilerMux);
+    }
+
+    bool snapshot(ProfilerSnapshot &out)
+    {
+        portENTER_CRITICAL(&profilerMux);
+        out = latest;
+        portEXIT_CRITICAL(&profilerMux);
+        return out.samples > 0;
+    }
+
+    void print()
+    {
+        static ProfilerSnapshot s; // console task only
+        const bool ready = snapshot(s);
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        Serial.println("\n============ TASK PROFILER ============");
+        if (!ready)
+        {
+            Serial.println("(no sample yet)");
+        }
+        else
+        {
+            if (s.runTimeStats)
+                Serial.printf("Windows: %.1f s / %.1f s (%u samples)\n", s.shortWindowMs / 1000.0f,
+                              s.longWindowMs / 1000.0f, (unsigned)s.samples);
+            else
+                Serial.println("⚠️  No run time stats in this build (configGENERATE_RUN_TIME_STATS): stacks only");
+            for (uint8_t c = 0; c < TASK_PROFILER_CORES; c++)
+            {
+                Serial.printf("Core %u load:", c);
+                printPermille(s.coreShortPermille[c]);
+                printPermille(s.coreLongPermille[c]);
+                Serial.println();
+            }
+            Serial.println("task             core prio  cpu short  cpu long   stack used / size  free min");
+            for (uint8_t i = 0; i < s.taskCount; i++)
+            {
+                const TaskProfile &t = s.tasks[i];
+                Serial.printf("%-16s %4s %4u   ", t.name, t.core < 0 ? "any" : (t.core ? "1" : "0"), t.priority);
+                printPermille(t.cpuShortPermille);
+                Serial.print("   ");
+                printPermille(t.cpuLongPermille);
+                if (t.stackBytes)
+                    Serial.printf("   %6u / %-6u", (unsigned)(t.stackBytes > t.stackFreeMin ? t.stackBytes - t.stackFreeMin : 0),
+                                  (unsigned)t.stackBytes);
+                else
+                    Serial.print("          -      ");
+                Serial.printf("  %8u%s\n", (unsigned)t.stackFreeMin,
+                              t.stackFreeMin < PROFILER_STACK_WARN_BYTES ? " ⚠️" : "");
+            }
+            if (s.untracked)
+                Serial.printf("(%u more tasks not shown: TASK_PROFILER_MAX_TASKS)\n", s.untracked);
+        }
+        Serial.println("=======================================\n");
+
+        xSemaphoreGive(serialMutex);
+    }
+
+} // namespace TASK_PROFILER
@@ -0,0 +1,153 @@
+#include "../../include/core/telemetry.h"
+#include "../../include/core/seqlock.h"
+#include "../../include/header.h"
+#include <esp_timer.h>
+#include <string.h>
+
+static Seqlock<ChargerTelemetry> chargerLock;
+static Seqlock<BmsTelemetry> bmsLock;
+
+// Per-signal RX times. Every decoder runs in canDispatchTask, the single
+// writer: it updates the working copy and publishes it through a Seqlock, so
+// other tasks read a whole 64-bit RX time without a lock. The snapshot
+// publishers run in that task and read the working copy directly.
+static SignalTiming signalTimes[TSIG_COUNT];
+static Seqlock<SignalTiming> signalLocks[TSIG_COUNT];
+
+static const char *SIGNAL_NAMES[TSIG_COUNT] = {
+    "charger status", "charger Vmax", "charger Imax", "output volt", "output curr",
+    "output temp", "metric79", "metric83", "terminal power", "terminal status",
+    "heartbeat", "BMS request", "charging Ah", "discharging Ah", "battery present"};
+
+namespace TELEMETRY
+{
+
+    void publishCharger()
+    {
+        ChargerTelemetry t;
+        t.terminalVolt = terminalVolt;
+        t.terminalCurr = terminalCurr;
+        t.terminalPower = terminalchargerPower;
+        t.outputVolt = chargerVolt;
+        t.outputCurr = chargerCurr;
+        t.outputTemp = chargerTemp;
+        t.terminalRxUs = signalTimes[TSIG_TERMINAL_POWER].rxUs; // our own stamp, no lock needed
+        chargerLock.publish(t);
+    }
+
+    void publishBms()
+    {
+        BmsTelemetry t;
+        t.vmax = BMS_Vmax;
+        t.imax = BMS_Imax;
+        t.socPercent = socPercent;
+        t.rangeKm = rangeKm;
+        t.batteryAh = batteryAh;
+        t.vehicleModel = vehicleModel;
+        t.requestRxUs = signalTimes[TSIG_BMS_REQUEST].rxUs;
+        t.socRxUs = signalTimes[TSIG_BMS_CHARGE_AH].rxUs;
+        bmsLock.publish(t);
+    }
+
+    ChargerTelemetry charger()
+    {
+        return chargerLock.read();
+    }
+
+    BmsTelemetry bms()
+    {
+        return bmsLock.read();
+    }
+
+    TelemetrySnapshot snapshot()
+    {
+        TelemetrySnapshot s;
+        s.chargerSeq = chargerLock.read(s.charger);
+        s.bmsSeq = bmsLock.read(s.bms);
+        return s;
+    }
+
+    void stamp(TelemetrySignal sig, uint64_t rxUs)
+    {
+        if (sig >= TSIG_COUNT)
+            return;
+        const uint64_t now = (uint64_t)esp_timer_get_time();
+        const uint32_t decodeUs = now > rxUs ? (uint32_t)(now - rxUs) : 0;
+
+        SignalTiming &s = signalTimes[sig];
+        // Frames of one signal come from one bus in order; never step back
+        if (rxUs > s.rxUs)
+            s.rxUs = rxUs;
+        s.decodeUs = decodeUs;
+        if (decodeUs > s.maxDecodeUs)
+            s.maxDecodeUs = decodeUs;
+        s.updates++;
+        signalLocks[sig].publish(s);
+    }
+
+    SignalTiming timing(TelemetrySignal sig)
+    {
+        if (sig >= TSIG_COUNT)
+            return SignalTiming{};
+        return signalLocks[sig].read();
+    }
+
+    uint64_t rxUs(TelemetrySignal sig)
+    {
+        return timing(sig).rxUs;
+    }
+
+    uint64_t ageUs(TelemetrySignal sig)
+    {
+        const uint64_t rx = rxUs(sig);
+        if (rx == 0)
+            return UINT64_MAX;
+        const uint64_t now = (uint64_t)esp_timer_get_time();
+        return now > rx ? now - rx : 0;
+    }
+
+    uint32_t ageMs(TelemetrySignal sig)
+    {
+        const uint64_t age = ageUs(sig);
+        if (age == UINT64_MAX || age / 1000 >= UINT32_MAX)
+            return UINT32_MAX;
+        return (uint32_t)(age / 1000);
+    }
+
+    const char *signalName(TelemetrySignal sig)
+    {
+        return sig < TSIG_COUNT ? SIGNAL_NAMES[sig] : "?";
+    }
+
+    void resetSignals()
+    {
+        memset(signalTimes, 0, sizeof(signalTimes));
+        for (uint8_t i = 0; i < TSIG_COUNT; i++)
+            signalLocks[i].publish(signalTimes[i]);
+    }
+
+    void printSignalAges()
+    {
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        Serial.println("\n========= SIGNAL AGE (RX time) =========");
+        Serial.println("signal              age ms   decode us (last / max)  updates");
+        for (uint8_t i = 0; i < TSIG_COUNT; i++)
+        {
+            const TelemetrySignal sig = (TelemetrySignal)i;
+            const SignalTiming t = timing(sig);
+            if (t.rxUs == 0)
+            {
+                Serial.printf("%-18s  %7s\n", SIGNAL_NAMES[i], "never");
+                continue;
+            }
+            Serial.printf("%-18s  %7u   %8u / %-8u     %u\n", SIGNAL_NAMES[i], ageMs(sig),
+                          t.decodeUs, t.maxDecodeUs, t.updates);
+        }
+        Serial.println("========================================\n");
+
+        xSemaphoreGive(serialMutex);
+    }
+
+} // namespace TELEMETRY
@@ -0,0 +1,154 @@
+#include "../../include/core/telemetry_frame.h"
+#include <math.h>
+
+// Fixed-point scale per field, in frame order
+static const float FIELD_SCALE[TELEMETRY_FRAME_FIELDS] = {10.0f, 10.0f, 100.0f, 100.0f, 10.0f, 10.0f};
+
+static void fieldsOf(const VehicleSample &s, int32_t f[TELEMETRY_FRAME_FIELDS])
+{
+    const float v[TELEMETRY_FRAME_FIELDS] = {s.soc, s.maxCurrent, s.voltage, s.current, s.temperature, s.rangeKm};
+    for (uint8_t i = 0; i < TELEMETRY_FRAME_FIELDS; i++)
+        f[i] = isnan(v[i]) ? 0 : (int32_t)lroundf(v[i] * FIELD_SCALE[i]);
+}
+
+static size_t putVarint(uint8_t *out, size_t pos, size_t cap, uint32_t v)
+{
+    do
+    {
+        if (pos >= cap)
+            return cap + 1;
+        uint8_t b = v & 0x7F;
+        v >>= 7;
+        out[pos++] = v ? (b | 0x80) : b;
+    } while (v);
+    return pos;
+}
+
+static bool getVarint(const uint8_t *in, size_t len, size_t &pos, uint32_t &v)
+{
+    v = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7)
+    {
+        if (pos >= len)
+            return false;
+        const uint8_t b = in[pos++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+void VehicleInfoBatch::clear()
+{
+    count_ = 0;
+    model_ = 0;
+}
+
+bool VehicleInfoBatch::add(uint8_t model, const VehicleSample &s)
+{
+    if (full() || (count_ > 0 && model != model_))
+        return false;
+    model_ = model;
+    samples_[count_++] = s;
+    return true;
+}
+
+size_t VehicleInfoBatch::encode(uint32_t nowMs, uint8_t *out, size_t cap) const
+{
+    if (count_ == 0 || cap < 3)
+        return 0;
+
+    out[0] = TELEMETRY_FRAME_VERSION;
+    out[1] = model_;
+    out[2] = count_;
+    size_t pos = 3;
+
+    int32_t prev[TELEMETRY_FRAME_FIELDS] = {};
+    for (uint8_t k = 0; k < count_; k++)
+    {
+        const VehicleSample &s = samples_[k];
+        const uint32_t t = k == 0 ? nowMs - s.tMs : s.tMs - samples_[k - 1].tMs;
+        pos = putVarint(out, pos, cap, t);
+
+        int32_t f[TELEMETRY_FRAME_FIELDS];
+        fieldsOf(s, f);
+        for (uint8_t i = 0; i < TELEMETRY_FRAME_FIELDS; i++)
+        {
+            pos = putVarint(out, pos, cap, zigzag(f[i] - prev[i]));
+            prev[i] = f[i];
+        }
+        if (pos > cap)
+            return 0;
+    }
+    return pos;
+}
+
+namespace TELEMETRY_FRAME
+{
+    size_t toBase64(const uint8_t *in, size_t len, char *out, size_t cap)
+    {
+        static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        const size_t outLen = ((len + 2) / 3) * 4;
+        if (outLen + 1 > cap)
+            return 0;
+
+        size_t o = 0;
+        for (size_t i = 0; i < len; i += 3)
+        {
+            const uint32_t n = (uint32_t)in[i] << 16 | (i + 1 < len ? (uint32_t)in[i + 1] << 8 : 0) |
+                               (i + 2 < len ? in[i + 2] : 0);
+            out[o++] = ALPHABET[(n >> 18) & 0x3F];
+            out[o++] = ALPHABET[(n >> 12) & 0x3F];
+            out[o++] = i + 1 < len ? ALPHABET[(n >> 6) & 0x3F] : '=';
+            out[o++] = i + 2 < len ? ALPHABET[n & 0x3F] : '=';
+        }
+        out[o] = '\0';
+        return o;
+    }
+
+    size_t decode(const uint8_t *in, size_t len, uint32_t builtMs, uint8_t &model,
+                  VehicleSample *out, size_t maxSamples)
+    {
+        if (len < 3 || in[0] != TELEMETRY_FRAME_VERSION)
+            return 0;
+        model = in[1];
+        const size_t n = in[2];
+        if (n == 0 || n > maxSamples)
+            return 0;
+
+        size_t pos = 3;
+        int32_t acc[TELEMETRY_FRAME_FIELDS] = {};
+        uint32_t t = builtMs;
+        for (size_t k = 0; k < n; k++)
+        {
+            uint32_t dt;
+            if (!getVarint(in, len, pos, dt))
+                return 0;
+            t = k == 0 ? builtMs - dt : t + dt;
+
+            float v[TELEMETRY_FRAME_FIELDS];
+            for (uint8_t i = 0; i < TELEMETRY_FRAME_FIELDS; i++)
+            {
+                uint32_t z;
+                if (!getVarint(in, len, pos, z))
+                    return 0;
+                acc[i] += unzigzag(z);
+                v[i] = acc[i] / FIELD_SCALE[i];
+            }
+            out[k] = {t, v[0], v[1], v[2], v[3], v[4], v[5]};
+        }
+        return pos == len ? n : 0;
+    }
+
+} // namespace TELEMETRY_FRAME
@@ -1,5 +1,9 @@
 #include "header.h"
 #include "drivers/can_mcp2515_driver.h"
+#include "config/timing.h"
+#include "core/telemetry.h"
+#include "core/signal_history.h"
+#include "core/deferred_log.h"
 #include <Arduino.h>
 #include <math.h>
 
@@ -25,17 +29,17 @@ static uint8_t buildStatusFlags()
     // Bit3: Battery not connected / reversed
     if (!batteryConnected)
         flags |= 0x08;
-    // Bit4: Communication timeout (no BMS request in >5s)
-    if ((millis() - lastBMS) > 5000)
+    // Bit4: Communication timeout (no BMS request in >5s, from RX time)
+    if (TELEMETRY::ageMs(TSIG_BATTERY_PRESENT) > 5000)
         flags |= 0x10;
     return flags;
 }
 
-void handleBMSMessage(const twai_message_t &msg)
+void handleBMSMessage(const CanMessage &msg)
 {
-    if (!msg.extd)
+    if (!msg.extended)
         return;
-    if ((msg.identifier & 0x1FFFFFFFUL) != (ID_BMS_REQUEST & 0x1FFFFFFFUL))
+    if ((msg.id & 0x1FFFFFFFUL) != (ID_BMS_REQUEST & 0x1FFFFFFFUL))
         return;
 
     // Serial.println("BMS message received");
@@ -43,9 +47,10 @@ void handleBMSMessage(const twai_message_t &msg)
     if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(10)) == pdTRUE)
     {
         batteryConnected = true;
-        lastBMS = millis();
+        TELEMETRY::stamp(TSIG_BMS_REQUEST, msg.timestamp_us);
+        TELEMETRY::stamp(TSIG_BATTERY_PRESENT, msg.timestamp_us);
 
-        const uint8_t dlc = msg.data_length_code;
+        const uint8_t dlc = msg.dlc;
         memcpy(lastBMSData, msg.data, dlc > 8 ? 8 : dlc);
 
         const uint16_t vmax_raw = (uint16_t(msg.data[0]) << 8) | msg.data[1];
@@ -59,13 +64,13 @@ void handleBMSMessage(const twai_message_t &msg)
         
         // Log state changes
         if (newSafeToCharge != bmsSafeToCharge) {
-            Serial.printf("[BMS] %s Charging switch: %s (byte4=0x%02X)\n",
+            DLOG("[BMS] %s Charging switch: %s (byte4=0x%02X)\n",
                 newSafeToCharge ? "✅" : "🚨",
                 newSafeToCharge ? "ON" : "OFF",
                 msg.data[4]);
         }
         if (newHeatingActive != bmsHeatingActive) {
-            Serial.printf("[BMS] %s Heating: %s (byte5=0x%02X)\n",
+            DLOG("[BMS] %s Heating: %s (byte5=0x%02X)\n",
                 newHeatingActive ? "⚠️" : "✅",
                 newHeatingActive ? "ACTIVE" : "OFF",
                 msg.data[5]);
@@ -81,10 +86,8 @@ void handleBMSMessage(const twai_message_t &msg)
         cachedRawI = (uint32_t)lroundf(BMS_Imax * 30.5f);
 
         if (BMS_Vmax > 56.0f && BMS_Vmax < 85.5f)
-        {
             batteryConnected = true;
-            lastBMS = millis();
-        }
+        TELEMETRY::publishBms();
         xSemaphoreGive(dataMutex);
     }
 }
@@ -116,7 +119,8 @@ void sendChargerFeedback()
     txData[6] = 0x00;
     txData[7] = 0x00;
 
-    CAN_MCP2515::sendMessage(ID_HEARTBEAT & 0x1FFFFFFFUL, txData, 8, true);
+    // Sent from TXB2 by the CAN2 task every HEARTBEAT_INTERVAL_MS
+    CAN_MCP2515::updateMailbox(ID_HEARTBEAT & 0x1FFFFFFFUL, txData, 8, true, HEARTBEAT_INTERVAL_MS);
 }
 
 void requestSOCFromBMS()
@@ -137,15 +141,15 @@ void requestDischargingAh()
     CAN_MCP2515::sendMessage(ID_DISCHARGE_AH_REQUEST & 0x1FFFFFFFUL, txData, 8, true);
 }
 
-void handleChargingAhMessage(const twai_message_t &msg)
+void handleChargingAhMessage(const CanMessage &msg)
 {
-    if (!msg.extd)
+    if (!msg.extended)
         return;
 
-    if ((msg.identifier & 0x1FFFFFFFUL) != (ID_CHARGE_AH_RESPONSE & 0x1FFFFFFFUL))
+    if ((msg.id & 0x1FFFFFFFUL) != (ID_CHARGE_AH_RESPONSE & 0x1FFFFFFFUL))
         return;
 
-    if (msg.data_length_code < 4)
+    if (msg.dlc < 4)
         return;
 
     if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(10)) == pdTRUE)
@@ -155,8 +159,9 @@ void handleChargingAhMessage(const twai_message_t &msg)
                                   ((uint32_t)msg.data[2] << 8) | 
                                   msg.data[3];
         totalChargingAh = charge_ah_raw * 0.001f;
+        TELEMETRY::stamp(TSIG_BMS_CHARGE_AH, msg.timestamp_us);
         
-        Serial.printf("[BMS] ChargingAh received: raw=0x%08X (%.3fAh)\n", charge_ah_raw, totalChargingAh);
+        DLOG("[BMS] ChargingAh received: raw=0x%08X (%.3fAh)\n", charge_ah_raw, totalChargingAh);
         
         // Calculate SOC if ChargingAh > 0 (DischargingAh can be 0 for new battery)
         if (totalChargingAh > 0.0f)
@@ -187,28 +192,30 @@ void handleChargingAhMessage(const twai_message_t &msg)
             
             socPercent = batterySoc;
             rangeKm = batteryAh * 2.7f;
+            SIGNAL_HISTORY::record(HIST_SOC, socPercent, msg.timestamp_us);
             
-            Serial.printf("[BMS] ✅ SOC calculated: %.1f%% (%.1fAh / %.0fAh) Range=%.1fkm Model=%d\n",
+            DLOG("[BMS] ✅ SOC calculated: %.1f%% (%.1fAh / %.0fAh) Range=%.1fkm Model=%d\n",
                 socPercent, batteryAh, maxCapacityAh, rangeKm, vehicleModel);
             
             if (socPercent > 0.0f) {
                 batteryConnected = true;
             }
+            TELEMETRY::publishBms();
         }
 
         xSemaphoreGive(dataMutex);
     }
 }
 
-void handleDischargingAhMessage(const twai_message_t &msg)
+void handleDischargingAhMessage(const CanMessage &msg)
 {
-    if (!msg.extd)
+    if (!msg.extended)
         return;
 
-    if ((msg.identifier & 0x1FFFFFFFUL) != (ID_DISCHARGE_AH_RESPONSE & 0x1FFFFFFFUL))
+    if ((msg.id & 0x1FFFFFFFUL) != (ID_DISCHARGE_AH_RESPONSE & 0x1FFFFFFFUL))
         return;
 
-    if (msg.data_length_code < 4)
+    if (msg.dlc < 4)
         return;
 
     if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(10)) == pdTRUE)
@@ -218,14 +225,15 @@ void handleDischargingAhMessage(const twai_message_t &msg)
                                      ((uint32_t)msg.data[2] << 8) | 
                                      msg.data[3];
         totalDischargingAh = discharge_ah_raw * 0.001f;
+        TELEMETRY::stamp(TSIG_BMS_DISCHARGE_AH, msg.timestamp_us);
         
-        Serial.printf("[BMS] DischargingAh received: raw=0x%08X (%.3fAh)\n", discharge_ah_raw, totalDischargingAh);
+        DLOG("[BMS] DischargingAh received: raw=0x%08X (%.3fAh)\n", discharge_ah_raw, totalDischargingAh);
 
         xSemaphoreGive(dataMutex);
     }
 }
 
-void handleSOCMessage(const twai_message_t &msg)
+void handleSOCMessage(const CanMessage &msg)
 {
     // Deprecated - SOC now calculated from Ah values
     (void)msg;
@@ -0,0 +1,161 @@
+#include "../../include/drivers/can_bus_recovery.h"
+#include <string.h>
+
+void CanRecoveryHistogram::record(uint32_t us)
+{
+    uint8_t b = 0;
+    while (b < CAN_RECOVERY_BUCKETS - 1 && us > CAN_RECOVERY_EDGES_MS[b] * 1000)
+        b++;
+    buckets[b]++;
+
+    if (samples == 0 || us < minUs)
+        minUs = us;
+    if (us > maxUs)
+        maxUs = us;
+    totalUs += us;
+    samples++;
+}
+
+void CanBusOffRecovery::reset()
+{
+    state_ = CAN_REC_RUNNING;
+    errorPassive_ = false;
+    recoveredOnce_ = false;
+    backoffMs_ = 0;
+    downSinceUs_ = 0;
+    actionAtUs_ = 0;
+    recoveredUs_ = 0;
+    resetStats();
+}
+
+void CanBusOffRecovery::resetStats()
+{
+    memset(&stats_, 0, sizeof(stats_));
+    stats_.backoffMs = backoffMs_;
+}
+
+void CanBusOffRecovery::enterBusOff(uint64_t nowUs)
+{
+    stats_.busOffs++;
+    downSinceUs_ = nowUs;
+
+    // Back-to-back bus-offs: double the wait; a stable bus starts over
+    if (recoveredOnce_ && nowUs - recoveredUs_ < CAN1_BUSOFF_STABLE_MS * 1000ULL)
+    {
+        backoffMs_ = backoffMs_ ? backoffMs_ * 2 : CAN1_BUSOFF_BACKOFF_MIN_MS;
+        if (backoffMs_ > CAN1_BUSOFF_BACKOFF_MAX_MS)
+            backoffMs_ = CAN1_BUSOFF_BACKOFF_MAX_MS;
+    }
+    else
+    {
+        backoffMs_ = 0;
+    }
+    stats_.backoffMs = backoffMs_;
+
+    state_ = CAN_REC_BACKOFF;
+    actionAtUs_ = nowUs + backoffMs_ * 1000ULL;
+}
+
+void CanBusOffRecovery::onAlerts(uint32_t alerts, uint64_t nowUs)
+{
+    if (alerts & TWAI_ALERT_ABOVE_ERR_WARN)
+        stats_.errorWarnings++;
+    if (alerts & TWAI_ALERT_ERR_PASS)
+    {
+        if (state_ == CAN_REC_RUNNING && !errorPassive_)
+            stats_.errorPassive++;
+        errorPassive_ = true;
+    }
+    if (alerts & TWAI_ALERT_ERR_ACTIVE)
+        errorPassive_ = false;
+
+    if ((alerts & TWAI_ALERT_BUS_OFF) && state_ == CAN_REC_RUNNING)
+        enterBusOff(nowUs);
+
+    if ((alerts & TWAI_ALERT_BUS_RECOVERED) && state_ == CAN_REC_RECOVERING)
+    {
+        state_ = CAN_REC_RESTART;
+        actionAtUs_ = nowUs;
+    }
+}
+
+void CanBusOffRecovery::onState(twai_state_t state, uint64_t nowUs)
+{
+    if (state_ == CAN_REC_RUNNING)
+    {
+        if (state == TWAI_STATE_BUS_OFF)
+        {
+            enterBusOff(nowUs);
+        }
+        else if (state == TWAI_STATE_STOPPED)
+        {
+            stats_.stopped++;
+            downSinceUs_ = nowUs;
+            state_ = CAN_REC_RESTART;
+            actionAtUs_ = nowUs;
+        }
+    }
+    else if (state_ == CAN_REC_RECOVERING && state == TWAI_STATE_STOPPED)
+    {
+        // BUS_RECOVERED alert missed
+        state_ = CAN_REC_RESTART;
+        actionAtUs_ = nowUs;
+    }
+    else if (state_ == CAN_REC_RESTART && state == TWAI_STATE_BUS_OFF)
+    {
+        // A failed recovery request left the controller bus-off: retry it
+        state_ = CAN_REC_BACKOFF;
+    }
+    else if (state == TWAI_STATE_RUNNING)
+    {
+        // Restarted behind our back (driver reinstalled)
+        complete(CAN_REC_START, true, nowUs);
+    }
+}
+
+CanRecoveryAction CanBusOffRecovery::next(uint64_t nowUs) const
+{
+    if (nowUs < actionAtUs_)
+        return CAN_REC_NONE;
+    if (state_ == CAN_REC_BACKOFF)
+        return CAN_REC_INITIATE;
+    if (state_ == CAN_REC_RESTART)
+        return CAN_REC_START;
+    return CAN_REC_NONE;
+}
+
+void CanBusOffRecovery::complete(CanRecoveryAction action, bool ok, uint64_t nowUs)
+{
+    if (!ok)
+    {
+        stats_.actionFailures++;
+        if (action == CAN_REC_INITIATE)
+        {
+            // No longer bus-off (e.g. stopped meanwhile): the state read decides
+            state_ = CAN_REC_RESTART;
+        }
+        actionAtUs_ = nowUs + CAN1_TX_DOWN_RETRY_MS * 1000ULL;
+        return;
+    }
+
+    if (action == CAN_REC_INITIATE)
+    {
+        state_ = CAN_REC_RECOVERING;
+    }
+    else if (action == CAN_REC_START)
+    {
+        state_ = CAN_REC_RUNNING;
+        errorPassive_ = false;
+        recoveredOnce_ = true;
+        recoveredUs_ = nowUs;
+        stats_.recoveries++;
+        stats_.recovery.record((uint32_t)(nowUs - downSinceUs_));
+    }
+}
+
+uint32_t CanBusOffRecovery::waitUs(uint64_t nowUs) const
+{
+    if (state_ != CAN_REC_BACKOFF && state_ != CAN_REC_RESTART)
+        return UINT32_MAX;
+    return nowUs >= actionAtUs_ ? 0 : (uint32_t)(actionAtUs_ - nowUs);
+}
@@ -0,0 +1,312 @@
+#include "../../include/drivers/can_bus_stats.h"
+#include "../../include/drivers/can_twai_driver.h"
+#include "../../include/drivers/can_mcp2515_driver.h"
+#include "../../include/config/hardware.h"
+#include "../../include/header.h"
+#include <string.h>
+
+static const uint32_t BUS_BITRATE[CAN_BUS_COUNT] = {CAN1_BAUDRATE, CAN2_BAUDRATE};
+static const uint32_t WINDOW_US = CAN_STATS_WINDOW_MS * 1000UL;
+
+struct IdSlot
+{
+    uint32_t id;
+    bool extended;
+    bool tx;
+    uint32_t frames;
+    uint32_t lastUs;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t sumUs;
+    uint32_t intervals;
+    uint16_t hist[CAN_STATS_HIST_BUCKETS];
+};
+
+struct BusState
+{
+    uint32_t rxFrames;
+    uint32_t txFrames;
+    uint64_t bits;
+    bool windowOpen;
+    uint32_t windowStartUs;
+    uint32_t windowFrames;
+    uint32_t windowBits;
+    float framesPerSec;
+    float bitsPerSec;
+    float loadPercent;
+    float peakLoadPercent;
+    uint32_t untracked;
+    uint8_t idCount;
+    IdSlot ids[CAN_STATS_MAX_IDS];
+};
+
+// Written by the dispatcher (RX) and the TX paths, read by console / OCPP
+static BusState buses[CAN_BUS_COUNT];
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// --- Jitter histogram: bucket 0 < 16 us, then 4 linear sub-buckets per octave ---
+static uint8_t histBucket(uint32_t us)
+{
+    if (us < 16)
+        return 0;
+    const uint8_t octave = 31 - __builtin_clz(us);
+    if (octave >= 24)
+        return CAN_STATS_HIST_BUCKETS - 1;
+    const uint8_t sub = (us >> (octave - 2)) & 3;
+    return 1 + (octave - 4) * 4 + sub;
+}
+
+static uint32_t histUpperUs(uint8_t bucket)
+{
+    if (bucket == 0)
+        return 16;
+    const uint8_t octave = 4 + (bucket - 1) / 4;
+    const uint8_t sub = (bucket - 1) % 4;
+    return (uint32_t)(5 + sub) << (octave - 2);
+}
+
+static void rollWindow(CanBus bus, BusState &b, uint32_t nowUs)
+{
+    if (!b.windowOpen)
+    {
+        b.windowOpen = true;
+        b.windowStartUs = nowUs;
+        return;
+    }
+    const int32_t elapsed = (int32_t)(nowUs - b.windowStartUs);
+    if (elapsed < (int32_t)WINDOW_US)
+        return;
+
+    // A window that spans silence is averaged over its full length
+    b.framesPerSec = b.windowFrames * 1e6f / elapsed;
+    b.bitsPerSec = b.windowBits * 1e6f / elapsed;
+    b.loadPercent = b.bitsPerSec * 100.0f / BUS_BITRATE[bus];
+    if (b.loadPercent > b.peakLoadPercent)
+        b.peakLoadPercent = b.loadPercent;
+    b.windowFrames = 0;
+    b.windowBits = 0;
+    b.windowStartUs = nowUs;
+}
+
+static IdSlot *findSlot(BusState &b, uint32_t id, bool extended, bool tx)
+{
+    for (uint8_t i = 0; i < b.idCount; i++)
+    {
+        IdSlot &s = b.ids[i];
+        if (s.id == id && s.extended == extended && s.tx == tx)
+            return &s;
+    }
+    if (b.idCount >= CAN_STATS_MAX_IDS)
+        return nullptr;
+
+    IdSlot &s = b.ids[b.idCount++];
+    memset(&s, 0, sizeof(s));
+    s.id = id;
+    s.extended = extended;
+    s.tx = tx;
+    return &s;
+}
+
+static void record(CanBus bus, uint32_t id, uint8_t dlc, bool extended, bool tx, uint32_t t_us)
+{
+    if (bus >= CAN_BUS_COUNT)
+        return;
+    const uint32_t bits = canFrameBits(dlc > 8 ? 8 : dlc, extended);
+
+    portENTER_CRITICAL(&statsMux);
+    BusState &b = buses[bus];
+    rollWindow(bus, b, t_us);
+    if (tx)
+        b.txFrames++;
+    else
+        b.rxFrames++;
+    b.bits += bits;
+    b.windowFrames++;
+    b.windowBits += bits;
+
+    IdSlot *s = findSlot(b, id, extended, tx);
+    if (s == nullptr)
+    {
+        b.untracked++;
+    }
+    else
+    {
+        if (s->frames > 0)
+        {
+            const uint32_t dt = t_us - s->lastUs;
+            if (s->intervals == 0 || dt < s->minUs)
+                s->minUs = dt;
+            if (dt > s->maxUs)
+                s->maxUs = dt;
+
+            if (s->intervals > 0)
+            {
+                const uint32_t mean = (uint32_t)(s->sumUs / s->intervals);
+                uint16_t &h = s->hist[histBucket(dt > mean ? dt - mean : mean - dt)];
+                if (h == 0xFFFF)
+                {
+                    // Halve the whole histogram: keeps the shape, bounds the counters
+                    for (uint8_t k = 0; k < CAN_STATS_HIST_BUCKETS; k++)
+                        s->hist[k] >>= 1;
+                }
+                h++;
+            }
+            s->sumUs += dt;
+            s->intervals++;
+        }
+        s->frames++;
+        s->lastUs = t_us;
+    }
+    portEXIT_CRITICAL(&statsMux);
+}
+
+static uint32_t jitterP99(const IdSlot &s)
+{
+    uint32_t total = 0;
+    for (uint8_t k = 0; k < CAN_STATS_HIST_BUCKETS; k++)
+        total += s.hist[k];
+    if (total == 0)
+        return 0;
+
+    const uint32_t target = total - total / 100; // ceil(0.99 * total) within one sample
+    uint32_t seen = 0;
+    for (uint8_t k = 0; k < CAN_STATS_HIST_BUCKETS - 1; k++)
+    {
+        seen += s.hist[k];
+        if (seen >= target)
+            return histUpperUs(k);
+    }
+    return s.maxUs - s.minUs;
+}
+
+namespace CAN_STATS
+{
+    void onRx(CanBus bus, uint32_t id, uint8_t dlc, bool extended, uint32_t t_us)
+    {
+        record(bus, id, dlc, extended, false, t_us);
+    }
+
+    void onTx(CanBus bus, uint32_t id, uint8_t dlc, bool extended)
+    {
+        record(bus, id, dlc, extended, true, micros());
+    }
+
+    void snapshot(CanBus bus, CanBusStats &out)
+    {
+        memset(&out, 0, sizeof(out));
+        if (bus >= CAN_BUS_COUNT)
+            return;
+
+        portENTER_CRITICAL(&statsMux);
+        BusState &b = buses[bus];
+        rollWindow(bus, b, micros()); // close a window the bus went silent in
+        out.rxFrames = b.rxFrames;
+        out.txFrames = b.txFrames;
+        out.bits = b.bits;
+        out.framesPerSec = b.framesPerSec;
+        out.bitsPerSec = b.bitsPerSec;
+        out.loadPercent = b.loadPercent;
+        out.peakLoadPercent = b.peakLoadPercent;
+        out.untracked = b.untracked;
+        out.idCount = b.idCount;
+        for (uint8_t i = 0; i < b.idCount; i++)
+        {
+            const IdSlot &s = b.ids[i];
+            CanIdStats &d = out.ids[i];
+            d.id = s.id;
+            d.extended = s.extended;
+            d.tx = s.tx;
+            d.frames = s.frames;
+            d.minUs = s.minUs;
+            d.maxUs = s.maxUs;
+            d.meanUs = s.intervals ? (uint32_t)(s.sumUs / s.intervals) : 0;
+            d.jitterP99Us = jitterP99(s);
+            d.p99Us = d.meanUs + d.jitterP99Us < d.maxUs ? d.meanUs + d.jitterP99Us : d.maxUs;
+        }
+        portEXIT_CRITICAL(&statsMux);
+
+        if (bus == CAN_BUS_CHARGER)
+        {
+            const CanTwaiStatus st = CAN_TWAI::getStatus();
+            out.ringDrops = st.rx_overflows;
+            out.rejected = st.rx_rejected;
+            twai_status_info_t info;
+            if (twai_get_status_info(&info) == ESP_OK)
+                out.controllerMissed = info.rx_missed_count + info.rx_overrun_count;
+        }
+        else
+        {
+            const CanMcp2515Status st = CAN_MCP2515::getStatus();
+            out.ringDrops = st.rx_overflows;
+            out.rx0Overruns = st.rx0_overruns;
+            out.rx1Overruns = st.rx1_overruns;
+            out.controllerMissed = st.rx0_overruns + st.rx1_overruns;
+        }
+    }
+
+    void busLoad(CanBus bus, float &loadPercent, float &peakPercent)
+    {
+        loadPercent = peakPercent = 0.0f;
+        if (bus >= CAN_BUS_COUNT)
+            return;
+        portENTER_CRITICAL(&statsMux);
+        rollWindow(bus, buses[bus], micros());
+        loadPercent = buses[bus].loadPercent;
+        peakPercent = buses[bus].peakLoadPercent;
+        portEXIT_CRITICAL(&statsMux);
+    }
+
+    void reset()
+    {
+        portENTER_CRITICAL(&statsMux);
+        memset(buses, 0, sizeof(buses));
+        portEXIT_CRITICAL(&statsMux);
+    }
+
+    void print()
+    {
+        static const char *BUS_NAMES[CAN_BUS_COUNT] = {"CAN1 (Charger)", "CAN2 (BMS)"};
+        static CanBusStats s;
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        Serial.println("\n=============== CAN BUS STATISTICS ===============");
+        for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++)
+        {
+            snapshot((CanBus)bus, s);
+            Serial.printf("%s @ %u kbit/s: %.1f frames/s %.0f bit/s load %.2f%% (peak %.2f%%)\n",
+                          BUS_NAMES[bus], BUS_BITRATE[bus] / 1000, s.framesPerSec, s.bitsPerSec,
+                          s.loadPercent, s.peakLoadPercent);
+            Serial.printf("  rx=%u tx=%u ring drops=%u controller missed=%u", s.rxFrames, s.txFrames,
+                          s.ringDrops, s.controllerMissed);
+            if (bus == CAN_BUS_BMS)
+                Serial.printf(" (RX0OVR=%u RX1OVR=%u)", s.rx0Overruns, s.rx1Overruns);
+            else
+                Serial.printf(" rejected=%u", s.rejected);
+            Serial.printf(" untracked=%u\n", s.untracked);
+            if (bus == CAN_BUS_BMS)
+            {
+                const CanMcp2515Status st = CAN_MCP2515::getStatus();
+                Serial.printf("  TXB2 mailbox: sends=%u loads=%u aborts=%u SPI %.2f ms, saved %.2f ms (%.2f ms/min)\n",
+                              st.mailbox_sends, st.mailbox_loads, st.mailbox_aborts, st.mailbox_spi_us / 1000.0f,
+                              st.mailbox_saved_us / 1000.0f, st.mailbox_saved_us_per_min / 1000.0f);
+            }
+            Serial.println("  id          dir frames    min ms  mean ms   p99 ms   max ms  jitter p99 ms");
+            for (uint8_t i = 0; i < s.idCount; i++)
+            {
+                const CanIdStats &d = s.ids[i];
+                Serial.printf(d.extended ? "  0x%08X  %s %7u" : "  0x%03X       %s %7u", d.id, d.tx ? "tx" : "rx", d.frames);
+                if (d.frames > 1)
+                    Serial.printf(" %8.1f %8.1f %8.1f %8.1f %8.2f\n", d.minUs / 1000.0f, d.meanUs / 1000.0f,
+                                  d.p99Us / 1000.0f, d.maxUs / 1000.0f, d.jitterP99Us / 1000.0f);
+                else
+                    Serial.println();
+            }
+        }
+        Serial.println("==================================================\n");
+
+        xSemaphoreGive(serialMutex);
+    }
+
+} // namespace CAN_STATS
@@ -0,0 +1,169 @@
+#include "../../include/drivers/can_dispatcher.h"
+#include "../../include/drivers/can_bus_stats.h"
+#include "../../include/drivers/can_twai_driver.h"
+#include "../../include/drivers/can_mcp2515_driver.h"
+#include "../../include/header.h"
+#include "../../include/config/timing.h"
+#include "../../include/core/perf_trace.h"
+#include <esp_timer.h>
+
+// Dispatcher task handle (set when the task starts)
+static TaskHandle_t dispatchTaskHandle = nullptr;
+
+// Bucket upper bounds in microseconds (last bucket catches everything above)
+static const uint32_t LATENCY_EDGES_US[CAN_LATENCY_BUCKETS - 1] = {
+    50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000};
+
+static CanLatencyStats latencyStats[CAN_BUS_COUNT];
+
+static void recordLatency(CanBus bus, uint64_t rx_us)
+{
+    const uint64_t now = (uint64_t)esp_timer_get_time();
+    const uint32_t latency = now > rx_us ? (uint32_t)(now - rx_us) : 0;
+    CanLatencyStats &s = latencyStats[bus];
+
+    uint8_t b = 0;
+    while (b < CAN_LATENCY_BUCKETS - 1 && latency > LATENCY_EDGES_US[b])
+        b++;
+    s.buckets[b]++;
+
+    if (s.samples == 0 || latency < s.min_us)
+        s.min_us = latency;
+    if (latency > s.max_us)
+        s.max_us = latency;
+    s.total_us += latency;
+    s.samples++;
+}
+
+// Route a BMS bus frame to its decoder
+static void dispatchBmsFrame(const CanMessage &msg)
+{
+    PERF_TRACE_SCOPE(PERF_BMS_RX);
+    const uint32_t id = msg.id & 0x1FFFFFFFUL;
+
+    if (id == (ID_BMS_REQUEST & 0x1FFFFFFFUL))
+    {
+        handleBMSMessage(msg);
+    }
+    else if (id == (ID_CHARGE_AH_RESPONSE & 0x1FFFFFFFUL))
+    {
+        handleChargingAhMessage(msg);
+    }
+    else if (id == (ID_DISCHARGE_AH_RESPONSE & 0x1FFFFFFFUL))
+    {
+        handleDischargingAhMessage(msg);
+    }
+    else if (id == (ID_SOC_RESPONSE & 0x1FFFFFFFUL))
+    {
+        handleSOCMessage(msg);
+    }
+}
+
+namespace CAN_DISPATCH
+{
+    void notify()
+    {
+        if (dispatchTaskHandle)
+            xTaskNotifyGive(dispatchTaskHandle);
+    }
+
+    void notifyFromISR(BaseType_t *woken)
+    {
+        if (dispatchTaskHandle)
+            vTaskNotifyGiveFromISR(dispatchTaskHandle, woken);
+    }
+
+    void dispatchFrame(CanBus bus, const CanMessage &frame)
+    {
+        CAN_STATS::onRx(bus, frame.id, frame.dlc, frame.extended, (uint32_t)frame.timestamp_us);
+
+        if (bus == CAN_BUS_CHARGER)
+            handleChargerMessage(frame);
+        else
+            dispatchBmsFrame(frame);
+    }
+
+    CanLatencyStats getLatencyStats(CanBus bus)
+    {
+        return latencyStats[bus < CAN_BUS_COUNT ? bus : CAN_BUS_CHARGER];
+    }
+
+    void resetLatencyStats()
+    {
+        memset(latencyStats, 0, sizeof(latencyStats));
+    }
+
+    void printLatencyHistogram()
+    {
+        static const char *BUS_NAMES[CAN_BUS_COUNT] = {"CAN1 (Charger)", "CAN2 (BMS)"};
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        Serial.println("\n========= CAN RX → DECODE LATENCY =========");
+        for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++)
+        {
+            const CanLatencyStats s = latencyStats[bus];
+            Serial.printf("%s: samples=%u", BUS_NAMES[bus], s.samples);
+            if (s.samples == 0)
+            {
+                Serial.println();
+                continue;
+            }
+            Serial.printf(" min=%uus avg=%uus max=%uus\n",
+                          s.min_us, (uint32_t)(s.total_us / s.samples), s.max_us);
+
+            uint32_t lower = 0;
+            for (uint8_t b = 0; b < CAN_LATENCY_BUCKETS - 1; b++)
+            {
+                Serial.printf("  %6u-%-6uus : %u\n", lower, LATENCY_EDGES_US[b], s.buckets[b]);
+                lower = LATENCY_EDGES_US[b];
+            }
+            Serial.printf("  >%-12uus : %u\n", lower, s.buckets[CAN_LATENCY_BUCKETS - 1]);
+        }
+        Serial.println("===========================================\n");
+
+        xSemaphoreGive(serialMutex);
+    }
+
+} // namespace CAN_DISPATCH
+
+// --- Dispatcher task ---
+void canDispatchTask(void *arg)
+{
+    dispatchTaskHandle = xTaskGetCurrentTaskHandle();
+    Serial.println("[CAN] Dispatcher task started");
+
+    // Drain a burst at a time so the RX tasks get ring space back while a
+    // long backlog is worked off; the decoders read the burst array
+    static const size_t BURST = 8;
+    CanMessage frames[BURST];
+
+    while (true)
+    {
+        // Block until an RX task pushes a frame; the timeout only guards
+        // against a lost notification leaving frames stranded in a ring
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CAN_DISPATCH_IDLE_TIMEOUT_MS));
+
+        // CAN1 (Charger messages)
+        size_t n;
+        while ((n = CAN_TWAI::receiveMessages(frames, BURST)) > 0)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                CAN_DISPATCH::dispatchFrame(CAN_BUS_CHARGER, frames[i]);
+                recordLatency(CAN_BUS_CHARGER, frames[i].timestamp_us);
+            }
+        }
+
+        // CAN2 (BMS messages)
+        while ((n = CAN_MCP2515::receiveMessages(frames, BURST)) > 0)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                CAN_DISPATCH::dispatchFrame(CAN_BUS_BMS, frames[i]);
+                recordLatency(CAN_BUS_BMS, frames[i].timestamp_us);
+            }
+        }
+    }
+}
@@ -1,5 +1,6 @@
 #include "../../include/drivers/can_driver.h"
 #include "../../include/header.h"
+#include "../../include/core/spsc_ring.h"
 
 // New CAN driver buffer item (different from legacy RxBufItem)
 struct CanRxItem
@@ -10,48 +11,12 @@ struct CanRxItem
 
 // Ring buffer for received messages
 #define RX_BUFFER_SIZE 64
-static CanRxItem rxBuffer[RX_BUFFER_SIZE];
-static volatile uint16_t rxHead = 0;
-static volatile uint16_t rxTail = 0;
-
-// Legacy ring buffer for backward compatibility
-static RxBufItem legacyRxBuffer[64];
-static volatile uint16_t legacyRxHead = 0;
-static volatile uint16_t legacyRxTail = 0;
+static SpscRing<CanRxItem, RX_BUFFER_SIZE> rxRing;
 
 // Driver status
 static CanStatus driverStatus = {false, false, 0, 0, 0, 0};
 static SemaphoreHandle_t canRecoveryMutex = nullptr;
 
-// Legacy functions for backward compatibility
-void pushFrame(const twai_message_t &msg)
-{
-    RxBufItem item;
-    item.id = msg.identifier;
-    item.dlc = msg.data_length_code;
-    memcpy(item.data, msg.data, 8);
-    item.ext = msg.extd;
-    item.rtr = msg.rtr;
-
-    legacyRxBuffer[legacyRxHead] = item;
-    legacyRxHead = (legacyRxHead + 1) % 64;
-
-    if (legacyRxHead == legacyRxTail)
-    {
-        legacyRxTail = (legacyRxTail + 1) % 64;
-    }
-}
-
-bool popFrame(RxBufItem &out)
-{
-    if (legacyRxHead == legacyRxTail)
-        return false;
-
-    out = legacyRxBuffer[legacyRxTail];
-    legacyRxTail = (legacyRxTail + 1) % 64;
-    return true;
-}
-
 // Legacy twai_init function
 void twai_init()
 {
@@ -135,23 +100,22 @@ namespace CAN
 
     bool receiveMessage(twai_message_t *frame, uint32_t *timestamp_ms)
     {
-        if (rxHead == rxTail)
+        CanRxItem item;
+        if (!rxRing.pop(item))
             return false;
 
-        CanRxItem &item = rxBuffer[rxTail];
         *frame = item.frame;
         if (timestamp_ms)
             *timestamp_ms = item.timestamp_ms;
-
-        rxTail = (rxTail + 1) % RX_BUFFER_SIZE;
         return true;
     }
 
     bool peekMessage(twai_message_t *frame)
     {
-        if (rxHead == rxTail)
+        CanRxItem item;
+        if (!rxRing.peek(item))
             return false;
-        *frame = rxBuffer[rxTail].frame;
+        *frame = item.frame;
         return true;
     }
 
@@ -162,13 +126,12 @@ namespace CAN
 
     void flushRxBuffer()
     {
-        rxHead = rxTail = 0;
+        rxRing.clear();
     }
 
     uint8_t getRxBufferUsage()
     {
-        uint16_t count = (rxHead >= rxTail) ? (rxHead - rxTail) : (RX_BUFFER_SIZE - rxTail + rxHead);
-        return (count * 100) / RX_BUFFER_SIZE;
+        return rxRing.usagePercent();
     }
 
     void resetStatistics()
@@ -196,25 +159,19 @@ void can_rx_task(void *arg)
                 esp_err_t err = twai_receive(&msg, pdMS_TO_TICKS(100));
                 if (err == ESP_OK)
                 {
-                    // FIX: Check buffer overflow before writing
-                    uint16_t nextHead = (rxHead + 1) % RX_BUFFER_SIZE;
-                    if (nextHead != rxTail)
+                    CanRxItem item;
+                    item.frame = msg;
+                    item.timestamp_ms = millis();
+                    if (rxRing.push(item))
                     {
-                        rxBuffer[rxHead].frame = msg;
-                        rxBuffer[rxHead].timestamp_ms = millis();
-                        rxHead = nextHead;
                         driverStatus.total_rx_messages++;
-                        driverStatus.last_activity_ms = millis();
+                        driverStatus.last_activity_ms = item.timestamp_ms;
                     }
                     else
                     {
-                        // Buffer full - drop oldest message
-                        rxTail = (rxTail + 1) % RX_BUFFER_SIZE;
+                        // Buffer full - frame dropped (counted by the ring)
                         driverStatus.error_count++;
                     }
-                    
-                    // Also push to legacy buffer for compatibility
-                    pushFrame(msg);
                 }
             }
             xSemaphoreGive(canRecoveryMutex);
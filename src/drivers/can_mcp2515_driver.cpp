@@ -1,28 +1,467 @@
 #include "../../include/drivers/can_mcp2515_driver.h"
 #include "../../include/header.h"
 #include "../../include/config/hardware.h"
+#include "../../include/config/timing.h"
+#include "../../include/drivers/can_dispatcher.h"
+#include "../../include/drivers/can_bus_stats.h"
+#include "../../include/drivers/can_trace.h"
+#include "../../include/core/spsc_ring.h"
 #include <SPI.h>
+#include <esp_timer.h>
 
 // MCP2515 instance
 static MCP2515 *mcp2515 = nullptr;
 
 // Ring buffer for received messages
 #define MCP2515_RX_BUFFER_SIZE 64
-static CanMessage rxBuffer[MCP2515_RX_BUFFER_SIZE];
-static volatile uint16_t rxHead = 0;
-static volatile uint16_t rxTail = 0;
+static SpscRing<CanMessage, MCP2515_RX_BUFFER_SIZE> rxRing;
 
 // Driver status
-static CanMcp2515Status driverStatus = {false, false, 0, 0, 0, 0};
+static CanMcp2515Status driverStatus = {};
 static SemaphoreHandle_t mcp2515RecoveryMutex = nullptr;
+static uint32_t lastEflgCheckMs = 0;
+
+// Frames drained per pass at most; the RX task comes straight back while INT is low
+#define MCP2515_DRAIN_MAX_FRAMES 16
+
+// esp_timer_get_time() of the INT falling edge not yet given to a frame
+// (0 = none). The edge marks the arrival of the first frame after INT was
+// released, so that frame is stamped with it instead of the later SPI read.
+static int64_t intEdgeUs = 0;
+static portMUX_TYPE intEdgeMux = portMUX_INITIALIZER_UNLOCKED;
+
+// ========== RAW SPI INSTRUCTIONS ==========
+// The library reads a frame with READ STATUS + four register transfers.
+// READ RX BUFFER streams SIDH..D7 in one transaction and releases the
+// buffer (clears RXnIF) when CS rises, so a drain pass costs one READ
+// STATUS plus one transaction per frame.
+#define MCP_INSTR_WRITE 0x02
+#define MCP_INSTR_BIT_MODIFY 0x05
+#define MCP_INSTR_READ_RX0 0x90 // READ RX BUFFER, RXB0 from SIDH
+#define MCP_INSTR_READ_RX1 0x94 // READ RX BUFFER, RXB1 from SIDH
+#define MCP_INSTR_READ_STATUS 0xA0
+#define MCP_INSTR_LOAD_TX2_D0 0x45 // LOAD TX BUFFER, TXB2 from D0
+#define MCP_INSTR_RTS_TX2 0x84
+#define MCP_REG_CANINTE 0x2B
+#define MCP_REG_CANINTF 0x2C
+#define MCP_REG_TXB2CTRL 0x50
+#define MCP_REG_TXB2SIDH 0x51
+#define MCP_REG_TXB2D0 0x56
+#define MCP_REG_RXB0CTRL 0x60
+#define MCP_RXB0CTRL_BUKT 0x04
+#define MCP_TXBCTRL_TXREQ 0x08
+#define MCP_STATUS_RX0IF 0x01
+#define MCP_STATUS_RX1IF 0x02
+#define MCP_STATUS_TX0REQ 0x04
+#define MCP_STATUS_TX1REQ 0x10
+#define MCP_STATUS_TX2REQ 0x40
+#define MCP_SIDL_IDE 0x08
+
+#define MCP_SPI_CLOCK_HZ 10000000
+static const SPISettings mcpSpiSettings(MCP_SPI_CLOCK_HZ, MSBFIRST, SPI_MODE0);
+
+// ========== TXB2 MAILBOX ==========
+// TXB2 is reserved for one periodic frame. The owner only updates a RAM
+// copy of the payload; the CAN2 task loads the bytes that changed since
+// the last load and issues RTS when the frame is due. An unchanged payload
+// costs a one-byte RTS instead of the library's four transactions (free
+// buffer check, load, request, read-back). Other frames use TXB0/TXB1.
+struct Mailbox
+{
+    bool enabled;
+    bool reconfigured; // id / DLC changed: TXB2 header must be reloaded
+    uint32_t id;
+    bool extended;
+    uint8_t dlc;
+    uint32_t periodMs;
+    uint8_t payload[8]; // latest from the owner
+};
+static Mailbox mailbox = {};
+static portMUX_TYPE mailboxMux = portMUX_INITIALIZER_UNLOCKED;
+
+// CAN2 task only
+static uint8_t txb2Data[8];       // payload TXB2 holds
+static bool txb2HeaderValid = false;
+static uint32_t mailboxDueMs = 0;
+static uint64_t mailboxSpiNs = 0;   // SPI time the mailbox used
+static uint64_t mailboxSavedNs = 0; // vs a library sendMessage() per period
+static uint32_t mailboxSinceMs = 0;
+
+// SPI time for the diagnostics: bytes at the SPI clock plus chip-select /
+// transaction setup
+#define MCP_SPI_TXN_OVERHEAD_NS 2000
+#define MCP_SPI_BYTE_NS (8000000000ULL / MCP_SPI_CLOCK_HZ)
+// Library sendMessage(): TXBnCTRL read, SIDH..Dn load, TXREQ modify, read-back
+#define MCP_LIB_SEND_TXNS 4
+#define MCP_LIB_SEND_BYTES(dlc) (3 + 2 + 5 + (dlc) + 4 + 3)
+
+static inline uint32_t mcpSpiNs(uint32_t transactions, uint32_t bytes)
+{
+    return transactions * MCP_SPI_TXN_OVERHEAD_NS + bytes * MCP_SPI_BYTE_NS;
+}
+
+static inline void mcpSelect()
+{
+    SPI.beginTransaction(mcpSpiSettings);
+    digitalWrite(CAN2_CS_PIN, LOW);
+}
+
+static inline void mcpDeselect()
+{
+    digitalWrite(CAN2_CS_PIN, HIGH);
+    SPI.endTransaction();
+}
+
+static void mcpWriteRegister(uint8_t reg, uint8_t value)
+{
+    const uint8_t cmd[3] = {MCP_INSTR_WRITE, reg, value};
+    mcpSelect();
+    SPI.writeBytes(cmd, sizeof(cmd));
+    mcpDeselect();
+}
+
+static void mcpBitModify(uint8_t reg, uint8_t mask, uint8_t value)
+{
+    const uint8_t cmd[4] = {MCP_INSTR_BIT_MODIFY, reg, mask, value};
+    mcpSelect();
+    SPI.writeBytes(cmd, sizeof(cmd));
+    mcpDeselect();
+}
+
+static uint8_t mcpReadStatus()
+{
+    mcpSelect();
+    SPI.transfer(MCP_INSTR_READ_STATUS);
+    const uint8_t status = SPI.transfer(0xFF);
+    mcpDeselect();
+    return status;
+}
+
+// WRITE (or LOAD TX BUFFER when starting at D0) of consecutive registers
+static void mcpWriteTxb2(uint8_t reg, const uint8_t *data, uint8_t len)
+{
+    mcpSelect();
+    if (reg == MCP_REG_TXB2D0)
+    {
+        SPI.transfer(MCP_INSTR_LOAD_TX2_D0);
+    }
+    else
+    {
+        SPI.transfer(MCP_INSTR_WRITE);
+        SPI.transfer(reg);
+    }
+    SPI.writeBytes(data, len);
+    mcpDeselect();
+}
+
+static void mcpRequestTxb2()
+{
+    mcpSelect();
+    SPI.transfer(MCP_INSTR_RTS_TX2);
+    mcpDeselect();
+}
+
+static void mcpReadRxBuffer(uint8_t instruction, CanMessage &rx)
+{
+    uint8_t buf[13]; // SIDH, SIDL, EID8, EID0, DLC, D0..D7
+    mcpSelect();
+    SPI.transfer(instruction);
+    SPI.transferBytes(nullptr, buf, sizeof(buf));
+    mcpDeselect();
+
+    uint32_t id = ((uint32_t)buf[0] << 3) | (buf[1] >> 5);
+    rx.extended = (buf[1] & MCP_SIDL_IDE) != 0;
+    if (rx.extended)
+        id = (id << 18) | ((uint32_t)(buf[1] & 0x03) << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+    rx.id = id;
+    rx.dlc = buf[4] & 0x0F;
+    if (rx.dlc > 8)
+        rx.dlc = 8;
+    memcpy(rx.data, &buf[5], 8);
+}
+
+// RX time for the next frame read: the pending INT edge, else now (frames
+// that arrived while INT was already low have no edge of their own)
+static uint64_t takeRxTime()
+{
+    portENTER_CRITICAL(&intEdgeMux);
+    const int64_t edge = intEdgeUs;
+    intEdgeUs = 0;
+    portEXIT_CRITICAL(&intEdgeMux);
+    return (uint64_t)(edge ? edge : esp_timer_get_time());
+}
+
+static void pushFrame(CanMessage &rx)
+{
+    rx.timestamp_us = takeRxTime();
+    CAN_TRACE::record(CAN_BUS_BMS, rx);
+
+    if (rxRing.push(rx))
+    {
+        driverStatus.total_rx_messages++;
+        driverStatus.last_activity_ms = millis();
+    }
+    else
+    {
+        // Buffer full - frame dropped (counted by the ring)
+        driverStatus.error_count++;
+    }
+}
+
+// Read both buffers until INT deasserts; bothFull = an overrun was possible,
+// errorInt = INT held low with both buffers empty (ERRIF: EFLG changed)
+static uint8_t drainRxBuffers(bool &bothFull, bool &errorInt)
+{
+    uint8_t frames = 0;
+    bothFull = false;
+    errorInt = false;
+    do
+    {
+        const uint8_t status = mcpReadStatus() & (MCP_STATUS_RX0IF | MCP_STATUS_RX1IF);
+        if (status == 0)
+        {
+            errorInt = digitalRead(CAN2_INT_PIN) == LOW;
+            if (errorInt)
+                takeRxTime(); // the edge was ERRIF, not a frame
+            break;
+        }
+        if (status == (MCP_STATUS_RX0IF | MCP_STATUS_RX1IF))
+            bothFull = true;
+
+        // RXB0 first: with rollover it holds the older frame
+        CanMessage rx;
+        if (status & MCP_STATUS_RX0IF)
+        {
+            mcpReadRxBuffer(MCP_INSTR_READ_RX0, rx);
+            pushFrame(rx);
+            frames++;
+        }
+        if (status & MCP_STATUS_RX1IF)
+        {
+            mcpReadRxBuffer(MCP_INSTR_READ_RX1, rx);
+            pushFrame(rx);
+            frames++;
+        }
+    } while (digitalRead(CAN2_INT_PIN) == LOW && frames < MCP2515_DRAIN_MAX_FRAMES);
+
+    if (frames > 0)
+        CAN_DISPATCH::notify(); // Wake dispatcher immediately
+    return frames;
+}
+
+// Bitrate, filters, masks, rollover and interrupt enables, then normal mode
+// (init(), or the CAN2 task with the recovery mutex held)
+static bool configureChip()
+{
+    takeRxTime(); // drop an INT edge from before the reconfiguration
+
+    // CRITICAL: Don't use reset() - it clears filters
+    // Manual initialization instead
+    MCP2515::ERROR result = mcp2515->setConfigMode();
+    if (result != MCP2515::ERROR_OK)
+    {
+        Serial.printf("[CAN2] ❌ Config mode failed: %d\n", result);
+        return false;
+    }
+
+    // Set bitrate (CRITICAL: 8MHz crystal)
+    result = mcp2515->setBitrate(CAN_250KBPS, MCP_8MHZ);
+    if (result != MCP2515::ERROR_OK)
+    {
+        Serial.printf("[CAN2] ❌ Bitrate config failed: %d (check 8MHz crystal)\n", result);
+        return false;
+    }
+
+    // CRITICAL: Configure hardware filters for BMS IDs only
+    // RXF0 (RXB0): 0x1806E5F4 - BMS Request (Vmax, Imax)
+    result = mcp2515->setFilter(MCP2515::RXF0, true, 0x1806E5F4UL);
+    if (result != MCP2515::ERROR_OK)
+    {
+        Serial.printf("[CAN2] ❌ Filter RXF0 failed: %d\n", result);
+        return false;
+    }
+
+    // RXF1 (RXB1): 0x160B8001 - Charging Ah Response
+    result = mcp2515->setFilter(MCP2515::RXF1, true, 0x160B8001UL);
+    if (result != MCP2515::ERROR_OK)
+    {
+        Serial.printf("[CAN2] ❌ Filter RXF1 failed: %d\n", result);
+        return false;
+    }
+
+    // RXF2 (RXB0): 0x160D8001 - Discharging Ah Response
+    result = mcp2515->setFilter(MCP2515::RXF2, true, 0x160D8001UL);
+    if (result != MCP2515::ERROR_OK)
+    {
+        Serial.printf("[CAN2] ❌ Filter RXF2 failed: %d\n", result);
+        return false;
+    }
+
+    // RXF3-5: Unused, set to impossible ID
+    mcp2515->setFilter(MCP2515::RXF3, true, 0x1FFFFFFFUL);
+    mcp2515->setFilter(MCP2515::RXF4, true, 0x1FFFFFFFUL);
+    mcp2515->setFilter(MCP2515::RXF5, true, 0x1FFFFFFFUL);
+
+    // Set masks to match exact IDs (all bits must match)
+    result = mcp2515->setFilterMask(MCP2515::MASK0, true, 0x1FFFFFFFUL);
+    if (result != MCP2515::ERROR_OK)
+    {
+        Serial.printf("[CAN2] ❌ Mask0 failed: %d\n", result);
+        return false;
+    }
+
+    result = mcp2515->setFilterMask(MCP2515::MASK1, true, 0x1FFFFFFFUL);
+    if (result != MCP2515::ERROR_OK)
+    {
+        Serial.printf("[CAN2] ❌ Mask1 failed: %d\n", result);
+        return false;
+    }
+
+    Serial.println("[CAN2] ✅ Hardware filters configured (3 BMS IDs only)");
+
+    // reset() is skipped, so CANINTE and BUKT are not set by the library:
+    // let RXB0 roll over into RXB1 and drive INT from both RX buffers
+    mcpBitModify(MCP_REG_RXB0CTRL, MCP_RXB0CTRL_BUKT, MCP_RXB0CTRL_BUKT);
+    // ERRIF (EFLG changed) wakes the task for bus-off / error-passive; a stale
+    // one would hold INT low without the falling edge the ISR waits for
+    mcpBitModify(MCP_REG_CANINTF, MCP2515::CANINTF_ERRIF | MCP2515::CANINTF_MERRF, 0);
+    mcpWriteRegister(MCP_REG_CANINTE,
+                     MCP2515::CANINTF_RX0IF | MCP2515::CANINTF_RX1IF | MCP2515::CANINTF_ERRIF);
+
+    // Set normal mode
+    result = mcp2515->setNormalMode();
+    if (result != MCP2515::ERROR_OK)
+    {
+        Serial.printf("[CAN2] ❌ Normal mode failed: %d (check wiring)\n", result);
+        return false;
+    }
+
+    return true;
+}
+
+// ========== ERROR RECOVERY ==========
+// Graded, cheapest first (CAN2 task, recovery mutex held). Error-passive
+// still receives and transmits: ERRIF is cleared and the time until the
+// counters drop below the warning limit (error-active, EWARN clear) is
+// recorded, so a noisy bus flapping around 128 is one episode. Bus-off toggles configuration mode, which
+// clears TEC / REC and keeps bitrate, filters, masks and TXB2. Bitrate,
+// filters and masks are only reprogrammed when the toggle does not bring the
+// controller back or bus-off keeps coming back.
+static CanMcp2515RecoveryStats recoveryStats = {};
+static portMUX_TYPE recoveryMux = portMUX_INITIALIZER_UNLOCKED;
+
+// CAN2 task only
+static bool errorPassive = false;
+static uint32_t passiveSinceUs = 0;
+static bool reinitPending = false; // last reconfiguration failed: retry on the EFLG poll
+static uint32_t busOffWindowStartMs = 0;
+static uint8_t busOffsInWindow = 0;
+
+#define MCP2515_ERROR_STATE_FLAGS (MCP2515::EFLG_TXBO | MCP2515::EFLG_TXEP | MCP2515::EFLG_RXEP)
+
+static void recordRecovery(Mcp2515RecoveryPath path, bool ok, uint32_t us)
+{
+    portENTER_CRITICAL(&recoveryMux);
+    if (ok)
+        recoveryStats.time[path].record(us);
+    else
+        recoveryStats.failures[path]++;
+    portEXIT_CRITICAL(&recoveryMux);
+}
+
+static void countRecovery(Mcp2515RecoveryPath path)
+{
+    portENTER_CRITICAL(&recoveryMux);
+    recoveryStats.runs[path]++;
+    portEXIT_CRITICAL(&recoveryMux);
+}
+
+// Configuration mode and back: TEC / REC cleared, configuration kept.
+// setNormalMode() reads CANSTAT back; EFLG confirms bus-off is gone.
+static bool modeToggleRecovery()
+{
+    return mcp2515->setConfigMode() == MCP2515::ERROR_OK && mcp2515->setNormalMode() == MCP2515::ERROR_OK &&
+           !(mcp2515->getErrorFlags() & MCP2515::EFLG_TXBO);
+}
+
+static void recoverBusOff(uint32_t detectedUs)
+{
+    const uint32_t now = millis();
+    if (now - busOffWindowStartMs > CAN2_BUSOFF_WINDOW_MS)
+    {
+        busOffWindowStartMs = now;
+        busOffsInWindow = 0;
+    }
+    bool reinit = reinitPending || ++busOffsInWindow >= CAN2_REINIT_AFTER_BUSOFFS;
+
+    if (!reinit)
+    {
+        countRecovery(MCP_REC_MODE_TOGGLE);
+        const bool ok = modeToggleRecovery();
+        const uint32_t us = micros() - detectedUs;
+        recordRecovery(MCP_REC_MODE_TOGGLE, ok, us);
+        if (ok)
+        {
+            Serial.printf("[CAN2] ✅ Bus-off cleared by mode toggle in %u us\n", us);
+            return;
+        }
+        Serial.println("[CAN2] ⚠️  Mode toggle did not clear bus-off - reconfiguring");
+        reinit = true;
+    }
+
+    countRecovery(MCP_REC_REINIT);
+    const bool ok = configureChip();
+    const uint32_t us = micros() - detectedUs;
+    recordRecovery(MCP_REC_REINIT, ok, us);
+    reinitPending = !ok;
+    if (ok)
+    {
+        busOffsInWindow = 0;
+        txb2HeaderValid = false; // TXB2 contents are not trusted across a reconfiguration
+        Serial.printf("[CAN2] ✅ Controller reconfigured in %u us\n", us);
+    }
+}
 
-// ISR flag
-static volatile bool messageAvailable = false;
+// EFLG error-state bits (plus EWARN) from the latest read
+static void recoverErrorState(uint8_t flags)
+{
+    const uint32_t detectedUs = micros();
+    if ((flags & MCP2515::EFLG_TXBO) || reinitPending)
+    {
+        Serial.printf("[CAN2] 🚨 Bus-off (EFLG 0x%02X), recovering in place\n", flags);
+        recoverBusOff(detectedUs);
+        errorPassive = false; // counters cleared
+        return;
+    }
+
+    const bool passive = (flags & (MCP2515::EFLG_TXEP | MCP2515::EFLG_RXEP)) != 0;
+    if (passive && !errorPassive)
+    {
+        errorPassive = true;
+        passiveSinceUs = detectedUs;
+        countRecovery(MCP_REC_PASSIVE);
+        Serial.printf("[CAN2] ⚠️  Error-passive (EFLG 0x%02X), still receiving\n", flags);
+    }
+    else if (errorPassive && !(flags & MCP2515::EFLG_EWARN))
+    {
+        errorPassive = false;
+        recordRecovery(MCP_REC_PASSIVE, true, detectedUs - passiveSinceUs);
+    }
+}
+
+// ISR handler: INT falling edge stamps the RX time and wakes the CAN2 RX task directly
+static TaskHandle_t rxTaskHandle = nullptr;
 
-// ISR handler
 void IRAM_ATTR mcp2515_isr()
 {
-    messageAvailable = true;
+    portENTER_CRITICAL_ISR(&intEdgeMux);
+    intEdgeUs = esp_timer_get_time();
+    portEXIT_CRITICAL_ISR(&intEdgeMux);
+
+    BaseType_t woken = pdFALSE;
+    if (rxTaskHandle)
+        vTaskNotifyGiveFromISR(rxTaskHandle, &woken);
+    portYIELD_FROM_ISR(woken);
 }
 
 namespace CAN_MCP2515
@@ -48,82 +487,8 @@ namespace CAN_MCP2515
                 mcp2515 = new MCP2515(CAN2_CS_PIN);
             }
 
-            // CRITICAL: Don't use reset() - it clears filters
-            // Manual initialization instead
-            MCP2515::ERROR result = mcp2515->setConfigMode();
-            if (result != MCP2515::ERROR_OK)
-            {
-                Serial.printf("[CAN2] ❌ Config mode failed: %d\n", result);
-                xSemaphoreGive(mcp2515RecoveryMutex);
-                return false;
-            }
-
-            // Set bitrate (CRITICAL: 8MHz crystal)
-            result = mcp2515->setBitrate(CAN_250KBPS, MCP_8MHZ);
-            if (result != MCP2515::ERROR_OK)
-            {
-                Serial.printf("[CAN2] ❌ Bitrate config failed: %d (check 8MHz crystal)\n", result);
-                xSemaphoreGive(mcp2515RecoveryMutex);
-                return false;
-            }
-
-            // CRITICAL: Configure hardware filters for BMS IDs only
-            // RXF0 (RXB0): 0x1806E5F4 - BMS Request (Vmax, Imax)
-            result = mcp2515->setFilter(MCP2515::RXF0, true, 0x1806E5F4UL);
-            if (result != MCP2515::ERROR_OK)
-            {
-                Serial.printf("[CAN2] ❌ Filter RXF0 failed: %d\n", result);
-                xSemaphoreGive(mcp2515RecoveryMutex);
-                return false;
-            }
-
-            // RXF1 (RXB1): 0x160B8001 - Charging Ah Response
-            result = mcp2515->setFilter(MCP2515::RXF1, true, 0x160B8001UL);
-            if (result != MCP2515::ERROR_OK)
-            {
-                Serial.printf("[CAN2] ❌ Filter RXF1 failed: %d\n", result);
-                xSemaphoreGive(mcp2515RecoveryMutex);
-                return false;
-            }
-
-            // RXF2 (RXB0): 0x160D8001 - Discharging Ah Response
-            result = mcp2515->setFilter(MCP2515::RXF2, true, 0x160D8001UL);
-            if (result != MCP2515::ERROR_OK)
-            {
-                Serial.printf("[CAN2] ❌ Filter RXF2 failed: %d\n", result);
-                xSemaphoreGive(mcp2515RecoveryMutex);
-                return false;
-            }
-
-            // RXF3-5: Unused, set to impossible ID
-            mcp2515->setFilter(MCP2515::RXF3, true, 0x1FFFFFFFUL);
-            mcp2515->setFilter(MCP2515::RXF4, true, 0x1FFFFFFFUL);
-            mcp2515->setFilter(MCP2515::RXF5, true, 0x1FFFFFFFUL);
-
-            // Set masks to match exact IDs (all bits must match)
-            result = mcp2515->setFilterMask(MCP2515::MASK0, true, 0x1FFFFFFFUL);
-            if (result != MCP2515::ERROR_OK)
+            if (!configureChip())
             {
-                Serial.printf("[CAN2] ❌ Mask0 failed: %d\n", result);
-                xSemaphoreGive(mcp2515RecoveryMutex);
-                return false;
-            }
-
-            result = mcp2515->setFilterMask(MCP2515::MASK1, true, 0x1FFFFFFFUL);
-            if (result != MCP2515::ERROR_OK)
-            {
-                Serial.printf("[CAN2] ❌ Mask1 failed: %d\n", result);
-                xSemaphoreGive(mcp2515RecoveryMutex);
-                return false;
-            }
-
-            Serial.println("[CAN2] ✅ Hardware filters configured (3 BMS IDs only)");
-
-            // Set normal mode
-            result = mcp2515->setNormalMode();
-            if (result != MCP2515::ERROR_OK)
-            {
-                Serial.printf("[CAN2] ❌ Normal mode failed: %d (check wiring)\n", result);
                 xSemaphoreGive(mcp2515RecoveryMutex);
                 return false;
             }
@@ -132,6 +497,10 @@ namespace CAN_MCP2515
             pinMode(CAN2_INT_PIN, INPUT_PULLUP);
             attachInterrupt(digitalPinToInterrupt(CAN2_INT_PIN), mcp2515_isr, FALLING);
 
+            // TXB2 contents are not trusted across a reinit
+            txb2HeaderValid = false;
+            mailboxDueMs = millis();
+
             driverStatus.is_initialized = true;
             driverStatus.is_active = true;
             Serial.println("[CAN2] ✅ MCP2515 initialized successfully");
@@ -175,9 +544,16 @@ namespace CAN_MCP2515
         frame.can_dlc = length;
         memcpy(frame.data, data, length);
 
-        MCP2515::ERROR result = mcp2515->sendMessage(&frame);
+        // TXB2 belongs to the mailbox: the library's own buffer search could pick it
+        const uint8_t status = mcpReadStatus();
+        MCP2515::ERROR result = MCP2515::ERROR_ALLTXBUSY;
+        if (!(status & MCP_STATUS_TX0REQ))
+            result = mcp2515->sendMessage(MCP2515::TXB0, &frame);
+        else if (!(status & MCP_STATUS_TX1REQ))
+            result = mcp2515->sendMessage(MCP2515::TXB1, &frame);
         if (result == MCP2515::ERROR_OK)
         {
+            CAN_STATS::onTx(CAN_BUS_BMS, id, length, is_extended);
             driverStatus.total_tx_messages++;
             driverStatus.last_activity_ms = millis();
             return true;
@@ -187,44 +563,54 @@ namespace CAN_MCP2515
         return false;
     }
 
-    bool receiveMessage(CanMessage *msg)
+    void updateMailbox(uint32_t id, const uint8_t *data, uint8_t length, bool is_extended, uint32_t periodMs)
     {
-        if (rxHead == rxTail)
-            return false;
-
-        *msg = rxBuffer[rxTail];
-        rxTail = (rxTail + 1) % MCP2515_RX_BUFFER_SIZE;
-        return true;
+        if (length > 8)
+            length = 8;
+        portENTER_CRITICAL(&mailboxMux);
+        if (!mailbox.enabled || mailbox.id != id || mailbox.extended != is_extended ||
+            mailbox.dlc != length || mailbox.periodMs != periodMs)
+        {
+            mailbox.enabled = true;
+            mailbox.reconfigured = true;
+            mailbox.id = id;
+            mailbox.extended = is_extended;
+            mailbox.dlc = length;
+            mailbox.periodMs = periodMs ? periodMs : 1;
+        }
+        memcpy(mailbox.payload, data, length);
+        portEXIT_CRITICAL(&mailboxMux);
     }
 
-    bool popFrame(RxBufItem &out)
+    bool receiveMessage(CanMessage *msg)
     {
-        CanMessage msg;
-        if (!receiveMessage(&msg))
-            return false;
+        return rxRing.pop(*msg);
+    }
 
-        out.id = msg.id;
-        out.dlc = msg.dlc;
-        memcpy(out.data, msg.data, 8);
-        out.ext = msg.extended;
-        out.rtr = false;
-        return true;
+    size_t receiveMessages(CanMessage *msgs, size_t max)
+    {
+        return rxRing.popN(msgs, max);
     }
 
     CanMcp2515Status getStatus()
     {
-        return driverStatus;
+        CanMcp2515Status status = driverStatus;
+        status.rx_overflows = rxRing.overflowCount();
+        status.mailbox_spi_us = (uint32_t)(mailboxSpiNs / 1000);
+        status.mailbox_saved_us = (uint32_t)(mailboxSavedNs / 1000);
+        const uint32_t elapsedMs = millis() - mailboxSinceMs;
+        status.mailbox_saved_us_per_min = elapsedMs ? (uint32_t)(mailboxSavedNs * 60 / elapsedMs) : 0;
+        return status;
     }
 
     void flushRxBuffer()
     {
-        rxHead = rxTail = 0;
+        rxRing.clear();
     }
 
     uint8_t getRxBufferUsage()
     {
-        uint16_t count = (rxHead >= rxTail) ? (rxHead - rxTail) : (MCP2515_RX_BUFFER_SIZE - rxTail + rxHead);
-        return (count * 100) / MCP2515_RX_BUFFER_SIZE;
+        return rxRing.usagePercent();
     }
 
     void resetStatistics()
@@ -232,6 +618,15 @@ namespace CAN_MCP2515
         driverStatus.total_rx_messages = 0;
         driverStatus.total_tx_messages = 0;
         driverStatus.error_count = 0;
+        driverStatus.rx0_overruns = 0;
+        driverStatus.rx1_overruns = 0;
+        driverStatus.mailbox_sends = 0;
+        driverStatus.mailbox_loads = 0;
+        driverStatus.mailbox_aborts = 0;
+        mailboxSpiNs = 0;
+        mailboxSavedNs = 0;
+        mailboxSinceMs = millis();
+        rxRing.resetOverflowCount();
     }
 
     bool isHealthy()
@@ -240,86 +635,230 @@ namespace CAN_MCP2515
         return (millis() - driverStatus.last_activity_ms) < TIMEOUT_MS;
     }
 
+    uint8_t serviceRx()
+    {
+        if (!mcp2515 || !driverStatus.is_active)
+            return 0;
+
+        bool bothFull, errorInt;
+        drainRxBuffers(bothFull, errorInt);
+
+        // EFLG is not in READ STATUS: read it on ERRIF, when an overrun was
+        // possible (both buffers were full) and otherwise every CAN2_EFLG_POLL_MS
+        const uint32_t now = millis();
+        if (!bothFull && !errorInt && now - lastEflgCheckMs < CAN2_EFLG_POLL_MS)
+            return 0;
+        lastEflgCheckMs = now;
+
+        // Clear the interrupt source first: a change after the read raises it again
+        if (errorInt)
+            mcp2515->clearERRIF();
+        const uint8_t errorFlags = mcp2515->getErrorFlags();
+        if (errorFlags & (MCP2515::EFLG_RX0OVR | MCP2515::EFLG_RX1OVR))
+        {
+            if (errorFlags & MCP2515::EFLG_RX0OVR)
+                driverStatus.rx0_overruns++;
+            if (errorFlags & MCP2515::EFLG_RX1OVR)
+                driverStatus.rx1_overruns++;
+            mcp2515->clearRXnOVRFlags();
+            driverStatus.error_count++;
+        }
+
+        const uint8_t errorState = errorFlags & MCP2515_ERROR_STATE_FLAGS;
+        if (errorState || errorPassive || reinitPending)
+            recoverErrorState(errorState | (errorFlags & MCP2515::EFLG_EWARN));
+        return errorState;
+    }
+
+    uint32_t serviceMailbox()
+    {
+        if (!mcp2515 || !driverStatus.is_active)
+            return CAN2_EFLG_POLL_MS;
+
+        Mailbox m;
+        portENTER_CRITICAL(&mailboxMux);
+        m = mailbox;
+        mailbox.reconfigured = false;
+        portEXIT_CRITICAL(&mailboxMux);
+        if (!m.enabled)
+            return CAN2_EFLG_POLL_MS;
+
+        const uint32_t now = millis();
+        if (m.reconfigured)
+        {
+            txb2HeaderValid = false;
+            mailboxDueMs = now;
+        }
+        const int32_t untilDue = (int32_t)(mailboxDueMs - now);
+        if (untilDue > 0)
+            return (uint32_t)untilDue;
+
+        // On the period grid; resync after a stall (reinit, long mutex wait)
+        mailboxDueMs += m.periodMs;
+        if ((int32_t)(mailboxDueMs - now) <= 0)
+            mailboxDueMs = now + m.periodMs;
+
+        // Changed bytes since the last load, as one contiguous span
+        int first = -1, last = -1;
+        for (int i = 0; i < m.dlc; i++)
+        {
+            if (m.payload[i] != txb2Data[i])
+            {
+                if (first < 0)
+                    first = i;
+                last = i;
+            }
+        }
+
+        uint32_t transactions = 0, bytes = 0;
+        if (!txb2HeaderValid || first >= 0)
+        {
+            // TXB2 must not be written while its previous request is pending
+            // (no ACK on the bus): abort it and load on the next period
+            transactions++;
+            bytes += 2;
+            if (mcpReadStatus() & MCP_STATUS_TX2REQ)
+            {
+                mcpBitModify(MCP_REG_TXB2CTRL, MCP_TXBCTRL_TXREQ, 0);
+                driverStatus.mailbox_aborts++;
+                mailboxSpiNs += mcpSpiNs(transactions + 1, bytes + 4);
+                return m.periodMs;
+            }
+
+            if (!txb2HeaderValid)
+            {
+                // SIDH, SIDL, EID8, EID0, DLC, D0..Dn in one WRITE
+                uint8_t regs[13];
+                const uint32_t id = m.id;
+                if (m.extended)
+                {
+                    regs[0] = (uint8_t)(id >> 21);
+                    regs[1] = (uint8_t)((((id >> 18) & 0x07) << 5) | MCP_SIDL_IDE | ((id >> 16) & 0x03));
+                    regs[2] = (uint8_t)(id >> 8);
+                    regs[3] = (uint8_t)id;
+                }
+                else
+                {
+                    regs[0] = (uint8_t)(id >> 3);
+                    regs[1] = (uint8_t)((id & 0x07) << 5);
+                    regs[2] = regs[3] = 0;
+                }
+                regs[4] = m.dlc;
+                memcpy(&regs[5], m.payload, m.dlc);
+                mcpWriteTxb2(MCP_REG_TXB2SIDH, regs, 5 + m.dlc);
+                transactions++;
+                bytes += 2 + 5 + m.dlc;
+                txb2HeaderValid = true;
+            }
+            else
+            {
+                const uint8_t len = (uint8_t)(last - first + 1);
+                mcpWriteTxb2(MCP_REG_TXB2D0 + first, &m.payload[first], len);
+                transactions++;
+                bytes += (first == 0 ? 1 : 2) + len;
+            }
+            memcpy(txb2Data, m.payload, m.dlc);
+            driverStatus.mailbox_loads++;
+        }
+
+        mcpRequestTxb2();
+        transactions++;
+        bytes++;
+
+        const uint32_t usedNs = mcpSpiNs(transactions, bytes);
+        const uint32_t libraryNs = mcpSpiNs(MCP_LIB_SEND_TXNS, MCP_LIB_SEND_BYTES(m.dlc));
+        mailboxSpiNs += usedNs;
+        if (libraryNs > usedNs)
+            mailboxSavedNs += libraryNs - usedNs;
+
+        CAN_STATS::onTx(CAN_BUS_BMS, m.id, m.dlc, m.extended);
+        driverStatus.mailbox_sends++;
+        driverStatus.total_tx_messages++;
+        driverStatus.last_activity_ms = now;
+        return m.periodMs;
+    }
+
+    CanMcp2515RecoveryStats getRecoveryStats()
+    {
+        portENTER_CRITICAL(&recoveryMux);
+        const CanMcp2515RecoveryStats s = recoveryStats;
+        portEXIT_CRITICAL(&recoveryMux);
+        return s;
+    }
+
+    void resetRecoveryStats()
+    {
+        portENTER_CRITICAL(&recoveryMux);
+        memset(&recoveryStats, 0, sizeof(recoveryStats));
+        portEXIT_CRITICAL(&recoveryMux);
+    }
+
+    void printRecoveryStats()
+    {
+        static const char *PATH_NAMES[MCP_REC_PATHS] = {"error-passive", "mode toggle", "reconfigure"};
+        const CanMcp2515RecoveryStats s = getRecoveryStats();
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        Serial.println("\n=========== CAN2 ERROR RECOVERY ===========");
+        for (uint8_t p = 0; p < MCP_REC_PATHS; p++)
+        {
+            const CanRecoveryHistogram &h = s.time[p];
+            Serial.printf("%-13s runs=%u failed=%u", PATH_NAMES[p], s.runs[p], s.failures[p]);
+            if (h.samples)
+                Serial.printf(" recover min=%.2f avg=%.2f max=%.2f ms", h.minUs / 1000.0f,
+                              h.totalUs / 1000.0f / h.samples, h.maxUs / 1000.0f);
+            Serial.println();
+            if (!h.samples)
+                continue;
+            uint32_t lower = 0;
+            for (uint8_t b = 0; b < CAN_RECOVERY_BUCKETS - 1; b++)
+            {
+                if (h.buckets[b])
+                    Serial.printf("  %5u-%-5ums : %u\n", lower, CAN_RECOVERY_EDGES_MS[b], h.buckets[b]);
+                lower = CAN_RECOVERY_EDGES_MS[b];
+            }
+            if (h.buckets[CAN_RECOVERY_BUCKETS - 1])
+                Serial.printf("  >%-10ums : %u\n", lower, h.buckets[CAN_RECOVERY_BUCKETS - 1]);
+        }
+        Serial.println("===========================================\n");
+
+        xSemaphoreGive(serialMutex);
+    }
+
 } // namespace CAN_MCP2515
 
 // CAN2 RX Task (BMS messages)
 void can2_rx_task(void *arg)
 {
     Serial.println("[CAN2] RX task started");
-
-    struct can_frame frame;
+    rxTaskHandle = xTaskGetCurrentTaskHandle();
+    uint32_t waitMs = CAN2_EFLG_POLL_MS;
 
     while (true)
     {
+        // The ISR only sees the falling edge of INT: block while the line is
+        // idle (until the EFLG check or the mailbox is due), go straight on
+        // while frames are still pending
+        if (digitalRead(CAN2_INT_PIN) == HIGH || !driverStatus.is_active)
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+        waitMs = CAN2_EFLG_POLL_MS;
+
         // Take mutex before accessing MCP2515
         if (mcp2515RecoveryMutex && xSemaphoreTake(mcp2515RecoveryMutex, pdMS_TO_TICKS(100)) == pdTRUE)
         {
             if (driverStatus.is_initialized && driverStatus.is_active)
             {
-                // Check interrupt flag
-                if (messageAvailable || !digitalRead(CAN2_INT_PIN))
-                {
-                    messageAvailable = false;
-
-                    MCP2515::ERROR result = mcp2515->readMessage(&frame);
-                    if (result == MCP2515::ERROR_OK)
-                    {
-                        // Check buffer overflow
-                        uint16_t nextHead = (rxHead + 1) % MCP2515_RX_BUFFER_SIZE;
-                        if (nextHead != rxTail)
-                        {
-                            // Convert can_frame to CanMessage
-                            rxBuffer[rxHead].id = frame.can_id & CAN_EFF_MASK;
-                            rxBuffer[rxHead].dlc = frame.can_dlc;
-                            memcpy(rxBuffer[rxHead].data, frame.data, 8);
-                            rxBuffer[rxHead].extended = (frame.can_id & CAN_EFF_FLAG) != 0;
-                            rxBuffer[rxHead].timestamp_ms = millis();
-
-                            rxHead = nextHead;
-                            driverStatus.total_rx_messages++;
-                            driverStatus.last_activity_ms = millis();
-                        }
-                        else
-                        {
-                            // Buffer full - drop oldest
-                            rxTail = (rxTail + 1) % MCP2515_RX_BUFFER_SIZE;
-                            driverStatus.error_count++;
-                        }
-                    }
-                }
+                // Drain both RX buffers; bus-off / error-passive are recovered in place
+                CAN_MCP2515::serviceRx();
 
-                // Check for bus errors and auto-recover
-                uint8_t errorFlags = mcp2515->getErrorFlags();
-                if (errorFlags != 0)
-                {
-                    // Clear RX overflow flags immediately (0x40 = EFLG_RX1OVR)
-                    if (errorFlags & (MCP2515::EFLG_RX0OVR | MCP2515::EFLG_RX1OVR))
-                    {
-                        mcp2515->clearRXnOVRFlags();
-                        driverStatus.error_count++;
-                    }
-                    
-                    // Only log critical errors (bus-off, not overflow or warnings)
-                    if (errorFlags & (MCP2515::EFLG_TXBO | MCP2515::EFLG_RXEP))
-                    {
-                        Serial.printf("[CAN2] 🚨 Critical error: 0x%02X\n", errorFlags);
-                        mcp2515->clearRXnOVRFlags();
-                        mcp2515->clearInterrupts();
-                        mcp2515->clearTXInterrupts();
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                        
-                        // Reinitialize
-                        xSemaphoreGive(mcp2515RecoveryMutex);
-                        CAN_MCP2515::deinit();
-                        vTaskDelay(pdMS_TO_TICKS(100));
-                        CAN_MCP2515::init();
-                        continue;
-                    }
-                }
+                // Periodic TXB2 frame; SPI is ours while the mutex is held
+                const uint32_t dueMs = CAN_MCP2515::serviceMailbox();
+                if (dueMs < waitMs)
+                    waitMs = dueMs;
             }
             xSemaphoreGive(mcp2515RecoveryMutex);
         }
-
-        vTaskDelay(pdMS_TO_TICKS(10));
     }
 }
@@ -0,0 +1,165 @@
+#include "../../include/drivers/can_trace.h"
+#include "../../include/header.h"
+
+static_assert((CAN_TRACE_CAPACITY & (CAN_TRACE_CAPACITY - 1)) == 0, "CAN_TRACE_CAPACITY must be a power of two");
+
+static CanTraceRecord traceRing[CAN_TRACE_CAPACITY];
+static uint32_t traceWritten = 0; // monotonically increasing record counter
+static uint32_t streamPos = 0;
+static uint32_t streamDropped = 0;
+static volatile bool traceEnabled = true;
+static volatile bool traceStreaming = false;
+
+// Two producers (CAN1/CAN2 RX tasks) → short spinlock critical section
+static portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const uint32_t TRACE_MASK = CAN_TRACE_CAPACITY - 1;
+
+// Print one record as "T " + 32 hex chars (caller holds serialMutex)
+static void printRecord(const CanTraceRecord &r)
+{
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+    char line[2 + 32 + 1];
+    const uint8_t *b = reinterpret_cast<const uint8_t *>(&r);
+
+    line[0] = 'T';
+    line[1] = ' ';
+    for (size_t i = 0; i < sizeof(r); i++)
+    {
+        line[2 + i * 2] = HEX_DIGITS[b[i] >> 4];
+        line[3 + i * 2] = HEX_DIGITS[b[i] & 0x0F];
+    }
+    line[sizeof(line) - 1] = '\0';
+    Serial.println(line);
+}
+
+namespace CAN_TRACE
+{
+    void record(CanBus bus, const CanMessage &msg)
+    {
+        if (!traceEnabled)
+            return;
+
+        const CanTraceRecord r = pack(bus, msg);
+        portENTER_CRITICAL(&traceMux);
+        traceRing[traceWritten & TRACE_MASK] = r;
+        traceWritten++;
+        portEXIT_CRITICAL(&traceMux);
+    }
+
+    void setEnabled(bool enabled)
+    {
+        traceEnabled = enabled;
+    }
+
+    bool isEnabled()
+    {
+        return traceEnabled;
+    }
+
+    uint32_t recordedCount()
+    {
+        return traceWritten;
+    }
+
+    size_t snapshot(CanTraceRecord *out, size_t max)
+    {
+        portENTER_CRITICAL(&traceMux);
+        const uint32_t written = traceWritten;
+        uint32_t available = written < CAN_TRACE_CAPACITY ? written : CAN_TRACE_CAPACITY;
+        if (available > max)
+            available = max;
+        const uint32_t first = written - available;
+        for (uint32_t i = 0; i < available; i++)
+            out[i] = traceRing[(first + i) & TRACE_MASK];
+        portEXIT_CRITICAL(&traceMux);
+        return available;
+    }
+
+    void clear()
+    {
+        portENTER_CRITICAL(&traceMux);
+        traceWritten = 0;
+        streamPos = 0;
+        streamDropped = 0;
+        portEXIT_CRITICAL(&traceMux);
+    }
+
+    void dump()
+    {
+        const bool wasEnabled = traceEnabled;
+        traceEnabled = false;
+
+        const uint32_t written = traceWritten;
+        const uint32_t count = written < CAN_TRACE_CAPACITY ? written : CAN_TRACE_CAPACITY;
+        const uint32_t first = written - count;
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) == pdTRUE)
+        {
+            Serial.printf("#CANTRACE v%d records=%u dropped=%u\n", CAN_TRACE_VERSION, count, first);
+            for (uint32_t i = 0; i < count; i++)
+                printRecord(traceRing[(first + i) & TRACE_MASK]);
+            Serial.println("#CANTRACE END");
+            xSemaphoreGive(serialMutex);
+        }
+
+        traceEnabled = wasEnabled;
+    }
+
+    void setStreaming(bool enabled)
+    {
+        portENTER_CRITICAL(&traceMux);
+        streamPos = traceWritten;
+        streamDropped = 0;
+        portEXIT_CRITICAL(&traceMux);
+
+        if (enabled && xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) == pdTRUE)
+        {
+            Serial.printf("#CANTRACE v%d stream\n", CAN_TRACE_VERSION);
+            xSemaphoreGive(serialMutex);
+        }
+        traceStreaming = enabled;
+    }
+
+    bool isStreaming()
+    {
+        return traceStreaming;
+    }
+
+    void pollStream()
+    {
+        if (!traceStreaming)
+            return;
+
+        // Serial at 115200 baud carries ~300 records/s; more than a ring's
+        // worth of backlog means records were overwritten before we got there
+        const uint32_t written = traceWritten;
+        if (written - streamPos > CAN_TRACE_CAPACITY)
+        {
+            streamDropped += written - streamPos - CAN_TRACE_CAPACITY;
+            streamPos = written - CAN_TRACE_CAPACITY;
+        }
+        if (streamPos == written)
+            return;
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        CanTraceRecord r;
+        while (streamPos != written)
+        {
+            portENTER_CRITICAL(&traceMux);
+            r = traceRing[streamPos & TRACE_MASK];
+            portEXIT_CRITICAL(&traceMux);
+            printRecord(r);
+            streamPos++;
+        }
+        if (streamDropped)
+        {
+            Serial.printf("#CANTRACE dropped=%u\n", streamDropped);
+            streamDropped = 0;
+        }
+        xSemaphoreGive(serialMutex);
+    }
+
+} // namespace CAN_TRACE
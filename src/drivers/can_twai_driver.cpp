@@ -1,17 +1,44 @@
 #include "../../include/drivers/can_twai_driver.h"
 #include "../../include/header.h"
 #include "../../include/config/hardware.h"
+#include "../../include/config/timing.h"
+#include "../../include/drivers/can_acceptance_filter.h"
+#include "../../include/drivers/can_dispatcher.h"
+#include "../../include/drivers/can_bus_stats.h"
+#include "../../include/drivers/can_trace.h"
+#include "../../include/drivers/can_tx_queue.h"
+#include "../../include/core/spsc_ring.h"
+#include <esp_timer.h>
 
 // Ring buffer for received messages (unified format)
 #define TWAI_RX_BUFFER_SIZE 64
-static CanMessage rxBuffer[TWAI_RX_BUFFER_SIZE];
-static volatile uint16_t rxHead = 0;
-static volatile uint16_t rxTail = 0;
+static SpscRing<CanMessage, TWAI_RX_BUFFER_SIZE> rxRing;
 
 // Driver status
-static CanTwaiStatus driverStatus = {false, false, 0, 0, 0, 0};
+static CanTwaiStatus driverStatus = {false, false, 0, 0, 0, 0, 0, 0};
+
+#if CAN1_ACCEPTANCE_FILTER
+// Narrowest single/dual TWAI filter over CAN1_RX_IDS
+static constexpr CanAcceptanceFilter can1Filter = buildTwaiFilter(CAN1_RX_IDS);
+
+template <size_t N>
+static constexpr bool filterPassesAll(const CanAcceptanceFilter &f, const uint32_t (&ids)[N])
+{
+    for (size_t i = 0; i < N; i++)
+    {
+        if (!twaiFilterAccepts(f, ids[i]))
+            return false;
+    }
+    return true;
+}
+static_assert(filterPassesAll(can1Filter, CAN1_RX_IDS), "CAN1 acceptance filter rejects a wanted id");
+#endif
 static SemaphoreHandle_t twaiRecoveryMutex = nullptr;
 
+// Bus-off recovery: driven by can1_alert_task, read by the console
+static CanBusOffRecovery busRecovery;
+static portMUX_TYPE recoveryMux = portMUX_INITIALIZER_UNLOCKED;
+
 namespace CAN_TWAI
 {
     bool init()
@@ -27,8 +54,17 @@ namespace CAN_TWAI
         if (twaiRecoveryMutex && xSemaphoreTake(twaiRecoveryMutex, pdMS_TO_TICKS(1000)) == pdTRUE)
         {
             twai_general_config_t g_config = TWAI_GENERAL_CONFIG_DEFAULT(CAN1_TX_PIN, CAN1_RX_PIN, TWAI_MODE_NORMAL);
+            g_config.tx_queue_len = CAN1_TX_CONTROLLER_QUEUE; // ordering is done by the CAN_TX lanes
+            g_config.alerts_enabled = CAN1_RECOVERY_ALERTS | CAN1_TX_ALERTS;
             twai_timing_config_t t_config = TWAI_TIMING_CONFIG_250KBITS();
+#if CAN1_ACCEPTANCE_FILTER
+            twai_filter_config_t f_config = {};
+            f_config.acceptance_code = can1Filter.code;
+            f_config.acceptance_mask = can1Filter.mask;
+            f_config.single_filter = can1Filter.single;
+#else
             twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+#endif
 
             esp_err_t err = twai_driver_install(&g_config, &t_config, &f_config);
             if (err != ESP_OK)
@@ -49,6 +85,11 @@ namespace CAN_TWAI
             driverStatus.is_initialized = true;
             driverStatus.is_active = true;
             Serial.println("[CAN1] ✅ TWAI initialized successfully");
+#if CAN1_ACCEPTANCE_FILTER
+            Serial.printf("[CAN1] ✅ Acceptance filter: %s code=0x%08X mask=0x%08X (%u extended ids pass)\n",
+                          can1Filter.single ? "single" : "dual", can1Filter.code, can1Filter.mask,
+                          can1Filter.acceptedIds);
+#endif
 
             xSemaphoreGive(twaiRecoveryMutex);
             return true;
@@ -70,7 +111,9 @@ namespace CAN_TWAI
         return driverStatus.is_active;
     }
 
-    bool sendMessage(uint32_t id, const uint8_t *data, uint8_t length, bool is_extended)
+    // Shared by the blocking and the queued send paths
+    static esp_err_t transmitFrame(uint32_t id, const uint8_t *data, uint8_t length, bool is_extended,
+                                   TickType_t wait)
     {
         twai_message_t msg = {};
         msg.identifier = id;
@@ -78,55 +121,58 @@ namespace CAN_TWAI
         msg.extd = is_extended ? 1 : 0;
         memcpy(msg.data, data, length);
 
-        esp_err_t err = twai_transmit(&msg, pdMS_TO_TICKS(100));
+        esp_err_t err = twai_transmit(&msg, wait);
         if (err == ESP_OK)
         {
+            CAN_STATS::onTx(CAN_BUS_CHARGER, id, length, is_extended);
             driverStatus.total_tx_messages++;
             driverStatus.last_activity_ms = millis();
-            return true;
         }
-        driverStatus.error_count++;
-        return false;
+        else if (err != ESP_ERR_TIMEOUT && err != ESP_FAIL)
+        {
+            driverStatus.error_count++;
+        }
+        return err;
     }
 
-    bool receiveMessage(CanMessage *msg)
+    bool sendMessage(uint32_t id, const uint8_t *data, uint8_t length, bool is_extended)
     {
-        if (rxHead == rxTail)
-            return false;
+        const esp_err_t err = transmitFrame(id, data, length, is_extended, pdMS_TO_TICKS(100));
+        if (err == ESP_ERR_TIMEOUT || err == ESP_FAIL)
+            driverStatus.error_count++;
+        return err == ESP_OK;
+    }
 
-        *msg = rxBuffer[rxTail];
-        rxTail = (rxTail + 1) % TWAI_RX_BUFFER_SIZE;
-        return true;
+    esp_err_t transmit(uint32_t id, const uint8_t *data, uint8_t length, bool is_extended)
+    {
+        return transmitFrame(id, data, length, is_extended, 0);
     }
 
-    bool popFrame(RxBufItem &out)
+    bool receiveMessage(CanMessage *msg)
     {
-        CanMessage msg;
-        if (!receiveMessage(&msg))
-            return false;
+        return rxRing.pop(*msg);
+    }
 
-        out.id = msg.id;
-        out.dlc = msg.dlc;
-        memcpy(out.data, msg.data, 8);
-        out.ext = msg.extended;
-        out.rtr = false;
-        return true;
+    size_t receiveMessages(CanMessage *msgs, size_t max)
+    {
+        return rxRing.popN(msgs, max);
     }
 
     CanTwaiStatus getStatus()
     {
-        return driverStatus;
+        CanTwaiStatus status = driverStatus;
+        status.rx_overflows = rxRing.overflowCount();
+        return status;
     }
 
     void flushRxBuffer()
     {
-        rxHead = rxTail = 0;
+        rxRing.clear();
     }
 
     uint8_t getRxBufferUsage()
     {
-        uint16_t count = (rxHead >= rxTail) ? (rxHead - rxTail) : (TWAI_RX_BUFFER_SIZE - rxTail + rxHead);
-        return (count * 100) / TWAI_RX_BUFFER_SIZE;
+        return rxRing.usagePercent();
     }
 
     void resetStatistics()
@@ -134,6 +180,8 @@ namespace CAN_TWAI
         driverStatus.total_rx_messages = 0;
         driverStatus.total_tx_messages = 0;
         driverStatus.error_count = 0;
+        driverStatus.rx_rejected = 0;
+        rxRing.resetOverflowCount();
     }
 
     bool isHealthy()
@@ -142,8 +190,154 @@ namespace CAN_TWAI
         return (millis() - driverStatus.last_activity_ms) < TIMEOUT_MS;
     }
 
+    bool acceptsFrame(uint32_t id, bool extended)
+    {
+#if CAN1_ACCEPTANCE_FILTER
+        return extended && canIdListContains(CAN1_RX_IDS, id & 0x1FFFFFFFUL);
+#else
+        (void)id;
+        (void)extended;
+        return true;
+#endif
+    }
+
+    uint32_t serviceRecovery(uint32_t waitMs)
+    {
+        uint32_t alerts = 0;
+        twai_read_alerts(&alerts, pdMS_TO_TICKS(waitMs));
+
+        // The state read back covers alerts that were missed or not raised (twai_stop())
+        const uint32_t handed = CAN_TX::handedCount();
+        twai_status_info_t info;
+        const bool haveState = twai_get_status_info(&info) == ESP_OK;
+        const uint64_t now = (uint64_t)esp_timer_get_time();
+
+        // TX_SUCCESS / TX_FAILED may merge between reads: the counts settle which frames are done
+        if (haveState)
+            CAN_TX::onController(handed, info);
+
+        portENTER_CRITICAL(&recoveryMux);
+        const CanRecoveryState before = busRecovery.state();
+        busRecovery.onAlerts(alerts, now);
+        if (haveState)
+            busRecovery.onState(info.state, now);
+        const CanRecoveryState after = busRecovery.state();
+        const CanRecoveryAction action = busRecovery.next(now);
+        const uint32_t backoffMs = busRecovery.stats().backoffMs;
+        portEXIT_CRITICAL(&recoveryMux);
+
+        if (before == CAN_REC_RUNNING && after == CAN_REC_BACKOFF)
+            Serial.printf("[CAN1] 🚨 BUS-OFF detected, recovery in %u ms\n", backoffMs);
+        else if (before == CAN_REC_RUNNING && after == CAN_REC_RESTART)
+            Serial.println("[CAN1] 🚨 Controller stopped, restarting");
+
+        if (action != CAN_REC_NONE)
+        {
+            const esp_err_t err = action == CAN_REC_INITIATE ? twai_initiate_recovery() : twai_start();
+            const uint64_t done = (uint64_t)esp_timer_get_time();
+            portENTER_CRITICAL(&recoveryMux);
+            busRecovery.complete(action, err == ESP_OK, done);
+            const uint64_t downSince = busRecovery.downSinceUs();
+            portEXIT_CRITICAL(&recoveryMux);
+
+            if (err != ESP_OK)
+                Serial.printf("[CAN1] ⚠️  Recovery step %s failed: %d\n",
+                              action == CAN_REC_INITIATE ? "initiate" : "start", err);
+            else if (action == CAN_REC_START)
+                Serial.printf("[CAN1] ✅ Bus recovered in %.1f ms\n", (done - downSince) / 1000.0f);
+        }
+
+        portENTER_CRITICAL(&recoveryMux);
+        const uint32_t untilUs = busRecovery.waitUs((uint64_t)esp_timer_get_time());
+        portEXIT_CRITICAL(&recoveryMux);
+        if (untilUs == UINT32_MAX)
+            return CAN1_ALERT_POLL_MS;
+        const uint32_t untilMs = (untilUs + 999) / 1000;
+        return untilMs < CAN1_ALERT_POLL_MS ? untilMs : CAN1_ALERT_POLL_MS;
+    }
+
+    CanRecoveryState recoveryState(uint32_t *downMs)
+    {
+        portENTER_CRITICAL(&recoveryMux);
+        const CanRecoveryState state = busRecovery.state();
+        const uint64_t downSince = busRecovery.downSinceUs();
+        portEXIT_CRITICAL(&recoveryMux);
+        if (downMs)
+            *downMs = state == CAN_REC_RUNNING ? 0 : (uint32_t)(((uint64_t)esp_timer_get_time() - downSince) / 1000);
+        return state;
+    }
+
+    CanBusOffStats getRecoveryStats()
+    {
+        portENTER_CRITICAL(&recoveryMux);
+        const CanBusOffStats s = busRecovery.stats();
+        portEXIT_CRITICAL(&recoveryMux);
+        return s;
+    }
+
+    void resetRecoveryStats()
+    {
+        portENTER_CRITICAL(&recoveryMux);
+        busRecovery.resetStats();
+        portEXIT_CRITICAL(&recoveryMux);
+    }
+
+    void printRecoveryStats()
+    {
+        static const char *STATE_NAMES[] = {"running", "backoff", "recovering", "restart"};
+        const CanBusOffStats s = getRecoveryStats();
+        uint32_t downMs = 0;
+        const CanRecoveryState state = recoveryState(&downMs);
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        Serial.println("\n=========== CAN1 BUS-OFF RECOVERY ===========");
+        Serial.printf("state=%s", STATE_NAMES[state]);
+        if (state != CAN_REC_RUNNING)
+            Serial.printf(" (down %u ms)", downMs);
+        Serial.printf("\nbus-off=%u recovered=%u stopped=%u error-passive=%u warnings=%u failures=%u backoff=%u ms\n",
+                      s.busOffs, s.recoveries, s.stopped, s.errorPassive, s.errorWarnings, s.actionFailures,
+                      s.backoffMs);
+        const CanRecoveryHistogram &h = s.recovery;
+        if (h.samples)
+        {
+            Serial.printf("time to recover: min=%.1f ms avg=%.1f ms max=%.1f ms\n", h.minUs / 1000.0f,
+                          h.totalUs / 1000.0f / h.samples, h.maxUs / 1000.0f);
+            uint32_t lower = 0;
+            for (uint8_t b = 0; b < CAN_RECOVERY_BUCKETS - 1; b++)
+            {
+                Serial.printf("  %5u-%-5ums : %u\n", lower, CAN_RECOVERY_EDGES_MS[b], h.buckets[b]);
+                lower = CAN_RECOVERY_EDGES_MS[b];
+            }
+            Serial.printf("  >%-10ums : %u\n", lower, h.buckets[CAN_RECOVERY_BUCKETS - 1]);
+        }
+        Serial.println("=============================================\n");
+
+        xSemaphoreGive(serialMutex);
+    }
+
 } // namespace CAN_TWAI
 
+// --- CAN1 alert task ---
+// Blocks on TWAI alerts (recovery and TX completions); wakes early only while a backoff or restart is due
+void can1_alert_task(void *arg)
+{
+    Serial.println("[CAN1] Alert task started");
+
+    uint32_t waitMs = CAN1_ALERT_POLL_MS;
+    while (true)
+    {
+        if (!driverStatus.is_initialized)
+        {
+            // twai_read_alerts() fails straight away without a driver
+            vTaskDelay(pdMS_TO_TICKS(CAN1_ALERT_POLL_MS));
+            continue;
+        }
+        waitMs = CAN_TWAI::serviceRecovery(waitMs);
+    }
+}
+
 // CAN1 RX Task (Charger messages)
 void can1_rx_task(void *arg)
 {
@@ -153,40 +347,56 @@ void can1_rx_task(void *arg)
 
     while (true)
     {
+        bool driverReady = false;
+
         // Take mutex before accessing TWAI driver
         if (twaiRecoveryMutex && xSemaphoreTake(twaiRecoveryMutex, pdMS_TO_TICKS(100)) == pdTRUE)
         {
             if (driverStatus.is_initialized && driverStatus.is_active)
             {
+                driverReady = true;
+
+                // Blocks until a frame arrives - no extra sleep once one is received
                 esp_err_t err = twai_receive(&msg, pdMS_TO_TICKS(100));
-                if (err == ESP_OK)
+                if (err == ESP_OK && !CAN_TWAI::acceptsFrame(msg.identifier, msg.extd != 0))
+                {
+                    // The hardware filter is a superset of CAN1_RX_IDS: no decoder wants this one
+                    driverStatus.rx_rejected++;
+                }
+                else if (err == ESP_OK)
                 {
-                    // Check buffer overflow
-                    uint16_t nextHead = (rxHead + 1) % TWAI_RX_BUFFER_SIZE;
-                    if (nextHead != rxTail)
+                    // Convert twai_message_t to CanMessage
+                    CanMessage rx;
+                    rx.id = msg.identifier;
+                    rx.dlc = msg.data_length_code;
+                    memcpy(rx.data, msg.data, 8);
+                    rx.extended = (msg.extd != 0);
+                    // twai_receive() has no hardware timestamp: stamp as it returns
+                    rx.timestamp_us = (uint64_t)esp_timer_get_time();
+                    CAN_TRACE::record(CAN_BUS_CHARGER, rx);
+
+                    if (rxRing.push(rx))
                     {
-                        // Convert twai_message_t to CanMessage
-                        rxBuffer[rxHead].id = msg.identifier;
-                        rxBuffer[rxHead].dlc = msg.data_length_code;
-                        memcpy(rxBuffer[rxHead].data, msg.data, 8);
-                        rxBuffer[rxHead].extended = (msg.extd != 0);
-                        rxBuffer[rxHead].timestamp_ms = millis();
-
-                        rxHead = nextHead;
                         driverStatus.total_rx_messages++;
                         driverStatus.last_activity_ms = millis();
                     }
                     else
                     {
-                        // Buffer full - drop oldest
-                        rxTail = (rxTail + 1) % TWAI_RX_BUFFER_SIZE;
+                        // Buffer full - frame dropped (counted by the ring)
                         driverStatus.error_count++;
                     }
+
+                    // Wake dispatcher immediately
+                    CAN_DISPATCH::notify();
                 }
             }
             xSemaphoreGive(twaiRecoveryMutex);
         }
 
-        vTaskDelay(pdMS_TO_TICKS(10));
+        // Only back off while the driver is down (recovery in progress)
+        if (!driverReady)
+        {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
     }
 }
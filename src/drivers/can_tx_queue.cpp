@@ -0,0 +1,316 @@
+#include "../../include/drivers/can_tx_queue.h"
+#include "../../include/drivers/can_twai_driver.h"
+#include "../../include/header.h"
+#include <Arduino.h>
+#include <string.h>
+
+// =========================================================
+// QUEUE
+// =========================================================
+void CanTxQueue::clear()
+{
+    memset(lanes_, 0, sizeof(lanes_));
+    nextSeq_ = 1;
+    handed_ = retired_ = failedSeen_ = 0;
+}
+
+bool CanTxQueue::enqueue(CanTxLane lane, const CanTxFrame &frame, uint32_t nowUs)
+{
+    if (lane >= CAN_TX_LANES)
+        return false;
+    Lane &l = lanes_[lane];
+    const uint32_t seq = nextSeq_++;
+    if (nextSeq_ == 0)
+        nextSeq_ = 1; // 0 marks "nothing in flight"
+
+    if (frame.key != CAN_TX_NO_COALESCE)
+    {
+        // Newest match only: an older one may be in flight, or must still go out first
+        for (uint8_t i = l.count; i-- > 0;)
+        {
+            CanTxFrame &s = l.slots[(l.head + i) % CAN_TX_LANE_DEPTH];
+            if (s.id != frame.id || s.key != frame.key || s.extended != frame.extended)
+                continue;
+            if (s.seq == l.inFlightSeq)
+                break; // already with the controller: queue behind it
+            const uint32_t queuedUs = s.queuedUs;
+            s = frame;
+            s.queuedUs = queuedUs;
+            s.seq = seq;
+            l.stats.coalesced++;
+            return true;
+        }
+    }
+
+    if (l.count >= CAN_TX_LANE_DEPTH)
+    {
+        l.stats.dropped++;
+        return false;
+    }
+    CanTxFrame &s = l.slots[(l.head + l.count) % CAN_TX_LANE_DEPTH];
+    s = frame;
+    s.queuedUs = nowUs;
+    s.seq = seq;
+    l.count++;
+    l.stats.queued++;
+    if (l.count > l.stats.peakDepth)
+        l.stats.peakDepth = l.count;
+    return true;
+}
+
+bool CanTxQueue::front(CanTxFrame &out, CanTxToken &token)
+{
+    for (uint8_t i = 0; i < CAN_TX_LANES; i++)
+    {
+        Lane &l = lanes_[i];
+        if (l.count == 0)
+            continue;
+        out = l.slots[l.head];
+        l.inFlightSeq = out.seq;
+        token.lane = i;
+        token.slot = l.head;
+        token.seq = out.seq;
+        return true;
+    }
+    return false;
+}
+
+void CanTxQueue::pop(Lane &l)
+{
+    l.head = (l.head + 1) % CAN_TX_LANE_DEPTH;
+    l.count--;
+}
+
+void CanTxQueue::complete(const CanTxToken &token, bool handed, uint32_t nowUs)
+{
+    if (token.lane >= CAN_TX_LANES)
+        return;
+    Lane &l = lanes_[token.lane];
+    if (l.inFlightSeq == token.seq)
+        l.inFlightSeq = 0;
+    if (!handed)
+        return;
+
+    // The controller has it now, whether or not it is still in the lane
+    if (handed_ - retired_ >= CAN_TX_WIRE_DEPTH)
+        retire(true); // it took a newer frame, so the oldest has left it
+    wire_[handed_ % CAN_TX_WIRE_DEPTH] = token.lane;
+    handed_++;
+
+    // Flushed meanwhile: nothing of this frame is left to remove
+    if (l.count == 0 || l.head != token.slot || l.slots[l.head].seq != token.seq)
+        return;
+
+    const uint32_t wait = nowUs - l.slots[l.head].queuedUs;
+    if (wait > l.stats.maxWaitUs)
+        l.stats.maxWaitUs = wait;
+    l.stats.totalWaitUs += wait;
+    l.stats.handed++;
+    pop(l);
+}
+
+void CanTxQueue::retire(bool delivered)
+{
+    CanTxLaneStats &s = lanes_[wire_[retired_ % CAN_TX_WIRE_DEPTH]].stats;
+    if (delivered)
+        s.delivered++;
+    else
+        s.lost++;
+    retired_++;
+}
+
+void CanTxQueue::onController(uint32_t handedBefore, uint32_t pending, uint32_t failedTotal, bool running)
+{
+    if (failedTotal < failedSeen_)
+        failedSeen_ = 0; // reinstalled driver, its count starts again
+
+    // <= 0 once the handover overflow retired past the snapshot
+    const int32_t held = (int32_t)(handedBefore - retired_);
+    if (!running)
+    {
+        // Stopped or bus-off: the controller has dropped its TX queue
+        for (int32_t i = 0; i < held; i++)
+            retire(false);
+        failedSeen_ = failedTotal;
+        return;
+    }
+
+    // Frames handed after the snapshot may already count in pending: then
+    // fewer are retired now and the rest on the next alert
+    for (int32_t done = held - (int32_t)pending; done > 0; done--)
+    {
+        const bool failed = failedSeen_ < failedTotal;
+        if (failed)
+            failedSeen_++;
+        retire(!failed);
+    }
+}
+
+void CanTxQueue::flush(CanTxLane lane)
+{
+    if (lane >= CAN_TX_LANES)
+        return;
+    Lane &l = lanes_[lane];
+    l.stats.flushed += l.count;
+    l.head = 0;
+    l.count = 0;
+    l.inFlightSeq = 0;
+}
+
+void CanTxQueue::stats(CanTxLane lane, CanTxLaneStats &out) const
+{
+    if (lane >= CAN_TX_LANES)
+    {
+        memset(&out, 0, sizeof(out));
+        return;
+    }
+    out = lanes_[lane].stats;
+    out.depth = lanes_[lane].count;
+}
+
+void CanTxQueue::resetStats()
+{
+    for (uint8_t i = 0; i < CAN_TX_LANES; i++)
+    {
+        memset(&lanes_[i].stats, 0, sizeof(lanes_[i].stats));
+        lanes_[i].stats.peakDepth = lanes_[i].count;
+    }
+}
+
+// =========================================================
+// FIRMWARE INSTANCE
+// =========================================================
+// Filled by any task, drained by can1_tx_task: short spinlock, never held
+// across a transmit
+static CanTxQueue txQueue;
+static portMUX_TYPE txMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t txTaskHandle = nullptr;
+
+namespace CAN_TX
+{
+    bool send(CanTxLane lane, uint32_t id, const uint8_t *data, uint8_t length, bool is_extended, uint16_t key)
+    {
+        CanTxFrame f = {};
+        f.id = id;
+        f.dlc = length > 8 ? 8 : length;
+        memcpy(f.data, data, f.dlc);
+        f.extended = is_extended;
+        f.key = key;
+
+        const uint32_t now = micros();
+        portENTER_CRITICAL(&txMux);
+        const bool ok = txQueue.enqueue(lane, f, now);
+        portEXIT_CRITICAL(&txMux);
+
+        if (ok && txTaskHandle)
+            xTaskNotifyGive(txTaskHandle);
+        return ok;
+    }
+
+    void stats(CanTxLane lane, CanTxLaneStats &out)
+    {
+        portENTER_CRITICAL(&txMux);
+        txQueue.stats(lane, out);
+        portEXIT_CRITICAL(&txMux);
+    }
+
+    void resetStats()
+    {
+        portENTER_CRITICAL(&txMux);
+        txQueue.resetStats();
+        portEXIT_CRITICAL(&txMux);
+    }
+
+    uint32_t handedCount()
+    {
+        portENTER_CRITICAL(&txMux);
+        const uint32_t n = txQueue.handedCount();
+        portEXIT_CRITICAL(&txMux);
+        return n;
+    }
+
+    void onController(uint32_t handedBefore, const twai_status_info_t &info)
+    {
+        portENTER_CRITICAL(&txMux);
+        txQueue.onController(handedBefore, info.msgs_to_tx, info.tx_failed_count,
+                             info.state == TWAI_STATE_RUNNING);
+        portEXIT_CRITICAL(&txMux);
+    }
+
+    void printStats()
+    {
+        static const char *LANE_NAMES[CAN_TX_LANES] = {"safety", "periodic"};
+        CanTxLaneStats s[CAN_TX_LANES];
+        for (uint8_t i = 0; i < CAN_TX_LANES; i++)
+            stats((CanTxLane)i, s[i]);
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        Serial.println("\n============== CAN1 TX QUEUE ==============");
+        Serial.println("lane      queued coalesced dropped flushed handed   wire   lost depth peak  avg ms  max ms");
+        for (uint8_t i = 0; i < CAN_TX_LANES; i++)
+        {
+            const CanTxLaneStats &l = s[i];
+            Serial.printf("%-8s %7u %9u %7u %7u %6u %6u %6u %5u %4u %7.2f %7.2f\n", LANE_NAMES[i], l.queued,
+                          l.coalesced, l.dropped, l.flushed, l.handed, l.delivered, l.lost, l.depth, l.peakDepth,
+                          l.handed ? l.totalWaitUs / 1000.0f / l.handed : 0.0f, l.maxWaitUs / 1000.0f);
+        }
+        Serial.println("===========================================\n");
+
+        xSemaphoreGive(serialMutex);
+    }
+
+} // namespace CAN_TX
+
+// --- CAN1 TX task ---
+// The controller queue holds one frame, so the lanes decide the order on
+// the wire. A full controller queue is retried every CAN1_TX_RETRY_MS; a
+// stopped or bus-off controller flushes the polls and keeps the commands.
+void can1_tx_task(void *arg)
+{
+    txTaskHandle = xTaskGetCurrentTaskHandle();
+    Serial.println("[CAN1] TX task started");
+
+    TickType_t wait = pdMS_TO_TICKS(CAN1_TX_IDLE_TIMEOUT_MS);
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, wait);
+        wait = pdMS_TO_TICKS(CAN1_TX_IDLE_TIMEOUT_MS);
+
+        while (true)
+        {
+            CanTxFrame f;
+            CanTxToken token;
+            portENTER_CRITICAL(&txMux);
+            const bool have = txQueue.front(f, token);
+            portEXIT_CRITICAL(&txMux);
+            if (!have)
+                break;
+
+            // The lanes may change while this frame is on its way: complete() pops only this one
+            const esp_err_t err = CAN_TWAI::transmit(f.id, f.data, f.dlc, f.extended);
+            const uint32_t now = micros();
+            portENTER_CRITICAL(&txMux);
+            txQueue.complete(token, err == ESP_OK, now);
+            portEXIT_CRITICAL(&txMux);
+            if (err == ESP_OK)
+                continue;
+
+            if (err == ESP_ERR_INVALID_STATE)
+            {
+                // Controller stopped / bus-off / being reinstalled: stale polls are useless afterwards
+                portENTER_CRITICAL(&txMux);
+                txQueue.flush(CAN_TX_PERIODIC);
+                portEXIT_CRITICAL(&txMux);
+                wait = pdMS_TO_TICKS(CAN1_TX_DOWN_RETRY_MS);
+            }
+            else
+            {
+                // Controller queue full: the frame on the wire finishes within a millisecond
+                wait = pdMS_TO_TICKS(CAN1_TX_RETRY_MS);
+            }
+            break;
+        }
+    }
+}
@@ -1,7 +1,18 @@
 #include "header.h"
 #include "drivers/can_twai_driver.h"
 #include "drivers/can_mcp2515_driver.h"
+#include "drivers/can_signal_table.h"
+#include "drivers/can_acceptance_filter.h"
+#include "drivers/charger_poll.h"
+#include "drivers/can_bus_stats.h"
+#include "core/telemetry.h"
+#include "core/energy_meter.h"
+#include "core/signal_history.h"
+#include "core/perf_trace.h"
+#include "core/deferred_log.h"
+#include "config/timing.h"
 #include <Arduino.h>
+#include <freertos/timers.h>
 #include <string.h>
 
 // Toggle OCPP telemetry here (set to 1 to enable, 0 to disable)
@@ -10,268 +21,196 @@
 #include "ocpp/csms_communication.h"
 #endif
 
-// Response watchdog
-static unsigned long lastResp = 0;
-
-// Big-endian float helper (assumes payload stores MSB first)
-static inline float beFloat(const uint8_t *b)
+// --- POLL SCHEDULE ---
+// Per function code periods (idle / charging, ms; 0 = on demand) and
+// priority (0 = most urgent). 0x32 is the start/stop command and only goes
+// out on a state change, so checking it often costs no bus time.
+const ChargerPollSpec chargerPolls[] = {
+    {ID_CTRL_REQ, 0x32, 0, 100, 100},    // charge command
+    {ID_TELEM_REQ, 0x82, 1, 1000, 100},  // output current
+    {ID_TELEM_REQ, 0x84, 2, 1000, 250},  // battery voltage (also plug detection)
+    {ID_CTRL_REQ, 0x00, 3, 0, 1000},     // Vmax setpoint
+    {ID_CTRL_REQ, 0x03, 3, 0, 1000},     // Imax setpoint
+    {ID_TELEM_REQ, 0x80, 4, 2000, 1000}, // temperature
+    {ID_TELEM_REQ, 0x79, 5, 0, 0},       // metric79, on demand
+    {ID_TELEM_REQ, 0x83, 5, 0, 0},       // metric83, on demand
+};
+const uint8_t NUM_CHARGER_POLLS = sizeof(chargerPolls) / sizeof(chargerPolls[0]);
+static_assert(sizeof(chargerPolls) / sizeof(chargerPolls[0]) <= CHARGER_POLL_MAX_CODES,
+              "chargerPolls exceeds CHARGER_POLL_MAX_CODES");
+
+// --- SIGNAL HOOKS ---
+// Side effects beyond a scaled store. Called with dataMutex held.
+
+// RX time (esp_timer_get_time) of the frame being decoded, for hooks that need it
+static uint64_t decodeRxUs = 0;
+
+// Any control response with a plausible Vmax echo means the pack is present
+static void hookCtrlPlug(const uint8_t *data)
 {
-    uint8_t tmp[4] = {b[3], b[2], b[1], b[0]};
-    float f;
-    memcpy(&f, tmp, sizeof(f));
-    return f;
+    (void)data;
+    if (Charger_Vmax > 56.0f && Charger_Vmax < 85.5f)
+    {
+        batteryConnected = true;
+        gunPhysicallyConnected = true;
+        TELEMETRY::stamp(TSIG_BATTERY_PRESENT, decodeRxUs);
+    }
 }
 
-// Groups
-Group groups[] = {
-    // Ctrl/limits group: status(0x32), Vmax(0x00), Imax(0x03)
-    {0x068181FEUL, 0x0681817EUL, {0x32, 0x00, 0x03}, 3, 300, 0, 0},
-    // Telemetry group: batt V(0x84), curr(0x82), temp(0x80), metric79, metric83
-    {0x068182FEUL, 0x0681827EUL, {0x84, 0x82, 0x79, 0x80, 0x83}, 5, 200, 0, 0}};
-const uint8_t NUM_GROUPS = sizeof(groups) / sizeof(Group);
-
-// Forward decoders
-static void decode_0681817E(const twai_message_t &msg);
-static void decode_0681827E(const twai_message_t &msg);
-static void decode_00433F01(const twai_message_t &msg);
-static void decode_00473F01(const twai_message_t &msg);
-static void decode_18FF50E5(const twai_message_t &msg);
-
-void handleChargerMessage(const twai_message_t &msg)
+static void hookCtrlStatus(const uint8_t *data)
 {
-    const uint8_t dlc = msg.data_length_code;
-    memcpy(lastData, msg.data, dlc > 8 ? 8 : dlc);
-
-    const uint32_t id = msg.extd ? (msg.identifier & 0x1FFFFFFFUL)
-                                 : (msg.identifier & 0x7FF);
+    chargerStatus = (data[3] == 0x00) ? "ON" : "OFF";
+    hookCtrlPlug(data);
+}
 
-    switch (id)
+static void hookBattVolt(const uint8_t *data)
+{
+    (void)data;
+    if (chargerVolt > 56.0f && chargerVolt < 84.5f)
     {
-    case (ID_CTRL_RESP & 0x1FFFFFFFUL):
-        decode_0681817E(msg);
-        break;
-    case (ID_TELEM_RESP & 0x1FFFFFFFUL):
-        decode_0681827E(msg);
-        break;
-    case (ID_TERM_POWER & 0x1FFFFFFFUL):
-        decode_00433F01(msg);
-        break;
-    case (ID_TERM_STATUS & 0x1FFFFFFFUL):
-        decode_00473F01(msg);
-        break;
-    case (ID_HEARTBEAT & 0x1FFFFFFFUL):
-        decode_18FF50E5(msg);
-        break;
-    default:
-        break;
+        batteryConnected = true;
+        gunPhysicallyConnected = true;
     }
 }
-// --- DECODERS ---
 
-static void decode_0681817E(const twai_message_t &msg)
+static void hookOutputTemp(const uint8_t *data)
 {
-    const uint8_t dlc = msg.data_length_code;
-    if (dlc < 8)
-        return;
-    const uint8_t func = msg.data[1];
-    const uint32_t raw = (uint32_t(msg.data[4]) << 24) |
-                         (uint32_t(msg.data[5]) << 16) |
-                         (uint32_t(msg.data[6]) << 8) |
-                         uint32_t(msg.data[7]);
+    (void)data;
+    SIGNAL_HISTORY::record(HIST_CHARGER_TEMP, chargerTemp, decodeRxUs);
+}
 
-    // FIX: Use timeout to prevent deadlock
-    if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(50)) == pdTRUE)
+static void hookMetric79(const uint8_t *data)
+{
+    metric79_raw = ((uint16_t)data[6] << 8) | data[7];
+}
+
+static void hookTermPower(const uint8_t *data)
+{
+    (void)data;
+    terminalchargerPower = terminalVolt * terminalCurr;
+    ENERGY_METER::onTerminalPower(decodeRxUs, terminalVolt, terminalCurr);
+    SIGNAL_HISTORY::record(HIST_TERMINAL_VOLT, terminalVolt, decodeRxUs);
+    SIGNAL_HISTORY::record(HIST_TERMINAL_CURR, terminalCurr, decodeRxUs);
+
+    // HYBRID PLUG DETECTION - Method 1: Voltage + Current presence
+    if (terminalVolt > 56.0f && terminalVolt < 85.5f)
     {
-        if (func == 0x32)
-        {
-            memcpy(lastStatusData, msg.data, dlc > 8 ? 8 : dlc);
-            chargerStatus = (msg.data[3] == 0x00) ? "ON" : "OFF";
-        }
-        else if (func == 0x00)
-        {
-            memcpy(lastVmaxData, msg.data, dlc > 8 ? 8 : dlc);
-            Charger_Vmax = raw / 1024.0f;
-        }
-        else if (func == 0x03)
-        {
-            memcpy(lastImaxData, msg.data, dlc > 8 ? 8 : dlc);
-            Charger_Imax = raw / 30.5f;
-        }
-        if (Charger_Vmax > 56.0f && Charger_Vmax < 85.5f)
-        {
-            batteryConnected = true;
-            gunPhysicallyConnected = true;
-            lastBMS = millis();
-        }
-        xSemaphoreGive(dataMutex);
+        batteryConnected = true;
+        gunPhysicallyConnected = true;
+        TELEMETRY::stamp(TSIG_BATTERY_PRESENT, decodeRxUs);
     }
+}
+
+static void hookTermStatus(const uint8_t *data)
+{
+    const uint8_t b6 = data[6], b7 = data[7];
+    if (b6 == 0x03 && b7 == 0x01)
+        terminalStatus = "NOT CHARGING";
+    else if (b6 == 0x03 && b7 == 0x02)
+        terminalStatus = "CHARGING";
     else
-    {
-        // FIX: Log mutex timeout to detect deadlocks
-        Serial.println("[CAN] ⚠️  Mutex timeout in decode_0681817E");
-    }
-    // Update response watchdog
-    lastResp = millis();
-    // Serial.println("📥 Control response received");
+        terminalStatus = "UNKNOWN";
 }
 
-static void decode_0681827E(const twai_message_t &msg)
+static void hookHeartbeat(const uint8_t *data)
 {
-    const uint8_t dlc = msg.data_length_code;
-    if (dlc < 8)
-        return;
-    const uint8_t func = msg.data[1];
+    const bool alive = (data[4] & 0x08) != 0; // bit 3 alive
+    terminalchargerStatus = alive ? "HEARTBEAT ALIVE" : "NO HEARTBEAT";
+}
 
-    // FIX: Use timeout to prevent deadlock
-    if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(50)) == pdTRUE)
-    {
-        if (func == 0x84)
-        {
-            memcpy(lastBattData, msg.data, dlc > 8 ? 8 : dlc);
-            const uint32_t raw = (uint32_t(msg.data[4]) << 24) |
-                                 (uint32_t(msg.data[5]) << 16) |
-                                 (uint32_t(msg.data[6]) << 8) |
-                                 uint32_t(msg.data[7]);
-            chargerVolt = raw / 1024.0f;
-
-            if (chargerVolt > 56.0f && chargerVolt < 84.5f)
-            {
-                batteryConnected = true;
-                gunPhysicallyConnected = true;
-            }
-        }
-        else if (func == 0x82)
-        {
-            memcpy(lastCurrData, msg.data, dlc > 8 ? 8 : dlc);
-            chargerCurr = (float(((uint16_t)msg.data[6] << 8) | (uint16_t)msg.data[7])) / 10.0f;
-        }
-        else if (func == 0x80)
-        {
-            memcpy(lastTempData, msg.data, dlc > 8 ? 8 : dlc);
-            chargerTemp = (float(((uint16_t)msg.data[6] << 8) | (uint16_t)msg.data[7])) * 0.001f;
-        }
-        else if (func == 0x79)
-        {
-            memcpy(lastVoltData, msg.data, dlc > 8 ? 8 : dlc);
-            metric79_raw = ((uint16_t)msg.data[6] << 8) | msg.data[7];
-            metric79_scaled = metric79_raw * 1.0f;
-        }
-        else if (func == 0x83)
-        {
-            memcpy(lastVoltData, msg.data, dlc > 8 ? 8 : dlc);
-            metric83_scaled = beFloat(&msg.data[4]);
-        }
-        xSemaphoreGive(dataMutex);
-    }
-    else
+// --- SIGNAL TABLE ---
+// One entry per (CAN id, data[1] function code). Broadcast frames without a
+// function code use CAN_FUNC_NONE.
+#define NO_FIELD {CanFieldEnc::NONE, 0, 0.0f, nullptr}
+
+static const CanSignal chargerSignals[] = {
+    // Control responses (0x0681817E): value in data[4..7]
+    {ID_CTRL_RESP, 0x32, 8, {NO_FIELD, NO_FIELD}, CAN_RAW(lastStatusData), hookCtrlStatus, TSIG_CHARGER_STATUS},
+    {ID_CTRL_RESP, 0x00, 8, {{CanFieldEnc::U32_BE, 4, 1.0f / 1024.0f, &Charger_Vmax}, NO_FIELD}, CAN_RAW(lastVmaxData), hookCtrlPlug, TSIG_CHARGER_VMAX},
+    {ID_CTRL_RESP, 0x03, 8, {{CanFieldEnc::U32_BE, 4, 1.0f / 30.5f, &Charger_Imax}, NO_FIELD}, CAN_RAW(lastImaxData), hookCtrlPlug, TSIG_CHARGER_IMAX},
+    // Any other control response still runs the plug check on the last Vmax
+    {ID_CTRL_RESP, CAN_FUNC_ANY, 8, {NO_FIELD, NO_FIELD}, nullptr, hookCtrlPlug, TSIG_COUNT},
+
+    // Telemetry responses (0x0681827E)
+    {ID_TELEM_RESP, 0x84, 8, {{CanFieldEnc::U32_BE, 4, 1.0f / 1024.0f, &chargerVolt}, NO_FIELD}, CAN_RAW(lastBattData), hookBattVolt, TSIG_OUTPUT_VOLT},
+    {ID_TELEM_RESP, 0x82, 8, {{CanFieldEnc::U16_BE, 6, 0.1f, &chargerCurr}, NO_FIELD}, CAN_RAW(lastCurrData), nullptr, TSIG_OUTPUT_CURR},
+    {ID_TELEM_RESP, 0x80, 8, {{CanFieldEnc::U16_BE, 6, 0.001f, &chargerTemp}, NO_FIELD}, CAN_RAW(lastTempData), hookOutputTemp, TSIG_OUTPUT_TEMP},
+    {ID_TELEM_RESP, 0x79, 8, {{CanFieldEnc::U16_BE, 6, 1.0f, &metric79_scaled}, NO_FIELD}, CAN_RAW(lastVoltData), hookMetric79, TSIG_METRIC79},
+    {ID_TELEM_RESP, 0x83, 8, {{CanFieldEnc::F32_BE, 4, 1.0f, &metric83_scaled}, NO_FIELD}, CAN_RAW(lastVoltData), nullptr, TSIG_METRIC83},
+
+    // Terminal broadcasts
+    {ID_TERM_POWER, CAN_FUNC_NONE, 8,
+     {{CanFieldEnc::F32_BE, 0, 1.0f, &terminalVolt}, {CanFieldEnc::F32_BE, 4, 1.0f, &terminalCurr}},
+     CAN_RAW(lastTermData1), hookTermPower, TSIG_TERMINAL_POWER},
+    {ID_TERM_STATUS, CAN_FUNC_NONE, 8, {NO_FIELD, NO_FIELD}, CAN_RAW(lastTermData2), hookTermStatus, TSIG_TERMINAL_STATUS},
+    {ID_HEARTBEAT, CAN_FUNC_NONE, 8, {NO_FIELD, NO_FIELD}, CAN_RAW(lastHData), hookHeartbeat, TSIG_HEARTBEAT},
+};
+
+#undef NO_FIELD
+
+static constexpr auto chargerSignalIndex = buildCanSignalIndex<5>(chargerSignals);
+static_assert(chargerSignalIndex.mult != 0, "chargerSignals keys invalid or no collision-free hash");
+
+// Every decoded id has to pass the CAN1 acceptance filter
+template <size_t N>
+static constexpr bool signalsInRxIds(const CanSignal (&table)[N])
+{
+    for (size_t i = 0; i < N; i++)
     {
-        // FIX: Log mutex timeout to detect deadlocks
-        Serial.println("[CAN] ⚠️  Mutex timeout in decode_0681827E");
+        if (!canIdListContains(CAN1_RX_IDS, table[i].id))
+            return false;
     }
-    // Update response watchdog
-    lastResp = millis();
-    // Serial.println("📥 Telemetry response received");
+    return true;
 }
+static constexpr bool chargerSignalsInRxIds = signalsInRxIds(chargerSignals);
+static_assert(chargerSignalsInRxIds, "chargerSignals id missing from CAN1_RX_IDS");
 
-static void decode_00433F01(const twai_message_t &msg)
+void handleChargerMessage(const CanMessage &msg)
 {
-    const uint8_t dlc = msg.data_length_code;
-    if (dlc < 8)
+    PERF_TRACE_SCOPE(PERF_CHARGER_RX);
+    const uint8_t dlc = msg.dlc > 8 ? 8 : msg.dlc;
+#if CAN_DECODE_CAPTURE_RAW
+    memcpy(lastData, msg.data, dlc);
+#endif
+
+    const uint32_t id = msg.extended ? (msg.id & 0x1FFFFFFFUL) : (msg.id & 0x7FF);
+
+    const CanSignal *sig = findCanSignal(chargerSignals, chargerSignalIndex, id, msg.data[1]);
+    if (sig == nullptr || dlc < sig->min_dlc)
         return;
 
     // FIX: Use timeout to prevent deadlock
     if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(50)) == pdTRUE)
     {
-        memcpy(lastTermData1, msg.data, dlc > 8 ? 8 : dlc);
-        
-        terminalVolt = beFloat(&msg.data[0]);
-        terminalCurr = beFloat(&msg.data[4]);  // Already scaled correctly
-        terminalchargerPower = terminalVolt * terminalCurr;
-
-        // CRITICAL: Update timestamp for charger health monitoring
-        lastTerminalPower = millis();
-
-        // HYBRID PLUG DETECTION - Method 1: Voltage + Current presence
-        if (terminalVolt > 56.0f && terminalVolt < 85.5f)
-        {
-            batteryConnected = true;
-            gunPhysicallyConnected = true;
-            lastBMS = millis();
-        }
-
+        decodeRxUs = msg.timestamp_us;
+        if (sig->raw)
+            memcpy(sig->raw, msg.data, 8); // every entry requires a full 8-byte frame
+        if (sig->field[0].target)
+            *sig->field[0].target = canFieldValue(sig->field[0], msg.data);
+        if (sig->field[1].target)
+            *sig->field[1].target = canFieldValue(sig->field[1], msg.data);
+        TELEMETRY::stamp(sig->signal, msg.timestamp_us); // TSIG_COUNT is ignored
+        if (sig->hook)
+            sig->hook(msg.data);
+        // Measurement frames refresh the lock-free snapshot for other tasks
+        if (sig->field[0].target)
+            TELEMETRY::publishCharger();
         xSemaphoreGive(dataMutex);
     }
     else
     {
         // FIX: Log mutex timeout to detect deadlocks
-        Serial.println("[CAN] ⚠️  Mutex timeout in decode_00433F01");
+        DLOG("[CAN] ⚠️  Mutex timeout decoding 0x%08lX\n", (unsigned long)id);
     }
-}
-
-static void decode_00473F01(const twai_message_t &msg)
-{
-    const uint8_t dlc = msg.data_length_code;
-    if (dlc < 8)
-        return;
-
-    if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(10)) == pdTRUE)
-    {
-        memcpy(lastTermData2, msg.data, dlc > 8 ? 8 : dlc);
-        const uint8_t b6 = msg.data[6], b7 = msg.data[7];
-        if (b6 == 0x03 && b7 == 0x01)
-            terminalStatus = "NOT CHARGING";
-        else if (b6 == 0x03 && b7 == 0x02)
-            terminalStatus = "CHARGING";
-        else
-            terminalStatus = "UNKNOWN";
-
-        // CRITICAL: Update timestamp for charger health monitoring
-        lastTerminalStatus = millis();
 
-        xSemaphoreGive(dataMutex);
-    }
+    if (sig->func < CAN_FUNC_ANY)
+        CHARGER_POLL::onResponse(sig->func);
 }
 
-static void decode_18FF50E5(const twai_message_t &msg)
-{
-    const uint8_t dlc = msg.data_length_code;
-    if (dlc < 8)
-        return;
-
-    if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(10)) == pdTRUE)
-    {
-        memcpy(lastHData, msg.data, dlc > 8 ? 8 : dlc);
-        const bool alive = (msg.data[4] & 0x08) != 0; // bit 3 alive
-        terminalchargerStatus = alive ? "HEARTBEAT ALIVE" : "NO HEARTBEAT";
-        
-        // CRITICAL: Update timestamp for charger health monitoring
-        lastHeartbeat = millis();
-        
-        xSemaphoreGive(dataMutex);
-    }
-}
 
-void sendGroupRequest(Group &g)
+// Payload for one scheduled code (data[0..1] already set); false = skip this slot
+static bool buildChargerRequest(uint8_t func, uint8_t data[8])
 {
-    const unsigned long now = millis();
-    if ((unsigned long)(now - g.lastReq) < g.period)
-        return;
-    g.lastReq = now;
-
-    if (g.funcIndex >= g.funcCount)
-        g.funcIndex = 0;
-    const uint8_t func = g.funcs[g.funcIndex];
-
-    twai_message_t tx = {};
-    tx.identifier = g.reqId & 0x1FFFFFFFUL;
-    tx.extd = 1;
-    tx.rtr = 0;
-    tx.data_length_code = 8;
-
-    memset(tx.data, 0, 8);
-    tx.data[0] = 0x01;
-    tx.data[1] = func;
-
     static bool lastEnabled = false;
 
     if (func == 0x32)
@@ -290,8 +229,8 @@ void sendGroupRequest(Group &g)
         }
         else
         {
-            Serial.println("[SAFETY] ⚠️  Mutex timeout in sendGroupRequest - ABORTING charge command");
-            return; // CRITICAL: Do not send command if mutex fails
+            DLOG("[SAFETY] ⚠️  Mutex timeout in buildChargerRequest - ABORTING charge command\n");
+            return false; // CRITICAL: Do not send command if mutex fails
         }
         
         // SAFETY: All conditions must be true
@@ -299,13 +238,13 @@ void sendGroupRequest(Group &g)
 
         // RACE CONDITION FIX: Only send on state change
         if (safeToCharge == lastEnabled)
-            return;
+            return false;
 
         lastEnabled = safeToCharge;
-        tx.data[2] = 0x00;
-        tx.data[3] = safeToCharge ? 0x00 : 0x01;
+        data[2] = 0x00;
+        data[3] = safeToCharge ? 0x00 : 0x01;
         
-        Serial.printf("[SAFETY] Charging command: %s (gun=%d batt=%d enabled=%d)\n",
+        DLOG("[SAFETY] Charging command: %s (gun=%d batt=%d enabled=%d)\n",
             safeToCharge ? "START" : "STOP", gunConnected, battConnected, enabled);
     }
     else if (func == 0x00 || func == 0x03)
@@ -318,155 +257,112 @@ void sendGroupRequest(Group &g)
         }
         else
         {
-            return; // SAFETY: Skip if mutex fails
+            return false; // SAFETY: Skip if mutex fails
         }
         
         if (!enabled)
-            return;
+            return false;
 
         uint32_t raw = (func == 0x00) ? cachedRawV : cachedRawI;
-        tx.data[4] = (raw >> 24) & 0xFF;
-        tx.data[5] = (raw >> 16) & 0xFF;
-        tx.data[6] = (raw >> 8) & 0xFF;
-        tx.data[7] = raw & 0xFF;
+        data[4] = (raw >> 24) & 0xFF;
+        data[5] = (raw >> 16) & 0xFF;
+        data[6] = (raw >> 8) & 0xFF;
+        data[7] = raw & 0xFF;
     }
 
-    (void)CAN_TWAI::sendMessage(tx.identifier, tx.data, tx.data_length_code, true);
-    g.funcIndex = (g.funcIndex + 1) % g.funcCount;
+    return true;
+}
+
+// --- Periodic TX timer ---
+// The timer only wakes chargerCommTask; CAN transmits never run in the
+// timer service task.
+static void chargerTxTimerCallback(TimerHandle_t timer)
+{
+    TaskHandle_t task = (TaskHandle_t)pvTimerGetTimerID(timer);
+    if (task)
+        xTaskNotifyGive(task);
 }
 
-// --- Main comms task ---
+// --- Main comms task (periodic TX schedule + bus supervision) ---
+// RX decoding runs in canDispatchTask; this task only wakes on the TX timer.
 void chargerCommTask(void *arg)
 {
-    static unsigned long lastFeedback = 0;
-    static unsigned long lastSOCRequest = 0;
-    static unsigned long lastGroupRequest = 0;
-    static unsigned long lastBusRecovery = 0;
+    static bool outageStopped = false;
+
+    // Schedule in timer ticks (CHARGER_TX_TICK_MS each)
+    const uint32_t FEEDBACK_TICKS = HEARTBEAT_INTERVAL_MS / CHARGER_TX_TICK_MS;
+    const uint32_t AH_TICKS = SOC_REQUEST_INTERVAL_MS / CHARGER_TX_TICK_MS;
+
+    TimerHandle_t txTimer = xTimerCreate("CHG_TX_TMR", pdMS_TO_TICKS(CHARGER_TX_TICK_MS),
+                                         pdTRUE, xTaskGetCurrentTaskHandle(), chargerTxTimerCallback);
+    if (txTimer == nullptr || xTimerStart(txTimer, pdMS_TO_TICKS(100)) != pdPASS)
+    {
+        Serial.println("[CAN] ⚠️  TX timer unavailable - falling back to notify timeout");
+    }
+
+    CHARGER_POLL::init(chargerPolls, NUM_CHARGER_POLLS);
+
+    uint32_t tick = 0;
 
     while (true)
     {
-        // SAFETY: CAN bus error recovery
-        twai_status_info_t s;
-        if (twai_get_status_info(&s) == ESP_OK)
+        // Timeout doubles as the tick source if the timer could not be started
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CHARGER_TX_TICK_MS));
+        tick++;
+
+        // SAFETY: bus-off is recovered in place by can1_alert_task within a few
+        // milliseconds; charging is only stopped if the charger stays unreachable
+        uint32_t downMs = 0;
+        if (CAN_TWAI::recoveryState(&downMs) == CAN_REC_RUNNING)
+        {
+            outageStopped = false;
+        }
+        else if (downMs > CHARGER_RESPONSE_TIMEOUT_MS && !outageStopped)
         {
-            // CRITICAL: Immediate recovery on bus-off
-            if (s.state == TWAI_STATE_BUS_OFF || s.state == TWAI_STATE_STOPPED)
+            DLOG("[CAN1] 🚨 Bus down for %u ms - disabling charging\n", downMs);
+            if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(50)) == pdTRUE)
             {
-                if (millis() - lastBusRecovery > 5000) // Prevent rapid recovery loops
-                {
-                    Serial.println("[CAN] 🚨 BUS-OFF detected, initiating recovery...");
-                    
-                    // CRITICAL: Stop driver completely before reinstalling
-                    esp_err_t err = twai_stop();
-                    if (err != ESP_OK) {
-                        Serial.printf("[CAN1] Stop failed: %d\n", err);
-                    }
-                    vTaskDelay(pdMS_TO_TICKS(50));
-                    
-                    err = twai_driver_uninstall();
-                    if (err != ESP_OK) {
-                        Serial.printf("[CAN1] Uninstall failed: %d\n", err);
-                    }
-                    vTaskDelay(pdMS_TO_TICKS(100));
-                    
-                    // Reinitialize
-                    CAN_TWAI::init();
-                    lastBusRecovery = millis();
-                    
-                    // SAFETY: Disable charging during CAN recovery
-                    if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(50)) == pdTRUE)
-                    {
-                        chargingEnabled = false;
-                        xSemaphoreGive(dataMutex);
-                    }
-                }
+                chargingEnabled = false;
+                outageStopped = true;
+                xSemaphoreGive(dataMutex);
             }
-            
+        }
+
+        twai_status_info_t s;
+        if (twai_get_status_info(&s) == ESP_OK)
+        {
             // Log bus status periodically
             static unsigned long lastBusStatus = 0;
             if (millis() - lastBusStatus >= 10000)
             {
-                if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) == pdTRUE)
-                {
-                    Serial.printf("📊 CAN1: State=%d TX_Err=%d RX_Err=%d TX_Q=%d RX_Q=%d\n",
-                        s.state, s.tx_error_counter, s.rx_error_counter, s.msgs_to_tx, s.msgs_to_rx);
-                    xSemaphoreGive(serialMutex);
-                }
+                float load = 0.0f, peak = 0.0f;
+                CAN_STATS::busLoad(CAN_BUS_CHARGER, load, peak);
+                DLOG("📊 CAN1: State=%d TX_Err=%d RX_Err=%d TX_Q=%d RX_Q=%d Load=%.1f%% (peak %.1f%%) Rejected=%u\n",
+                    s.state, s.tx_error_counter, s.rx_error_counter, s.msgs_to_tx, s.msgs_to_rx,
+                    load, peak, CAN_TWAI::getStatus().rx_rejected);
                 lastBusStatus = millis();
             }
         }
 
-        // Send group requests with proper spacing
-        if (millis() - lastGroupRequest >= 500)
-        {
-            sendGroupRequest(groups[0]);
-            vTaskDelay(pdMS_TO_TICKS(50));
-            sendGroupRequest(groups[1]);
-            vTaskDelay(pdMS_TO_TICKS(50));
-            lastGroupRequest = millis();
-        }
+        // Polled function codes whose deadline has passed, within the bus budget
+        CHARGER_POLL::service(buildChargerRequest);
 
-        // Send charger feedback
-        if (millis() - lastFeedback >= 100)
+        // Refresh the charger feedback payload (sent by the CAN2 task)
+        if (tick % FEEDBACK_TICKS == 0)
         {
             sendChargerFeedback();
-            lastFeedback = millis();
         }
 
-        // Request Ah data periodically
-        if (millis() - lastSOCRequest >= 2000)
+        // Request Ah data periodically (charging and discharging on consecutive ticks)
+        const uint32_t ahPhase = tick % AH_TICKS;
+        if (ahPhase == 0)
         {
             requestChargingAh();
-            vTaskDelay(pdMS_TO_TICKS(10));
-            requestDischargingAh();
-            lastSOCRequest = millis();
         }
-
-        // Drain RX queues and dispatch
-        RxBufItem item;
-        
-        // Poll CAN1 (Charger messages)
-        while (CAN_TWAI::popFrame(item))
-        {
-            twai_message_t msg = {};
-            msg.identifier = item.id;
-            msg.extd = item.ext ? 1 : 0;
-            msg.rtr = item.rtr ? 1 : 0;
-            msg.data_length_code = item.dlc;
-            memcpy(msg.data, item.data, 8);
-
-            handleChargerMessage(msg);
-        }
-        
-        // Poll CAN2 (BMS messages)
-        while (CAN_MCP2515::popFrame(item))
+        else if (ahPhase == 1)
         {
-            twai_message_t msg = {};
-            msg.identifier = item.id;
-            msg.extd = item.ext ? 1 : 0;
-            msg.rtr = item.rtr ? 1 : 0;
-            msg.data_length_code = item.dlc;
-            memcpy(msg.data, item.data, 8);
-
-            if ((msg.identifier & 0x1FFFFFFFUL) == (ID_BMS_REQUEST & 0x1FFFFFFFUL))
-            {
-                handleBMSMessage(msg);
-            }
-            else if ((msg.identifier & 0x1FFFFFFFUL) == (ID_CHARGE_AH_RESPONSE & 0x1FFFFFFFUL))
-            {
-                handleChargingAhMessage(msg);
-            }
-            else if ((msg.identifier & 0x1FFFFFFFUL) == (ID_DISCHARGE_AH_RESPONSE & 0x1FFFFFFFUL))
-            {
-                handleDischargingAhMessage(msg);
-            }
-            else if ((msg.identifier & 0x1FFFFFFFUL) == (ID_SOC_RESPONSE & 0x1FFFFFFFUL))
-            {
-                handleSOCMessage(msg);
-            }
+            requestDischargingAh();
         }
-
-        vTaskDelay(pdMS_TO_TICKS(50));
     }
 }
 
@@ -476,13 +372,12 @@ void chargerCommTask(void *arg)
 // Production-grade charger health check based on CAN message timeouts
 bool isChargerModuleHealthy()
 {
-    const unsigned long now = millis();
-    const unsigned long CHARGER_TIMEOUT_MS = 3000; // 3 seconds timeout
+    const uint32_t CHARGER_TIMEOUT_MS = 3000; // 3 seconds timeout
     
-    // Check if we're receiving critical CAN messages from charger
-    bool terminalPowerOk = (now - lastTerminalPower) < CHARGER_TIMEOUT_MS;
-    bool terminalStatusOk = (now - lastTerminalStatus) < CHARGER_TIMEOUT_MS;
-    bool heartbeatOk = (now - lastHeartbeat) < CHARGER_TIMEOUT_MS;
+    // Check if we're receiving critical CAN messages from charger (age from RX time)
+    bool terminalPowerOk = TELEMETRY::ageMs(TSIG_TERMINAL_POWER) < CHARGER_TIMEOUT_MS;
+    bool terminalStatusOk = TELEMETRY::ageMs(TSIG_TERMINAL_STATUS) < CHARGER_TIMEOUT_MS;
+    bool heartbeatOk = TELEMETRY::ageMs(TSIG_HEARTBEAT) < CHARGER_TIMEOUT_MS;
     
     // Charger is healthy if at least 2 out of 3 messages are recent
     int healthyCount = (terminalPowerOk ? 1 : 0) + (terminalStatusOk ? 1 : 0) + (heartbeatOk ? 1 : 0);
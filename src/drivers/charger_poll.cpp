@@ -0,0 +1,406 @@
+#include "../../include/drivers/charger_poll.h"
+#include "../../include/drivers/can_tx_queue.h"
+#include "../../include/config/hardware.h"
+#include "../../include/header.h"
+#include "../../include/core/perf_trace.h"
+#include <Arduino.h>
+#include <string.h>
+
+static const uint32_t POLL_FRAME_BITS = canFrameBits(8, true);
+
+// =========================================================
+// SCHEDULER
+// =========================================================
+ChargerPollScheduler::ChargerPollScheduler()
+{
+    configure(nullptr, 0, CAN1_BAUDRATE, CHARGER_POLL_BUS_BUDGET_PCT);
+}
+
+void ChargerPollScheduler::configure(const ChargerPollSpec *specs, uint8_t count, uint32_t bitrate, uint8_t budgetPercent)
+{
+    if (count > CHARGER_POLL_MAX_CODES)
+        count = CHARGER_POLL_MAX_CODES;
+
+    memset(specs_, 0, sizeof(specs_));
+    memset(slots_, 0, sizeof(slots_));
+    if (specs && count)
+        memcpy(specs_, specs, count * sizeof(ChargerPollSpec));
+    for (uint8_t i = 0; i < count; i++)
+        slots_[i].stats.func = specs_[i].func;
+
+    count_ = count;
+    charging_ = false;
+    bitrate_ = bitrate;
+    costBits_ = 2 * POLL_FRAME_BITS; // request + response
+    stretch256_ = 256;
+    bucketBits_ = CHARGER_POLL_BURST * costBits_;
+    bucketCarry_ = 0;
+    nowMs_ = 0;
+    lastRefillMs_ = 0;
+    windowStartMs_ = 0;
+    started_ = false;
+    setBudgetPercent(budgetPercent);
+}
+
+void ChargerPollScheduler::setBudgetPercent(uint8_t percent)
+{
+    budgetPercent_ = percent == 0 ? 1 : (percent > 100 ? 100 : percent);
+    updateStretch();
+}
+
+// If the periodic demand of the budgeted codes exceeds the budget, stretch
+// all their periods by the same factor instead of starving the low
+// priorities. Priority 0 (commands) is not budgeted.
+void ChargerPollScheduler::updateStretch()
+{
+    uint64_t demand = 0; // bits per second * 1000
+    for (uint8_t i = 0; i < count_; i++)
+    {
+        const uint16_t period = charging_ ? specs_[i].periodChargingMs : specs_[i].periodIdleMs;
+        if (period && specs_[i].priority != 0)
+            demand += (uint64_t)costBits_ * 1000000ULL / period;
+    }
+    const uint64_t budget = (uint64_t)bitrate_ * budgetPercent_ * 10ULL; // bits per second * 1000
+    stretch256_ = demand > budget ? (uint32_t)(demand * 256 / budget) : 256;
+}
+
+uint32_t ChargerPollScheduler::periodOf(uint8_t index) const
+{
+    const uint32_t period = charging_ ? specs_[index].periodChargingMs : specs_[index].periodIdleMs;
+    return specs_[index].priority == 0 ? period : period * stretch256_ / 256;
+}
+
+bool ChargerPollScheduler::isDue(uint8_t index) const
+{
+    if (slots_[index].pending)
+        return true;
+    return periodOf(index) != 0 && (int32_t)(nowMs_ - slots_[index].nextDueMs) >= 0;
+}
+
+int ChargerPollScheduler::findFunc(uint8_t func) const
+{
+    for (uint8_t i = 0; i < count_; i++)
+    {
+        if (specs_[i].func == func)
+            return i;
+    }
+    return -1;
+}
+
+// Codes start one tick apart so equal or harmonic periods do not all land
+// on the same tick and compete for the bucket
+uint32_t ChargerPollScheduler::phaseOf(uint8_t index, uint32_t nowMs) const
+{
+    return nowMs + (uint32_t)index * CHARGER_TX_TICK_MS;
+}
+
+void ChargerPollScheduler::setCharging(bool charging, uint32_t nowMs)
+{
+    if (charging == charging_)
+        return;
+
+    uint32_t before[CHARGER_POLL_MAX_CODES];
+    for (uint8_t i = 0; i < count_; i++)
+        before[i] = periodOf(i);
+
+    charging_ = charging;
+    updateStretch();
+
+    for (uint8_t i = 0; i < count_; i++)
+    {
+        const uint32_t after = periodOf(i);
+        if (after == 0)
+            continue;
+        if (before[i] == 0)
+            slots_[i].nextDueMs = phaseOf(i, nowMs); // was on demand: deadline is stale
+        else if ((int32_t)(slots_[i].nextDueMs - (nowMs + after)) > 0)
+            slots_[i].nextDueMs = nowMs + after; // shorter period must not wait out the old one
+    }
+}
+
+void ChargerPollScheduler::requestOnce(uint8_t func)
+{
+    const int i = findFunc(func);
+    if (i >= 0)
+        slots_[i].pending = true;
+}
+
+void ChargerPollScheduler::beginTick(uint32_t nowMs)
+{
+    nowMs_ = nowMs;
+    if (!started_)
+    {
+        for (uint8_t i = 0; i < count_; i++)
+            slots_[i].nextDueMs = phaseOf(i, nowMs);
+        lastRefillMs_ = nowMs;
+        windowStartMs_ = nowMs;
+        started_ = true;
+    }
+
+    // Refill: budget% of the bit rate, carried in bit-ms so nothing is lost to rounding
+    const uint64_t acc = (uint64_t)(nowMs - lastRefillMs_) * bitrate_ * budgetPercent_ + bucketCarry_;
+    lastRefillMs_ = nowMs;
+    bucketCarry_ = (uint32_t)(acc % 100000ULL);
+    const uint64_t bits = bucketBits_ + acc / 100000ULL;
+    const uint32_t cap = CHARGER_POLL_BURST * costBits_;
+    bucketBits_ = bits > cap ? cap : (uint32_t)bits;
+
+    const uint32_t elapsed = nowMs - windowStartMs_;
+    if (elapsed >= CHARGER_POLL_STATS_WINDOW_MS)
+    {
+        for (uint8_t i = 0; i < count_; i++)
+        {
+            Slot &s = slots_[i];
+            s.stats.txHz = s.windowSent * 1000.0f / elapsed;
+            s.stats.rxHz = s.windowResp * 1000.0f / elapsed;
+            s.stats.busPercent = (float)(s.windowSent + s.windowResp) * POLL_FRAME_BITS * 100000.0f /
+                                 ((float)elapsed * bitrate_);
+            s.windowSent = 0;
+            s.windowResp = 0;
+        }
+        windowStartMs_ = nowMs;
+    }
+}
+
+int ChargerPollScheduler::pickDue()
+{
+    const bool budgetLeft = bucketBits_ >= costBits_;
+
+    int best = -1;
+    for (uint8_t i = 0; i < count_; i++)
+    {
+        if (!isDue(i) || (!budgetLeft && specs_[i].priority != 0))
+            continue;
+        if (best < 0 || specs_[i].priority < specs_[best].priority ||
+            (specs_[i].priority == specs_[best].priority &&
+             (int32_t)(slots_[i].nextDueMs - slots_[best].nextDueMs) < 0))
+            best = i;
+    }
+    return best;
+}
+
+void ChargerPollScheduler::complete(int index, bool sent)
+{
+    if (index < 0 || index >= count_)
+        return;
+    Slot &s = slots_[index];
+    const uint32_t period = periodOf(index);
+
+    if (sent)
+    {
+        bucketBits_ = bucketBits_ > costBits_ ? bucketBits_ - costBits_ : 0;
+        s.stats.sent++;
+        s.windowSent++;
+    }
+    else
+    {
+        s.stats.declined++;
+    }
+
+    if (period && (int32_t)(nowMs_ - s.nextDueMs) >= 0)
+    {
+        const uint32_t late = nowMs_ - s.nextDueMs;
+        if (sent && late > s.stats.maxLateMs)
+            s.stats.maxLateMs = late;
+        // Stay on the deadline grid; after a long stall restart from now instead of bursting
+        s.nextDueMs += period;
+        if ((int32_t)(nowMs_ - s.nextDueMs) >= 0)
+            s.nextDueMs = nowMs_ + period;
+    }
+    s.pending = false;
+}
+
+void ChargerPollScheduler::endTick()
+{
+    for (uint8_t i = 0; i < count_; i++)
+    {
+        if (isDue(i))
+            slots_[i].stats.deferred++;
+    }
+}
+
+void ChargerPollScheduler::onResponse(uint8_t func, uint32_t nowMs)
+{
+    const int i = findFunc(func);
+    if (i < 0)
+        return;
+    slots_[i].stats.responses++;
+    slots_[i].stats.lastRespMs = nowMs;
+    slots_[i].windowResp++;
+}
+
+uint8_t ChargerPollScheduler::stats(ChargerPollStats *out, uint8_t max) const
+{
+    uint8_t n = count_ < max ? count_ : max;
+    for (uint8_t i = 0; i < n; i++)
+    {
+        out[i] = slots_[i].stats;
+        out[i].periodMs = periodOf(i);
+    }
+    return n;
+}
+
+float ChargerPollScheduler::busPercent() const
+{
+    float total = 0.0f;
+    for (uint8_t i = 0; i < count_; i++)
+        total += slots_[i].stats.busPercent;
+    return total;
+}
+
+void ChargerPollScheduler::resetStats()
+{
+    for (uint8_t i = 0; i < count_; i++)
+    {
+        Slot &s = slots_[i];
+        memset(&s.stats, 0, sizeof(s.stats));
+        s.stats.func = specs_[i].func;
+        s.windowSent = 0;
+        s.windowResp = 0;
+    }
+    windowStartMs_ = nowMs_;
+}
+
+// =========================================================
+// FIRMWARE INSTANCE
+// =========================================================
+// Serviced by chargerCommTask, responses counted by the CAN dispatcher,
+// mode set by loop(): short spinlock, never held across a transmit
+static ChargerPollScheduler scheduler;
+static portMUX_TYPE pollMux = portMUX_INITIALIZER_UNLOCKED;
+
+namespace CHARGER_POLL
+{
+    void init(const ChargerPollSpec *specs, uint8_t count)
+    {
+        portENTER_CRITICAL(&pollMux);
+        scheduler.configure(specs, count, CAN1_BAUDRATE, CHARGER_POLL_BUS_BUDGET_PCT);
+        portEXIT_CRITICAL(&pollMux);
+    }
+
+    uint8_t service(BuildFn build)
+    {
+        PERF_TRACE_SCOPE(PERF_CHARGER_POLL);
+        uint8_t sent = 0;
+
+        portENTER_CRITICAL(&pollMux);
+        scheduler.beginTick(millis());
+        portEXIT_CRITICAL(&pollMux);
+
+        for (uint8_t n = 0; n < CHARGER_POLL_MAX_PER_TICK; n++)
+        {
+            ChargerPollSpec spec;
+            portENTER_CRITICAL(&pollMux);
+            const int index = scheduler.pickDue();
+            if (index >= 0)
+                spec = scheduler.spec(index);
+            portEXIT_CRITICAL(&pollMux);
+            if (index < 0)
+                break;
+
+            uint8_t data[8] = {0};
+            data[0] = 0x01;
+            data[1] = spec.func;
+            // Commands go to the safety lane; a poll still queued is superseded by this one
+            const CanTxLane lane = spec.priority == 0 ? CAN_TX_SAFETY : CAN_TX_PERIODIC;
+            const bool ok = build(spec.func, data) &&
+                            CAN_TX::send(lane, spec.reqId & 0x1FFFFFFFUL, data, 8, true, spec.func);
+
+            portENTER_CRITICAL(&pollMux);
+            scheduler.complete(index, ok);
+            portEXIT_CRITICAL(&pollMux);
+            if (ok)
+                sent++;
+        }
+
+        portENTER_CRITICAL(&pollMux);
+        scheduler.endTick();
+        portEXIT_CRITICAL(&pollMux);
+        return sent;
+    }
+
+    void setCharging(bool charging)
+    {
+        const uint32_t now = millis();
+        portENTER_CRITICAL(&pollMux);
+        scheduler.setCharging(charging, now);
+        portEXIT_CRITICAL(&pollMux);
+    }
+
+    void requestOnce(uint8_t func)
+    {
+        portENTER_CRITICAL(&pollMux);
+        scheduler.requestOnce(func);
+        portEXIT_CRITICAL(&pollMux);
+    }
+
+    void onResponse(uint8_t func)
+    {
+        const uint32_t now = millis();
+        portENTER_CRITICAL(&pollMux);
+        scheduler.onResponse(func, now);
+        portEXIT_CRITICAL(&pollMux);
+    }
+
+    void setBudgetPercent(uint8_t percent)
+    {
+        portENTER_CRITICAL(&pollMux);
+        scheduler.setBudgetPercent(percent);
+        portEXIT_CRITICAL(&pollMux);
+    }
+
+    uint8_t stats(ChargerPollStats *out, uint8_t max)
+    {
+        portENTER_CRITICAL(&pollMux);
+        const uint8_t n = scheduler.stats(out, max);
+        portEXIT_CRITICAL(&pollMux);
+        return n;
+    }
+
+    void resetStats()
+    {
+        portENTER_CRITICAL(&pollMux);
+        scheduler.resetStats();
+        portEXIT_CRITICAL(&pollMux);
+    }
+
+    void printStats()
+    {
+        ChargerPollStats s[CHARGER_POLL_MAX_CODES];
+        portENTER_CRITICAL(&pollMux);
+        const uint8_t n = scheduler.stats(s, CHARGER_POLL_MAX_CODES);
+        const bool charging = scheduler.isCharging();
+        const uint8_t budget = scheduler.budgetPercent();
+        const float bus = scheduler.busPercent();
+        const float stretch = scheduler.stretch();
+        portEXIT_CRITICAL(&pollMux);
+
+        if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100)) != pdTRUE)
+            return;
+
+        const uint32_t now = millis();
+        Serial.println("\n============ CHARGER POLL SCHEDULE ============");
+        Serial.printf("Mode: %s  Budget: %u%%  Bus used: %.2f%% (last %us)  Period stretch: x%.2f\n",
+                      charging ? "CHARGING" : "IDLE", budget, bus, CHARGER_POLL_STATS_WINDOW_MS / 1000, stretch);
+        Serial.println("func period  tx/s  rx/s  bus%   sent   resp  skip  defer late  age");
+        for (uint8_t i = 0; i < n; i++)
+        {
+            char period[16];
+            if (s[i].periodMs)
+                snprintf(period, sizeof(period), "%ums", s[i].periodMs);
+            else
+                snprintf(period, sizeof(period), "demand");
+            Serial.printf("0x%02X %-6s %5.1f %5.1f %5.2f %6u %6u %5u %6u %4u ",
+                          s[i].func, period, s[i].txHz, s[i].rxHz, s[i].busPercent,
+                          s[i].sent, s[i].responses, s[i].declined, s[i].deferred, s[i].maxLateMs);
+            if (s[i].responses)
+                Serial.printf("%ums\n", now - s[i].lastRespMs);
+            else
+                Serial.println("-");
+        }
+        Serial.println("===============================================\n");
+
+        xSemaphoreGive(serialMutex);
+    }
+
+} // namespace CHARGER_POLL
@@ -14,8 +14,17 @@
 #include "../include/ocpp_state_machine.h"
 #include "../include/security_manager.h"
 #include "../include/modules/ota_manager.h"
+#include "../include/modules/charging_core.h"
 #include "../include/drivers/can_twai_driver.h"
 #include "../include/drivers/can_mcp2515_driver.h"
+#include "../include/drivers/can_dispatcher.h"
+#include "../include/drivers/can_tx_queue.h"
+#include "../include/drivers/can_trace.h"
+#include "../include/core/telemetry.h"
+#include "../include/core/task_profiler.h"
+#include "../include/core/perf_trace.h"
+#include "../include/core/deferred_log.h"
+#include "../include/config/hardware.h"
 #include "../include/config/version.h"
 
 using namespace prod;
@@ -31,12 +40,12 @@ void ocppTask(void *pvParameters)
     // Initialize OCPP (waits for WiFi internally)
     ocpp::init();
 
-    // Main OCPP loop
+    // Main OCPP loop: blocks on the event queue between passes
     for (;;)
     {
         ocpp::poll();
         g_healthMonitor.feed();
-        vTaskDelay(pdMS_TO_TICKS(10));
+        ocpp::waitForWork();
     }
 }
 
@@ -101,7 +110,7 @@ void setup()
     BaseType_t can1RxResult = xTaskCreatePinnedToCore(
         can1_rx_task,
         "CAN1_RX",
-        6144,
+        TASK_STACK_SIZE_CAN_RX,
         nullptr,
         8,
         &can1RxHandle,
@@ -114,6 +123,7 @@ void setup()
     else
     {
         g_healthMonitor.addTaskToWatchdog(can1RxHandle, "CAN1_RX");
+        TASK_PROFILER::track(can1RxHandle, TASK_STACK_SIZE_CAN_RX);
     }
 
     // Create CAN2 RX task (BMS) - HIGH PRIORITY (priority 8)
@@ -121,7 +131,7 @@ void setup()
     BaseType_t can2RxResult = xTaskCreatePinnedToCore(
         can2_rx_task,
         "CAN2_RX",
-        6144,
+        TASK_STACK_SIZE_CAN_RX,
         nullptr,
         8,
         &can2RxHandle,
@@ -134,14 +144,82 @@ void setup()
     else
     {
         g_healthMonitor.addTaskToWatchdog(can2RxHandle, "CAN2_RX");
+        TASK_PROFILER::track(can2RxHandle, TASK_STACK_SIZE_CAN_RX);
+    }
+
+    // Create CAN1 TX task (Charger) - HIGH PRIORITY (priority 8)
+    // Drains the CAN_TX lanes; senders never block on the controller
+    TaskHandle_t can1TxHandle = nullptr;
+    BaseType_t can1TxResult = xTaskCreatePinnedToCore(
+        can1_tx_task,
+        "CAN1_TX",
+        TASK_STACK_SIZE_CAN_TX,
+        nullptr,
+        8,
+        &can1TxHandle,
+        1);
+
+    if (can1TxResult != pdPASS)
+    {
+        Serial.println("[CRITICAL] Failed to create CAN1_TX task!");
+    }
+    else
+    {
+        g_healthMonitor.addTaskToWatchdog(can1TxHandle, "CAN1_TX");
+        TASK_PROFILER::track(can1TxHandle, TASK_STACK_SIZE_CAN_TX);
+    }
+
+    // Create CAN1 alert task - HIGH PRIORITY (priority 9)
+    // Recovers bus-off in place (twai_initiate_recovery) instead of reinstalling the driver
+    TaskHandle_t can1AlertHandle = nullptr;
+    BaseType_t can1AlertResult = xTaskCreatePinnedToCore(
+        can1_alert_task,
+        "CAN1_ALERT",
+        TASK_STACK_SIZE_CAN_ALERT,
+        nullptr,
+        9,
+        &can1AlertHandle,
+        1);
+
+    if (can1AlertResult != pdPASS)
+    {
+        Serial.println("[CRITICAL] Failed to create CAN1_ALERT task!");
+    }
+    else
+    {
+        g_healthMonitor.addTaskToWatchdog(can1AlertHandle, "CAN1_ALERT");
+        TASK_PROFILER::track(can1AlertHandle, TASK_STACK_SIZE_CAN_ALERT);
+    }
+
+    // Create CAN dispatcher task - HIGH PRIORITY (priority 7)
+    // Woken by the RX tasks, decodes frames as soon as they land in the ring
+    TaskHandle_t dispatchHandle = nullptr;
+    BaseType_t dispatchResult = xTaskCreatePinnedToCore(
+        canDispatchTask,
+        "CAN_DISPATCH",
+        TASK_STACK_SIZE_CAN_DISPATCH,
+        nullptr,
+        7,
+        &dispatchHandle,
+        1);
+
+    if (dispatchResult != pdPASS)
+    {
+        Serial.println("[CRITICAL] Failed to create CAN_DISPATCH task!");
+    }
+    else
+    {
+        g_healthMonitor.addTaskToWatchdog(dispatchHandle, "CAN_DISPATCH");
+        TASK_PROFILER::track(dispatchHandle, TASK_STACK_SIZE_CAN_DISPATCH);
     }
 
     // Create charger communication task - HIGH PRIORITY (priority 7)
+    // Periodic TX schedule only (timer driven)
     TaskHandle_t chargerHandle = nullptr;
     BaseType_t chargerResult = xTaskCreatePinnedToCore(
         chargerCommTask,
         "CHARGER_COMM",
-        6144, // Increased from 4096 to prevent stack overflow
+        TASK_STACK_SIZE_CHARGER_COMM, // Increased from 4096 to prevent stack overflow
         nullptr,
         7, // Increased from 4 - safety-critical
         &chargerHandle,
@@ -155,13 +233,14 @@ void setup()
     {
         // SAFETY: Add to watchdog
         g_healthMonitor.addTaskToWatchdog(chargerHandle, "CHARGER_COMM");
+        TASK_PROFILER::track(chargerHandle, TASK_STACK_SIZE_CHARGER_COMM);
     }
 
     // FIX #3: Create OCPP task on Core 0 - MEDIUM PRIORITY (priority 3)
     BaseType_t ocppResult = xTaskCreatePinnedToCore(
         ocppTask,
         "OCPP_LOOP",
-        10240, // Increased from 8192 for WebSocket + TLS overhead
+        TASK_STACK_SIZE_OCPP, // Increased from 8192 for WebSocket + TLS overhead
         nullptr,
         3, // Lower priority than CAN, but dedicated to avoid blocking
         &ocppTaskHandle,
@@ -171,8 +250,13 @@ void setup()
     {
         Serial.println("[CRITICAL] Failed to create OCPP_LOOP task!");
     }
+    else
+    {
+        TASK_PROFILER::track(ocppTaskHandle, TASK_STACK_SIZE_OCPP);
+    }
 
     // Create UI task for serial menu - LOWEST PRIORITY
+    TaskHandle_t uiHandle = nullptr;
     BaseType_t uiResult = xTaskCreatePinnedToCore(
         [](void *arg)
         {
@@ -180,6 +264,7 @@ void setup()
             while (true)
             {
                 processSerialInput();
+                CAN_TRACE::pollStream();
                 if (!menuPrinted)
                 {
                     printMenu();
@@ -189,16 +274,33 @@ void setup()
             }
         },
         "UI_TASK",
-        4096,
+        TASK_STACK_SIZE_UI,
         nullptr,
         2,
-        nullptr,
+        &uiHandle,
         1);
     
     if (uiResult != pdPASS)
     {
         Serial.println("[CRITICAL] Failed to create UI_TASK!");
     }
+    else
+    {
+        TASK_PROFILER::track(uiHandle, TASK_STACK_SIZE_UI);
+    }
+
+    // Hot-path log lines are printed from here (console 'g')
+    if (!DEFERRED_LOG::init())
+    {
+        Serial.println("[CRITICAL] Failed to create LOG task!");
+    }
+
+    // Per-task CPU / stack sampling (console 'c', Diagnostics DataTransfer)
+    TASK_PROFILER::track(xTaskGetCurrentTaskHandle(), getArduinoLoopTaskStackSize());
+    if (!TASK_PROFILER::init())
+    {
+        Serial.println("[System] ⚠️  Task profiler timer not started");
+    }
 
     // Initialize WiFi with auto-reconnect
     Serial.println("[System] 📡 Initializing WiFi...");
@@ -230,14 +332,11 @@ void setup()
     Serial.println("[System] ✅ All systems initialized!\n");
 }
 
-void loop()
+// One pass of loop() once OCPP is up, without the yield (timed as PERF_MAIN_LOOP)
+static void loopOnce()
 {
-    // CRITICAL: Wait for OCPP initialization before accessing connector 1
-    if (!ocppInitialized) {
-        vTaskDelay(pdMS_TO_TICKS(100));
-        return;
-    }
-    
+    PERF_TRACE_SCOPE(PERF_MAIN_LOOP);
+
     // CRITICAL: Feed watchdog for loop task
     g_healthMonitor.feed();
     
@@ -251,259 +350,8 @@ void loop()
     // Poll OCPP state machine (deadlock prevention, timeout handling)
     g_ocppStateMachine.poll();
 
-    // HYBRID PLUG DISCONNECT DETECTION (Option 4)
-    static unsigned long lastPlugCheck = 0;
-    static unsigned long zeroCurrentStart = 0;
-    static float lastVoltageCheck = 0.0f;
-    static unsigned long lastVoltageTime = 0;
-    
-    if (millis() - lastPlugCheck >= 500)
-    {
-        bool shouldDisconnect = false;
-        
-        // Method 1: BMS timeout (3 seconds) - Most reliable
-        if ((gunPhysicallyConnected || batteryConnected) && (millis() - lastBMS > 3000))
-        {
-            Serial.println("[PLUG] 🔌 Disconnected: BMS timeout (3s)");
-            shouldDisconnect = true;
-        }
-        
-        // Method 2: Zero current timeout - ONLY during active charging
-        if (transactionActive && chargingEnabled && 
-            terminalVolt > 56.0f && terminalCurr < 0.5f)
-        {
-            if (zeroCurrentStart == 0)
-            {
-                zeroCurrentStart = millis();
-            }
-            else if (millis() - zeroCurrentStart > 5000)
-            {
-                Serial.println("[PLUG] 🔌 Disconnected: Zero current during charging (5s)");
-                shouldDisconnect = true;
-            }
-        }
-        else
-        {
-            zeroCurrentStart = 0;
-        }
-        
-        // Method 3: Voltage drop rate (>2V/s)
-        if (terminalVolt > 10.0f)
-        {
-            if (lastVoltageTime > 0)
-            {
-                float deltaV = lastVoltageCheck - terminalVolt;
-                float deltaT = (millis() - lastVoltageTime) / 1000.0f;
-                if (deltaT > 0.5f && (deltaV / deltaT) > 2.0f)
-                {
-                    Serial.printf("[PLUG] 🔌 Disconnected: Fast voltage drop (%.1fV/s)\n", deltaV / deltaT);
-                    shouldDisconnect = true;
-                }
-            }
-            lastVoltageCheck = terminalVolt;
-            lastVoltageTime = millis();
-        }
-        else
-        {
-            // Reset tracking when voltage too low
-            lastVoltageCheck = 0.0f;
-            lastVoltageTime = 0;
-        }
-        
-        // Execute disconnect
-        if (shouldDisconnect && (gunPhysicallyConnected || batteryConnected))
-        {
-            gunPhysicallyConnected = false;
-            batteryConnected = false;
-            zeroCurrentStart = 0;
-            Serial.println("[PLUG] ✅ Status: DISCONNECTED");
-            
-            // Only stop transaction if one is actually running
-            if (transactionActive && isTransactionRunning(1)) {
-                Serial.printf("[PLUG] 🛑 Stopping transaction due to EV disconnect (txId=%d)\n", activeTransactionId);
-                endTransaction(nullptr, "EVDisconnected");
-            } else {
-                Serial.println("[PLUG] ℹ️  No active transaction - just updating status to Available");
-            }
-        }
-        
-        lastPlugCheck = millis();
-    }
-
-    // Monitor plug connection state changes
-    static bool lastPlugState = false;
-    bool currentPlugState = (gunPhysicallyConnected && batteryConnected);
-    
-    if (currentPlugState != lastPlugState)
-    {
-        if (currentPlugState)
-        {
-            Serial.println("[PLUG] 🔌 Gun plugged, vehicle detected");
-        }
-        lastPlugState = currentPlugState;
-    }
-    
-    // Send VehicleInfo for pay-and-charge: User needs vehicle data BEFORE RemoteStart
-    // to calculate charging cost and choose charging options
-    static unsigned long lastVehicleInfoSent = 0;
-    static bool firstSendDone = false;
-    
-    // Send when EV connected in Preparing state (waiting for user to start charging)
-    // Stop when transaction starts (RemoteStart accepted)
-    bool shouldSendVehicleInfo = (
-        batteryConnected && 
-        gunPhysicallyConnected && 
-        !transactionActive &&  // No transaction started yet
-        !isTransactionRunning(1) &&  // Double-check no active transaction
-        BMS_Imax > 0.0f && 
-        terminalVolt > 56.0f &&
-        socPercent > 0.0f  // Valid SOC data
-    );
-    
-    if (shouldSendVehicleInfo)
-    {
-        // Fast updates: 3s first time, then 5s interval for real-time data
-        unsigned long interval = firstSendDone ? 5000 : 3000;
-        
-        if (millis() - lastVehicleInfoSent >= interval)
-        {
-            ocpp::sendVehicleInfo(socPercent, BMS_Imax, terminalVolt, terminalCurr, chargerTemp, vehicleModel, rangeKm);
-            lastVehicleInfoSent = millis();
-            firstSendDone = true;
-        }
-    }
-    else
-    {
-        // Reset when conditions not met
-        if (transactionActive || isTransactionRunning(1) || !batteryConnected) {
-            lastVehicleInfoSent = 0;
-            firstSendDone = false;
-        }
-    }
-
-    // SAFETY: Monitor BMS charging permission (100ms check)
-    static bool lastBmsSafeToCharge = false;
-    static unsigned long lastBmsSafetyCheck = 0;
-    
-    if (millis() - lastBmsSafetyCheck >= 100)
-    {
-        if (bmsSafeToCharge != lastBmsSafeToCharge)
-        {
-            if (!bmsSafeToCharge)
-            {
-                Serial.println("[SAFETY] 🚨 BMS CHARGING DISABLED!");
-                
-                if (transactionActive && isTransactionRunning(1))
-                {
-                    Serial.printf("[SAFETY] 🚨 EMERGENCY STOP - BMS switched OFF during charging (txId=%d)\n", activeTransactionId);
-                    ocpp::sendBMSAlert("BMS_EMERGENCY_STOP", "BMS disabled charging during transaction");
-                    endTransaction(nullptr, "EmergencyStop");
-                }
-                else
-                {
-                    ocpp::sendBMSAlert("BMS_CHARGING_DISABLED", "BMS not ready for charging");
-                }
-            }
-            else
-            {
-                Serial.println("[SAFETY] ✅ BMS charging enabled");
-                ocpp::sendBMSAlert("BMS_CHARGING_ENABLED", "BMS ready for charging");
-            }
-            lastBmsSafeToCharge = bmsSafeToCharge;
-        }
-        
-        lastBmsSafetyCheck = millis();
-    }
-
-    // Accumulate energy when charging - use terminal values with validation
-    static unsigned long lastEnergyTime = millis();
-    static unsigned long lastChargerHealthCheck = 0;
-    
-    if (millis() - lastChargerHealthCheck >= 2000)
-    {
-        bool chargerHealthy = isChargerModuleHealthy();
-        static bool lastChargerHealthy = false;
-        static bool firstCheck = true;
-        
-        // Detect health state change (skip logging on first check)
-        if (!firstCheck && chargerHealthy != lastChargerHealthy)
-        {
-            if (!chargerHealthy)
-            {
-                Serial.println("\n[CHARGER] ❌ CRITICAL: Charger module communication lost!");
-                Serial.println("[CHARGER] ⚠️  Possible causes:");
-                Serial.println("[CHARGER]    - Charger PCB powered OFF");
-                Serial.println("[CHARGER]    - CAN bus disconnected");
-                Serial.println("[CHARGER]    - Hardware fault");
-                Serial.printf("[CHARGER] 🔍 Last messages: TermPower=%lums TermStatus=%lums Heartbeat=%lums ago\n",
-                             millis() - lastTerminalPower,
-                             millis() - lastTerminalStatus,
-                             millis() - lastHeartbeat);
-                
-                // CRITICAL: Force connector to Unavailable
-                Serial.println("[OCPP] 🚨 Forcing connector to Unavailable");
-                // MicroOcpp will automatically update based on setEvseReadyInput
-            }
-            else
-            {
-                Serial.println("\n[CHARGER] ✅ Charger module communication restored!");
-                Serial.println("[OCPP] ✅ Connector now Available");
-            }
-            
-            lastChargerHealthy = chargerHealthy;
-        }
-        
-        if (firstCheck)
-        {
-            lastChargerHealthy = chargerHealthy;
-            firstCheck = false;
-        }
-        
-        // If charging enabled but charger offline, stop transaction
-        if (chargingEnabled && !chargerHealthy)
-        {
-            if (transactionActive && isTransactionRunning(1))
-            {
-                Serial.printf("[CHARGER] 🚨 SAFETY: Charger offline during transaction (txId=%d)\n", activeTransactionId);
-                Serial.println("[CHARGER] 🔍 Check: CAN bus, charger power, hardware connection");
-                endTransaction(nullptr, "EVSEFailure");
-            }
-        }
-        
-        lastChargerHealthCheck = millis();
-    }
-    
-    // FINAL FIX: HARD GATE without txId check
-    // Golden Rule: OCPP authorization comes from StartTransaction acceptance, NOT txId
-    bool ocppAllows = ocppPermitsCharge(1);
-    bool canCharge = (
-        ocppAllows &&           // OCPP must permit FIRST
-        transactionActive &&    // Transaction started
-        chargingEnabled         // Hardware enabled by OCPP callback
-    );
-    
-    // Only accumulate energy if HARD GATE is open AND hardware conditions valid
-    if (canCharge && 
-        terminalVolt > 56.0f && terminalVolt < 85.5f && 
-        terminalCurr > 0.0f && terminalCurr < 300.0f)
-    {
-        unsigned long now = millis();
-        float dt_hours = (now - lastEnergyTime) / 3600000.0f;
-        float energyDelta = terminalVolt * terminalCurr * dt_hours;
-        
-        // Only add positive energy increments with mutex protection
-        if (energyDelta > 0.0f && energyDelta < 1000.0f) {
-            if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-                energyWh += energyDelta;
-                xSemaphoreGive(dataMutex);
-            }
-        }
-        lastEnergyTime = now;
-    }
-    else
-    {
-        lastEnergyTime = millis();
-    }
+    // Plug detection, BMS/charger safety supervision, energy accumulation
+    ChargingCore::poll();
 
     // Debug output every 10 seconds - display terminal values
     static unsigned long lastDebug = 0;
@@ -515,31 +363,44 @@ void loop()
         bool txRunning = isTransactionRunning(1);  // Actively running
         bool chargerHealthy = isChargerModuleHealthy();
         bool ocppPermits = ocppPermitsCharge(1);
-
-        Serial.printf("\n[Status] Uptime: %us | WiFi: %s | OCPP: %s | State: %s\n",
-                      g_healthMonitor.getUptimeSeconds(),
-                      g_wifiManager.isConnected() ? "✅" : "❌",
-                      ocppConnected ? "Connected" : "Disconnected",
-                      g_ocppStateMachine.getStateName());
-        Serial.printf("[Metrics] V=%.1fV I=%.1fA SOC=%.1f%% Range=%.1fkm Temp=%.1f°C Energy=%.2fWh (meter=%d)\n",
-                      terminalVolt, terminalCurr, socPercent, rangeKm, chargerTemp, energyWh, (int)energyWh);
+        const TelemetrySnapshot snap = TELEMETRY::snapshot();
+
+        DLOG("\n[Status] Uptime: %us | WiFi: %s | OCPP: %s | State: %s\n",
+             g_healthMonitor.getUptimeSeconds(),
+             g_wifiManager.isConnected() ? "✅" : "❌",
+             ocppConnected ? "Connected" : "Disconnected",
+             g_ocppStateMachine.getStateName());
+        DLOG("[Metrics] V=%.1fV I=%.1fA SOC=%.1f%% Range=%.1fkm Temp=%.1f°C Energy=%.2fWh (meter=%d)\n",
+             snap.charger.terminalVolt, snap.charger.terminalCurr, snap.bms.socPercent,
+             snap.bms.rangeKm, snap.charger.outputTemp, energyWh, (int)energyWh);
         
         const char* modelName = "Unknown";
-        if (vehicleModel == 1) modelName = "Classic";
-        else if (vehicleModel == 2) modelName = "Pro";
-        else if (vehicleModel == 3) modelName = "Max";
+        if (snap.bms.vehicleModel == 1) modelName = "Classic";
+        else if (snap.bms.vehicleModel == 2) modelName = "Pro";
+        else if (snap.bms.vehicleModel == 3) modelName = "Max";
         
-        Serial.printf("[Vehicle] Model=%s | Capacity=%.0fAh | BMS_Imax=%.1fA\n",
-                      modelName, batteryAh, BMS_Imax);
-        Serial.printf("[Charger] Module=%s | Enabled=%s | TX=%s/%s | Current=%s | OCPP=%s\n",
-                      chargerHealthy ? "ONLINE" : "OFFLINE",
-                      chargingEnabled ? "YES" : "NO",
-                      txActive ? "ACTIVE" : "IDLE",
-                      txRunning ? "RUNNING" : "STOPPED",
-                      (terminalCurr > 1.0f) ? "FLOWING" : "ZERO",
-                      ocppPermits ? "PERMITS" : "BLOCKS");
+        DLOG("[Vehicle] Model=%s | Capacity=%.0fAh | BMS_Imax=%.1fA\n",
+             modelName, snap.bms.batteryAh, snap.bms.imax);
+        DLOG("[Charger] Module=%s | Enabled=%s | TX=%s/%s | Current=%s | OCPP=%s\n",
+             chargerHealthy ? "ONLINE" : "OFFLINE",
+             chargingEnabled ? "YES" : "NO",
+             txActive ? "ACTIVE" : "IDLE",
+             txRunning ? "RUNNING" : "STOPPED",
+             (snap.charger.terminalCurr > 1.0f) ? "FLOWING" : "ZERO",
+             ocppPermits ? "PERMITS" : "BLOCKS");
         lastDebug = millis();
     }
+}
+
+void loop()
+{
+    // CRITICAL: Wait for OCPP initialization before accessing connector 1
+    if (!ocppInitialized) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+        return;
+    }
+
+    loopOnce();
 
     // FIX #5: Yield to prevent watchdog timeout
     vTaskDelay(pdMS_TO_TICKS(10));
@@ -0,0 +1,350 @@
+#include "../../include/modules/charging_core.h"
+#include "../../include/header.h"
+#include "../../include/core/telemetry.h"
+#include "../../include/core/energy_meter.h"
+#include "../../include/core/telemetry_frame.h"
+#include "../../include/core/perf_trace.h"
+#include "../../include/core/deferred_log.h"
+#include "../../include/drivers/charger_poll.h"
+#include "../../include/ocpp/ocpp_client.h"
+#include <Arduino.h>
+#include <MicroOcpp.h>
+
+// HYBRID PLUG DISCONNECT DETECTION state
+static unsigned long lastPlugCheck = 0;
+static unsigned long zeroCurrentStart = 0;
+static float lastVoltageCheck = 0.0f;
+static uint64_t lastVoltageRxUs = 0; // RX time of the lastVoltageCheck sample
+static bool lastPlugState = false;
+
+// VehicleInfo publishing state
+static VehicleInfoBatch vehicleInfoBatch;
+static unsigned long lastVehicleInfoSample = 0;
+static bool firstSendDone = false;
+
+// BMS permission monitor state
+static bool lastBmsSafeToCharge = false;
+static unsigned long lastBmsSafetyCheck = 0;
+
+// Charger health state
+static unsigned long lastChargerHealthCheck = 0;
+static bool lastChargerHealthy = false;
+static bool firstHealthCheck = true;
+
+// HYBRID PLUG DISCONNECT DETECTION (Option 4)
+static void checkPlugDisconnect()
+{
+    if (millis() - lastPlugCheck < 500)
+        return;
+
+    bool shouldDisconnect = false;
+    const ChargerTelemetry t = TELEMETRY::charger();
+
+    // Method 1: BMS timeout (3 seconds since the last frame showing the pack) - Most reliable
+    if ((gunPhysicallyConnected || batteryConnected) && TELEMETRY::ageMs(TSIG_BATTERY_PRESENT) > 3000)
+    {
+        DLOG("[PLUG] 🔌 Disconnected: BMS timeout (3s)\n");
+        shouldDisconnect = true;
+    }
+
+    // Method 2: Zero current timeout - ONLY during active charging
+    if (transactionActive && chargingEnabled &&
+        t.terminalVolt > 56.0f && t.terminalCurr < 0.5f)
+    {
+        if (zeroCurrentStart == 0)
+        {
+            zeroCurrentStart = millis();
+        }
+        else if (millis() - zeroCurrentStart > 5000)
+        {
+            DLOG("[PLUG] 🔌 Disconnected: Zero current during charging (5s)\n");
+            shouldDisconnect = true;
+        }
+    }
+    else
+    {
+        zeroCurrentStart = 0;
+    }
+
+    // Method 3: Voltage drop rate (>2V/s) between terminal samples at least
+    // 0.5 s apart, timed by their RX times (the snapshot carries V with its
+    // frame's timestamp, so a sample seen twice or late does not skew dV/dt)
+    if (t.terminalVolt > 10.0f && t.terminalRxUs != 0)
+    {
+        if (lastVoltageRxUs == 0)
+        {
+            lastVoltageCheck = t.terminalVolt;
+            lastVoltageRxUs = t.terminalRxUs;
+        }
+        else if (t.terminalRxUs > lastVoltageRxUs)
+        {
+            float deltaV = lastVoltageCheck - t.terminalVolt;
+            float deltaT = (float)(t.terminalRxUs - lastVoltageRxUs) / 1000000.0f;
+            if (deltaT > 0.5f)
+            {
+                if ((deltaV / deltaT) > 2.0f)
+                {
+                    DLOG("[PLUG] 🔌 Disconnected: Fast voltage drop (%.1fV/s)\n", deltaV / deltaT);
+                    shouldDisconnect = true;
+                }
+                lastVoltageCheck = t.terminalVolt;
+                lastVoltageRxUs = t.terminalRxUs;
+            }
+        }
+    }
+    else
+    {
+        // Reset tracking when voltage too low
+        lastVoltageCheck = 0.0f;
+        lastVoltageRxUs = 0;
+    }
+
+    // Execute disconnect
+    if (shouldDisconnect && (gunPhysicallyConnected || batteryConnected))
+    {
+        gunPhysicallyConnected = false;
+        batteryConnected = false;
+        zeroCurrentStart = 0;
+        DLOG("[PLUG] ✅ Status: DISCONNECTED\n");
+
+        // Only stop transaction if one is actually running
+        if (transactionActive && isTransactionRunning(1)) {
+            DLOG("[PLUG] 🛑 Stopping transaction due to EV disconnect (txId=%d)\n", activeTransactionId);
+            endTransaction(nullptr, "EVDisconnected");
+        } else {
+            DLOG("[PLUG] ℹ️  No active transaction - just updating status to Available\n");
+        }
+    }
+
+    lastPlugCheck = millis();
+}
+
+// Monitor plug connection state changes
+static void trackPlugState()
+{
+    bool currentPlugState = (gunPhysicallyConnected && batteryConnected);
+
+    if (currentPlugState != lastPlugState)
+    {
+        if (currentPlugState)
+        {
+            DLOG("[PLUG] 🔌 Gun plugged, vehicle detected\n");
+        }
+        lastPlugState = currentPlugState;
+        ocpp::notifyPlugChanged(currentPlugState);
+    }
+}
+
+// Handed to the OCPP task: sending or queueing to flash must not hold up this loop
+static void flushVehicleInfo()
+{
+    if (!vehicleInfoBatch.empty())
+        ocpp::notifyVehicleInfo(vehicleInfoBatch);
+    vehicleInfoBatch.clear();
+}
+
+// Send VehicleInfo for pay-and-charge: User needs vehicle data BEFORE RemoteStart
+// to calculate charging cost and choose charging options
+static void publishVehicleInfo()
+{
+    // Send when EV connected in Preparing state (waiting for user to start charging)
+    // Stop when transaction starts (RemoteStart accepted)
+    const TelemetrySnapshot snap = TELEMETRY::snapshot();
+    bool shouldSendVehicleInfo = (
+        batteryConnected &&
+        gunPhysicallyConnected &&
+        !transactionActive &&  // No transaction started yet
+        !isTransactionRunning(1) &&  // Double-check no active transaction
+        snap.bms.imax > 0.0f &&
+        snap.charger.terminalVolt > 56.0f &&
+        snap.bms.socPercent > 0.0f  // Valid SOC data
+    );
+
+    if (shouldSendVehicleInfo)
+    {
+        // Fast first sample, then one every VEHICLE_INFO_SAMPLE_MS
+        unsigned long interval = firstSendDone ? VEHICLE_INFO_SAMPLE_MS : VEHICLE_INFO_FIRST_MS;
+
+        if (millis() - lastVehicleInfoSample >= interval)
+        {
+            const VehicleSample sample = {(uint32_t)millis(), snap.bms.socPercent, snap.bms.imax, snap.charger.terminalVolt,
+                                          snap.charger.terminalCurr, snap.charger.outputTemp, snap.bms.rangeKm};
+            const uint8_t model = (uint8_t)snap.bms.vehicleModel;
+            if (!vehicleInfoBatch.add(model, sample))
+            {
+                flushVehicleInfo(); // model changed
+                vehicleInfoBatch.add(model, sample);
+            }
+            // The first sample goes out alone: the user needs it before RemoteStart
+            if (!firstSendDone || vehicleInfoBatch.full())
+                flushVehicleInfo();
+            lastVehicleInfoSample = millis();
+            firstSendDone = true;
+        }
+    }
+    else
+    {
+        // Reset when conditions not met
+        if (transactionActive || isTransactionRunning(1) || !batteryConnected) {
+            // Samples up to the start still describe this vehicle; after an unplug they don't
+            if (batteryConnected)
+                flushVehicleInfo();
+            else
+                vehicleInfoBatch.clear();
+            lastVehicleInfoSample = 0;
+            firstSendDone = false;
+        }
+    }
+}
+
+// SAFETY: Monitor BMS charging permission (100ms check)
+static void monitorBmsPermission()
+{
+    if (millis() - lastBmsSafetyCheck < 100)
+        return;
+
+    if (bmsSafeToCharge != lastBmsSafeToCharge)
+    {
+        if (!bmsSafeToCharge)
+        {
+            DLOG("[SAFETY] 🚨 BMS CHARGING DISABLED!\n");
+
+            if (transactionActive && isTransactionRunning(1))
+            {
+                DLOG("[SAFETY] 🚨 EMERGENCY STOP - BMS switched OFF during charging (txId=%d)\n", activeTransactionId);
+                ocpp::notifyBMSAlert("BMS_EMERGENCY_STOP", "BMS disabled charging during transaction");
+                endTransaction(nullptr, "EmergencyStop");
+            }
+            else
+            {
+                ocpp::notifyBMSAlert("BMS_CHARGING_DISABLED", "BMS not ready for charging");
+            }
+        }
+        else
+        {
+            DLOG("[SAFETY] ✅ BMS charging enabled\n");
+            ocpp::notifyBMSAlert("BMS_CHARGING_ENABLED", "BMS ready for charging");
+        }
+        lastBmsSafeToCharge = bmsSafeToCharge;
+    }
+
+    lastBmsSafetyCheck = millis();
+}
+
+// Charger module health supervision (2s check)
+static void monitorChargerHealth()
+{
+    if (millis() - lastChargerHealthCheck < 2000)
+        return;
+
+    bool chargerHealthy = isChargerModuleHealthy();
+
+    // Detect health state change (skip logging on first check)
+    if (!firstHealthCheck && chargerHealthy != lastChargerHealthy)
+    {
+        if (!chargerHealthy)
+        {
+            DLOG("\n[CHARGER] ❌ CRITICAL: Charger module communication lost!\n");
+            DLOG("[CHARGER] ⚠️  Possible causes:\n");
+            DLOG("[CHARGER]    - Charger PCB powered OFF\n");
+            DLOG("[CHARGER]    - CAN bus disconnected\n");
+            DLOG("[CHARGER]    - Hardware fault\n");
+            DLOG("[CHARGER] 🔍 Last messages: TermPower=%lums TermStatus=%lums Heartbeat=%lums ago\n",
+                 (unsigned long)TELEMETRY::ageMs(TSIG_TERMINAL_POWER),
+                 (unsigned long)TELEMETRY::ageMs(TSIG_TERMINAL_STATUS),
+                 (unsigned long)TELEMETRY::ageMs(TSIG_HEARTBEAT));
+
+            // CRITICAL: Force connector to Unavailable
+            DLOG("[OCPP] 🚨 Forcing connector to Unavailable\n");
+            // MicroOcpp will automatically update based on setEvseReadyInput
+        }
+        else
+        {
+            DLOG("\n[CHARGER] ✅ Charger module communication restored!\n");
+            DLOG("[OCPP] ✅ Connector now Available\n");
+        }
+
+        lastChargerHealthy = chargerHealthy;
+        ocpp::notifyChargerHealth(chargerHealthy);
+    }
+
+    if (firstHealthCheck)
+    {
+        lastChargerHealthy = chargerHealthy;
+        firstHealthCheck = false;
+        if (!chargerHealthy)
+            ocpp::notifyChargerHealth(false); // offline from boot
+    }
+
+    // If charging enabled but charger offline, stop transaction
+    if (chargingEnabled && !chargerHealthy)
+    {
+        if (transactionActive && isTransactionRunning(1))
+        {
+            DLOG("[CHARGER] 🚨 SAFETY: Charger offline during transaction (txId=%d)\n", activeTransactionId);
+            DLOG("[CHARGER] 🔍 Check: CAN bus, charger power, hardware connection\n");
+            endTransaction(nullptr, "EVSEFailure");
+        }
+    }
+
+    lastChargerHealthCheck = millis();
+}
+
+// Gate the energy meter: frames are integrated by ENERGY_METER on their own
+// RX timestamps, this only decides whether the session is billable
+static void accumulateEnergy()
+{
+    // FINAL FIX: HARD GATE without txId check
+    // Golden Rule: OCPP authorization comes from StartTransaction acceptance, NOT txId
+    bool ocppAllows = ocppPermitsCharge(1);
+    bool canCharge = (
+        ocppAllows &&           // OCPP must permit FIRST
+        transactionActive &&    // Transaction started
+        chargingEnabled         // Hardware enabled by OCPP callback
+    );
+    ENERGY_METER::setMetering(canCharge);
+    CHARGER_POLL::setCharging(canCharge);
+
+    // Mirror for the console and status lines
+    const float wh = (float)ENERGY_METER::energyWh();
+    if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        energyWh = wh;
+        xSemaphoreGive(dataMutex);
+    }
+}
+
+namespace ChargingCore
+{
+
+    void poll()
+    {
+        PERF_TRACE_SCOPE(PERF_CHARGING_CORE);
+        checkPlugDisconnect();
+        trackPlugState();
+        publishVehicleInfo();
+        monitorBmsPermission();
+        monitorChargerHealth();
+        accumulateEnergy();
+    }
+
+    void reset()
+    {
+        lastPlugCheck = 0;
+        zeroCurrentStart = 0;
+        lastVoltageCheck = 0.0f;
+        lastVoltageRxUs = 0;
+        lastPlugState = false;
+
+        vehicleInfoBatch.clear();
+        lastVehicleInfoSample = 0;
+        firstSendDone = false;
+
+        lastBmsSafeToCharge = false;
+        lastBmsSafetyCheck = 0;
+
+        lastChargerHealthCheck = 0;
+        lastChargerHealthy = false;
+        firstHealthCheck = true;
+    }
+
+} // namespace ChargingCore
@@ -10,6 +10,12 @@
 #include "../../include/header.h"
 #include "../../include/modules/ota_manager.h"
 #include "../../include/ocpp_state_machine.h"
+#include "../../include/core/telemetry.h"
+#include "../../include/core/energy_meter.h"
+#include "../../include/core/datatransfer_payload.h"
+#include "../../include/core/ocpp_outbox.h"
+#include "../../include/core/ocpp_events.h"
+#include "../../include/core/perf_trace.h"
 #include <MicroOcpp/Core/Context.h>
 #include <MicroOcpp/Model/Model.h>
 #include <MicroOcpp/Model/FirmwareManagement/FirmwareService.h>
@@ -18,21 +24,29 @@
 extern bool gunPhysicallyConnected;
 extern bool chargingEnabled;
 extern float energyWh;
-extern float terminalVolt;  // FIXED: Use terminal values (real measurements)
-extern float terminalCurr;  // FIXED: Use terminal values (real measurements)
 extern bool batteryConnected;
-extern float batteryAh;
-extern float BMS_Imax;
-extern float chargerTemp;
-extern float socPercent;    // SOC percentage
-extern float rangeKm;       // Range in km
-extern uint8_t vehicleModel;    // Vehicle model (1=Classic, 2=Pro, 3=Max)
 
 // Charger health check
 extern bool isChargerModuleHealthy();
 
 using namespace prod;
 
+// MicroOcpp samples each measurand through its own callback; sharing one
+// snapshot for a short window keeps V, I, SOC and T of a sample coherent.
+static const TelemetrySnapshot &meterSnapshot()
+{
+    static TelemetrySnapshot snap = {};
+    static unsigned long takenAt = 0;
+    static bool taken = false;
+    if (!taken || millis() - takenAt >= 200)
+    {
+        snap = TELEMETRY::snapshot();
+        takenAt = millis();
+        taken = true;
+    }
+    return snap;
+}
+
 // Transaction tracking and lock
 static unsigned long txStartTime = 0;
 static bool transactionLocked = false;
@@ -42,6 +56,11 @@ void ocpp::init()
 {
     Serial.println("[OCPP] 🔌 Initializing OCPP...");
 
+    // Before the WiFi wait: other tasks post events from boot on, and
+    // messages staged while offline go to flash
+    OCPP_EVENTS::init();
+    OCPP_OUTBOX::init();
+
     // Wait for WiFi
     uint32_t wifiWaitStart = millis();
     while (WiFi.status() != WL_CONNECTED)
@@ -67,28 +86,19 @@ void ocpp::init()
     // CRITICAL: Configure all inputs AFTER mocpp_initialize()
     Serial.println("[OCPP] 📋 Registering input callbacks...");
     
-    // Energy meter with validation - ALWAYS return non-negative
+    // Energy register (integer Wh): rounded from the per-frame integrator
     setEnergyMeterInput([]() {
-        int energyInt = 0;
-        if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-            // Ensure energyWh is never negative
-            if (energyWh < 0.0f) {
-                energyWh = 0.0f;
-            }
-            // Return as integer Wh (OCPP expects Wh, not kWh)
-            energyInt = (int)energyWh;
-            if (energyInt < 0) energyInt = 0;  // Double-check
-            xSemaphoreGive(dataMutex);
-        }
-        return energyInt;
+        const double wh = ENERGY_METER::energyWh();
+        return wh > 0.0 ? (int)lround(wh) : 0;
     });
     Serial.println("[OCPP]   ✓ Energy meter registered");
 
     // Power meter using terminal values
     setPowerMeterInput([]() {
-        if (terminalVolt < 56.0f || terminalVolt > 85.5f) return 0;
-        if (terminalCurr < 0.0f || terminalCurr > 300.0f) return 0;
-        return (int)(terminalVolt * terminalCurr);
+        const ChargerTelemetry t = TELEMETRY::charger();
+        if (t.terminalVolt < 56.0f || t.terminalVolt > 85.5f) return 0;
+        if (t.terminalCurr < 0.0f || t.terminalCurr > 300.0f) return 0;
+        return (int)t.terminalPower;
     });
     Serial.println("[OCPP]   ✓ Power meter registered");
 
@@ -135,6 +145,7 @@ void ocpp::init()
 
     // EV ready to charge with detailed logging
     setEvReadyInput([]() {
+        const float terminalVolt = TELEMETRY::charger().terminalVolt;
         bool ready = batteryConnected && terminalVolt > 56.0f;
         static bool lastReady = false;
         static float lastVolt = 0.0f;
@@ -156,11 +167,11 @@ void ocpp::init()
     Serial.println("[OCPP]   ✓ EV ready registered");
 
     // MeterValues - OCPP 1.6 standard measurands only
-    addMeterValueInput([]() -> float { return socPercent; }, "SoC", "Percent", nullptr, nullptr, 1);
-    addMeterValueInput([]() -> float { return terminalVolt; }, "Voltage", "V", nullptr, nullptr, 1);
-    addMeterValueInput([]() -> float { return terminalCurr; }, "Current.Import", "A", nullptr, nullptr, 1);
-    addMeterValueInput([]() -> float { return BMS_Imax; }, "Current.Offered", "A", nullptr, nullptr, 1);
-    addMeterValueInput([]() -> float { return chargerTemp; }, "Temperature", "Celsius", nullptr, nullptr, 1);
+    addMeterValueInput([]() -> float { return meterSnapshot().bms.socPercent; }, "SoC", "Percent", nullptr, nullptr, 1);
+    addMeterValueInput([]() -> float { return meterSnapshot().charger.terminalVolt; }, "Voltage", "V", nullptr, nullptr, 1);
+    addMeterValueInput([]() -> float { return meterSnapshot().charger.terminalCurr; }, "Current.Import", "A", nullptr, nullptr, 1);
+    addMeterValueInput([]() -> float { return meterSnapshot().bms.imax; }, "Current.Offered", "A", nullptr, nullptr, 1);
+    addMeterValueInput([]() -> float { return meterSnapshot().charger.outputTemp; }, "Temperature", "Celsius", nullptr, nullptr, 1);
     Serial.println("[OCPP]   ✓ MeterValues registered (standard measurands)");
 
     // Configure intervals - Clock-aligned sampling for immediate first sample
@@ -220,6 +231,7 @@ void ocpp::init()
             txStartTime = millis();
             sessionSummarySent = false;
             
+            ENERGY_METER::reset();
             if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
                 energyWh = 0.0f;
                 xSemaphoreGive(dataMutex);
@@ -238,7 +250,8 @@ void ocpp::init()
         } else if (notification == TxNotification_StopTx) {
             if (!sessionSummarySent && transactionLocked) {
                 float duration = (millis() - txStartTime) / 60000.0f;
-                ocpp::sendSessionSummary(socPercent, energyWh, duration);
+                ocpp::sendSessionSummary(TELEMETRY::bms().socPercent, (float)ENERGY_METER::energyWh(), duration);
+                ocpp::sendBusStats("SessionEnd");
                 sessionSummarySent = true;
             }
             transactionLocked = false;
@@ -284,18 +297,27 @@ void ocpp::init()
     ocppInitialized = true;
 }
 
+static void drainOutbox();
+
 void ocpp::poll()
 {
-    mocpp_loop();
-    
-    // Monitor charger health (availability updated automatically via setEvseReadyInput)
-    static bool lastHealthy = true;
-    bool healthy = isChargerModuleHealthy();
-    
-    if (healthy != lastHealthy) {
-        Serial.printf("[OCPP] Charger %s - Availability will update automatically\n",
-            healthy ? "ONLINE" : "OFFLINE");
-        lastHealthy = healthy;
+    {
+        PERF_TRACE_SCOPE(PERF_MOCPP_LOOP);
+        mocpp_loop();
+    }
+
+    drainOutbox();
+
+    static unsigned long lastBusStats = 0;
+    if (millis() - lastBusStats >= OCPP_BUS_STATS_INTERVAL_S * 1000UL) {
+        lastBusStats = millis();
+        ocpp::sendBusStats("Periodic");
+    }
+
+    static unsigned long lastDiagnostics = 0;
+    if (millis() - lastDiagnostics >= OCPP_DIAGNOSTICS_INTERVAL_S * 1000UL) {
+        lastDiagnostics = millis();
+        ocpp::sendDiagnostics("Periodic");
     }
     
     // Check if connection status changed
@@ -309,8 +331,80 @@ void ocpp::poll()
         
         if (operative) {
             Serial.printf("[OCPP] Charger health at connection: %s\n", 
-                          healthy ? "ONLINE" : "OFFLINE");
+                          isChargerModuleHealthy() ? "ONLINE" : "OFFLINE");
+        }
+    }
+}
+
+// Runs in the OCPP task
+static void handleEvent(const OcppEvent& event)
+{
+    switch (event.type) {
+    case OCPP_EVENT_PLUG:
+        // Connector plug input is read by the mocpp_loop() right after
+        break;
+    case OCPP_EVENT_CHARGER_HEALTH:
+        // Availability follows through setEvseReadyInput
+        Serial.printf("[OCPP] Charger %s - Availability will update automatically\n",
+                      event.value ? "ONLINE" : "OFFLINE");
+        // Bus state at the moment the charger dropped out, for fleet correlation
+        if (!event.value) {
+            ocpp::sendBusStats("ChargerOffline");
+        }
+        break;
+    case OCPP_EVENT_BMS_ALERT:
+        ocpp::sendBMSAlert(event.alertType, event.message);
+        break;
+    case OCPP_EVENT_VEHICLE_INFO: {
+        VehicleInfoBatch batch;
+        if (OCPP_EVENTS::takeVehicleInfo(event, batch)) {
+            ocpp::sendVehicleInfo(batch);
         }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void ocpp::waitForWork()
+{
+    // Short tick while BootNotification is in flight, in a transaction or replaying the outbox.
+    // WiFi down or between WebSocket reconnect attempts there is nothing to poll: idle tick.
+    const bool online = WiFi.status() == WL_CONNECTED;
+    const bool booting = online && !isOperative() && getOcppContext()->getConnection().isConnected();
+    const bool active = booting || (online && (isTransactionActive(1) || !OCPP_OUTBOX::empty()));
+
+    OcppEvent event;
+    if (!OCPP_EVENTS::wait(event, OCPP_EVENTS::tickMs(active))) {
+        return;
+    }
+    do {
+        handleEvent(event);
+    } while (OCPP_EVENTS::take(event));
+}
+
+void ocpp::notifyPlugChanged(bool plugged)
+{
+    OCPP_EVENTS::postPlug(plugged);
+}
+
+void ocpp::notifyChargerHealth(bool healthy)
+{
+    OCPP_EVENTS::postChargerHealth(healthy);
+}
+
+void ocpp::notifyBMSAlert(const char* alertType, const char* message)
+{
+    if (!OCPP_EVENTS::postBmsAlert(alertType, message)) {
+        Serial.printf("[OCPP] ❌ BMSAlert %s lost: OCPP event queue full\n", alertType);
+    }
+}
+
+void ocpp::notifyVehicleInfo(const VehicleInfoBatch& batch)
+{
+    if (!batch.empty() && !OCPP_EVENTS::postVehicleInfo(batch)) {
+        Serial.printf("[OCPP] ❌ VehicleTelemetry (%u samples) lost: OCPP event queue full\n", (unsigned)batch.count());
     }
 }
 
@@ -329,114 +423,188 @@ bool ocpp::isConnected()
     return operative;
 }
 
-void ocpp::sendVehicleInfo(float soc, float maxCurrent, float voltage, float current, float temperature, uint8_t model, float range)
+// Custom DataTransfer: the data text sits in the static arena
+// (datatransfer_payload.h) and is linked into the document, not copied.
+// The capture (type + ticket) fits std::function's local storage, so the
+// only allocation per message is MicroOcpp's own request document. The
+// text is held until the CALLRESULT; if the arena needs its space first,
+// it is moved to the outbox and this request is dropped when built.
+// Offline, or while older messages are still queued, the text goes to the
+// flash outbox instead and drainOutbox() replays it in order.
+static void sendDataTransfer(DataTransferMessage type, DataTransferTicket ticket)
 {
-    if (!isOperative()) {
-        return;
-    }
-
-    // Validate critical data only (allow SOC=0)
-    if (voltage <= 0.0f || maxCurrent <= 0.0f) {
+    if (!isOperative() || !OCPP_OUTBOX::empty()) {
+        const char* data = DATATRANSFER::data(type, ticket);
+        if (data && OCPP_OUTBOX::append(type, data, strlen(data))) {
+            Serial.printf("[OCPP] 💾 %s queued in outbox (%u pending)\n",
+                          DATATRANSFER::messageId(type), (unsigned)OCPP_OUTBOX::stats().pending);
+        } else {
+            Serial.printf("[OCPP] ❌ %s lost: offline and outbox unavailable\n", DATATRANSFER::messageId(type));
+        }
         return;
     }
 
-    const char* modelName = "Unknown";
-    if (model == 1) modelName = "Classic";
-    else if (model == 2) modelName = "Pro";
-    else if (model == 3) modelName = "Max";
-
-    Serial.printf("\n[OCPP] 📤 Sending VehicleInfo:\n");
-    Serial.printf("  SOC=%.1f%% | Model=%s | Range=%.1fkm | MaxI=%.1fA\n", soc, modelName, range, maxCurrent);
-
+    DATATRANSFER::hold(ticket);
     sendRequest("DataTransfer",
-        [soc, maxCurrent, model, range, modelName]() -> std::unique_ptr<MicroOcpp::JsonDoc> {
-            MicroOcpp::JsonDoc dataDoc(256);
-            JsonObject dataObj = dataDoc.to<JsonObject>();
-            dataObj["soc"] = soc;
-            dataObj["maxCurrent"] = maxCurrent;
-            dataObj["model"] = modelName;
-            dataObj["range"] = range;
-            
-            String dataStr;
-            serializeJson(dataObj, dataStr);
-            
-            auto doc = std::unique_ptr<MicroOcpp::JsonDoc>(new MicroOcpp::JsonDoc(768));
+        [type, ticket]() -> std::unique_ptr<MicroOcpp::JsonDoc> {
+            const char* data = DATATRANSFER::data(type, ticket);
+            if (!data) {
+                // Spilled to the outbox, which sends it: no document drops this request
+                return nullptr;
+            }
+            auto doc = std::unique_ptr<MicroOcpp::JsonDoc>(new MicroOcpp::JsonDoc(JSON_OBJECT_SIZE(3)));
             JsonObject payload = doc->to<JsonObject>();
             payload["vendorId"] = "RivotMotors";
-            payload["messageId"] = "VehicleInfo";
-            payload["data"] = dataStr;
+            payload["messageId"] = DATATRANSFER::messageId(type);
+            payload["data"] = data;
             return doc;
         },
-        [](JsonObject response) {
+        [type, ticket](JsonObject response) {
             const char* status = response["status"] | "Unknown";
-            Serial.printf("[OCPP] ✅ VehicleInfo response: %s\n\n", status);
+            DATATRANSFER::release(ticket);
+            Serial.printf("[OCPP] ✅ %s response: %s\n", DATATRANSFER::messageId(type), status);
         }
     );
 }
 
-void ocpp::sendSessionSummary(float finalSoc, float energyDelivered, float duration)
+// Outbox replay: oldest record first, one in flight, at most one per
+// OCPP_OUTBOX_DRAIN_INTERVAL_MS. Any CALLRESULT acknowledges the record;
+// without one it is resent after OCPP_OUTBOX_ACK_TIMEOUT_MS (at-least-once).
+static char outboxText[OCPP_OUTBOX_MAX_DATA + 1]; // data of record outboxDrain.seq
+
+static struct {
+    bool inFlight;
+    uint32_t seq;
+    uint8_t attempts;
+    unsigned long sentAt;
+} outboxDrain = {false, 0, 0, 0};
+
+static void drainOutbox()
 {
-    if (!isOperative()) {
+    if (!isOperative() || OCPP_OUTBOX::empty()) {
+        return;
+    }
+    const unsigned long now = millis();
+    if (outboxDrain.inFlight && now - outboxDrain.sentAt < OCPP_OUTBOX_ACK_TIMEOUT_MS) {
+        return;
+    }
+    if (now - outboxDrain.sentAt < OCPP_OUTBOX_DRAIN_INTERVAL_MS) {
         return;
     }
 
-    Serial.printf("\n[OCPP] 📊 Sending SessionSummary:\n");
-    Serial.printf("  FinalSOC=%.1f%% | Energy=%.2fWh | Duration=%.1fmin\n\n", 
-                  finalSoc, energyDelivered, duration);
+    OutboxRecord rec;
+    outboxDrain.inFlight = false;
+    if (OCPP_OUTBOX::peek(rec, outboxText, sizeof(outboxText)) == 0) {
+        return;
+    }
+    if (rec.seq != outboxDrain.seq) {
+        outboxDrain.seq = rec.seq;
+        outboxDrain.attempts = 0;
+    }
+    if (outboxDrain.attempts >= OCPP_OUTBOX_MAX_ATTEMPTS) {
+        Serial.printf("[OCPP] ❌ Outbox %s #%u unanswered %u times - dropped\n",
+                      DATATRANSFER::messageId(rec.type), (unsigned)rec.seq, (unsigned)outboxDrain.attempts);
+        OCPP_OUTBOX::discard(rec.seq);
+        return;
+    }
+
+    outboxDrain.attempts++;
+    outboxDrain.inFlight = true;
+    outboxDrain.sentAt = now;
+    Serial.printf("[OCPP] 📤 Replaying %s #%u from outbox\n", DATATRANSFER::messageId(rec.type), (unsigned)rec.seq);
 
+    const DataTransferMessage type = rec.type;
+    const uint32_t seq = rec.seq;
     sendRequest("DataTransfer",
-        [finalSoc, energyDelivered, duration]() -> std::unique_ptr<MicroOcpp::JsonDoc> {
-            MicroOcpp::JsonDoc dataDoc(256);
-            JsonObject dataObj = dataDoc.to<JsonObject>();
-            dataObj["finalSoc"] = finalSoc;
-            dataObj["energyDelivered"] = energyDelivered;
-            dataObj["durationMinutes"] = duration;
-            
-            String dataStr;
-            serializeJson(dataObj, dataStr);
-            
-            auto doc = std::unique_ptr<MicroOcpp::JsonDoc>(new MicroOcpp::JsonDoc(512));
+        [type, seq]() -> std::unique_ptr<MicroOcpp::JsonDoc> {
+            // A resend built late: outboxText already holds a later record, so
+            // this one was answered meanwhile. No document drops the request.
+            if (outboxDrain.seq != seq) {
+                return nullptr;
+            }
+            const size_t len = strlen(outboxText);
+            auto doc = std::unique_ptr<MicroOcpp::JsonDoc>(new MicroOcpp::JsonDoc(JSON_OBJECT_SIZE(3) + len + 1));
             JsonObject payload = doc->to<JsonObject>();
             payload["vendorId"] = "RivotMotors";
-            payload["messageId"] = "SessionSummary";
-            payload["data"] = dataStr;
+            payload["messageId"] = DATATRANSFER::messageId(type);
+            payload["data"] = (char*)outboxText; // copied: the next peek reuses the buffer
             return doc;
         },
-        [](JsonObject response) {
+        [type, seq](JsonObject response) {
             const char* status = response["status"] | "Unknown";
-            Serial.printf("[OCPP] ✅ SessionSummary response: %s\n\n", status);
+            OCPP_OUTBOX::ack(seq);
+            if (outboxDrain.seq == seq) {
+                outboxDrain.inFlight = false;
+            }
+            Serial.printf("[OCPP] ✅ %s #%u (outbox) response: %s\n", DATATRANSFER::messageId(type), (unsigned)seq, status);
         }
     );
 }
 
-void ocpp::sendBMSAlert(const char* alertType, const char* message)
+void ocpp::sendVehicleInfo(const VehicleInfoBatch& batch)
 {
-    if (!isOperative()) {
+    if (batch.empty()) {
         return;
     }
 
+    const DataTransferTicket ticket = DATATRANSFER::stageVehicleTelemetry(batch, millis());
+    if (!ticket) {
+        return;
+    }
+
+    const VehicleSample& s = batch.last();
+    Serial.printf("\n[OCPP] 📤 Sending VehicleTelemetry: %u samples\n", (unsigned)batch.count());
+    Serial.printf("  SOC=%.1f%% | Model=%u | Range=%.1fkm | MaxI=%.1fA | V=%.1f I=%.1f T=%.1f\n",
+                  s.soc, batch.model(), s.rangeKm, s.maxCurrent, s.voltage, s.current, s.temperature);
+
+    sendDataTransfer(DT_VEHICLE_TELEMETRY, ticket);
+}
+
+void ocpp::sendSessionSummary(float finalSoc, float energyDelivered, float duration)
+{
+    const DataTransferTicket ticket = DATATRANSFER::stageSessionSummary(finalSoc, energyDelivered, duration);
+
+    Serial.printf("\n[OCPP] 📊 Sending SessionSummary:\n");
+    Serial.printf("  FinalSOC=%.1f%% | Energy=%.2fWh | Duration=%.1fmin\n", 
+                  finalSoc, energyDelivered, duration);
+    if (!ticket) {
+        Serial.println("[OCPP] ❌ SessionSummary does not fit DT_SESSION_SUMMARY_BYTES");
+        return;
+    }
+    Serial.printf("  %s\n\n", DATATRANSFER::data(DT_SESSION_SUMMARY, ticket));
+
+    sendDataTransfer(DT_SESSION_SUMMARY, ticket);
+}
+
+void ocpp::sendBMSAlert(const char* alertType, const char* message)
+{
     Serial.printf("[OCPP] 🚨 Sending BMSAlert: %s - %s\n", alertType, message);
 
-    sendRequest("DataTransfer",
-        [alertType, message]() -> std::unique_ptr<MicroOcpp::JsonDoc> {
-            MicroOcpp::JsonDoc dataDoc(256);
-            JsonObject dataObj = dataDoc.to<JsonObject>();
-            dataObj["alertType"] = alertType;
-            dataObj["message"] = message;
-            dataObj["timestamp"] = millis();
-            
-            String dataStr;
-            serializeJson(dataObj, dataStr);
-            
-            auto doc = std::unique_ptr<MicroOcpp::JsonDoc>(new MicroOcpp::JsonDoc(512));
-            JsonObject payload = doc->to<JsonObject>();
-            payload["vendorId"] = "RivotMotors";
-            payload["messageId"] = "BMSAlert";
-            payload["data"] = dataStr;
-            return doc;
-        },
-        [](JsonObject response) {
-            Serial.printf("[OCPP] ✅ BMSAlert acknowledged\n");
-        }
-    );
+    const DataTransferTicket ticket = DATATRANSFER::stageBmsAlert(alertType, message, millis());
+    if (ticket) {
+        sendDataTransfer(DT_BMS_ALERT, ticket);
+    }
+}
+
+void ocpp::sendBusStats(const char* reason)
+{
+    Serial.printf("[OCPP] 📊 Sending CanBusStats (%s)\n", reason);
+
+    const DataTransferTicket ticket = DATATRANSFER::stageBusStats(reason, millis() / 1000);
+    if (!ticket) {
+        Serial.println("[OCPP] ❌ CanBusStats does not fit DT_BUS_STATS_BYTES");
+        return;
+    }
+    sendDataTransfer(DT_BUS_STATS, ticket);
+}
+
+void ocpp::sendDiagnostics(const char* reason)
+{
+    Serial.printf("[OCPP] 🩺 Sending Diagnostics (%s)\n", reason);
+
+    const DataTransferTicket ticket = DATATRANSFER::stageDiagnostics(reason, millis() / 1000);
+    if (!ticket) {
+        return;
+    }
+    sendDataTransfer(DT_DIAGNOSTICS, ticket);
 }
@@ -147,7 +147,7 @@ namespace prod
         {
             Serial.println("[OCPP_SM] ❌ BMS charging disabled - REJECTING RemoteStart");
             Serial.println("[OCPP_SM] ⚠️  BMS MOSFET is OFF (byte4=0x01)");
-            ocpp::sendBMSAlert("BMS_CHARGING_DISABLED", "Cannot start: BMS MOSFET is OFF");
+            ocpp::notifyBMSAlert("BMS_CHARGING_DISABLED", "Cannot start: BMS MOSFET is OFF");
             return false;
         }
 
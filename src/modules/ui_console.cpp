@@ -3,6 +3,22 @@
 #include <math.h>
 #include "esp_err.h" // for esp_err_to_name()
 #include <MicroOcpp.h>
+#include "drivers/can_dispatcher.h"
+#include "drivers/can_trace.h"
+#include "drivers/charger_poll.h"
+#include "drivers/can_bus_stats.h"
+#include "drivers/can_tx_queue.h"
+#include "drivers/can_twai_driver.h"
+#include "drivers/can_mcp2515_driver.h"
+#include "core/telemetry.h"
+#include "core/energy_meter.h"
+#include "core/signal_history.h"
+#include "core/datatransfer_payload.h"
+#include "core/ocpp_outbox.h"
+#include "core/ocpp_events.h"
+#include "core/task_profiler.h"
+#include "core/perf_trace.h"
+#include "core/deferred_log.h"
 
 // ====== UI States ======
 static bool uiInitialized = false;
@@ -55,6 +71,20 @@ void printMenu()
     Serial.println("3 → Show Output / Temperature");
     Serial.println("4 → Show Terminal Data");
     Serial.println("5 → Show All Data");
+    Serial.println("l → CAN RX Latency Histogram (L = reset)");
+    Serial.println("a → Signal Age / RX → Decode Latency");
+    Serial.println("h → Signal History V/I/Temp/SOC (H = CSV dump, 10 s tier)");
+    Serial.println("r → Dump CAN Trace (R = live stream on/off)");
+    Serial.println("p → Charger Poll Schedule (P = reset)");
+    Serial.println("b → CAN Bus Load / Per-ID Timing (B = reset)");
+    Serial.println("x → CAN1 TX Queue (X = reset)");
+    Serial.println("e → CAN Bus-Off / Error Recovery (E = reset)");
+    Serial.println("d → OCPP DataTransfer Payload Arenas");
+    Serial.println("o → OCPP Offline Outbox (flash queue)");
+    Serial.println("w → OCPP Task Wakeups / Busy Time (W = reset)");
+    Serial.println("c → Task CPU / Stack Profiler");
+    Serial.println("f → Hot-Path Scope Timings (F = Chrome trace dump)");
+    Serial.println("g → Deferred Log Queue / Dropped Lines");
     Serial.println("---------------------------------------");
     Serial.println("s → Start Charging");
     Serial.println("t → 🚨 EMERGENCY STOP (immediate)");
@@ -90,6 +120,11 @@ void printDecodedData()
         return;
     }
 
+    // One coherent tuple per screen instead of field-by-field global reads
+    const TelemetrySnapshot snap = TELEMETRY::snapshot();
+    const ChargerTelemetry &chg = snap.charger;
+    const BmsTelemetry &bms = snap.bms;
+
     // If muted, don't spam output
     if (userChoice == 0)
     {
@@ -102,7 +137,7 @@ void printDecodedData()
     if (userChoice == 1)
     {
         Serial.printf("[BMS→CCS] Vmax=%.2fV Imax=%.2fA Switch=%s Mode=%s\n",
-                      BMS_Vmax, BMS_Imax,
+                      bms.vmax, bms.imax,
                       chargingswitch ? "YES" : "NO",
                       heating ? "HEATING" : "CHARGING");
         Serial.print("Raw BMS Data: ");
@@ -114,13 +149,17 @@ void printDecodedData()
         Serial.print("Charger Status: ");
         Serial.println(chargerStatus);
         Serial.printf("Charger Vmax: %.2f V  Charger Imax: %.2f A\n", Charger_Vmax, Charger_Imax);
+        Serial.printf("Metric79: %.0f  Metric83: %.3f\n", metric79_scaled, metric83_scaled);
         Serial.print("Raw Charger Data: ");
         printBytes(lastStatusData, 8);
+        // Not polled periodically: refresh for the next screen
+        CHARGER_POLL::requestOnce(0x79);
+        CHARGER_POLL::requestOnce(0x83);
     }
     else if (userChoice == 3)
     {
         Serial.printf("Output Voltage: %.2f V  Output Current: %.2f A  Temp: %.2f °C\n",
-                      chargerVolt, chargerCurr, chargerTemp);
+                      chg.outputVolt, chg.outputCurr, chg.outputTemp);
         Serial.print("Raw Output Data V: ");
         printBytes(lastBattData, 8);
         Serial.print("Raw Output Data I: ");
@@ -131,23 +170,25 @@ void printDecodedData()
     else if (userChoice == 4)
     {
         Serial.printf("Terminal Voltage: %.2f V  Terminal Current: %.2f A  Power: %.2f W\n",
-                      terminalVolt, terminalCurr, terminalchargerPower);
+                      chg.terminalVolt, chg.terminalCurr, chg.terminalPower);
         Serial.print("Terminal Status: ");
         Serial.println(terminalStatus);
         Serial.print("Raw Terminal Data 1: ");
         printBytes(lastTermData1, 8);
         Serial.print("Raw Terminal Data 2: ");
         printBytes(lastTermData2, 8);
-        Serial.printf("Accumulated Energy: %.2f Wh\n", energyWh);
+        const EnergyMeterStats em = ENERGY_METER::stats();
+        Serial.printf("Accumulated Energy: %.3f Wh (metered %.0fs, %u frames, %u gaps / %.1fs skipped)\n",
+                      em.energyWh, em.meteredSeconds, em.samples, em.gaps, em.gapSeconds);
     }
     else if (userChoice == 5)
     {
         Serial.println("=========== ALL DATA ===========");
-        Serial.printf("[BMS] Vmax=%.2fV Imax=%.2fA\n", BMS_Vmax, BMS_Imax);
+        Serial.printf("[BMS] Vmax=%.2fV Imax=%.2fA\n", bms.vmax, bms.imax);
         Serial.printf("[Charger] Vmax=%.2fV Imax=%.2fA\n", Charger_Vmax, Charger_Imax);
-        Serial.printf("[Output] V=%.2fV I=%.2fA T=%.2fC\n", chargerVolt, chargerCurr, chargerTemp);
-        Serial.printf("[Terminal] V=%.2fV I=%.2fA P=%.2fW\n", terminalVolt, terminalCurr, terminalchargerPower);
-        Serial.printf("Accumulated Energy: %.2f Wh\n", energyWh);
+        Serial.printf("[Output] V=%.2fV I=%.2fA T=%.2fC\n", chg.outputVolt, chg.outputCurr, chg.outputTemp);
+        Serial.printf("[Terminal] V=%.2fV I=%.2fA P=%.2fW\n", chg.terminalVolt, chg.terminalCurr, chg.terminalPower);
+        Serial.printf("Accumulated Energy: %.3f Wh\n", ENERGY_METER::energyWh());
         Serial.print("Raw BMS: ");
         printBytes(lastBMSData, 8);
         Serial.print("Raw Charger: ");
@@ -195,6 +236,84 @@ void processSerialInput()
     case '5':
         userChoice = 5;
         break;
+    case 'l':
+        CAN_DISPATCH::printLatencyHistogram();
+        break;
+    case 'L':
+        CAN_DISPATCH::resetLatencyStats();
+        Serial.println("CAN latency statistics cleared");
+        break;
+    case 'a':
+        TELEMETRY::printSignalAges();
+        break;
+    case 'h':
+        SIGNAL_HISTORY::print();
+        break;
+    case 'H':
+        SIGNAL_HISTORY::dump(1);
+        break;
+    case 'd':
+        DATATRANSFER::printStats();
+        break;
+    case 'o':
+        OCPP_OUTBOX::printStats();
+        break;
+    case 'w':
+        OCPP_EVENTS::printStats();
+        break;
+    case 'W':
+        OCPP_EVENTS::resetStats();
+        Serial.println("[OCPP] Loop statistics reset");
+        break;
+    case 'c':
+        TASK_PROFILER::print();
+        break;
+    case 'f':
+        PERF_TRACE::printSummary();
+        break;
+    case 'F':
+        PERF_TRACE::dump();
+        break;
+    case 'g':
+        DEFERRED_LOG::printStats();
+        break;
+    case 'p':
+        CHARGER_POLL::printStats();
+        break;
+    case 'P':
+        CHARGER_POLL::resetStats();
+        Serial.println("Charger poll statistics cleared");
+        break;
+    case 'b':
+        CAN_STATS::print();
+        break;
+    case 'B':
+        CAN_STATS::reset();
+        Serial.println("CAN bus statistics cleared");
+        break;
+    case 'x':
+        CAN_TX::printStats();
+        break;
+    case 'X':
+        CAN_TX::resetStats();
+        Serial.println("CAN1 TX queue statistics cleared");
+        break;
+    case 'e':
+        CAN_TWAI::printRecoveryStats();
+        CAN_MCP2515::printRecoveryStats();
+        break;
+    case 'E':
+        CAN_TWAI::resetRecoveryStats();
+        CAN_MCP2515::resetRecoveryStats();
+        Serial.println("CAN recovery statistics cleared");
+        break;
+    case 'r':
+        CAN_TRACE::dump();
+        break;
+    case 'R':
+        CAN_TRACE::setStreaming(!CAN_TRACE::isStreaming());
+        Serial.printf("CAN trace live stream %s\n", CAN_TRACE::isStreaming() ? "ON" : "OFF");
+        break;
     case 's':
     case 'S':
         if (!ocppInitialized)
@@ -0,0 +1,47 @@
+#pragma once
+
+/**
+ * @file bench.h
+ * @brief Micro-benchmark registry for the native simulator (`bench` mode)
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * Benchmarks register themselves with SIM_BENCH and are run by name from
+ * sim_main. Firmware Serial output is muted while a benchmark runs; results
+ * go to stdout through benchReport().
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <chrono>
+
+struct BenchCase
+{
+    const char *name;
+    const char *description;
+    void (*run)();
+};
+
+struct BenchRegistrar
+{
+    BenchRegistrar(const char *name, const char *description, void (*run)());
+};
+
+/// All registered benchmarks, in link order
+const BenchCase *benchList(size_t *count);
+
+/// Print one result line: "<bench> <metric> <value> <unit>"
+void benchReport(const char *bench, const char *metric, double value, const char *unit);
+
+/// Monotonic wall-clock nanoseconds (independent of the sim clock)
+inline uint64_t benchNowNs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+#define SIM_BENCH(name, description)                                  \
+    static void bench_##name();                                       \
+    static BenchRegistrar benchReg_##name(#name, description, bench_##name); \
+    static void bench_##name()
@@ -0,0 +1,213 @@
+#include "bench.h"
+#include "../../include/drivers/can_twai_driver.h"
+#include "../../include/config/hardware.h"
+#include "../../include/config/timing.h"
+#include <sim/sim_clock.h>
+#include <sim/sim_twai.h>
+#include <sim/virtual_bus.h>
+#include <stdio.h>
+
+// CAN1 bus-off handling on virtual time (100 us steps), 60 s of charger
+// traffic (one accepted frame every 10 ms) with the sim_twai.h injector:
+//
+//   5.0 s               bus-off, bus fine right after
+//   7.0 s               bus-off again 2 s later
+//   20.0 s              bus-off with the bus shorted for 300 ms
+//   40.0 / 40.5 / 41.0  three bus-offs in a row
+//
+//   reinstall  - the former chargerCommTask check on its 50 ms tick:
+//                twai_stop(), 50 ms, uninstall, 100 ms, CAN_TWAI::init(),
+//                at most once per 5 s, charging disabled every time
+//   in place   - CAN_TWAI::serviceRecovery() every step (the alert task
+//                wakes on the alert)
+//
+// Outage: injection -> controller running on a fault-free bus (or the next
+// injection, which then owns the rest of a continuous outage).
+
+static const uint64_t REC_RUN_US = 60000000ULL;
+static const uint64_t REC_STEP_US = 100;
+static const uint64_t REC_FRAME_US = 10000;
+
+struct RecEvent
+{
+    uint64_t atUs;
+    uint64_t faultUs; // bus held faulty this long after the bus-off
+};
+
+static const RecEvent recEvents[] = {
+    {5000000, 0}, {7000000, 0}, {20000000, 300000}, {40000000, 0}, {40500000, 0}, {41000000, 0}};
+static const size_t REC_EVENTS = sizeof(recEvents) / sizeof(recEvents[0]);
+
+struct RecResult
+{
+    uint32_t offered;
+    uint32_t received;
+    uint32_t reinstalls;
+    uint32_t chargingStops;
+    uint64_t outageUs[REC_EVENTS];
+};
+
+// Legacy recovery sequence, one phase per blocking call in chargerCommTask
+enum LegacyPhase
+{
+    LEGACY_IDLE,
+    LEGACY_STOPPED,    // after twai_stop(), 50 ms
+    LEGACY_UNINSTALLED // after uninstall, 100 ms, then init()
+};
+
+// Shared loop: traffic, injection, outage tracking; 'service' runs the recovery under test
+template <typename Service>
+static RecResult runScenario(Service service)
+{
+    RecResult r = {};
+    size_t nextEvent = 0;
+    int open = -1; // event whose outage is being measured
+    uint64_t faultEndUs = 0;
+    bool fault = false;
+
+    for (uint64_t t = 0; t < REC_RUN_US; t += REC_STEP_US)
+    {
+        sim::setClockUs(t);
+
+        if (nextEvent < REC_EVENTS && t >= recEvents[nextEvent].atUs)
+        {
+            // Still down from the previous event: it owns the outage up to now
+            if (open >= 0)
+                r.outageUs[open] = t - recEvents[open].atUs;
+            sim::twaiInjectBusOff();
+            if (recEvents[nextEvent].faultUs)
+            {
+                sim::twaiSetBusFault(true);
+                fault = true;
+                faultEndUs = t + recEvents[nextEvent].faultUs;
+            }
+            open = (int)nextEvent++;
+        }
+        if (fault && t >= faultEndUs)
+        {
+            sim::twaiSetBusFault(false);
+            fault = false;
+        }
+
+        service(t, r);
+
+        if (t % REC_FRAME_US == 0 && !fault)
+        {
+            sim::BusFrame f = {};
+            f.id = ID_TELEM_RESP;
+            f.extended = true;
+            f.dlc = 8;
+            sim::busSend(sim::BUS_CHARGER, f);
+            r.offered++;
+        }
+        twai_message_t msg;
+        while (twai_receive(&msg, 0) == ESP_OK)
+            r.received++;
+
+        twai_status_info_t info;
+        if (open >= 0 && !fault && twai_get_status_info(&info) == ESP_OK && info.state == TWAI_STATE_RUNNING)
+        {
+            r.outageUs[open] = t - recEvents[open].atUs;
+            open = -1;
+        }
+    }
+    return r;
+}
+
+static RecResult runReinstall()
+{
+    sim::setClockUs(0);
+    CAN_TWAI::init();
+
+    LegacyPhase phase = LEGACY_IDLE;
+    uint64_t phaseUntil = 0, nextTick = 0;
+    uint64_t lastRecoveryUs = 0;
+    bool recoveredOnce = false;
+
+    RecResult r = runScenario([&](uint64_t t, RecResult &res)
+                              {
+        if (phase == LEGACY_STOPPED && t >= phaseUntil)
+        {
+            twai_driver_uninstall();
+            phase = LEGACY_UNINSTALLED;
+            phaseUntil = t + 100000;
+        }
+        else if (phase == LEGACY_UNINSTALLED && t >= phaseUntil)
+        {
+            CAN_TWAI::init();
+            res.reinstalls++;
+            res.chargingStops++;
+            lastRecoveryUs = t;
+            recoveredOnce = true;
+            phase = LEGACY_IDLE;
+            nextTick = t + CHARGER_TX_TICK_MS * 1000ULL;
+        }
+        if (phase != LEGACY_IDLE || t < nextTick)
+            return;
+        nextTick = t + CHARGER_TX_TICK_MS * 1000ULL;
+
+        twai_status_info_t s;
+        if (twai_get_status_info(&s) != ESP_OK)
+            return;
+        if ((s.state == TWAI_STATE_BUS_OFF || s.state == TWAI_STATE_STOPPED) &&
+            (!recoveredOnce || t - lastRecoveryUs > 5000000))
+        {
+            twai_stop();
+            phase = LEGACY_STOPPED;
+            phaseUntil = t + 50000;
+        } });
+
+    CAN_TWAI::deinit();
+    return r;
+}
+
+static RecResult runInPlace(CanBusOffStats &stats)
+{
+    sim::setClockUs(0);
+    CAN_TWAI::init();
+    CAN_TWAI::resetRecoveryStats();
+
+    RecResult r = runScenario([](uint64_t, RecResult &)
+                              { CAN_TWAI::serviceRecovery(0); });
+    stats = CAN_TWAI::getRecoveryStats();
+    CAN_TWAI::deinit();
+    return r;
+}
+
+static void report(const char *run, const RecResult &r)
+{
+    char metric[48];
+    uint64_t total = 0, worst = 0;
+    for (size_t i = 0; i < REC_EVENTS; i++)
+    {
+        snprintf(metric, sizeof(metric), "%s outage %.1fs%s", run, recEvents[i].atUs / 1e6,
+                 recEvents[i].faultUs ? " short" : "");
+        benchReport("can1_recovery", metric, r.outageUs[i] / 1000.0, "ms");
+        total += r.outageUs[i];
+        worst = r.outageUs[i] > worst ? r.outageUs[i] : worst;
+    }
+    snprintf(metric, sizeof(metric), "%s outage total", run);
+    benchReport("can1_recovery", metric, total / 1000.0, "ms");
+    snprintf(metric, sizeof(metric), "%s frames lost", run);
+    benchReport("can1_recovery", metric, r.offered - r.received, "");
+    snprintf(metric, sizeof(metric), "%s reinstalls", run);
+    benchReport("can1_recovery", metric, r.reinstalls, "");
+    snprintf(metric, sizeof(metric), "%s charging stops", run);
+    benchReport("can1_recovery", metric, r.chargingStops, "");
+}
+
+SIM_BENCH(can1_recovery, "CAN1 bus-off: driver reinstall vs in-place twai_initiate_recovery()")
+{
+    sim::useVirtualClock(true);
+    const RecResult reinstall = runReinstall();
+    CanBusOffStats stats;
+    const RecResult inPlace = runInPlace(stats);
+    sim::useVirtualClock(false);
+
+    report("reinstall", reinstall);
+    report("in place", inPlace);
+    benchReport("can1_recovery", "in place recoveries", stats.recoveries, "");
+    benchReport("can1_recovery", "in place recover min", stats.recovery.minUs / 1000.0, "ms");
+    benchReport("can1_recovery", "in place recover max", stats.recovery.maxUs / 1000.0, "ms");
+    benchReport("can1_recovery", "in place last backoff", stats.backoffMs, "ms");
+}
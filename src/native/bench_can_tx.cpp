@@ -0,0 +1,448 @@
+#include "bench.h"
+#include "../../include/drivers/can_tx_queue.h"
+#include "../../include/drivers/charger_poll.h"
+#include "../../include/config/hardware.h"
+#include <deque>
+#include <functional>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// CAN1 transmit path on virtual time (100 us steps, no driver): the charger
+// poll schedule in charging mode plus five start/stop commands, over a bus
+// that is
+//
+//   flooded    - 5.0 .. 8.0 s: higher-priority traffic leaves one frame
+//                slot every 100 ms
+//   bus-off    - 12.0 .. 13.0 s: transmits are rejected, queued frames lost
+//   normal     - otherwise, 540 us per frame
+//
+// Runs:
+//   blocking   - the former path: chargerCommTask calls twai_transmit()
+//                with a 100 ms timeout into the default 5-frame TX queue
+//   queued     - CAN_TX lanes drained by can1_tx_task (retry every 1 ms)
+//                into a 1-frame controller queue
+//
+// Command latency is build -> end of frame on the wire, -1 if it never got there.
+//
+// In flight: can1_tx_task copies the front frame, drops the lock and
+// transmits; meanwhile
+//   stop behind poll  - a STOP enters the safety lane while a poll is on
+//                       its way to the controller
+//   stop behind start - a STOP (same id and key) arrives while the START
+//                       it supersedes is on its way
+// the frame completed must be the one transmitted, and the STOP must still
+// go out afterwards.
+
+static const uint64_t TX_RUN_US = 20000000ULL;
+static const uint64_t TX_STEP_US = 100;
+static const uint64_t TX_TICK_US = CHARGER_TX_TICK_MS * 1000ULL;
+static const uint32_t TX_FRAME_US = 540;
+static const uint64_t FLOOD_START_US = 5000000, FLOOD_END_US = 8000000, FLOOD_SLOT_US = 100000;
+static const uint64_t BUSOFF_START_US = 12000000, BUSOFF_END_US = 13000000;
+static const uint64_t COMMAND_US[] = {6000000, 9000000, 12500000, 15000000, 18000000};
+static const size_t COMMANDS = sizeof(COMMAND_US) / sizeof(COMMAND_US[0]);
+
+struct WireFrame
+{
+    uint8_t func;
+    int command; // index into COMMAND_US, -1 for polls
+};
+
+struct TxResult
+{
+    uint32_t polls;         // on the wire
+    uint32_t floodPolls;    // on the wire during the flood
+    uint32_t pollsFailed;   // timed out / rejected / flushed / lane full
+    uint32_t commandsSent;
+    int64_t commandUs[COMMANDS]; // -1 = never reached the wire
+    uint64_t stallMaxUs;    // longest chargerCommTask tick
+    uint32_t lateTicks;     // ticks started > 1 ms after the timer
+    uint32_t coalesced;
+    int32_t wireMismatch;   // queued: lane wire count (controller accounting) - frames on the wire
+};
+
+// TWAI controller: FIFO in front of the bus
+class TxController
+{
+public:
+    explicit TxController(size_t depth) : depth_(depth) {}
+
+    static bool busOff(uint64_t t) { return t >= BUSOFF_START_US && t < BUSOFF_END_US; }
+    bool full() const { return fifo_.size() >= depth_; }
+    uint32_t pending() const { return (uint32_t)fifo_.size(); }
+
+    bool push(const WireFrame &f, uint64_t t)
+    {
+        if (busOff(t) || full())
+            return false;
+        fifo_.push_back(f);
+        if (fifo_.size() == 1 && busyUntil_ < t)
+            busyUntil_ = t;
+        return true;
+    }
+
+    // Frames whose transmission ended by t
+    template <typename Fn>
+    void advance(uint64_t t, Fn onWire)
+    {
+        if (busOff(t))
+        {
+            fifo_.clear();
+            busyUntil_ = BUSOFF_END_US;
+            return;
+        }
+        while (!fifo_.empty())
+        {
+            uint64_t start = busyUntil_;
+            if (start >= FLOOD_START_US && start < FLOOD_END_US)
+                start = (start + FLOOD_SLOT_US - 1) / FLOOD_SLOT_US * FLOOD_SLOT_US;
+            if (start + TX_FRAME_US > t)
+                return;
+            busyUntil_ = start + TX_FRAME_US;
+            onWire(fifo_.front(), busyUntil_);
+            fifo_.pop_front();
+        }
+    }
+
+private:
+    size_t depth_;
+    std::deque<WireFrame> fifo_;
+    uint64_t busyUntil_ = 0;
+};
+
+struct CommandState
+{
+    size_t next = 0;     // next COMMAND_US to raise
+    int pending = -1;    // raised, not yet built
+    uint64_t builtUs[COMMANDS];
+};
+
+// buildChargerRequest() while charging: 0x32 only when the commanded state changed
+static bool buildFrame(uint8_t func, CommandState &cmd, uint64_t t, WireFrame &out)
+{
+    out.func = func;
+    out.command = -1;
+    if (func != 0x32)
+        return true;
+    if (cmd.pending < 0)
+        return false;
+    out.command = cmd.pending;
+    cmd.builtUs[cmd.pending] = t;
+    cmd.pending = -1;
+    return true;
+}
+
+static void raiseCommands(CommandState &cmd, uint64_t t)
+{
+    if (cmd.next < COMMANDS && t >= COMMAND_US[cmd.next])
+        cmd.pending = (int)cmd.next++;
+}
+
+static void onWire(TxResult &r, const CommandState &cmd, const WireFrame &f, uint64_t endUs)
+{
+    if (f.command >= 0)
+    {
+        r.commandsSent++;
+        r.commandUs[f.command] = (int64_t)(endUs - cmd.builtUs[f.command]);
+    }
+    else
+    {
+        r.polls++;
+        if (endUs >= FLOOD_START_US && endUs < FLOOD_END_US)
+            r.floodPolls++;
+    }
+}
+
+static ChargerPollScheduler makeScheduler()
+{
+    ChargerPollScheduler s;
+    s.configure(chargerPolls, NUM_CHARGER_POLLS, CAN1_BAUDRATE, CHARGER_POLL_BUS_BUDGET_PCT);
+    s.setCharging(true, 0);
+    return s;
+}
+
+static TxResult newResult()
+{
+    TxResult r = {};
+    for (size_t i = 0; i < COMMANDS; i++)
+        r.commandUs[i] = -1;
+    return r;
+}
+
+static TxResult runBlocking()
+{
+    TxResult r = newResult();
+    CommandState cmd;
+    TxController ctl(5);
+    ChargerPollScheduler sched = makeScheduler();
+
+    // chargerCommTask state: between ticks, or blocked in twai_transmit()
+    bool inTick = false, haveFrame = false;
+    uint64_t tickStart = 0, nextTick = 0, deadline = 0;
+    uint8_t perTick = 0;
+    int index = -1;
+    WireFrame frame = {};
+
+    for (uint64_t t = 0; t < TX_RUN_US; t += TX_STEP_US)
+    {
+        ctl.advance(t, [&](const WireFrame &f, uint64_t end)
+                    { onWire(r, cmd, f, end); });
+        raiseCommands(cmd, t);
+
+        if (!inTick)
+        {
+            if (t < nextTick)
+                continue;
+            if (t - nextTick > 1000)
+                r.lateTicks++;
+            // Timer notifications that arrived while blocked collapse into one
+            while (nextTick <= t)
+                nextTick += TX_TICK_US;
+            inTick = true;
+            tickStart = t;
+            perTick = 0;
+            sched.beginTick((uint32_t)(t / 1000));
+        }
+
+        while (inTick)
+        {
+            if (!haveFrame)
+            {
+                index = perTick < CHARGER_POLL_MAX_PER_TICK ? sched.pickDue() : -1;
+                if (index < 0)
+                {
+                    sched.endTick();
+                    inTick = false;
+                    if (t - tickStart > r.stallMaxUs)
+                        r.stallMaxUs = t - tickStart;
+                    break;
+                }
+                perTick++;
+                if (!buildFrame(sched.spec(index).func, cmd, t, frame))
+                {
+                    sched.complete(index, false);
+                    continue;
+                }
+                haveFrame = true;
+                deadline = t + 100000;
+            }
+
+            if (ctl.push(frame, t))
+            {
+                sched.complete(index, true);
+                haveFrame = false;
+            }
+            else if (TxController::busOff(t) || t >= deadline)
+            {
+                // ESP_ERR_INVALID_STATE / ESP_ERR_TIMEOUT: the frame is gone
+                if (frame.command < 0)
+                    r.pollsFailed++;
+                sched.complete(index, false);
+                haveFrame = false;
+            }
+            else
+            {
+                break; // still blocked
+            }
+        }
+    }
+    return r;
+}
+
+static TxResult runQueued()
+{
+    TxResult r = newResult();
+    CommandState cmd;
+    TxController ctl(CAN1_TX_CONTROLLER_QUEUE);
+    ChargerPollScheduler sched = makeScheduler();
+    CanTxQueue queue;
+    uint64_t nextTick = 0, txWake = 0;
+    uint32_t periodicGone = 0;
+
+    for (uint64_t t = 0; t < TX_RUN_US; t += TX_STEP_US)
+    {
+        ctl.advance(t, [&](const WireFrame &f, uint64_t end)
+                    { onWire(r, cmd, f, end); });
+        // can1_alert_task on TX_SUCCESS / bus-off
+        queue.onController(queue.handedCount(), ctl.pending(), 0, !TxController::busOff(t));
+        raiseCommands(cmd, t);
+
+        if (t >= nextTick)
+        {
+            nextTick += TX_TICK_US;
+            sched.beginTick((uint32_t)(t / 1000));
+            for (uint8_t n = 0; n < CHARGER_POLL_MAX_PER_TICK; n++)
+            {
+                const int index = sched.pickDue();
+                if (index < 0)
+                    break;
+                const ChargerPollSpec &spec = sched.spec(index);
+                WireFrame wf;
+                bool ok = buildFrame(spec.func, cmd, t, wf);
+                if (ok)
+                {
+                    // CanTxFrame carries the bench's frame tag in its payload
+                    CanTxFrame f = {};
+                    f.id = spec.reqId;
+                    f.dlc = 8;
+                    f.extended = true;
+                    f.key = spec.func;
+                    f.data[1] = wf.func;
+                    f.data[2] = (uint8_t)(wf.command + 1);
+                    ok = queue.enqueue(spec.priority == 0 ? CAN_TX_SAFETY : CAN_TX_PERIODIC, f, (uint32_t)t);
+                    if (!ok && wf.command < 0)
+                        r.pollsFailed++;
+                }
+                sched.complete(index, ok);
+            }
+            sched.endTick();
+            txWake = t; // enqueue notifies can1_tx_task
+        }
+
+        // can1_tx_task: runs on notification or its retry timeout
+        if (t < txWake)
+            continue;
+        txWake = UINT64_MAX;
+        CanTxFrame f;
+        CanTxToken token;
+        while (queue.front(f, token))
+        {
+            const WireFrame wf = {f.data[1], (int)f.data[2] - 1};
+            const bool pushed = ctl.push(wf, t);
+            queue.complete(token, pushed, (uint32_t)t);
+            if (pushed)
+                continue;
+            if (TxController::busOff(t))
+            {
+                queue.flush(CAN_TX_PERIODIC);
+                txWake = t + CAN1_TX_DOWN_RETRY_MS * 1000ULL;
+            }
+            else
+            {
+                txWake = t + CAN1_TX_RETRY_MS * 1000ULL;
+            }
+            break;
+        }
+    }
+
+    CanTxLaneStats s;
+    r.wireMismatch = -(int32_t)(r.polls + r.commandsSent);
+    for (uint8_t lane = 0; lane < CAN_TX_LANES; lane++)
+    {
+        queue.stats((CanTxLane)lane, s);
+        r.coalesced += s.coalesced;
+        r.wireMismatch += (int32_t)s.delivered;
+        // Polls the controller dropped at bus-off never reached the wire either
+        if (lane == CAN_TX_PERIODIC)
+            periodicGone = s.flushed + s.lost;
+    }
+    r.pollsFailed += periodicGone;
+    return r;
+}
+
+static void report(const char *run, const TxResult &r)
+{
+    char metric[48];
+    snprintf(metric, sizeof(metric), "%s commands sent", run);
+    benchReport("can_tx", metric, r.commandsSent, "of 5");
+    for (size_t i = 0; i < COMMANDS; i++)
+    {
+        const uint64_t t = COMMAND_US[i];
+        const char *bus = t >= FLOOD_START_US && t < FLOOD_END_US        ? "flood"
+                          : t >= BUSOFF_START_US && t < BUSOFF_END_US ? "bus-off"
+                                                                       : "normal";
+        snprintf(metric, sizeof(metric), "%s cmd %.1fs %s", run, t / 1e6, bus);
+        benchReport("can_tx", metric, r.commandUs[i] < 0 ? -1.0 : r.commandUs[i] / 1000.0,
+                    r.commandUs[i] < 0 ? "(lost)" : "ms");
+    }
+    snprintf(metric, sizeof(metric), "%s loop stall max", run);
+    benchReport("can_tx", metric, r.stallMaxUs / 1000.0, "ms");
+    snprintf(metric, sizeof(metric), "%s late ticks", run);
+    benchReport("can_tx", metric, r.lateTicks, "");
+    snprintf(metric, sizeof(metric), "%s polls on wire", run);
+    benchReport("can_tx", metric, r.polls, "");
+    snprintf(metric, sizeof(metric), "%s polls in flood", run);
+    benchReport("can_tx", metric, r.floodPolls, "");
+    snprintf(metric, sizeof(metric), "%s polls lost", run);
+    benchReport("can_tx", metric, r.pollsFailed, "");
+    snprintf(metric, sizeof(metric), "%s coalesced", run);
+    benchReport("can_tx", metric, r.coalesced, "");
+}
+
+static void reportWireAccounting(const TxResult &r)
+{
+    benchReport("can_tx", "queued wire count - actual", r.wireMismatch, "frames");
+}
+
+static CanTxFrame commandFrame(uint8_t func, uint8_t enable)
+{
+    CanTxFrame f = {};
+    f.id = 0x02200000;
+    f.dlc = 8;
+    f.extended = true;
+    f.key = func;
+    f.data[1] = func;
+    f.data[7] = enable;
+    return f;
+}
+
+// Drain the queue as can1_tx_task does, with `during` run between front()
+// and complete(); the frames that reached the controller, in order
+static std::vector<CanTxFrame> drainWith(CanTxQueue &q, const std::function<void()> &during)
+{
+    std::vector<CanTxFrame> wire;
+    CanTxFrame f;
+    CanTxToken token;
+    bool once = true;
+    while (q.front(f, token))
+    {
+        if (once)
+            during();
+        once = false;
+        wire.push_back(f);
+        q.complete(token, true, 0);
+    }
+    return wire;
+}
+
+static void reportInFlight()
+{
+    const uint8_t stop = 0x00, start = 0x01;
+
+    // STOP into the safety lane while a periodic poll is in flight
+    CanTxQueue q;
+    q.enqueue(CAN_TX_PERIODIC, commandFrame(0x36, 0), 0);
+    std::vector<CanTxFrame> wire = drainWith(q, [&]
+                                             { q.enqueue(CAN_TX_SAFETY, commandFrame(0x32, stop), 0); });
+    const bool stopOut = wire.size() == 2 && wire[0].key == 0x36 && wire[1].key == 0x32 && wire[1].data[7] == stop;
+    benchReport("can_tx", "in-flight stop after poll", stopOut ? 1 : 0, "of 1");
+
+    // STOP superseding a START that is already on its way
+    q.clear();
+    q.enqueue(CAN_TX_SAFETY, commandFrame(0x32, start), 0);
+    wire = drainWith(q, [&]
+                     { q.enqueue(CAN_TX_SAFETY, commandFrame(0x32, stop), 0); });
+    const bool lastStop = wire.size() == 2 && wire[0].data[7] == start && wire[1].data[7] == stop;
+    benchReport("can_tx", "in-flight stop after start", lastStop ? 1 : 0, "of 1");
+
+    // And a later START replaces that queued STOP, not the in-flight frame
+    q.clear();
+    q.enqueue(CAN_TX_SAFETY, commandFrame(0x32, start), 0);
+    wire = drainWith(q, [&]
+                     {
+                         q.enqueue(CAN_TX_SAFETY, commandFrame(0x32, stop), 0);
+                         q.enqueue(CAN_TX_SAFETY, commandFrame(0x32, start), 0);
+                     });
+    const bool lastStart = wire.size() == 2 && wire[1].data[7] == start;
+    benchReport("can_tx", "in-flight newest cmd last", lastStart ? 1 : 0, "of 1");
+}
+
+SIM_BENCH(can_tx, "CAN1 TX: blocking twai_transmit vs CAN_TX priority lanes, flooded + bus-off bus")
+{
+    report("blocking", runBlocking());
+    const TxResult queued = runQueued();
+    report("queued", queued);
+    reportWireAccounting(queued);
+    reportInFlight();
+}
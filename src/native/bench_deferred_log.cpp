@@ -0,0 +1,195 @@
+#include "bench.h"
+#include "../../include/core/deferred_log.h"
+#include <Arduino.h>
+#include <sim/sim_serial.h>
+#include <atomic>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+// Cost to the calling task of the BMS Ah / SOC lines (handleChargingAhMessage,
+// handleDischargingAhMessage), with the UART modelled at 115200 baud:
+//
+//   before  - Serial.printf(): the caller waits whenever the 128-byte TX
+//             FIFO is full, i.e. for most of each line after the first
+//   after   - DLOG(): format pointer and arguments into the ring; the line
+//             is printed later by whoever drains it
+//   burst   - 200 lines at once against a LOG task writing at 115200 baud:
+//             what does not fit the ring is dropped and counted
+//   mpsc    - 4 producer threads (a line each every ~50 us, like several
+//             busy tasks; then flat out) and the consumer draining without
+//             pacing: every line arrives intact and in order per producer,
+//             or is counted as dropped
+
+static const uint32_t DL_BAUD = 115200;
+static const uint32_t DL_PRINTF_SETS = 10;   // x3 lines, paced (~50 ms per set)
+static const uint32_t DL_LOG_CALLS = 300000;
+static const uint32_t DL_BURST = 200;
+static const uint32_t DL_PRODUCERS = 4;
+static const uint32_t DL_PER_PRODUCER = 20000;
+
+static const uint32_t dlChargeRaw = 0x0012D6AE;
+static const float dlChargeAh = 1234.606f, dlDischargeAh = 1200.067f;
+
+static void dlPrintfSet()
+{
+    Serial.printf("[BMS] ChargingAh received: raw=0x%08X (%.3fAh)\n", (unsigned)dlChargeRaw, dlChargeAh);
+    Serial.printf("[BMS] ✅ SOC calculated: %.1f%% (%.1fAh / %.0fAh) Range=%.1fkm Model=%d\n", 57.6f, 34.5f, 60.0f, 93.3f, 2);
+    Serial.printf("[BMS] DischargingAh received: raw=0x%08X (%.3fAh)\n", 0x00124FC3u, dlDischargeAh);
+}
+
+static void dlLogSet()
+{
+    DLOG("[BMS] ChargingAh received: raw=0x%08X (%.3fAh)\n", (unsigned)dlChargeRaw, dlChargeAh);
+    DLOG("[BMS] ✅ SOC calculated: %.1f%% (%.1fAh / %.0fAh) Range=%.1fkm Model=%d\n", 57.6f, 34.5f, 60.0f, 93.3f, 2);
+    DLOG("[BMS] DischargingAh received: raw=0x%08X (%.3fAh)\n", 0x00124FC3u, dlDischargeAh);
+}
+
+// mpsc: lines "<producer> <seq>\n" checked as the consumer prints them
+static std::atomic<uint32_t> dlReceived{0}, dlMalformed{0}, dlDisorder{0};
+static int64_t dlLastSeq[DL_PRODUCERS];
+
+static void dlCheckSink(const char *line, size_t len)
+{
+    char *end = nullptr;
+    const unsigned long producer = strtoul(line, &end, 10);
+    const long seq = end && *end == ' ' ? strtol(end + 1, &end, 10) : -1;
+    if (producer >= DL_PRODUCERS || seq < 0 || !end || *end != '\n' || (size_t)(end + 1 - line) != len)
+    {
+        dlMalformed++;
+        return;
+    }
+    if (seq <= dlLastSeq[producer])
+        dlDisorder++;
+    dlLastSeq[producer] = seq;
+    dlReceived++;
+}
+
+static void dlMpsc(bool paced)
+{
+    const char *tag = paced ? "mpsc" : "mpsc flood";
+    char metric[48];
+    DlogStats s0, s1;
+
+    for (int64_t &seq : dlLastSeq)
+        seq = -1;
+    dlReceived = dlMalformed = dlDisorder = 0;
+    DEFERRED_LOG::flush();
+    DEFERRED_LOG::setSink(dlCheckSink);
+    DEFERRED_LOG::getStats(s0);
+    std::atomic<uint32_t> producing{DL_PRODUCERS};
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < DL_PRODUCERS; p++)
+    {
+        producers.emplace_back([p, paced, &producing]
+                               {
+                                   for (uint32_t seq = 0; seq < DL_PER_PRODUCER; seq++)
+                                   {
+                                       DLOG("%u %u\n", (unsigned)p, (unsigned)seq);
+                                       if (paced)
+                                           std::this_thread::sleep_for(std::chrono::microseconds(1));
+                                   }
+                                   producing--;
+                               });
+    }
+    while (producing > 0)
+        DEFERRED_LOG::flush();
+    for (std::thread &t : producers)
+        t.join();
+    DEFERRED_LOG::flush();
+    DEFERRED_LOG::setSink(nullptr);
+    DEFERRED_LOG::getStats(s1);
+
+    const uint32_t total = DL_PRODUCERS * DL_PER_PRODUCER;
+    const uint32_t dropped = s1.dropped - s0.dropped;
+    const struct
+    {
+        const char *name;
+        double value;
+    } results[] = {{"received", (double)dlReceived.load()},
+                   {"dropped (counted)", (double)dropped},
+                   {"unaccounted", (double)total - dlReceived.load() - dropped},
+                   {"malformed", (double)dlMalformed.load()},
+                   {"out of order", (double)dlDisorder.load()}};
+    for (const auto &r : results)
+    {
+        snprintf(metric, sizeof(metric), "%s: %s", tag, r.name);
+        benchReport("deferred_log", metric, r.value, "");
+    }
+}
+
+SIM_BENCH(deferred_log, "Deferred logger: caller cost vs Serial.printf at 115200 baud, overflow, 4 producers")
+{
+    DlogStats s0, s1;
+
+    // Before: the calling task blocks on the UART
+    sim::setSerialBaud(DL_BAUD);
+    delay(20); // FIFO empty
+    uint64_t worst = 0;
+    uint64_t t0 = benchNowNs();
+    for (uint32_t i = 0; i < DL_PRINTF_SETS; i++)
+    {
+        const uint64_t c0 = benchNowNs();
+        dlPrintfSet();
+        const uint64_t c = benchNowNs() - c0;
+        if (c > worst)
+            worst = c;
+    }
+    benchReport("deferred_log", "before: Serial.printf per line", (benchNowNs() - t0) / 1000.0 / (DL_PRINTF_SETS * 3), "us");
+    benchReport("deferred_log", "before: worst set of 3 lines", worst / 1000.0, "us");
+    sim::setSerialBaud(0);
+
+    // After: queue only (drained between batches, untimed)
+    DEFERRED_LOG::flush();
+    DEFERRED_LOG::getStats(s0);
+    uint64_t queuedNs = 0;
+    for (uint32_t done = 0; done < DL_LOG_CALLS; done += 3 * 16)
+    {
+        t0 = benchNowNs();
+        for (uint32_t i = 0; i < 16; i++)
+            dlLogSet();
+        queuedNs += benchNowNs() - t0;
+        DEFERRED_LOG::flush();
+    }
+    DEFERRED_LOG::getStats(s1);
+    const uint32_t calls = s1.queued - s0.queued + s1.dropped - s0.dropped;
+    benchReport("deferred_log", "after: DLOG per line", (double)queuedNs / calls, "ns");
+    benchReport("deferred_log", "after: dropped", s1.dropped - s0.dropped, "");
+
+    char line[DLOG_LINE_MAX];
+    DlogRecord r;
+    r.format = "[BMS] ✅ SOC calculated: %.1f%% (%.1fAh / %.0fAh) Range=%.1fkm Model=%d\n";
+    r.argc = 0;
+    for (float v : {57.6f, 34.5f, 60.0f, 93.3f})
+        r.types[r.argc] = DEFERRED_LOG::packArg(r.args[r.argc], v), r.argc++;
+    r.types[r.argc] = DEFERRED_LOG::packArg(r.args[r.argc], 2), r.argc++;
+    t0 = benchNowNs();
+    for (uint32_t i = 0; i < 100000; i++)
+        DEFERRED_LOG::format(r, line, sizeof(line));
+    benchReport("deferred_log", "LOG task: format per line", (benchNowNs() - t0) / 100000.0, "ns");
+
+    // Burst: the LOG task writes at 115200 while 200 lines arrive at once
+    DEFERRED_LOG::init();
+    sim::setSerialBaud(DL_BAUD);
+    DEFERRED_LOG::getStats(s0);
+    worst = 0;
+    for (uint32_t i = 0; i < DL_BURST; i++)
+    {
+        const uint64_t c0 = benchNowNs();
+        DLOG("[BMS] ChargingAh received: raw=0x%08X (%.3fAh)\n", (unsigned)i, dlChargeAh);
+        const uint64_t c = benchNowNs() - c0;
+        if (c > worst)
+            worst = c;
+    }
+    DEFERRED_LOG::flush();
+    DEFERRED_LOG::getStats(s1);
+    sim::setSerialBaud(0);
+    benchReport("deferred_log", "burst: lines", DL_BURST, "");
+    benchReport("deferred_log", "burst: written", s1.written - s0.written, "");
+    benchReport("deferred_log", "burst: dropped (counted)", s1.dropped - s0.dropped, "");
+    benchReport("deferred_log", "burst: worst DLOG call", worst / 1000.0, "us");
+
+    // MPSC: 4 producers, one consumer, nothing lost uncounted
+    dlMpsc(true);
+    dlMpsc(false);
+}
@@ -0,0 +1,366 @@
+#include "bench.h"
+#include "../../include/core/datatransfer_payload.h"
+#include "../../include/core/ocpp_outbox.h"
+#include "sim/sim_flash.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+// Heap fragmentation from custom DataTransfer messages over 100k messages.
+// The allocations of each message are replayed into a first-fit heap model
+// with coalescing (8-byte header, 8-byte granularity) of ESP32 size, next
+// to unrelated traffic (16 B - 1.6 KB blocks living 1-200 messages, the
+// WiFi / lwIP / MicroOcpp churn from other tasks) that may land between
+// any two steps of a message, with the same random sequence in both runs.
+//
+//   json   - the former builders: std::function capture (SessionSummary,
+//            VehicleInfo), inner JsonDoc, String grown in 32-byte steps by
+//            serializeJson, outer JsonDoc holding a copy of the String
+//   arena  - DATATRANSFER: nothing but a JSON_OBJECT_SIZE(3) document; the
+//            heap region is smaller by DATATRANSFER::arenaBytes(), the
+//            static arena comes out of the same DRAM
+//
+// Both runs share MicroOcpp's part: Request + operation (freed when the
+// CALLRESULT arrives 2-8 messages later), request document and serialized
+// text. Data text lengths are those of a sim run with 12 ids per bus.
+// Besides the free-block figures, the OCPP task's allocations per message
+// and its largest transient heap demand for one message are reported.
+//
+// burst - BMS alerts held as if queued behind a slow CALLRESULT, then a
+//         CanBusStats: every alert must still be in the arena or in the
+//         outbox (flash stand-in), none lost
+
+static const size_t DTH_HEAP_BYTES = 96 * 1024;
+static const uint32_t DTH_MESSAGES = 100000;
+
+// First-fit heap with coalescing; offsets only, nothing is touched
+class HeapModel
+{
+public:
+    explicit HeapModel(size_t bytes) : free_{{0, bytes}}, failures_(0), allocs_(0), used_bytes_(0), peak_(0) {}
+
+    // Block handle = offset + 1, 0 = failed
+    size_t alloc(size_t size)
+    {
+        const size_t need = (size + 8 + 7) & ~(size_t)7;
+        for (size_t i = 0; i < free_.size(); i++)
+        {
+            if (free_[i].size < need)
+                continue;
+            const size_t off = free_[i].off;
+            free_[i].off += need;
+            free_[i].size -= need;
+            if (free_[i].size == 0)
+                free_.erase(free_.begin() + i);
+            used_.push_back({off, need});
+            allocs_++;
+            used_bytes_ += need;
+            peak_ = used_bytes_ > peak_ ? used_bytes_ : peak_;
+            return off + 1;
+        }
+        failures_++;
+        return 0;
+    }
+
+    void release(size_t handle)
+    {
+        if (handle == 0)
+            return;
+        const size_t off = handle - 1;
+        size_t size = 0;
+        for (size_t i = 0; i < used_.size(); i++)
+        {
+            if (used_[i].off == off)
+            {
+                size = used_[i].size;
+                used_bytes_ -= size;
+                used_[i] = used_.back();
+                used_.pop_back();
+                break;
+            }
+        }
+        size_t i = 0;
+        while (i < free_.size() && free_[i].off < off)
+            i++;
+        free_.insert(free_.begin() + i, {off, size});
+        if (i + 1 < free_.size() && free_[i].off + free_[i].size == free_[i + 1].off)
+        {
+            free_[i].size += free_[i + 1].size;
+            free_.erase(free_.begin() + i + 1);
+        }
+        if (i > 0 && free_[i - 1].off + free_[i - 1].size == free_[i].off)
+        {
+            free_[i - 1].size += free_[i].size;
+            free_.erase(free_.begin() + i);
+        }
+    }
+
+    size_t realloc(size_t handle, size_t size)
+    {
+        release(handle);
+        return alloc(size);
+    }
+
+    size_t largestFree() const
+    {
+        size_t best = 0;
+        for (const Block &b : free_)
+            best = b.size > best ? b.size : best;
+        return best;
+    }
+
+    size_t totalFree() const
+    {
+        size_t total = 0;
+        for (const Block &b : free_)
+            total += b.size;
+        return total;
+    }
+
+    uint32_t failures() const { return failures_; }
+    uint32_t allocs() const { return allocs_; }
+    size_t used() const { return used_bytes_; }
+
+    /// High-water mark of used bytes since the last resetPeak()
+    size_t peak() const { return peak_; }
+    void resetPeak() { peak_ = used_bytes_; }
+
+private:
+    struct Block
+    {
+        size_t off;
+        size_t size;
+    };
+    std::vector<Block> free_;
+    std::vector<Block> used_;
+    uint32_t failures_;
+    uint32_t allocs_;
+    size_t used_bytes_;
+    size_t peak_;
+};
+
+struct DthMessage
+{
+    DataTransferMessage type;
+    uint32_t weight;    // per 100 messages
+    size_t textLen;     // data text
+    size_t capture;     // former std::function capture on the heap (0 = stored locally)
+    size_t innerDoc;    // former JsonDoc capacities
+    size_t outerDoc;
+};
+
+// VehicleInfo: former inner JSON ~70 chars / frame base64 ~56
+static const DthMessage dthMix[] = {
+    {DT_VEHICLE_TELEMETRY, 50, 70, 24, 256, 768},
+    {DT_BMS_ALERT, 20, 88, 0, 256, 512},
+    {DT_SESSION_SUMMARY, 15, 217, 128, 512, 1024},
+    {DT_BUS_STATS, 15, 2300, 0, 6144, 0}, // outer: text + 256
+};
+
+struct DthResult
+{
+    size_t finalLargest; // after the last message, traffic still live
+    size_t finalFree;
+    size_t minLargest;
+    double meanLargest;
+    uint32_t below16k; // messages after which no 16 KB block was left (TLS record buffer)
+    uint32_t failures;
+    uint32_t allocs;   // heap allocations of the OCPP task over all messages
+    size_t peakDemand; // largest heap growth while one message is built and sent
+};
+
+static uint32_t dthRng;
+static uint32_t dthRand(uint32_t n)
+{
+    dthRng = dthRng * 1664525UL + 1013904223UL;
+    return (dthRng >> 8) % n;
+}
+
+static DthResult runHeap(bool arena)
+{
+    const size_t region = DTH_HEAP_BYTES - (arena ? DATATRANSFER::arenaBytes() : 0);
+    HeapModel heap(region);
+    dthRng = 2024;
+
+    struct Live
+    {
+        size_t handle;
+        uint32_t until; // message index it is freed at
+    };
+    std::vector<Live> live;
+    DthResult r = {0, 0, region, 0.0, 0, 0, 0, 0};
+    uint32_t backgroundAllocs = 0;
+
+    uint32_t m = 0;
+    // Other tasks allocate while the OCPP task builds and sends (any step)
+    auto background = [&]()
+    {
+        if (dthRand(8) != 0)
+            return;
+        const size_t size = dthRand(4) == 0 ? 1600 : 16 + dthRand(480);
+        live.push_back({heap.alloc(size), m + 1 + dthRand(200)});
+        backgroundAllocs++;
+    };
+
+    for (; m < DTH_MESSAGES; m++)
+    {
+        background();
+
+        uint32_t pick = dthRand(100);
+        const DthMessage *msg = &dthMix[0];
+        for (const DthMessage &d : dthMix)
+        {
+            if (pick < d.weight)
+            {
+                msg = &d;
+                break;
+            }
+            pick -= d.weight;
+        }
+        const size_t wire = 70 + msg->textLen + msg->textLen / 6; // escaped quotes
+        const size_t usedBefore = heap.used();
+        heap.resetPeak();
+
+        // sendRequest(): Request + operation, plus the capture
+        const size_t request = heap.alloc(192);
+        const size_t capture = arena ? 0 : (msg->capture ? heap.alloc(msg->capture) : 0);
+        background();
+
+        // Payload builder
+        size_t outer;
+        if (arena)
+        {
+            outer = heap.alloc(48);
+            background();
+            background();
+        }
+        else
+        {
+            const size_t inner = heap.alloc(msg->innerDoc);
+            background();
+            size_t str = 0;
+            for (size_t len = 32; len < msg->textLen + 32; len += 32)
+                str = heap.realloc(str, len < msg->textLen ? len : msg->textLen + 1);
+            outer = heap.alloc(msg->outerDoc ? msg->outerDoc : msg->textLen + 256);
+            background();
+            heap.release(str);
+            heap.release(inner);
+        }
+
+        // MicroOcpp: CALL document and its text, sent and dropped
+        background();
+        const size_t callDoc = heap.alloc(64 + (arena ? 48 : msg->textLen + 48));
+        const size_t text = heap.alloc(wire + 32);
+        background();
+        heap.release(text);
+        heap.release(callDoc);
+        heap.release(outer);
+        live.push_back({request, m + 2 + dthRand(7)});
+        live.push_back({capture, m + 2 + dthRand(7)});
+        // Includes background blocks taken meanwhile, the same in both runs
+        const size_t demand = heap.peak() - usedBefore;
+        r.peakDemand = demand > r.peakDemand ? demand : r.peakDemand;
+
+        for (size_t i = 0; i < live.size();)
+        {
+            if (live[i].until <= m)
+            {
+                heap.release(live[i].handle);
+                live[i] = live.back();
+                live.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        const size_t largest = heap.largestFree();
+        r.minLargest = largest < r.minLargest ? largest : r.minLargest;
+        r.meanLargest += (double)largest / DTH_MESSAGES;
+        if (largest < 16384)
+            r.below16k++;
+    }
+
+    r.finalLargest = heap.largestFree();
+    r.finalFree = heap.totalFree();
+    r.failures = heap.failures();
+    r.allocs = heap.allocs() - backgroundAllocs;
+    return r;
+}
+
+static void dthReport(const char *run, const DthResult &r)
+{
+    char metric[48];
+    snprintf(metric, sizeof(metric), "%s largest free at 100k", run);
+    benchReport("dt_heap", metric, r.finalLargest, "B");
+    snprintf(metric, sizeof(metric), "%s total free at 100k", run);
+    benchReport("dt_heap", metric, r.finalFree, "B");
+    snprintf(metric, sizeof(metric), "%s largest free mean", run);
+    benchReport("dt_heap", metric, r.meanLargest, "B");
+    snprintf(metric, sizeof(metric), "%s largest free min", run);
+    benchReport("dt_heap", metric, r.minLargest, "B");
+    snprintf(metric, sizeof(metric), "%s msgs with < 16 KB block", run);
+    benchReport("dt_heap", metric, r.below16k, "");
+    snprintf(metric, sizeof(metric), "%s alloc failures", run);
+    benchReport("dt_heap", metric, r.failures, "");
+    snprintf(metric, sizeof(metric), "%s allocs per message", run);
+    benchReport("dt_heap", metric, (double)r.allocs / DTH_MESSAGES, "");
+    snprintf(metric, sizeof(metric), "%s peak demand per message", run);
+    benchReport("dt_heap", metric, r.peakDemand, "B");
+}
+
+static const uint32_t DTH_BURST_ALERTS = 12;
+
+static void runBurst()
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/rivot_dt_burst_%d.bin", (int)getpid());
+    remove(path);
+    if (!sim::flashAttach(OCPP_OUTBOX_PARTITION, path, 64 * 1024) || !OCPP_OUTBOX::init())
+        return;
+    DATATRANSFER::resetStats();
+
+    // Queued requests: hold() as sendDataTransfer() does, no CALLRESULT yet
+    DataTransferTicket alerts[DTH_BURST_ALERTS];
+    char message[32];
+    for (uint32_t i = 0; i < DTH_BURST_ALERTS; i++)
+    {
+        snprintf(message, sizeof(message), "burst alert %u", (unsigned)i);
+        alerts[i] = DATATRANSFER::stageBmsAlert("BMS_EMERGENCY_STOP", message, i);
+        DATATRANSFER::hold(alerts[i]);
+    }
+    DATATRANSFER::hold(DATATRANSFER::stageBusStats("Burst", 0));
+
+    // Each alert once: still linkable by its request, or replayed from the outbox
+    uint32_t inArena = 0, inOutbox = 0;
+    for (uint32_t i = 0; i < DTH_BURST_ALERTS; i++)
+        inArena += DATATRANSFER::data(DT_BMS_ALERT, alerts[i]) != nullptr;
+    OutboxRecord rec;
+    char text[OCPP_OUTBOX_MAX_DATA + 1];
+    while (OCPP_OUTBOX::peek(rec, text, sizeof(text)))
+    {
+        inOutbox += rec.type == DT_BMS_ALERT && strstr(text, "burst alert") != nullptr;
+        OCPP_OUTBOX::ack(rec.seq);
+    }
+    const DataTransferStats s = DATATRANSFER::stats(DT_BMS_ALERT);
+
+    benchReport("dt_heap", "burst alerts queued", DTH_BURST_ALERTS, "");
+    benchReport("dt_heap", "burst alerts in arena", inArena, "");
+    benchReport("dt_heap", "burst alerts in outbox", inOutbox, "");
+    benchReport("dt_heap", "burst alerts lost", s.lost, "");
+
+    sim::flashDetach(OCPP_OUTBOX_PARTITION);
+    remove(path);
+}
+
+SIM_BENCH(dt_heap, "DataTransfer payloads: heap fragmentation after 100k messages, ArduinoJson+String vs static arena")
+{
+    const DthResult json = runHeap(false);
+    const DthResult arena = runHeap(true);
+    dthReport("json", json);
+    dthReport("arena", arena);
+    benchReport("dt_heap", "arena static bytes", DATATRANSFER::arenaBytes(), "B");
+    runBurst();
+}
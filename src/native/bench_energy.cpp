@@ -0,0 +1,199 @@
+#include "bench.h"
+#include "../../include/core/energy_meter.h"
+#include <math.h>
+#include <stdio.h>
+
+// Offline metering accuracy: synthetic terminal V/I profiles are sampled the
+// way the charger broadcasts them (0x00433F01 every ~100 ms, RX latency
+// jitter, optional frame loss) and metered two ways:
+//
+//   loop tick  - the previous loop() integration: every ~10 ms take the
+//                latest frame, P * (millis() delta) into a float
+//   per frame  - EnergyIntegrator: trapezoid on each frame's RX time (us)
+//
+// Ground truth is the 1 ms trapezoid of the continuous profile. Errors are
+// relative, in ppm (1000 ppm = 0.1 %).
+//
+// long silence - the charger stops broadcasting for 2^32 us + 0.5 s
+// (~71.6 min) and resumes: with 64-bit RX times that is a gap; a 32-bit
+// microsecond stamp wraps and sees a 0.5 s interval to integrate.
+
+static const double PI = 3.14159265358979323846;
+
+struct Profile
+{
+    const char *name;
+    double seconds;
+    double lossRate;   // fraction of frames lost
+    double outageAtS;  // start of a charger silence (< 0 = none)
+    double outageLenS;
+    double stallEveryS; // loop() blocked (OCPP/WiFi) every N s (0 = never)
+    double stallLenS;
+    void (*sample)(double t, double &volt, double &curr);
+};
+
+// CC at 55 A for 20 min, then CV taper (tau 5 min); voltage climbs to 84 V
+static void ccCv(double t, double &v, double &i)
+{
+    v = t < 1200.0 ? 70.0 + 14.0 * t / 1200.0 : 84.0;
+    i = t < 1200.0 ? 55.0 : 55.0 * exp(-(t - 1200.0) / 300.0);
+}
+
+// Rectifier ripple: 40 A +- 8 A at 0.7 Hz on a 78 V pack
+static void ripple(double t, double &v, double &i)
+{
+    v = 78.0;
+    i = 40.0 + 8.0 * sin(2.0 * PI * 0.7 * t);
+}
+
+// Load steps between 10 A and 50 A every 7.3 s
+static void steps(double t, double &v, double &i)
+{
+    v = 76.0;
+    i = fmod(t, 14.6) < 7.3 ? 10.0 : 50.0;
+}
+
+// 1 h bulk at 55 A, then 90 min trickle at 3 A: the float accumulator is
+// large by then and each 10 ms delta is only ~1.5 float ulps
+static void bulkTrickle(double t, double &v, double &i)
+{
+    v = t < 3600.0 ? 72.0 + 12.0 * t / 3600.0 : 84.0;
+    i = t < 3600.0 ? 55.0 : 3.0;
+}
+
+static const Profile PROFILES[] = {
+    {"cc-cv", 2400.0, 0.0, -1.0, 0.0, 0.0, 0.0, ccCv},
+    {"ripple", 1200.0, 0.0, -1.0, 0.0, 0.0, 0.0, ripple},
+    {"steps", 1200.0, 0.0, -1.0, 0.0, 0.0, 0.0, steps},
+    {"steps+stalls", 1200.0, 0.0, -1.0, 0.0, 20.0, 1.5, steps},
+    {"bulk+trickle", 9000.0, 0.0, -1.0, 0.0, 0.0, 0.0, bulkTrickle},
+    {"cc-cv lossy", 2400.0, 0.05, 600.0, 3.0, 0.0, 0.0, ccCv},
+};
+
+// Deterministic LCG so runs are comparable
+static uint32_t rngState = 12345;
+static double rnd()
+{
+    rngState = rngState * 1664525UL + 1013904223UL;
+    return (rngState >> 8) / 16777216.0;
+}
+
+static double truthWh(const Profile &p)
+{
+    const double dt = 0.001;
+    double wh = 0.0, v, i;
+    p.sample(0.0, v, i);
+    double prev = v * i;
+    for (double t = dt; t <= p.seconds + 1e-9; t += dt)
+    {
+        p.sample(t, v, i);
+        const double pw = v * i;
+        wh += 0.5 * (prev + pw) * dt / 3600.0;
+        prev = pw;
+    }
+    return wh;
+}
+
+struct MeterResult
+{
+    double loopTickWh;
+    double perFrameWh;
+    EnergyMeterStats stats;
+};
+
+static MeterResult meter(const Profile &p)
+{
+    rngState = 12345;
+
+    EnergyIntegrator integrator;
+    integrator.setEnabled(true);
+
+    // Loop-tick model state
+    float loopWh = 0.0f;
+    uint32_t lastTickMs = 0;
+    bool haveFrame = false;
+    float frameV = 0.0f, frameI = 0.0f;
+    double nextTick = 0.0;
+
+    double txT = 0.0;
+    while (txT <= p.seconds)
+    {
+        const double rxT = txT + 0.0002 + 0.0028 * rnd(); // 0.2-3 ms RX latency
+
+        // loop() ticks that run before this frame is decoded see the previous one
+        while (nextTick < rxT && nextTick <= p.seconds)
+        {
+            const uint32_t nowMs = (uint32_t)(nextTick * 1000.0);
+            if (haveFrame && frameV > 56.0f && frameV < 85.5f && frameI > 0.0f && frameI < 300.0f)
+            {
+                const float dtHours = (nowMs - lastTickMs) / 3600000.0f;
+                const float delta = frameV * frameI * dtHours;
+                if (delta > 0.0f && delta < 1000.0f)
+                    loopWh += delta;
+            }
+            lastTickMs = nowMs;
+            nextTick += 0.010 + 0.003 * rnd(); // 10 ms vTaskDelay + scheduling jitter
+            if (p.stallEveryS > 0.0 && fmod(nextTick, p.stallEveryS) < 0.013)
+                nextTick += p.stallLenS;
+        }
+
+        const bool outage = p.outageAtS >= 0.0 && txT >= p.outageAtS && txT < p.outageAtS + p.outageLenS;
+        if (!outage && rnd() >= p.lossRate)
+        {
+            double v, i;
+            p.sample(txT, v, i);
+            frameV = (float)v;
+            frameI = (float)i;
+            haveFrame = true;
+            integrator.addSample((uint64_t)(rxT * 1e6), frameV, frameI);
+        }
+
+        txT += 0.100 + 0.004 * (rnd() - 0.5); // charger broadcast period +- 2 ms
+    }
+
+    return {loopWh, integrator.energyWh(), integrator.stats()};
+}
+
+static void longSilence()
+{
+    const uint64_t silenceUs = (1ULL << 32) + 500000ULL;
+    const uint64_t times[] = {0, 100000, 100000 + silenceUs, 200000 + silenceUs};
+    double wh[2];
+    uint32_t gaps[2];
+    for (int wide = 0; wide < 2; wide++)
+    {
+        EnergyIntegrator integrator;
+        integrator.setEnabled(true);
+        for (uint64_t t : times)
+            integrator.addSample(wide ? t : (uint64_t)(uint32_t)t, 72.0f, 50.0f);
+        wh[wide] = integrator.energyWh();
+        gaps[wide] = integrator.stats().gaps;
+    }
+    benchReport("energy", "silence 71.6 min 32-bit gaps", gaps[0], "");
+    benchReport("energy", "silence 71.6 min 32-bit Wh", wh[0], "Wh");
+    benchReport("energy", "silence 71.6 min 64-bit gaps", gaps[1], "");
+    benchReport("energy", "silence 71.6 min 64-bit Wh", wh[1], "Wh");
+}
+
+SIM_BENCH(energy, "metering accuracy: loop-tick float integration vs per-frame trapezoid")
+{
+    for (const Profile &p : PROFILES)
+    {
+        const double truth = truthWh(p);
+        const MeterResult r = meter(p);
+        char metric[48];
+
+        snprintf(metric, sizeof(metric), "%s truth", p.name);
+        benchReport("energy", metric, truth, "Wh");
+        snprintf(metric, sizeof(metric), "%s loop tick err", p.name);
+        benchReport("energy", metric, 1e6 * (r.loopTickWh - truth) / truth, "ppm");
+        snprintf(metric, sizeof(metric), "%s per frame err", p.name);
+        benchReport("energy", metric, 1e6 * (r.perFrameWh - truth) / truth, "ppm");
+        if (r.stats.gaps)
+        {
+            snprintf(metric, sizeof(metric), "%s gaps skipped", p.name);
+            benchReport("energy", metric, r.stats.gapSeconds, "s");
+        }
+    }
+    longSilence();
+}
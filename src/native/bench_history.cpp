@@ -0,0 +1,161 @@
+#include "bench.h"
+#include "../../include/core/signal_history.h"
+#include <math.h>
+#include <stdio.h>
+
+// 24 h of charger telemetry into SignalHistory: terminal V / I at 10 Hz
+// (frame jitter +-2 ms), charger temperature at 1 Hz, SOC at 1 Hz.
+// V ramps 60 -> 84 V over each 4 h session with 0.3 V ripple, I follows a
+// CC/CV profile, the charger idles (no samples) 20 min between sessions.
+//
+//   insert  - wall time per SignalHistory::record() over the whole day
+//   query   - summary of the last 5 min / 1 h / 24 h from the tier
+//             tierFor() picks, against min / max / mean computed exactly
+//             over the same bucket-aligned range from the raw samples
+//   memory  - static store vs raw float samples for the same 24 h
+
+static const uint32_t HIST_DAY_S = 24 * 3600;
+static const uint32_t HIST_SESSION_S = 4 * 3600;
+static const uint32_t HIST_IDLE_S = 20 * 60;
+static const uint32_t HIST_RATE_HZ = 10;
+
+static SignalHistory benchHistory;
+
+static uint32_t histRng = 777;
+static float histRnd()
+{
+    histRng = histRng * 1664525UL + 1013904223UL;
+    return (histRng >> 8) / 16777216.0f;
+}
+
+// Sample time in seconds (charging), false while the charger idles
+static bool histCharging(double t, double &inSession)
+{
+    inSession = fmod(t, (double)(HIST_SESSION_S + HIST_IDLE_S));
+    return inSession < HIST_SESSION_S;
+}
+
+static float histVolt(double s)
+{
+    return (float)(60.0 + 24.0 * s / HIST_SESSION_S + 0.3 * sin(s * 7.0));
+}
+
+static float histCurr(double s)
+{
+    const double x = s / HIST_SESSION_S;
+    return (float)(x < 0.7 ? 30.0 : 30.0 * (1.0 - x) / 0.3 + 0.5);
+}
+
+// Exact reference over [fromS, toS) for one channel (regenerates the samples)
+struct HistExact
+{
+    double min;
+    double max;
+    double sum;
+    uint32_t n;
+
+    void add(double v)
+    {
+        if (n == 0 || v < min)
+            min = v;
+        if (n == 0 || v > max)
+            max = v;
+        sum += v;
+        n++;
+    }
+};
+
+// Replays the sample stream, calling fn(channel, value, tS)
+template <typename Fn>
+static void histStream(Fn fn)
+{
+    histRng = 777;
+    for (uint64_t k = 0; k < (uint64_t)HIST_DAY_S * HIST_RATE_HZ; k++)
+    {
+        const double t = k / (double)HIST_RATE_HZ + 0.002 * (histRnd() - 0.5) + 0.01;
+        double s;
+        if (!histCharging(t, s))
+            continue;
+        const uint32_t tS = (uint32_t)t;
+        fn(HIST_TERMINAL_VOLT, histVolt(s), tS);
+        fn(HIST_TERMINAL_CURR, histCurr(s), tS);
+        if (k % HIST_RATE_HZ == 0)
+        {
+            fn(HIST_CHARGER_TEMP, (float)(35.0 + 15.0 * s / HIST_SESSION_S), tS);
+            fn(HIST_SOC, (float)(20.0 + 75.0 * s / HIST_SESSION_S), tS);
+        }
+    }
+}
+
+static void histCheck(const char *label, uint32_t backS, uint32_t nowS)
+{
+    const uint8_t tier = SignalHistory::tierFor(nowS - backS, nowS);
+    const uint32_t period = HISTORY_TIER_SPECS[tier].periodS;
+    const uint32_t fromS = (nowS - backS) / period * period; // bucket aligned
+    const uint32_t toS = nowS - 1;
+
+    HistExact exact[HIST_CHANNELS] = {};
+    histStream([&](HistoryChannel ch, float v, uint32_t tS)
+               {
+        if (tS >= fromS && tS < nowS)
+            exact[ch].add(v); });
+
+    static HistoryPoint pts[HISTORY_TIER2_BUCKETS];
+    double worstMinMax = 0.0, worstMean = 0.0;
+    uint64_t queryNs = 0;
+    for (uint8_t ch = 0; ch < HIST_CHANNELS; ch++)
+    {
+        const uint64_t q0 = benchNowNs();
+        const size_t n = benchHistory.query((HistoryChannel)ch, tier, fromS, toS, pts, HISTORY_TIER2_BUCKETS);
+        queryNs += benchNowNs() - q0;
+
+        double mn = 0.0, mx = 0.0, meanSum = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            mn = (i == 0 || pts[i].min < mn) ? pts[i].min : mn;
+            mx = (i == 0 || pts[i].max > mx) ? pts[i].max : mx;
+            meanSum += pts[i].mean;
+        }
+        if (n == 0 || exact[ch].n == 0)
+            continue;
+        const double e = exact[ch].sum / exact[ch].n;
+        worstMinMax = fmax(worstMinMax, fmax(fabs(mn - exact[ch].min), fabs(mx - exact[ch].max)));
+        worstMean = fmax(worstMean, fabs(meanSum / n - e) / fabs(e));
+    }
+
+    char metric[48];
+    snprintf(metric, sizeof(metric), "%s tier", label);
+    benchReport("history", metric, tier, "");
+    snprintf(metric, sizeof(metric), "%s min/max err", label);
+    benchReport("history", metric, 1000.0 * worstMinMax, "milli-units");
+    snprintf(metric, sizeof(metric), "%s mean err", label);
+    benchReport("history", metric, 1e6 * worstMean, "ppm");
+    snprintf(metric, sizeof(metric), "%s query 4 ch", label);
+    benchReport("history", metric, queryNs / 1000.0, "us");
+}
+
+SIM_BENCH(history, "signal history: O(1) insert, 24 h of 10 Hz V/I in fixed memory, summary accuracy")
+{
+    benchHistory.reset();
+
+    uint64_t samples = 0, rawBytes = 0;
+    uint64_t insertNs = 0;
+    histStream([&](HistoryChannel ch, float v, uint32_t tS)
+               {
+        const uint64_t t0 = benchNowNs();
+        benchHistory.record(ch, v, tS);
+        insertNs += benchNowNs() - t0;
+        samples++;
+        rawBytes += sizeof(uint32_t) + sizeof(float); });
+
+    benchReport("history", "samples", (double)samples, "");
+    benchReport("history", "insert", (double)insertNs / samples, "ns/sample");
+    benchReport("history", "store", (double)SignalHistory::memoryBytes(), "bytes");
+    benchReport("history", "raw samples (t, float)", (double)rawBytes, "bytes");
+
+    histCheck("last 5 min", 5 * 60, HIST_DAY_S);
+    histCheck("last 1 h", 3600, HIST_DAY_S);
+    histCheck("last 24 h", HIST_DAY_S - HISTORY_TIER2_PERIOD_S, HIST_DAY_S);
+
+    benchHistory.reset();
+}
@@ -0,0 +1,231 @@
+#include "bench.h"
+#include "../../include/drivers/can_mcp2515_driver.h"
+#include "../../include/config/hardware.h"
+#include "../../include/config/timing.h"
+#include <SPI.h>
+#include <sim/sim_clock.h>
+#include <sim/sim_mcp2515.h>
+#include <sim/virtual_bus.h>
+#include <algorithm>
+#include <stdio.h>
+#include <vector>
+
+// CAN2 receive path against the MCP2515 model on virtual time, 60 s per
+// traffic profile. Only ids passing the BMS filters are generated.
+//
+//   legacy     - the former can2_rx_task: wakes every 10 ms, one library
+//                readMessage() per wake, EFLG read every wake, no rollover
+//   interrupt  - CAN_MCP2515::serviceRx() run 50 us after each INT falling
+//                edge (ISR -> task notify) and every CAN2_EFLG_POLL_MS
+//
+// Profiles:
+//   bms        - 0x1806E5F4 every 100 ms, Ah responses every 2 s at a
+//                random offset (the firmware's normal load)
+//   burst      - the three ids back to back every 20 ms
+
+static const uint64_t MCP_RUN_US = 60ULL * 1000000ULL;
+static const uint64_t MCP_WAKE_LATENCY_US = 50;
+static const uint64_t MCP_LEGACY_TICK_US = 10000;
+static const uint32_t MCP_FRAME_US = 540; // 8-byte extended frame at 250 kbit/s
+
+struct Arrival
+{
+    uint64_t t_us;
+    uint32_t id;
+};
+
+struct McpResult
+{
+    uint32_t offered;
+    uint32_t received;
+    uint32_t lost;
+    uint32_t spi;
+};
+
+static uint32_t mcpRng = 1;
+static uint32_t mcpRandom(uint32_t range)
+{
+    mcpRng = mcpRng * 1664525UL + 1013904223UL;
+    return (mcpRng >> 8) % range;
+}
+
+static std::vector<Arrival> bmsProfile()
+{
+    std::vector<Arrival> a;
+    mcpRng = 1;
+    for (uint64_t t = 0; t < MCP_RUN_US; t += 100000)
+        a.push_back({t + 3000, ID_BMS_REQUEST});
+    for (uint64_t t = 0; t < MCP_RUN_US; t += 2000000)
+    {
+        a.push_back({t + mcpRandom(1000000), ID_CHARGE_AH_RESPONSE});
+        a.push_back({t + 1000000 + mcpRandom(1000000), ID_DISCHARGE_AH_RESPONSE});
+    }
+    std::sort(a.begin(), a.end(), [](const Arrival &x, const Arrival &y)
+              { return x.t_us < y.t_us; });
+    return a;
+}
+
+static std::vector<Arrival> burstProfile()
+{
+    std::vector<Arrival> a;
+    for (uint64_t t = 0; t < MCP_RUN_US; t += 20000)
+    {
+        a.push_back({t + 1000, ID_BMS_REQUEST});
+        a.push_back({t + 1000 + MCP_FRAME_US, ID_CHARGE_AH_RESPONSE});
+        a.push_back({t + 1000 + 2 * MCP_FRAME_US, ID_DISCHARGE_AH_RESPONSE});
+    }
+    return a;
+}
+
+static void putFrame(const Arrival &a)
+{
+    sim::BusFrame f = {};
+    f.id = a.id;
+    f.dlc = 8;
+    f.extended = true;
+    f.data[0] = (uint8_t)a.t_us;
+    sim::setClockUs(a.t_us);
+    sim::busSend(sim::BUS_BMS, f);
+}
+
+// Former CAN2 setup: filters without reset(), so no rollover; RX interrupts on
+static void legacySetup(MCP2515 &mcp)
+{
+    mcp.setConfigMode();
+    mcp.setBitrate(CAN_250KBPS, MCP_8MHZ);
+    mcp.setFilter(MCP2515::RXF0, true, ID_BMS_REQUEST);
+    mcp.setFilter(MCP2515::RXF1, true, ID_CHARGE_AH_RESPONSE);
+    mcp.setFilter(MCP2515::RXF2, true, ID_DISCHARGE_AH_RESPONSE);
+    mcp.setFilterMask(MCP2515::MASK0, true, 0x1FFFFFFFUL);
+    mcp.setFilterMask(MCP2515::MASK1, true, 0x1FFFFFFFUL);
+
+    const uint8_t rxb0ctrl[3] = {0x02, 0x60, 0x00};
+    const uint8_t caninte[3] = {0x02, 0x2B, MCP2515::CANINTF_RX0IF | MCP2515::CANINTF_RX1IF};
+    for (const uint8_t *cmd : {rxb0ctrl, caninte})
+    {
+        digitalWrite(CAN2_CS_PIN, LOW);
+        SPI.writeBytes(cmd, 3);
+        digitalWrite(CAN2_CS_PIN, HIGH);
+    }
+    mcp.clearInterrupts();
+    mcp.clearRXnOVRFlags();
+    mcp.setNormalMode();
+}
+
+static McpResult runLegacy(const std::vector<Arrival> &arrivals)
+{
+    sim::setClockUs(0);
+    MCP2515 mcp(CAN2_CS_PIN);
+    legacySetup(mcp);
+
+    McpResult r = {};
+    const uint32_t spi0 = sim::mcp2515SpiTransactions();
+    const uint32_t lost0 = sim::mcp2515RxOverflowCount();
+    size_t next = 0;
+    for (uint64_t tick = MCP_LEGACY_TICK_US; tick <= MCP_RUN_US; tick += MCP_LEGACY_TICK_US)
+    {
+        while (next < arrivals.size() && arrivals[next].t_us < tick)
+            putFrame(arrivals[next++]);
+        sim::setClockUs(tick);
+
+        struct can_frame frame;
+        if (digitalRead(CAN2_INT_PIN) == LOW && mcp.readMessage(&frame) == MCP2515::ERROR_OK)
+            r.received++;
+        if (mcp.getErrorFlags() & (MCP2515::EFLG_RX0OVR | MCP2515::EFLG_RX1OVR))
+            mcp.clearRXnOVRFlags();
+    }
+    // Whatever is still buffered would be read on the next wakes
+    struct can_frame frame;
+    while (mcp.readMessage(&frame) == MCP2515::ERROR_OK)
+        r.received++;
+
+    r.offered = arrivals.size();
+    r.lost = sim::mcp2515RxOverflowCount() - lost0;
+    r.spi = sim::mcp2515SpiTransactions() - spi0;
+    return r;
+}
+
+static uint32_t serviceAndCount(uint64_t now)
+{
+    sim::setClockUs(now);
+    CAN_MCP2515::serviceRx();
+    CanMessage msgs[16];
+    uint32_t n = 0, got;
+    while ((got = CAN_MCP2515::receiveMessages(msgs, 16)) > 0)
+        n += got;
+    return n;
+}
+
+static McpResult runInterrupt(const std::vector<Arrival> &arrivals)
+{
+    sim::setClockUs(0);
+    CAN_MCP2515::init();
+    CAN_MCP2515::flushRxBuffer();
+    CAN_MCP2515::resetStatistics();
+
+    McpResult r = {};
+    const uint32_t spi0 = sim::mcp2515SpiTransactions();
+    const uint32_t lost0 = sim::mcp2515RxOverflowCount();
+    const uint64_t pollUs = CAN2_EFLG_POLL_MS * 1000ULL;
+    uint64_t timeoutAt = pollUs;
+    uint64_t wakeAt = UINT64_MAX;
+    size_t next = 0;
+
+    while (true)
+    {
+        const uint64_t arrival = next < arrivals.size() ? arrivals[next].t_us : UINT64_MAX;
+        const uint64_t wake = wakeAt < timeoutAt ? wakeAt : timeoutAt;
+        if (arrival == UINT64_MAX && wake > MCP_RUN_US)
+            break;
+
+        if (arrival <= wake)
+        {
+            // Falling edge on INT -> ISR notifies the task
+            const bool idle = digitalRead(CAN2_INT_PIN) == HIGH;
+            putFrame(arrivals[next++]);
+            if (idle && digitalRead(CAN2_INT_PIN) == LOW && wakeAt == UINT64_MAX)
+                wakeAt = arrival + MCP_WAKE_LATENCY_US;
+            continue;
+        }
+
+        r.received += serviceAndCount(wake);
+        wakeAt = digitalRead(CAN2_INT_PIN) == LOW ? wake + MCP_WAKE_LATENCY_US : UINT64_MAX;
+        timeoutAt = wake + pollUs;
+    }
+
+    r.offered = arrivals.size();
+    r.lost = sim::mcp2515RxOverflowCount() - lost0;
+    r.spi = sim::mcp2515SpiTransactions() - spi0;
+    CAN_MCP2515::deinit();
+    return r;
+}
+
+static void report(const char *run, const McpResult &r)
+{
+    char metric[48];
+    const double seconds = MCP_RUN_US / 1e6;
+    snprintf(metric, sizeof(metric), "%s frames lost", run);
+    benchReport("mcp2515", metric, r.lost, "frames");
+    snprintf(metric, sizeof(metric), "%s lost", run);
+    benchReport("mcp2515", metric, r.offered ? r.lost * 100.0 / r.offered : 0.0, "%");
+    snprintf(metric, sizeof(metric), "%s SPI/s", run);
+    benchReport("mcp2515", metric, r.spi / seconds, "txn/s");
+    snprintf(metric, sizeof(metric), "%s SPI/frame", run);
+    benchReport("mcp2515", metric, r.received ? (double)r.spi / r.received : 0.0, "txn");
+}
+
+SIM_BENCH(mcp2515, "CAN2 receive: 10 ms single-frame poll vs INT-driven burst drain")
+{
+    sim::useVirtualClock(true);
+    sim::mcp2515SetIntPin(CAN2_INT_PIN);
+
+    const std::vector<Arrival> bms = bmsProfile();
+    const std::vector<Arrival> burst = burstProfile();
+
+    report("bms legacy", runLegacy(bms));
+    report("bms interrupt", runInterrupt(bms));
+    report("burst legacy", runLegacy(burst));
+    report("burst interrupt", runInterrupt(burst));
+
+    sim::useVirtualClock(false);
+}
@@ -0,0 +1,222 @@
+#include "bench.h"
+#include "../../include/drivers/can_mcp2515_driver.h"
+#include "../../include/config/hardware.h"
+#include "../../include/config/timing.h"
+#include <sim/sim_clock.h>
+#include <sim/sim_mcp2515.h>
+#include <sim/virtual_bus.h>
+#include <stdio.h>
+
+// CAN2 error handling on virtual time (100 us steps), 30 s of BMS traffic
+// (0x1806E5F4 every 10 ms) through the MCP2515 model:
+//
+//   5.0 s               noisy bus for 200 ms: REC held at 128 (error-passive)
+//   10.0 s              bus-off
+//   20.0 / 20.5 / 21.0  three bus-offs in a row (the third within
+//                       CAN2_BUSOFF_WINDOW_MS reconfigures)
+//
+//   reinit   - the former can2_rx_task: EFLG read every CAN2_EFLG_POLL_MS,
+//              TXBO / RXEP -> clear flags, 100 ms, deinit(), 100 ms, init()
+//   graded   - CAN_MCP2515::serviceRx() on every INT low level and every
+//              CAN2_EFLG_POLL_MS (the task's wake-ups)
+//
+// Gap: longest interval between received frames within 500 ms of an event
+// (10 ms when nothing is missed).
+
+static const uint64_t REC2_RUN_US = 30000000ULL;
+static const uint64_t REC2_STEP_US = 100;
+static const uint64_t REC2_FRAME_US = 10000;
+static const uint64_t REC2_FRAME_OFFSET_US = 3000;
+static const uint64_t REC2_NOISE_US = 200000;
+static const uint64_t REC2_WINDOW_US = 500000;
+
+struct Rec2Event
+{
+    uint64_t atUs;
+    bool busOff; // else error-passive for REC2_NOISE_US
+};
+
+static const Rec2Event rec2Events[] = {
+    {5000000, false}, {10000000, true}, {20000000, true}, {20500000, true}, {21000000, true}};
+static const size_t REC2_EVENTS = sizeof(rec2Events) / sizeof(rec2Events[0]);
+
+struct Rec2Result
+{
+    uint32_t offered;
+    uint32_t received;
+    uint32_t reinits;
+    uint64_t gapUs[REC2_EVENTS];
+};
+
+// Traffic, injection and gap tracking; 'service' runs the CAN2 task under test
+// and returns the frames it received this step
+template <typename Service>
+static Rec2Result runScenario(Service service)
+{
+    Rec2Result r = {};
+    size_t nextEvent = 0;
+    uint64_t noiseEndUs = 0;
+    uint64_t lastRxUs = 0;
+
+    for (uint64_t t = 0; t < REC2_RUN_US; t += REC2_STEP_US)
+    {
+        sim::setClockUs(t);
+
+        if (nextEvent < REC2_EVENTS && t >= rec2Events[nextEvent].atUs)
+        {
+            if (rec2Events[nextEvent].busOff)
+                sim::mcp2515InjectBusOff();
+            else
+                noiseEndUs = t + REC2_NOISE_US;
+            nextEvent++;
+        }
+        // Errors between the good frames keep REC at 128
+        if (t < noiseEndUs)
+            sim::mcp2515InjectErrorPassive();
+
+        if (t % REC2_FRAME_US == REC2_FRAME_OFFSET_US)
+        {
+            sim::BusFrame f = {};
+            f.id = ID_BMS_REQUEST;
+            f.extended = true;
+            f.dlc = 8;
+            sim::busSend(sim::BUS_BMS, f);
+            r.offered++;
+        }
+
+        const uint32_t got = service(t, r);
+        if (got == 0)
+            continue;
+        r.received += got;
+        for (size_t i = 0; i < REC2_EVENTS; i++)
+        {
+            if (t >= rec2Events[i].atUs && t < rec2Events[i].atUs + REC2_WINDOW_US && t - lastRxUs > r.gapUs[i])
+                r.gapUs[i] = t - lastRxUs;
+        }
+        lastRxUs = t;
+    }
+    return r;
+}
+
+static Rec2Result runReinit()
+{
+    sim::setClockUs(0);
+    CAN_MCP2515::init();
+    MCP2515 mcp(CAN2_CS_PIN); // the old task's view of the chip (library calls)
+
+    enum
+    {
+        RUNNING,
+        DELAY_BEFORE_DEINIT,
+        DELAY_BEFORE_INIT
+    } phase = RUNNING;
+    uint64_t phaseUntil = 0, nextPoll = CAN2_EFLG_POLL_MS * 1000ULL;
+
+    Rec2Result r = runScenario([&](uint64_t t, Rec2Result &res) -> uint32_t
+                               {
+        if (phase == DELAY_BEFORE_DEINIT)
+        {
+            if (t < phaseUntil)
+                return 0;
+            CAN_MCP2515::deinit();
+            phase = DELAY_BEFORE_INIT;
+            phaseUntil = t + 100000;
+            return 0;
+        }
+        if (phase == DELAY_BEFORE_INIT)
+        {
+            if (t < phaseUntil)
+                return 0;
+            CAN_MCP2515::init();
+            res.reinits++;
+            phase = RUNNING;
+            nextPoll = t + CAN2_EFLG_POLL_MS * 1000ULL;
+        }
+
+        uint32_t got = 0;
+        struct can_frame frame;
+        while (digitalRead(CAN2_INT_PIN) == LOW && mcp.readMessage(&frame) == MCP2515::ERROR_OK)
+            got++;
+
+        if (t >= nextPoll)
+        {
+            nextPoll = t + CAN2_EFLG_POLL_MS * 1000ULL;
+            if (mcp.getErrorFlags() & (MCP2515::EFLG_TXBO | MCP2515::EFLG_RXEP))
+            {
+                mcp.clearRXnOVRFlags();
+                mcp.clearInterrupts();
+                mcp.clearTXInterrupts();
+                phase = DELAY_BEFORE_DEINIT;
+                phaseUntil = t + 100000;
+            }
+        }
+        return got; });
+
+    CAN_MCP2515::deinit();
+    return r;
+}
+
+static Rec2Result runGraded(CanMcp2515RecoveryStats &stats)
+{
+    sim::setClockUs(0);
+    CAN_MCP2515::init();
+    CAN_MCP2515::flushRxBuffer();
+    CAN_MCP2515::resetRecoveryStats();
+    uint64_t nextPoll = 0;
+
+    Rec2Result r = runScenario([&](uint64_t t, Rec2Result &) -> uint32_t
+                               {
+        if (digitalRead(CAN2_INT_PIN) == HIGH && t < nextPoll)
+            return 0;
+        nextPoll = t + CAN2_EFLG_POLL_MS * 1000ULL;
+        CAN_MCP2515::serviceRx();
+
+        CanMessage msgs[16];
+        uint32_t got = 0, n;
+        while ((n = CAN_MCP2515::receiveMessages(msgs, 16)) > 0)
+            got += n;
+        return got; });
+
+    stats = CAN_MCP2515::getRecoveryStats();
+    CAN_MCP2515::deinit();
+    return r;
+}
+
+static void report(const char *run, const Rec2Result &r)
+{
+    char metric[48];
+    for (size_t i = 0; i < REC2_EVENTS; i++)
+    {
+        snprintf(metric, sizeof(metric), "%s gap %.1fs %s", run, rec2Events[i].atUs / 1e6,
+                 rec2Events[i].busOff ? "bus-off" : "passive");
+        benchReport("mcp2515_recovery", metric, r.gapUs[i] / 1000.0, "ms");
+    }
+    snprintf(metric, sizeof(metric), "%s frames lost", run);
+    benchReport("mcp2515_recovery", metric, r.offered - r.received, "");
+    snprintf(metric, sizeof(metric), "%s full reinits", run);
+    benchReport("mcp2515_recovery", metric, r.reinits, "");
+}
+
+SIM_BENCH(mcp2515_recovery, "CAN2 errors: deinit/init on every TXBO/RXEP vs graded in-place recovery")
+{
+    sim::useVirtualClock(true);
+    sim::mcp2515SetIntPin(CAN2_INT_PIN);
+    const Rec2Result reinit = runReinit();
+    CanMcp2515RecoveryStats stats;
+    Rec2Result graded = runGraded(stats);
+    graded.reinits = stats.runs[MCP_REC_REINIT];
+    sim::useVirtualClock(false);
+
+    static const char *PATHS[MCP_REC_PATHS] = {"passive", "mode toggle", "reconfigure"};
+    report("reinit", reinit);
+    report("graded", graded);
+    for (uint8_t p = 0; p < MCP_REC_PATHS; p++)
+    {
+        char metric[48];
+        snprintf(metric, sizeof(metric), "graded %s runs", PATHS[p]);
+        benchReport("mcp2515_recovery", metric, stats.runs[p], "");
+        const CanRecoveryHistogram &h = stats.time[p];
+        snprintf(metric, sizeof(metric), "graded %s recover max", PATHS[p]);
+        benchReport("mcp2515_recovery", metric, h.maxUs / 1000.0, "ms");
+    }
+}
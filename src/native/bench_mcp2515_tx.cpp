@@ -0,0 +1,179 @@
+#include "bench.h"
+#include "../../include/drivers/can_mcp2515_driver.h"
+#include "../../include/config/hardware.h"
+#include "../../include/config/timing.h"
+#include <sim/sim_clock.h>
+#include <sim/sim_mcp2515.h>
+#include <sim/virtual_bus.h>
+#include <stdio.h>
+#include <string.h>
+
+// Charger feedback heartbeat (0x18FF50E5, every HEARTBEAT_INTERVAL_MS) on
+// CAN2 through the MCP2515 model, 60 s of a CC charge: voltage 70.0 -> 72.0 V
+// (one 0.1 V step every 3 s), current 30.0 A +/- 0.1 A changing about once a
+// second, status flags constant. The payload is rebuilt every period.
+//
+//   library    - the former sendChargerFeedback(): MCP2515::sendMessage()
+//                per period (free buffer check, load, request, read-back)
+//   mailbox    - CAN_MCP2515::updateMailbox() per period and
+//                serviceMailbox() from the CAN2 task: changed bytes + RTS
+//
+// SPI time = transactions x 2 us (CS / setup) + bytes x 0.8 us (10 MHz).
+
+static const uint32_t TXB_RUN_MS = 60000;
+static const double TXB_TXN_US = 2.0;
+static const double TXB_BYTE_US = 0.8;
+
+struct TxbResult
+{
+    uint32_t frames;     // heartbeats on the bus
+    uint32_t stale;      // payload on the bus != payload built for that period
+    uint32_t spiTxns;
+    uint32_t spiBytes;
+    uint32_t loads;      // mailbox only
+    uint32_t reportedSavedPerMin;
+};
+
+struct TxbListener
+{
+    uint32_t frames;
+    uint8_t last[8];
+};
+
+static void onBmsFrame(const sim::BusFrame &f, void *ctx)
+{
+    TxbListener *l = (TxbListener *)ctx;
+    if (f.id != (ID_HEARTBEAT & 0x1FFFFFFFUL) || !f.extended)
+        return;
+    l->frames++;
+    memcpy(l->last, f.data, 8);
+}
+
+static uint32_t txbRng = 7;
+static uint32_t txbRandom(uint32_t range)
+{
+    txbRng = txbRng * 1664525UL + 1013904223UL;
+    return (txbRng >> 8) % range;
+}
+
+// Payload sendChargerFeedback() builds at time t
+static void feedbackPayload(uint32_t tMs, uint8_t out[8])
+{
+    static int currentOffset = 0;
+    if (tMs == 0)
+    {
+        txbRng = 7;
+        currentOffset = 0;
+    }
+    if (tMs % 1000 == 0)
+        currentOffset = (int)txbRandom(3) - 1;
+
+    const uint16_t vraw = (uint16_t)(700 + tMs / 3000);
+    const uint16_t iraw = (uint16_t)(300 + currentOffset);
+    out[0] = vraw >> 8;
+    out[1] = vraw & 0xFF;
+    out[2] = iraw >> 8;
+    out[3] = iraw & 0xFF;
+    out[4] = 0x05; // charging, BMS ok
+    out[5] = out[6] = out[7] = 0;
+}
+
+static TxbResult runLibrary()
+{
+    TxbResult r = {};
+    TxbListener l = {};
+    sim::setClockUs(0);
+    MCP2515 mcp(CAN2_CS_PIN);
+    mcp.setConfigMode();
+    mcp.setBitrate(CAN_250KBPS, MCP_8MHZ);
+    mcp.setNormalMode();
+    const int node = sim::busAttach(sim::BUS_BMS, onBmsFrame, &l);
+
+    const uint32_t txns0 = sim::mcp2515SpiTransactions(), bytes0 = sim::mcp2515SpiBytes();
+    for (uint32_t t = 0; t < TXB_RUN_MS; t += HEARTBEAT_INTERVAL_MS)
+    {
+        sim::setClockUs(t * 1000ULL);
+        struct can_frame frame;
+        frame.can_id = (ID_HEARTBEAT & 0x1FFFFFFFUL) | CAN_EFF_FLAG;
+        frame.can_dlc = 8;
+        feedbackPayload(t, frame.data);
+        mcp.sendMessage(&frame);
+        if (memcmp(l.last, frame.data, 8) != 0)
+            r.stale++;
+    }
+    r.spiTxns = sim::mcp2515SpiTransactions() - txns0;
+    r.spiBytes = sim::mcp2515SpiBytes() - bytes0;
+    r.frames = l.frames;
+    sim::busDetach(sim::BUS_BMS, node);
+    return r;
+}
+
+static TxbResult runMailbox()
+{
+    TxbResult r = {};
+    TxbListener l = {};
+    sim::setClockUs(0);
+    CAN_MCP2515::init();
+    CAN_MCP2515::resetStatistics();
+    const int node = sim::busAttach(sim::BUS_BMS, onBmsFrame, &l);
+
+    const uint32_t txns0 = sim::mcp2515SpiTransactions(), bytes0 = sim::mcp2515SpiBytes();
+    for (uint32_t t = 0; t < TXB_RUN_MS; t += HEARTBEAT_INTERVAL_MS)
+    {
+        // chargerCommTask refreshes the payload, the CAN2 task wakes when it is due
+        sim::setClockUs(t * 1000ULL);
+        uint8_t payload[8];
+        feedbackPayload(t, payload);
+        CAN_MCP2515::updateMailbox(ID_HEARTBEAT & 0x1FFFFFFFUL, payload, 8, true, HEARTBEAT_INTERVAL_MS);
+        sim::setClockUs(t * 1000ULL + 500);
+        CAN_MCP2515::serviceMailbox();
+        if (memcmp(l.last, payload, 8) != 0)
+            r.stale++;
+    }
+    r.spiTxns = sim::mcp2515SpiTransactions() - txns0;
+    r.spiBytes = sim::mcp2515SpiBytes() - bytes0;
+    r.frames = l.frames;
+
+    const CanMcp2515Status st = CAN_MCP2515::getStatus();
+    r.loads = st.mailbox_loads;
+    r.reportedSavedPerMin = st.mailbox_saved_us_per_min;
+    sim::busDetach(sim::BUS_BMS, node);
+    CAN_MCP2515::deinit();
+    return r;
+}
+
+static double spiUsPerMin(const TxbResult &r)
+{
+    const double minutes = TXB_RUN_MS / 60000.0;
+    return (r.spiTxns * TXB_TXN_US + r.spiBytes * TXB_BYTE_US) / minutes;
+}
+
+static void report(const char *run, const TxbResult &r)
+{
+    char metric[48];
+    const double minutes = TXB_RUN_MS / 60000.0;
+    snprintf(metric, sizeof(metric), "%s frames on bus", run);
+    benchReport("mcp2515_tx", metric, r.frames, "");
+    snprintf(metric, sizeof(metric), "%s stale payloads", run);
+    benchReport("mcp2515_tx", metric, r.stale, "");
+    snprintf(metric, sizeof(metric), "%s SPI transactions", run);
+    benchReport("mcp2515_tx", metric, r.spiTxns / minutes, "/min");
+    snprintf(metric, sizeof(metric), "%s SPI bytes", run);
+    benchReport("mcp2515_tx", metric, r.spiBytes / minutes, "/min");
+    snprintf(metric, sizeof(metric), "%s SPI bus time", run);
+    benchReport("mcp2515_tx", metric, spiUsPerMin(r) / 1000.0, "ms/min");
+}
+
+SIM_BENCH(mcp2515_tx, "CAN2 heartbeat: library sendMessage per period vs TXB2 mailbox, SPI cost")
+{
+    sim::useVirtualClock(true);
+    const TxbResult library = runLibrary();
+    const TxbResult mailbox = runMailbox();
+    sim::useVirtualClock(false);
+
+    report("library", library);
+    report("mailbox", mailbox);
+    benchReport("mcp2515_tx", "mailbox loads", mailbox.loads, "");
+    benchReport("mcp2515_tx", "SPI time saved", (spiUsPerMin(library) - spiUsPerMin(mailbox)) / 1000.0, "ms/min");
+    benchReport("mcp2515_tx", "driver reported saved", mailbox.reportedSavedPerMin / 1000.0, "ms/min");
+}
@@ -0,0 +1,176 @@
+#include "bench.h"
+#include "../../include/core/ocpp_events.h"
+#include "../../include/config/timing.h"
+#include <Arduino.h>
+#include <atomic>
+#include <string.h>
+#include <thread>
+
+// OCPP task loop on an idle charger, then with events from another task
+// (plug / health / BMS alert), in real time:
+//
+//   poll10   - the former loop: poll, vTaskDelay(10 ms); the OCPP side sees
+//              a state change on its next pass (as ocpp::poll() did with
+//              isChargerModuleHealthy())
+//   events   - OCPP_EVENTS: wait on the queue with tickMs(active); an event
+//              wakes the task at once
+//
+// Each run: OL_IDLE_MS with nothing happening (the charger has been idle
+// longer than OCPP_TICK_HOLD_MS), then OL_EVENTS events 25-75 ms apart.
+// mocpp_loop() itself is an empty stand-in, so the figures are wakeups and
+// reaction time, not MicroOcpp's own CPU cost.
+//
+// vehicle info - what flushVehicleInfo() now costs the loop task: copy the
+// batch into a slot and post it (it used to send, or offline append to the
+// flash outbox, itself); batches beyond OCPP_VEHICLE_INFO_SLOTS waiting are
+// refused, and each taken batch must match the one posted.
+
+static const uint32_t OL_IDLE_MS = 2000;
+static const uint32_t OL_EVENTS = 40;
+
+struct OlResult
+{
+    double idleWakeupsPerS;
+    double meanLatencyUs;
+    uint32_t maxLatencyUs;
+};
+
+static uint32_t olRng;
+static uint32_t olRand(uint32_t n)
+{
+    olRng = olRng * 1664525UL + 1013904223UL;
+    return (olRng >> 8) % n;
+}
+
+static OlResult runLoop(bool events)
+{
+    std::atomic<bool> stop{false};
+    std::atomic<uint32_t> passes{0};
+    std::atomic<uint64_t> pendingAtUs{0}; // poll10: state change not seen yet
+    std::atomic<uint64_t> latencySum{0};
+    std::atomic<uint32_t> latencyMax{0};
+    std::atomic<uint32_t> handled{0};
+
+    auto seen = [&](uint64_t postedUs)
+    {
+        const uint32_t us = (uint32_t)((uint64_t)esp_timer_get_time() - postedUs);
+        latencySum += us;
+        if (us > latencyMax)
+            latencyMax = us;
+        handled++;
+    };
+
+    OCPP_EVENTS::init();
+    OcppEvent drain;
+    while (OCPP_EVENTS::take(drain))
+    {
+    }
+    OCPP_EVENTS::tickMs(false);
+
+    std::thread ocppTask([&]
+                         {
+        while (!stop)
+        {
+            passes++; // mocpp_loop()
+            if (events)
+            {
+                OcppEvent e;
+                if (OCPP_EVENTS::wait(e, OCPP_EVENTS::tickMs(false)))
+                {
+                    do
+                        seen(e.postedUs);
+                    while (OCPP_EVENTS::take(e));
+                }
+            }
+            else
+            {
+                const uint64_t at = pendingAtUs.exchange(0);
+                if (at)
+                    seen(at);
+                vTaskDelay(pdMS_TO_TICKS(10));
+            }
+        } });
+
+    delay(OL_IDLE_MS);
+    const uint32_t idlePasses = passes;
+
+    olRng = 5;
+    for (uint32_t i = 0; i < OL_EVENTS; i++)
+    {
+        delay(25 + olRand(50));
+        if (events)
+            OCPP_EVENTS::postChargerHealth(i & 1);
+        else
+            pendingAtUs = (uint64_t)esp_timer_get_time();
+    }
+    delay(50);
+    stop = true;
+    if (events)
+        OCPP_EVENTS::postPlug(false); // wake for exit
+    ocppTask.join();
+
+    OlResult r;
+    r.idleWakeupsPerS = idlePasses * 1000.0 / OL_IDLE_MS;
+    r.meanLatencyUs = handled ? (double)latencySum / handled : 0.0;
+    r.maxLatencyUs = latencyMax;
+    return r;
+}
+
+static const uint32_t OL_VI_ROUNDS = 100000;
+
+static void runVehicleInfo()
+{
+    VehicleInfoBatch batch;
+    for (uint32_t i = 0; i < VEHICLE_INFO_BATCH_SAMPLES; i++)
+        batch.add(2, {i * 5000, 57.5f + i, 30.0f, 67.2f, 12.5f, 31.0f, 90.0f});
+
+    OCPP_EVENTS::init();
+    OcppEvent e;
+    while (OCPP_EVENTS::take(e))
+    {
+    }
+
+    // Loop task side, with the OCPP task keeping up
+    VehicleInfoBatch got;
+    uint64_t postNs = 0;
+    uint32_t mismatched = 0;
+    uint8_t a[64], b[64];
+    const size_t len = batch.encode(20000, a, sizeof(a));
+    for (uint32_t i = 0; i < OL_VI_ROUNDS; i++)
+    {
+        const uint64_t t0 = benchNowNs();
+        OCPP_EVENTS::postVehicleInfo(batch);
+        postNs += benchNowNs() - t0;
+        if (!OCPP_EVENTS::take(e) || !OCPP_EVENTS::takeVehicleInfo(e, got) || got.encode(20000, b, sizeof(b)) != len ||
+            memcmp(a, b, len) != 0)
+            mismatched++;
+    }
+    benchReport("ocpp_loop", "vehicle info post (loop task)", (double)postNs / OL_VI_ROUNDS, "ns");
+    benchReport("ocpp_loop", "vehicle info mismatched", mismatched, "");
+
+    // OCPP task stalled: the slots fill, later batches are refused
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < OCPP_VEHICLE_INFO_SLOTS + 2; i++)
+        accepted += OCPP_EVENTS::postVehicleInfo(batch) ? 1 : 0;
+    uint32_t taken = 0;
+    while (OCPP_EVENTS::take(e))
+        taken += OCPP_EVENTS::takeVehicleInfo(e, got) ? 1 : 0;
+    benchReport("ocpp_loop", "vehicle info stalled: accepted", accepted, "of 4");
+    benchReport("ocpp_loop", "vehicle info stalled: taken", taken, "");
+}
+
+SIM_BENCH(ocpp_loop, "OCPP task: fixed 10 ms poll vs event queue with adaptive tick (idle wakeups, event reaction)")
+{
+    const OlResult poll10 = runLoop(false);
+    const OlResult events = runLoop(true);
+
+    benchReport("ocpp_loop", "poll10 idle wakeups", poll10.idleWakeupsPerS, "/s");
+    benchReport("ocpp_loop", "poll10 event reaction mean", poll10.meanLatencyUs, "us");
+    benchReport("ocpp_loop", "poll10 event reaction max", poll10.maxLatencyUs, "us");
+    benchReport("ocpp_loop", "events idle wakeups", events.idleWakeupsPerS, "/s");
+    benchReport("ocpp_loop", "events event reaction mean", events.meanLatencyUs, "us");
+    benchReport("ocpp_loop", "events event reaction max", events.maxLatencyUs, "us");
+    benchReport("ocpp_loop", "idle wakeups saved", poll10.idleWakeupsPerS / events.idleWakeupsPerS, "x");
+    runVehicleInfo();
+    OCPP_EVENTS::resetStats();
+}
@@ -0,0 +1,181 @@
+#include "bench.h"
+#include "../../include/core/ocpp_outbox.h"
+#include "sim/sim_flash.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// OCPP outbox on the file-backed flash stand-in (esp_partition shim).
+//
+//   append   - 10k DataTransfers queued while offline, mix and data text
+//              lengths of a sim run: VehicleTelemetry 50 % (84 B),
+//              BMSAlert 20 % (88 B), SessionSummary 15 % (217 B),
+//              CanBusStats 15 % (967 B); the partition is sized so nothing
+//              is dropped
+//   recover  - reboot with all 10k pending: OCPP_OUTBOX::init() rebuilds
+//              head, tail and count from the headers
+//   replay   - peek + ack of every record in order, with a second reboot
+//              after 4000 acks that must resume at record 4001
+//   ocpplog  - the same 10k into the 512 KB partition of partitions.csv:
+//              oldest records dropped, erase spread across sectors
+//
+// Host wall time is that of the stand-in (a file); the ESP32 figure is
+// modelled from the flash operations counted by the shim with typical
+// SPI NOR timings (W25Q32 datasheet): 30 µs per page program plus 2.5 µs
+// per byte (0.7 ms for a full 256 B page), 45 ms per 4 KB sector erase,
+// reads at 20 MB/s plus 10 µs per call.
+
+static const uint32_t OB_RECORDS = 10000;
+static const uint32_t OB_REBOOT_AT = 4000;
+static const uint32_t OB_BIG_BYTES = 4 * 1024 * 1024;
+static const uint32_t OB_OCPPLOG_BYTES = 0x80000;
+
+struct ObMessage
+{
+    DataTransferMessage type;
+    uint32_t weight; // per 100 records
+    size_t len;
+};
+
+static const ObMessage obMix[] = {
+    {DT_VEHICLE_TELEMETRY, 50, 84},
+    {DT_BMS_ALERT, 20, 88},
+    {DT_SESSION_SUMMARY, 15, 217},
+    {DT_BUS_STATS, 15, 967},
+};
+
+static uint32_t obRng;
+static uint32_t obRand(uint32_t n)
+{
+    obRng = obRng * 1664525UL + 1013904223UL;
+    return (obRng >> 8) % n;
+}
+
+static const ObMessage &obPick()
+{
+    uint32_t pick = obRand(100);
+    for (const ObMessage &m : obMix)
+    {
+        if (pick < m.weight)
+            return m;
+        pick -= m.weight;
+    }
+    return obMix[0];
+}
+
+// Printable filler carrying the record number, so replay order can be checked
+static size_t obText(char *out, uint32_t n, size_t len)
+{
+    int head = snprintf(out, len + 1, "{\"n\":%u,\"f\":\"", (unsigned)n);
+    for (size_t i = (size_t)head; i + 2 < len; i++)
+        out[i] = (char)('a' + (n + i) % 26);
+    out[len - 2] = '"';
+    out[len - 1] = '}';
+    out[len] = '\0';
+    return len;
+}
+
+static double obFlashMs(const sim::FlashCounters &c)
+{
+    return c.pagesProgrammed * 0.030 + c.bytesWritten * 0.0025 + c.sectorsErased * 45.0 + c.reads * 0.010 +
+           c.bytesRead / 20000.0;
+}
+
+static bool obAttach(const char *path, uint32_t bytes, bool fresh)
+{
+    if (fresh)
+        remove(path);
+    if (!sim::flashAttach(OCPP_OUTBOX_PARTITION, path, bytes))
+        return false;
+    sim::flashResetCounters(OCPP_OUTBOX_PARTITION);
+    return OCPP_OUTBOX::init();
+}
+
+// Queue OB_RECORDS; returns host ns
+static uint64_t obAppendAll()
+{
+    char text[OCPP_OUTBOX_MAX_DATA + 1];
+    obRng = 7;
+    const uint64_t t0 = benchNowNs();
+    for (uint32_t n = 0; n < OB_RECORDS; n++)
+    {
+        const ObMessage &m = obPick();
+        OCPP_OUTBOX::append(m.type, text, obText(text, n, m.len));
+    }
+    return benchNowNs() - t0;
+}
+
+// Deliver `count` records in order; returns how many came back as queued
+static uint32_t obDrain(uint32_t first, uint32_t count)
+{
+    static char text[OCPP_OUTBOX_MAX_DATA + 1];
+    uint32_t inOrder = 0;
+    for (uint32_t n = first; n < first + count; n++)
+    {
+        OutboxRecord rec;
+        if (OCPP_OUTBOX::peek(rec, text, sizeof(text)) == 0)
+            break;
+        unsigned got = 0;
+        if (sscanf(text, "{\"n\":%u", &got) == 1 && got == n)
+            inOrder++;
+        OCPP_OUTBOX::ack(rec.seq);
+    }
+    return inOrder;
+}
+
+SIM_BENCH(outbox, "OCPP outbox: 10k offline DataTransfers appended, recovered after reboot and replayed")
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/rivot_outbox_bench_%d.bin", (int)getpid());
+
+    // Append
+    if (!obAttach(path, OB_BIG_BYTES, true))
+    {
+        benchReport("outbox", "partition attach failed", 0, "");
+        return;
+    }
+    const uint64_t appendNs = obAppendAll();
+    const sim::FlashCounters ac = sim::flashCounters(OCPP_OUTBOX_PARTITION);
+    const OutboxStats as = OCPP_OUTBOX::stats();
+    benchReport("outbox", "records queued", as.pending, "");
+    benchReport("outbox", "append host", (double)appendNs / OB_RECORDS, "ns/record");
+    benchReport("outbox", "append flash bytes", (double)ac.bytesWritten / OB_RECORDS, "B/record");
+    benchReport("outbox", "append ESP32 model", obFlashMs(ac) / OB_RECORDS, "ms/record");
+    benchReport("outbox", "append ESP32 throughput", OB_RECORDS / (obFlashMs(ac) / 1000.0), "records/s");
+
+    // Reboot with everything pending
+    const uint64_t r0 = benchNowNs();
+    obAttach(path, OB_BIG_BYTES, false);
+    const double recoverMs = (benchNowNs() - r0) / 1e6;
+    const sim::FlashCounters rc = sim::flashCounters(OCPP_OUTBOX_PARTITION);
+    benchReport("outbox", "recovered pending", OCPP_OUTBOX::stats().pending, "");
+    benchReport("outbox", "recover host", recoverMs, "ms");
+    benchReport("outbox", "recover ESP32 model", obFlashMs(rc), "ms");
+
+    // Replay, rebooting part way
+    const uint64_t d0 = benchNowNs();
+    uint32_t inOrder = obDrain(0, OB_REBOOT_AT);
+    obAttach(path, OB_BIG_BYTES, false);
+    const uint32_t resumed = OCPP_OUTBOX::stats().pending;
+    inOrder += obDrain(OB_REBOOT_AT, OB_RECORDS - OB_REBOOT_AT);
+    const double replayMs = (benchNowNs() - d0) / 1e6;
+    const sim::FlashCounters dc = sim::flashCounters(OCPP_OUTBOX_PARTITION);
+    benchReport("outbox", "pending after reboot at 4000", resumed, "");
+    benchReport("outbox", "replayed in order", inOrder, "");
+    benchReport("outbox", "replay host", replayMs, "ms");
+    benchReport("outbox", "replay ESP32 model (flash only)", obFlashMs(dc), "ms");
+    benchReport("outbox", "pending after replay", OCPP_OUTBOX::stats().pending, "");
+
+    // Production partition size
+    obAttach(path, OB_OCPPLOG_BYTES, true);
+    obAppendAll();
+    const OutboxStats ps = OCPP_OUTBOX::stats();
+    const sim::FlashCounters pc = sim::flashCounters(OCPP_OUTBOX_PARTITION);
+    benchReport("outbox", "ocpplog 512 KB pending", ps.pending, "");
+    benchReport("outbox", "ocpplog 512 KB dropped (oldest)", ps.dropped, "");
+    benchReport("outbox", "ocpplog erases per sector min", pc.minSectorErases, "");
+    benchReport("outbox", "ocpplog erases per sector max", pc.maxSectorErases, "");
+
+    sim::flashDetach(OCPP_OUTBOX_PARTITION);
+    remove(path);
+}
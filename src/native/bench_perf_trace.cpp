@@ -0,0 +1,127 @@
+#include "bench.h"
+#include "../../include/core/perf_trace.h"
+#include <Arduino.h>
+#include <atomic>
+#include <stdio.h>
+
+// Cost of one PERF_TRACE_SCOPE on the host, against what it replaces:
+//
+//   before  - a timing line per event, the way hot paths were measured so
+//             far (micros() around the call, then snprintf of "[BMS] decode
+//             %lu us"); Serial itself is not counted
+//   after   - an empty scope, armed and disarmed, minus the bare loop
+//   cores   - two tasks pinned to core 0 and 1 record at full rate: each
+//             ring must hold only its own core's scopes, in end-time order
+//
+// On the host the "cycle counter" is CLOCK_MONOTONIC in ns; on the ESP32
+// RSR CCOUNT is a single instruction, so the target cost is the atomic
+// add and a 12-byte store.
+
+#if PERF_TRACE_ENABLED
+
+static const uint32_t PT_EVENTS = 2000000;
+static const uint32_t PT_LOG_EVENTS = 200000;
+static const uint32_t PT_CORE_EVENTS = 200000;
+
+static inline void ptBarrier()
+{
+    asm volatile("" ::: "memory");
+}
+
+static double ptLoopNs(bool traced)
+{
+    const uint64_t t0 = benchNowNs();
+    for (uint32_t i = 0; i < PT_EVENTS; i++)
+    {
+        if (traced)
+        {
+            PERF_TRACE_SCOPE(PERF_BMS_RX);
+            ptBarrier();
+        }
+        else
+        {
+            ptBarrier();
+        }
+    }
+    return (double)(benchNowNs() - t0) / PT_EVENTS;
+}
+
+static std::atomic<uint32_t> ptDone{0};
+
+static void ptCoreTask(void *arg)
+{
+    const PerfTraceId id = (PerfTraceId)(uintptr_t)arg;
+    for (uint32_t i = 0; i < PT_CORE_EVENTS; i++)
+    {
+        PERF_TRACE_SCOPE(id);
+        ptBarrier();
+    }
+    ptDone++;
+    vTaskDelete(nullptr);
+}
+
+#endif // PERF_TRACE_ENABLED
+
+SIM_BENCH(perf_trace, "Scope timer: ns per traced event vs a formatted timing line, two cores recording at once")
+{
+#if PERF_TRACE_ENABLED
+    PERF_TRACE::clear();
+
+    // Before: time with micros() and format a line per event
+    char line[64];
+    volatile size_t sink = 0;
+    uint64_t t0 = benchNowNs();
+    for (uint32_t i = 0; i < PT_LOG_EVENTS; i++)
+    {
+        const uint32_t start = micros();
+        ptBarrier();
+        sink = sink + snprintf(line, sizeof(line), "[BMS] decode %lu us\n", (unsigned long)(micros() - start));
+    }
+    benchReport("perf_trace", "before: micros()+snprintf per event", (double)(benchNowNs() - t0) / PT_LOG_EVENTS, "ns");
+
+    const double bare = ptLoopNs(false);
+    const double armed = ptLoopNs(true);
+    perfTraceArmed = false;
+    const double disarmed = ptLoopNs(true);
+    perfTraceArmed = true;
+    benchReport("perf_trace", "after: scope armed", armed - bare, "ns");
+    benchReport("perf_trace", "after: scope disarmed", disarmed - bare, "ns");
+    benchReport("perf_trace", "records written", PERF_TRACE::recorded(), "");
+
+    // Two cores at once: no record lands in the other core's ring
+    PERF_TRACE::clear();
+    ptDone = 0;
+    xTaskCreatePinnedToCore(ptCoreTask, "PT_CORE0", 4096, (void *)(uintptr_t)PERF_CHARGER_RX, 5, nullptr, 0);
+    xTaskCreatePinnedToCore(ptCoreTask, "PT_CORE1", 4096, (void *)(uintptr_t)PERF_MOCPP_LOOP, 5, nullptr, 1);
+    t0 = benchNowNs();
+    while (ptDone < 2)
+        delay(1);
+    const double wallNs = (double)(benchNowNs() - t0);
+
+    uint32_t foreign = 0, disorder = 0;
+    const PerfTraceId own[2] = {PERF_CHARGER_RX, PERF_MOCPP_LOOP};
+    for (uint8_t c = 0; c < 2; c++)
+    {
+        const PerfTraceRing &ring = perfTraceRings[c];
+        const uint32_t head = ring.head.load();
+        if (head != PT_CORE_EVENTS)
+            foreign += head > PT_CORE_EVENTS ? head - PT_CORE_EVENTS : PT_CORE_EVENTS - head;
+        for (uint32_t i = head - PERF_TRACE_CAPACITY; i < head; i++)
+        {
+            const PerfTraceRecord &r = ring.records[i & (PERF_TRACE_CAPACITY - 1)];
+            const PerfTraceRecord &prev = ring.records[(i - 1) & (PERF_TRACE_CAPACITY - 1)];
+            if (r.id != own[c])
+                foreign++;
+            if (i > head - PERF_TRACE_CAPACITY && (int32_t)(r.endCycles - prev.endCycles) < 0)
+                disorder++;
+        }
+    }
+    benchReport("perf_trace", "2 cores: events", 2.0 * PT_CORE_EVENTS, "");
+    benchReport("perf_trace", "2 cores: wall per event", wallNs / PT_CORE_EVENTS, "ns");
+    benchReport("perf_trace", "2 cores: misplaced records", foreign, "");
+    benchReport("perf_trace", "2 cores: out of order", disorder, "");
+    PERF_TRACE::clear();
+#else
+    benchReport("perf_trace", "compiled out (PERF_TRACE_ENABLED 0)", 0, "");
+#endif
+}
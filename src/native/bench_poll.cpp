@@ -0,0 +1,170 @@
+#include "bench.h"
+#include "../../include/drivers/charger_poll.h"
+#include "../../include/config/hardware.h"
+#include <stdio.h>
+#include <string.h>
+
+// Charger poll schedule over a simulated 10 min charging session on
+// virtual time (no CAN driver): every transmitted request is answered
+// after 2 ms unless the response is lost (2 %). Reported per code: refresh
+// rate and worst age of the value, for
+//
+//   legacy     - the former fixed groups: one code per 500 ms control tick,
+//                ctrl and telemetry group on alternating ticks, round robin
+//                advancing only after a transmit (0x32 is sent on change only)
+//   scheduler  - ChargerPollScheduler with the firmware table and budget
+//   1% budget  - the same with the bus budget cut to 1 % (demand > budget)
+
+static const uint32_t POLL_RUN_MS = 600000;
+static const uint32_t POLL_TICK_MS = CHARGER_TX_TICK_MS;
+
+struct CodeTrace
+{
+    uint32_t responses;
+    uint32_t lastMs;
+    uint32_t worstAgeMs;
+};
+
+static uint32_t pollRng = 12345;
+static bool responseLost()
+{
+    pollRng = pollRng * 1664525UL + 1013904223UL;
+    return (pollRng >> 8) % 100 < 2;
+}
+
+static int codeIndex(uint8_t func)
+{
+    for (uint8_t i = 0; i < NUM_CHARGER_POLLS; i++)
+    {
+        if (chargerPolls[i].func == func)
+            return i;
+    }
+    return -1;
+}
+
+static void traceResponse(CodeTrace *trace, uint8_t func, uint32_t nowMs)
+{
+    const int i = codeIndex(func);
+    if (i < 0 || responseLost())
+        return;
+    CodeTrace &t = trace[i];
+    if (nowMs - t.lastMs > t.worstAgeMs)
+        t.worstAgeMs = nowMs - t.lastMs;
+    t.responses++;
+    t.lastMs = nowMs;
+}
+
+// The firmware builder's decisions while charging: command once, setpoints always
+static bool chargingBuild(uint8_t func, bool &commandSent)
+{
+    if (func == 0x32)
+    {
+        if (commandSent)
+            return false;
+        commandSent = true;
+    }
+    return true;
+}
+
+static uint32_t runLegacy(CodeTrace *trace)
+{
+    static const uint8_t CTRL[] = {0x32, 0x00, 0x03};
+    static const uint8_t TELEM[] = {0x84, 0x82, 0x79, 0x80, 0x83};
+    uint8_t ctrlIdx = 0, telemIdx = 0;
+    bool commandSent = false;
+    uint32_t frames = 0;
+
+    for (uint32_t now = 0, tick = 0; now < POLL_RUN_MS; now += POLL_TICK_MS, tick++)
+    {
+        const uint32_t phase = tick % (500 / POLL_TICK_MS);
+        if (phase == 0 && chargingBuild(CTRL[ctrlIdx], commandSent))
+        {
+            traceResponse(trace, CTRL[ctrlIdx], now + 2);
+            ctrlIdx = (ctrlIdx + 1) % 3;
+            frames += 2;
+        }
+        else if (phase == 1)
+        {
+            traceResponse(trace, TELEM[telemIdx], now + 2);
+            telemIdx = (telemIdx + 1) % 5;
+            frames += 2;
+        }
+    }
+    return frames;
+}
+
+static uint32_t runScheduler(CodeTrace *trace, uint8_t budgetPercent, uint32_t &deferred)
+{
+    ChargerPollScheduler sched;
+    sched.configure(chargerPolls, NUM_CHARGER_POLLS, CAN1_BAUDRATE, budgetPercent);
+    sched.beginTick(0);
+    sched.setCharging(true, 0);
+    bool commandSent = false;
+    uint32_t frames = 0;
+
+    for (uint32_t now = 0; now < POLL_RUN_MS; now += POLL_TICK_MS)
+    {
+        sched.beginTick(now);
+        for (int n = 0; n < CHARGER_POLL_MAX_PER_TICK; n++)
+        {
+            const int i = sched.pickDue();
+            if (i < 0)
+                break;
+            const uint8_t func = sched.spec(i).func;
+            const bool sent = chargingBuild(func, commandSent);
+            sched.complete(i, sent);
+            if (sent)
+            {
+                traceResponse(trace, func, now + 2);
+                frames += 2;
+            }
+        }
+        sched.endTick();
+    }
+
+    ChargerPollStats s[CHARGER_POLL_MAX_CODES];
+    const uint8_t n = sched.stats(s, CHARGER_POLL_MAX_CODES);
+    deferred = 0;
+    for (uint8_t i = 0; i < n; i++)
+        deferred += s[i].deferred;
+    return frames;
+}
+
+static void report(const char *run, CodeTrace *trace, uint32_t frames)
+{
+    char metric[48];
+    for (uint8_t i = 0; i < NUM_CHARGER_POLLS; i++)
+    {
+        CodeTrace &t = trace[i];
+        if (chargerPolls[i].priority == 0 || (t.responses == 0 && chargerPolls[i].periodChargingMs == 0))
+            continue; // commands, and codes on demand in the scheduler runs
+        if (POLL_RUN_MS - t.lastMs > t.worstAgeMs)
+            t.worstAgeMs = POLL_RUN_MS - t.lastMs; // still stale at the end
+        snprintf(metric, sizeof(metric), "%s 0x%02X refresh", run, chargerPolls[i].func);
+        benchReport("poll", metric, t.responses * 1000.0 / POLL_RUN_MS, "Hz");
+        snprintf(metric, sizeof(metric), "%s 0x%02X worst age", run, chargerPolls[i].func);
+        benchReport("poll", metric, t.worstAgeMs, "ms");
+    }
+    snprintf(metric, sizeof(metric), "%s bus load", run);
+    benchReport("poll", metric, frames * canFrameBits(8, true) * 100.0 / ((double)POLL_RUN_MS * CAN1_BAUDRATE / 1000.0), "%");
+}
+
+SIM_BENCH(poll, "charger poll schedule: legacy fixed groups vs deadline scheduler")
+{
+    CodeTrace trace[CHARGER_POLL_MAX_CODES];
+    uint32_t deferred = 0;
+
+    pollRng = 12345;
+    memset(trace, 0, sizeof(trace));
+    report("legacy", trace, runLegacy(trace));
+
+    pollRng = 12345;
+    memset(trace, 0, sizeof(trace));
+    report("scheduler", trace, runScheduler(trace, CHARGER_POLL_BUS_BUDGET_PCT, deferred));
+    benchReport("poll", "scheduler deferrals", deferred, "");
+
+    pollRng = 12345;
+    memset(trace, 0, sizeof(trace));
+    report("1% budget", trace, runScheduler(trace, 1, deferred));
+    benchReport("poll", "1% budget deferrals", deferred, "");
+}
@@ -0,0 +1,156 @@
+#include "bench.h"
+#include "../../include/core/telemetry.h"
+#include "../../include/header.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Torn-read stress: one writer (the CAN1 decoder) publishes terminal frames
+// as fast as it can while several readers (loop(), OCPP callbacks, console)
+// check that every tuple they see belongs to a single frame.
+//
+// Each frame n carries outputVolt = n and V/I/P derived from n, so a reader
+// can recompute the expected tuple from the tag and spot any mix of frames.
+// The first run reads field by field, as the bare globals allowed; the
+// detector must find tears there. The second run goes through TELEMETRY
+// and must find none.
+
+static const uint64_t SEQLOCK_RUN_NS = 1000000000ULL; // per phase
+static const int SEQLOCK_READERS = 3;
+
+static void makeFrame(uint32_t n, ChargerTelemetry &t)
+{
+    t.terminalVolt = 56.0f + (float)(n % 2048) * 0.0078125f;
+    t.terminalCurr = (float)(n % 4096) * 0.015625f;
+    t.terminalPower = t.terminalVolt * t.terminalCurr;
+    t.outputVolt = (float)n;
+    t.outputCurr = t.terminalCurr;
+    t.outputTemp = (float)(n % 100);
+    t.terminalRxUs = 0;
+}
+
+static bool isTorn(const ChargerTelemetry &got)
+{
+    if (got.outputVolt == 0.0f)
+        return false; // nothing published yet
+    ChargerTelemetry want;
+    makeFrame((uint32_t)got.outputVolt, want);
+    return got.terminalVolt != want.terminalVolt || got.terminalCurr != want.terminalCurr ||
+           got.terminalPower != want.terminalPower || got.outputCurr != want.outputCurr ||
+           got.outputTemp != want.outputTemp;
+}
+
+struct StressResult
+{
+    uint64_t reads;
+    uint64_t torn;
+    uint32_t frames;
+    double writeNs; // per published frame
+};
+
+// Field-by-field shared floats: what readers of the bare globals got
+static std::atomic<float> rawFields[6];
+
+template <typename PublishFn, typename ReadFn>
+static StressResult runStress(PublishFn publish, ReadFn read)
+{
+    std::atomic<bool> done(false);
+    std::atomic<uint64_t> reads(0), torn(0);
+    std::vector<std::thread> readers;
+
+    for (int r = 0; r < SEQLOCK_READERS; r++)
+    {
+        readers.emplace_back([&]
+                             {
+                                 uint64_t n = 0, bad = 0;
+                                 ChargerTelemetry t;
+                                 while (!done.load(std::memory_order_relaxed))
+                                 {
+                                     read(t);
+                                     n++;
+                                     if (isTorn(t))
+                                         bad++;
+                                 }
+                                 reads += n;
+                                 torn += bad;
+                             });
+    }
+
+    // Time-bounded so single-core hosts finish too; there the tears come
+    // from the writer being preempted between field stores
+    ChargerTelemetry frame;
+    const uint64_t t0 = benchNowNs();
+    uint64_t elapsed = 0;
+    uint32_t n = 0;
+    while (elapsed < SEQLOCK_RUN_NS && n < (1UL << 24) - 1024) // tag stays exact in a float
+    {
+        for (int i = 0; i < 1024; i++)
+        {
+            makeFrame(++n, frame);
+            publish(frame);
+        }
+        elapsed = benchNowNs() - t0;
+    }
+
+    done = true;
+    for (auto &th : readers)
+        th.join();
+
+    return {reads.load(), torn.load(), n, (double)elapsed / n};
+}
+
+SIM_BENCH(seqlock, "torn-read stress: bare per-field reads vs TELEMETRY seqlock snapshot")
+{
+    // Baseline: per-field stores and loads, no versioning
+    const StressResult bare = runStress(
+        [](const ChargerTelemetry &f)
+        {
+            rawFields[0].store(f.terminalVolt, std::memory_order_relaxed);
+            rawFields[1].store(f.terminalCurr, std::memory_order_relaxed);
+            rawFields[2].store(f.terminalPower, std::memory_order_relaxed);
+            // Preempted mid-update now and then, as a busy decoder task is;
+            // also makes tears visible on single-core hosts
+            if (((uint32_t)f.outputVolt & 63) == 0)
+                std::this_thread::yield();
+            rawFields[3].store(f.outputVolt, std::memory_order_relaxed);
+            rawFields[4].store(f.outputCurr, std::memory_order_relaxed);
+            rawFields[5].store(f.outputTemp, std::memory_order_relaxed);
+        },
+        [](ChargerTelemetry &t)
+        {
+            t.terminalVolt = rawFields[0].load(std::memory_order_relaxed);
+            t.terminalCurr = rawFields[1].load(std::memory_order_relaxed);
+            t.terminalPower = rawFields[2].load(std::memory_order_relaxed);
+            t.outputVolt = rawFields[3].load(std::memory_order_relaxed);
+            t.outputCurr = rawFields[4].load(std::memory_order_relaxed);
+            t.outputTemp = rawFields[5].load(std::memory_order_relaxed);
+        });
+
+    // Seqlock: the decoder's globals are copied by TELEMETRY::publishCharger()
+    const StressResult locked = runStress(
+        [](const ChargerTelemetry &f)
+        {
+            terminalVolt = f.terminalVolt;
+            terminalCurr = f.terminalCurr;
+            terminalchargerPower = f.terminalPower;
+            chargerVolt = f.outputVolt;
+            chargerCurr = f.outputCurr;
+            chargerTemp = f.outputTemp;
+            TELEMETRY::publishCharger();
+        },
+        [](ChargerTelemetry &t)
+        { t = TELEMETRY::charger(); });
+
+    benchReport("seqlock", "bare frames", (double)bare.frames, "");
+    benchReport("seqlock", "bare reads", (double)bare.reads, "");
+    benchReport("seqlock", "bare torn reads", (double)bare.torn, "");
+    benchReport("seqlock", "seqlock frames", (double)locked.frames, "");
+    benchReport("seqlock", "seqlock reads", (double)locked.reads, "");
+    benchReport("seqlock", "seqlock torn reads", (double)locked.torn, "");
+    benchReport("seqlock", "writer wall time", locked.writeNs, "ns/frame");
+
+    if (bare.torn == 0)
+        printf("seqlock: WARNING detector saw no tears in the bare run\n");
+    if (locked.torn != 0)
+        printf("seqlock: FAIL %llu torn snapshots\n", (unsigned long long)locked.torn);
+}
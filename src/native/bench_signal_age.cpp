@@ -0,0 +1,203 @@
+#include "bench.h"
+#include "../../include/header.h"
+#include "../../include/core/telemetry.h"
+#include "../../include/drivers/can_frame.h"
+#include <sim/sim_clock.h>
+#include <math.h>
+#include <string.h>
+
+// Signal timing on virtual time: terminal power frames (0x1081D27E) every
+// ~100 ms go through handleChargerMessage() with an RX -> decode delay
+// (mostly < 2 ms, 10 % of frames 20-80 ms behind a CAN2 drain or a held
+// dataMutex). loop() ticks every 10-13 ms and runs the plug check every
+// 500 ms. The terminal voltage sags at 1.8 V/s (under the 2 V/s disconnect
+// threshold) and steps back up every 5 s.
+//
+//   decode time  - the former consumers: lastTerminalPower = millis() in the
+//                  decoder, dV/dt over the loop() time between checks
+//   RX time      - TELEMETRY::ageMs() and the snapshot's terminalRxUs
+//
+// Age error: |reported - (now - RX time of the latest decoded frame)| at
+// every loop() tick. Rate error: relative to 1.8 V/s, over sag intervals.
+
+static const double AGE_RUN_S = 120.0;
+static const double AGE_SAG_V_PER_S = 1.8;
+static const double AGE_SAG_PERIOD_S = 5.0;
+
+static uint32_t ageRng = 4242;
+static double ageRnd()
+{
+    ageRng = ageRng * 1664525UL + 1013904223UL;
+    return (ageRng >> 8) / 16777216.0;
+}
+
+static float sagVolt(double t)
+{
+    return (float)(82.0 - AGE_SAG_V_PER_S * fmod(t, AGE_SAG_PERIOD_S));
+}
+
+static void putFloatBE(uint8_t *b, float v)
+{
+    uint8_t tmp[4];
+    memcpy(tmp, &v, 4);
+    b[0] = tmp[3];
+    b[1] = tmp[2];
+    b[2] = tmp[1];
+    b[3] = tmp[0];
+}
+
+// dV/dt estimates of one method
+struct RateStats
+{
+    uint32_t samples;
+    uint32_t trips; // estimate > 2 V/s: false plug disconnect
+    double maxErr;
+    double totalErr;
+
+    void add(double deltaV, double deltaT)
+    {
+        if (deltaV < 0.0)
+            return; // interval spans the step back up
+        const double rate = deltaV / deltaT;
+        const double err = fabs(rate - AGE_SAG_V_PER_S) / AGE_SAG_V_PER_S;
+        if (rate > 2.0)
+            trips++;
+        if (err > maxErr)
+            maxErr = err;
+        totalErr += err;
+        samples++;
+    }
+};
+
+struct AgeStats
+{
+    uint32_t samples;
+    double maxErrMs;
+    double totalErrMs;
+
+    void add(double reportedMs, double trueMs)
+    {
+        const double err = fabs(reportedMs - trueMs);
+        if (err > maxErrMs)
+            maxErrMs = err;
+        totalErrMs += err;
+        samples++;
+    }
+};
+
+SIM_BENCH(signal_age, "signal age and dV/dt: decode-time millis() vs frame RX time")
+{
+    sim::useVirtualClock(true);
+    sim::setClockUs(0);
+    TELEMETRY::resetSignals();
+    ageRng = 4242;
+
+    RateStats legacyRate = {}, rxRate = {};
+    AgeStats legacyAge = {}, rxAge = {};
+
+    // Former consumers
+    uint32_t legacyDecodeMs = 0;
+    float legacyV = 0.0f;
+    uint32_t legacyT = 0;
+
+    // RX-time consumer (mirrors the plug check)
+    float rxV = 0.0f;
+    uint64_t rxT = 0;
+
+    uint64_t lastDecodedRxUs = 0, lastCheckUs = 0, prevDecodeUs = 0;
+    double nextTickS = 0.0, txS = 0.1;
+    uint64_t frameRxUs = 0, frameDecodeUs = 0;
+    float frameV = 0.0f;
+
+    auto nextFrame = [&]()
+    {
+        frameV = sagVolt(txS);
+        frameRxUs = (uint64_t)((txS + 0.0002 + 0.0008 * ageRnd()) * 1e6);
+        const double d = ageRnd() < 0.1 ? 0.020 + 0.060 * ageRnd() : 0.0001 + 0.0019 * ageRnd();
+        frameDecodeUs = frameRxUs + (uint64_t)(d * 1e6);
+        if (frameDecodeUs < prevDecodeUs)
+            frameDecodeUs = prevDecodeUs; // decoded in order
+        txS += 0.100 + 0.004 * (ageRnd() - 0.5);
+    };
+    nextFrame();
+
+    while (nextTickS < AGE_RUN_S)
+    {
+        const uint64_t tickUs = (uint64_t)(nextTickS * 1e6);
+        if (frameDecodeUs <= tickUs)
+        {
+            sim::setClockUs(frameDecodeUs);
+            CanMessage msg = {};
+            msg.id = ID_TERM_POWER;
+            msg.extended = true;
+            msg.dlc = 8;
+            putFloatBE(&msg.data[0], frameV);
+            putFloatBE(&msg.data[4], 30.0f);
+            msg.timestamp_us = frameRxUs;
+            handleChargerMessage(msg);
+            legacyDecodeMs = millis();
+            lastDecodedRxUs = frameRxUs;
+            prevDecodeUs = frameDecodeUs;
+            nextFrame();
+            continue;
+        }
+
+        sim::setClockUs(tickUs);
+        nextTickS += 0.010 + 0.003 * ageRnd();
+        if (lastDecodedRxUs == 0)
+            continue;
+
+        const double trueMs = (tickUs - lastDecodedRxUs) / 1000.0;
+        legacyAge.add(millis() - legacyDecodeMs, trueMs);
+        rxAge.add(TELEMETRY::ageUs(TSIG_TERMINAL_POWER) / 1000.0, trueMs);
+
+        if (tickUs - lastCheckUs < 500000)
+            continue;
+        lastCheckUs = tickUs;
+        const ChargerTelemetry t = TELEMETRY::charger();
+
+        // Former check: sample timed by the loop() that read it
+        if (legacyT > 0)
+        {
+            const float deltaT = (millis() - legacyT) / 1000.0f;
+            if (deltaT > 0.5f)
+                legacyRate.add(legacyV - t.terminalVolt, deltaT);
+        }
+        legacyV = t.terminalVolt;
+        legacyT = millis();
+
+        // RX-time check
+        if (rxT == 0)
+        {
+            rxV = t.terminalVolt;
+            rxT = t.terminalRxUs;
+        }
+        else if (t.terminalRxUs > rxT)
+        {
+            const float deltaT = (float)(t.terminalRxUs - rxT) / 1000000.0f;
+            if (deltaT > 0.5f)
+            {
+                rxRate.add(rxV - t.terminalVolt, deltaT);
+                rxV = t.terminalVolt;
+                rxT = t.terminalRxUs;
+            }
+        }
+    }
+
+    const SignalTiming timing = TELEMETRY::timing(TSIG_TERMINAL_POWER);
+    TELEMETRY::resetSignals();
+    sim::useVirtualClock(false);
+
+    benchReport("signal_age", "frames", timing.updates, "");
+    benchReport("signal_age", "decode time age err max", legacyAge.maxErrMs, "ms");
+    benchReport("signal_age", "decode time age err mean", legacyAge.totalErrMs / legacyAge.samples, "ms");
+    benchReport("signal_age", "RX time age err max", rxAge.maxErrMs, "ms");
+    benchReport("signal_age", "RX time age err mean", rxAge.totalErrMs / rxAge.samples, "ms");
+    benchReport("signal_age", "decode time dV/dt err max", 100.0 * legacyRate.maxErr, "%");
+    benchReport("signal_age", "decode time dV/dt err mean", 100.0 * legacyRate.totalErr / legacyRate.samples, "%");
+    benchReport("signal_age", "decode time false trips", legacyRate.trips, "");
+    benchReport("signal_age", "RX time dV/dt err max", 100.0 * rxRate.maxErr, "%");
+    benchReport("signal_age", "RX time dV/dt err mean", 100.0 * rxRate.totalErr / rxRate.samples, "%");
+    benchReport("signal_age", "RX time false trips", rxRate.trips, "");
+    benchReport("signal_age", "RX -> decode max", timing.maxDecodeUs / 1000.0, "ms");
+}
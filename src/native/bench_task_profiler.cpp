@@ -0,0 +1,132 @@
+#include "bench.h"
+#include "../../include/core/task_profiler.h"
+#include <Arduino.h>
+#include <atomic>
+#include <string.h>
+#include <time.h>
+
+// TASK_PROFILER against tasks with a known load, in real time:
+//
+//   accuracy - three tasks pinned to core 1 burn 0.5 / 2 / 5 ms of thread
+//              CPU time every 10 ms (5 / 20 / 50 % of a core); the profiler's
+//              long window after TP_RUN_MS must match, and so must core 1's
+//              load (a little under, if the host stretches the 10 ms period)
+//   stack    - one task touches a 1500 B buffer on a 4096 B stack: the high
+//              water mark must show at least that much used
+//   cost     - sample() with the tasks above registered (host: pthread CPU
+//              clocks and a scan of each painted stack)
+
+static const uint32_t TP_RUN_MS = 3000;
+static const uint32_t TP_SAMPLE_MS = 250;
+static const uint32_t TP_COST_SAMPLES = 200;
+
+struct TpLoad
+{
+    const char *name;
+    uint32_t busyUs; // per 10 ms
+};
+
+static const TpLoad tpLoads[] = {{"TP_LOAD5", 500}, {"TP_LOAD20", 2000}, {"TP_LOAD50", 5000}};
+
+static uint64_t tpThreadCpuUs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static std::atomic<bool> tpStop{false};
+static std::atomic<uint32_t> tpRunning{0};
+
+static void tpLoadTask(void *arg)
+{
+    const TpLoad *load = (const TpLoad *)arg;
+    tpRunning++;
+    TickType_t wake = xTaskGetTickCount();
+    while (!tpStop)
+    {
+        // CPU time, not wall time: a preempted spin still burns busyUs
+        const uint64_t until = tpThreadCpuUs() + load->busyUs;
+        while (tpThreadCpuUs() < until)
+        {
+        }
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(10));
+    }
+    tpRunning--;
+    vTaskDelete(nullptr);
+}
+
+static void tpStackTask(void *)
+{
+    tpRunning++;
+    volatile uint8_t buf[1500];
+    memset((void *)buf, 1, sizeof(buf));
+    while (!tpStop)
+        vTaskDelay(pdMS_TO_TICKS(10));
+    tpRunning--;
+    vTaskDelete(nullptr);
+}
+
+static const TaskProfile *tpFind(const ProfilerSnapshot &s, const char *name)
+{
+    for (uint8_t i = 0; i < s.taskCount; i++)
+    {
+        if (strcmp(s.tasks[i].name, name) == 0)
+            return &s.tasks[i];
+    }
+    return nullptr;
+}
+
+SIM_BENCH(task_profiler, "Task profiler: CPU share of known loads, stack high water, cost per sample")
+{
+    tpStop = false;
+    for (const TpLoad &l : tpLoads)
+    {
+        TaskHandle_t h = nullptr;
+        xTaskCreatePinnedToCore(tpLoadTask, l.name, 4096, (void *)&l, 5, &h, 1);
+        TASK_PROFILER::track(h, 4096);
+    }
+    while (tpRunning < 3)
+        delay(1);
+    // Started once the others run: the dynamic loader resolves symbols on the
+    // stack of whichever thread calls first, which would count against it
+    TaskHandle_t stackTask = nullptr;
+    xTaskCreatePinnedToCore(tpStackTask, "TP_STACK", 4096, nullptr, 5, &stackTask, 1);
+    TASK_PROFILER::track(stackTask, 4096);
+    while (tpRunning < 4)
+        delay(1);
+
+    for (uint32_t t = 0; t < TP_RUN_MS; t += TP_SAMPLE_MS)
+    {
+        TASK_PROFILER::sample();
+        delay(TP_SAMPLE_MS);
+    }
+    TASK_PROFILER::sample();
+
+    static ProfilerSnapshot s;
+    TASK_PROFILER::snapshot(s);
+    uint32_t expectedCore1 = 0;
+    for (const TpLoad &l : tpLoads)
+    {
+        const TaskProfile *p = tpFind(s, l.name);
+        char metric[40];
+        snprintf(metric, sizeof(metric), "%s measured", l.name);
+        benchReport("task_profiler", metric, p ? p->cpuLongPermille / 10.0 : -1.0, "%");
+        expectedCore1 += l.busyUs / 10;
+    }
+    benchReport("task_profiler", "core 1 expected", expectedCore1 / 10.0, "%");
+    benchReport("task_profiler", "core 1 measured", s.coreLongPermille[1] / 10.0, "%");
+    benchReport("task_profiler", "long window", s.longWindowMs, "ms");
+    const TaskProfile *st = tpFind(s, "TP_STACK");
+    benchReport("task_profiler", "TP_STACK used (>= 1500)", st ? st->stackBytes - st->stackFreeMin : 0, "B");
+
+    const uint64_t t0 = benchNowNs();
+    for (uint32_t i = 0; i < TP_COST_SAMPLES; i++)
+        TASK_PROFILER::sample();
+    benchReport("task_profiler", "tasks sampled", s.taskCount, "");
+    benchReport("task_profiler", "sample() host", (benchNowNs() - t0) / 1000.0 / TP_COST_SAMPLES, "us");
+
+    tpStop = true;
+    while (tpRunning > 0)
+        delay(1);
+}
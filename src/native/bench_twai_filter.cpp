@@ -0,0 +1,127 @@
+#include "bench.h"
+#include "../../include/drivers/can_twai_driver.h"
+#include "../../include/config/hardware.h"
+#include <sim/virtual_bus.h>
+#include <stdio.h>
+
+// CAN1 receive filtering on a shared charger bus, 60 s of traffic through
+// the TWAI controller model. Per second:
+//
+//   charger    - the ids the decoders use: both response ids at the poll
+//                rates, terminal power 10 Hz, terminal status 2 Hz,
+//                heartbeat 1 Hz
+//   foreign    - three more power modules answering their own controller
+//                (0x0681817x / 0x0681827x), J1939 broadcasts and 11-bit
+//                traffic from other nodes
+//
+//   accept all - the former TWAI_FILTER_CONFIG_ACCEPT_ALL(): every frame
+//                wakes can1_rx_task and takes a ring slot
+//   filtered   - CAN_TWAI::init() with the computed filter, then the
+//                software check (CAN_TWAI::acceptsFrame)
+
+struct TwaiTraffic
+{
+    uint32_t id;
+    bool extended;
+    uint16_t perSecond;
+};
+
+static const TwaiTraffic twaiTraffic[] = {
+    {ID_CTRL_RESP, true, 8},
+    {ID_TELEM_RESP, true, 12},
+    {ID_TERM_POWER, true, 10},
+    {ID_TERM_STATUS, true, 2},
+    {ID_HEARTBEAT, true, 1},
+    // Other power modules on the same bus
+    {0x0681817DUL, true, 8},
+    {0x0681827DUL, true, 12},
+    {0x0681817CUL, true, 8},
+    {0x0681827CUL, true, 12},
+    {0x0681817BUL, true, 8},
+    {0x0681827BUL, true, 12},
+    // J1939 broadcasts
+    {0x18FEF100UL, true, 10},
+    {0x18FF50E4UL, true, 1},
+    {0x0CF00400UL, true, 50},
+    {0x18FECA00UL, true, 1},
+    {0x1806E5F4UL, true, 10},
+    // 11-bit nodes
+    {0x181, false, 100},
+    {0x281, false, 100},
+    {0x701, false, 1},
+};
+
+static const uint32_t TWAI_BENCH_SECONDS = 60;
+
+struct TwaiResult
+{
+    uint32_t offered;
+    uint32_t wakeups;  // frames handed to can1_rx_task by the controller
+    uint32_t pushed;   // frames put in the RX ring
+    uint32_t rejected; // dropped by the software check
+};
+
+static TwaiResult runTraffic(bool filtered)
+{
+    TwaiResult r = {};
+    for (uint32_t s = 0; s < TWAI_BENCH_SECONDS; s++)
+    {
+        for (const TwaiTraffic &t : twaiTraffic)
+        {
+            for (uint16_t n = 0; n < t.perSecond; n++)
+            {
+                sim::BusFrame f = {};
+                f.id = t.id;
+                f.extended = t.extended;
+                f.dlc = 8;
+                f.data[1] = (uint8_t)n;
+                sim::busSend(sim::BUS_CHARGER, f);
+                r.offered++;
+
+                twai_message_t msg;
+                while (twai_receive(&msg, 0) == ESP_OK)
+                {
+                    r.wakeups++;
+                    if (!filtered || CAN_TWAI::acceptsFrame(msg.identifier, msg.extd != 0))
+                        r.pushed++;
+                    else
+                        r.rejected++;
+                }
+            }
+        }
+    }
+    return r;
+}
+
+static void report(const char *run, const TwaiResult &r)
+{
+    char metric[48];
+    snprintf(metric, sizeof(metric), "%s task wakeups", run);
+    benchReport("twai_filter", metric, (double)r.wakeups / TWAI_BENCH_SECONDS, "/s");
+    snprintf(metric, sizeof(metric), "%s ring pushes", run);
+    benchReport("twai_filter", metric, (double)r.pushed / TWAI_BENCH_SECONDS, "/s");
+    snprintf(metric, sizeof(metric), "%s sw rejected", run);
+    benchReport("twai_filter", metric, (double)r.rejected / TWAI_BENCH_SECONDS, "/s");
+    snprintf(metric, sizeof(metric), "%s hw pass", run);
+    benchReport("twai_filter", metric, r.offered ? r.wakeups * 100.0 / r.offered : 0.0, "%");
+}
+
+SIM_BENCH(twai_filter, "CAN1 acceptance: accept-all vs computed TWAI filter + software check")
+{
+    twai_general_config_t g = TWAI_GENERAL_CONFIG_DEFAULT(CAN1_TX_PIN, CAN1_RX_PIN, TWAI_MODE_NORMAL);
+    twai_timing_config_t t = TWAI_TIMING_CONFIG_250KBITS();
+    twai_filter_config_t all = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    twai_driver_install(&g, &t, &all);
+    twai_start();
+    const TwaiResult before = runTraffic(false);
+    twai_stop();
+    twai_driver_uninstall();
+
+    CAN_TWAI::init();
+    const TwaiResult after = runTraffic(true);
+    CAN_TWAI::deinit();
+
+    benchReport("twai_filter", "bus frames", (double)before.offered / TWAI_BENCH_SECONDS, "/s");
+    report("accept all", before);
+    report("filtered", after);
+}
@@ -0,0 +1,167 @@
+#include "bench.h"
+#include "../../include/core/telemetry_frame.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// VehicleInfo uplink for 10 min of an EV waiting in Preparing (SOC and
+// range steady, terminal V with +-50 mV noise, a few mA of current,
+// temperature drifting by 0.1 °C), sampled at 3 s then every 5 s:
+//
+//   json    - the former sendVehicleInfo(): inner JsonDoc(256) serialized
+//             to a String (soc, maxCurrent, model name, range only), embedded
+//             as an escaped string in an outer JsonDoc(768), one message
+//             per sample
+//   frame   - VehicleTelemetry: all six values, first sample alone, then
+//             VEHICLE_INFO_BATCH_SAMPLES per message, base64 in "data"
+//
+// Bytes on wire: the OCPP CALL text [2,"<id>","DataTransfer",{...}] with a
+// 10 character message id. ArduinoJson is not part of the native build, so
+// the JSON text is rebuilt with snprintf (double formatting of the float
+// values, as ArduinoJson prints them) and heap churn is counted from the
+// allocation sizes in the code: the documents, the String, the std::function
+// capture and the serialized message.
+
+static const uint32_t VI_RUN_MS = 10 * 60 * 1000;
+static const size_t VI_CALL_OVERHEAD = strlen("[2,\"0123456789\",\"DataTransfer\",]");
+static const size_t VI_JSON_OBJECT_SLOT = 16; // ArduinoJson 6 VariantSlot on ESP32
+
+static uint32_t viRng = 99;
+static float viRnd()
+{
+    viRng = viRng * 1664525UL + 1013904223UL;
+    return (viRng >> 8) / 16777216.0f;
+}
+
+static VehicleSample viSample(uint32_t tMs)
+{
+    return {tMs, 57.5f, 55.0f, 76.3f + 0.1f * (viRnd() - 0.5f), 0.01f * viRnd(),
+            30.0f + (tMs > VI_RUN_MS / 2 ? 0.1f : 0.0f), 93.2f};
+}
+
+// ArduinoJson prints floats widened to double with 9 significant digits
+static void viNum(char *out, size_t cap, float v)
+{
+    snprintf(out, cap, "%.9g", (double)v);
+}
+
+// Former payload text (inner object escaped into the outer "data" string)
+static size_t viLegacyPayload(const VehicleSample &s, char *out, size_t cap, size_t &innerLen)
+{
+    char soc[32], imax[32], range[32], inner[160];
+    viNum(soc, sizeof(soc), s.soc);
+    viNum(imax, sizeof(imax), s.maxCurrent);
+    viNum(range, sizeof(range), s.rangeKm);
+    innerLen = (size_t)snprintf(inner, sizeof(inner), "{\"soc\":%s,\"maxCurrent\":%s,\"model\":\"Pro\",\"range\":%s}",
+                                soc, imax, range);
+
+    size_t n = (size_t)snprintf(out, cap, "{\"vendorId\":\"RivotMotors\",\"messageId\":\"VehicleInfo\",\"data\":\"");
+    for (const char *p = inner; *p && n + 2 < cap; p++)
+    {
+        if (*p == '"')
+            out[n++] = '\\';
+        out[n++] = *p;
+    }
+    n += (size_t)snprintf(out + n, cap - n, "\"}");
+    return n;
+}
+
+struct ViResult
+{
+    uint32_t messages;
+    uint32_t samples;
+    uint64_t wireBytes;
+    uint64_t heapBytes;
+    uint64_t allocs;
+};
+
+static void viReport(const char *run, const ViResult &r, uint32_t fields)
+{
+    const double minutes = VI_RUN_MS / 60000.0;
+    char metric[48];
+    snprintf(metric, sizeof(metric), "%s messages/min", run);
+    benchReport("vehicle_info", metric, r.messages / minutes, "");
+    snprintf(metric, sizeof(metric), "%s values per sample", run);
+    benchReport("vehicle_info", metric, fields, "");
+    snprintf(metric, sizeof(metric), "%s wire bytes/min", run);
+    benchReport("vehicle_info", metric, r.wireBytes / minutes, "B");
+    snprintf(metric, sizeof(metric), "%s wire bytes/sample", run);
+    benchReport("vehicle_info", metric, (double)r.wireBytes / r.samples, "B");
+    snprintf(metric, sizeof(metric), "%s heap churn/min", run);
+    benchReport("vehicle_info", metric, r.heapBytes / minutes, "B");
+    snprintf(metric, sizeof(metric), "%s allocations/min", run);
+    benchReport("vehicle_info", metric, r.allocs / minutes, "");
+}
+
+SIM_BENCH(vehicle_info, "VehicleInfo uplink: JSON-in-JSON per sample vs batched delta/varint frame")
+{
+    ViResult legacy = {}, frame = {};
+    VehicleInfoBatch batch;
+    uint64_t encodeNs = 0;
+    uint32_t roundTripErrors = 0;
+    double maxRoundTripErr = 0.0;
+
+    auto flush = [&](uint32_t nowMs)
+    {
+        if (batch.empty())
+            return;
+        uint8_t bin[TELEMETRY_FRAME_MAX_BYTES];
+        char b64[TELEMETRY_FRAME_MAX_B64];
+        const uint64_t t0 = benchNowNs();
+        const size_t binLen = batch.encode(nowMs, bin, sizeof(bin));
+        const size_t b64Len = TELEMETRY_FRAME::toBase64(bin, binLen, b64, sizeof(b64));
+        encodeNs += benchNowNs() - t0;
+
+        const size_t payload = strlen("{\"vendorId\":\"RivotMotors\",\"messageId\":\"VehicleTelemetry\",\"data\":\"\"}") + b64Len;
+        frame.messages++;
+        frame.samples += batch.count();
+        frame.wireBytes += VI_CALL_OVERHEAD + payload;
+        // outer document, std::function capture, serialized message
+        frame.heapBytes += 3 * VI_JSON_OBJECT_SLOT + b64Len + 1 + TELEMETRY_FRAME_MAX_B64 + sizeof(size_t) +
+                           VI_CALL_OVERHEAD + payload + 1;
+        frame.allocs += 3;
+
+        // Server side: decode and compare at wire resolution
+        VehicleSample back[VEHICLE_INFO_BATCH_SAMPLES];
+        uint8_t model = 0;
+        const size_t n = TELEMETRY_FRAME::decode(bin, binLen, nowMs, model, back, VEHICLE_INFO_BATCH_SAMPLES);
+        if (n != batch.count() || model != batch.model() || back[n - 1].tMs != batch.last().tMs)
+            roundTripErrors++;
+        else
+            maxRoundTripErr = fmax(maxRoundTripErr, fabs(back[n - 1].voltage - batch.last().voltage));
+        batch.clear();
+    };
+
+    bool first = true;
+    for (uint32_t t = 3000; t < VI_RUN_MS; t += 5000)
+    {
+        const VehicleSample s = viSample(t);
+
+        // Former path: one message per sample
+        char payload[256];
+        size_t innerLen;
+        const size_t len = viLegacyPayload(s, payload, sizeof(payload), innerLen);
+        legacy.messages++;
+        legacy.samples++;
+        legacy.wireBytes += VI_CALL_OVERHEAD + len;
+        // inner doc, String, outer doc, std::function capture (5 values), serialized message
+        legacy.heapBytes += 256 + innerLen + 1 + 768 + 24 + VI_CALL_OVERHEAD + len + 1;
+        legacy.allocs += 5;
+
+        if (!batch.add(2, s))
+        {
+            flush(t);
+            batch.add(2, s);
+        }
+        if (first || batch.full())
+            flush(t);
+        first = false;
+    }
+    flush(VI_RUN_MS);
+
+    viReport("json", legacy, 4);
+    viReport("frame", frame, TELEMETRY_FRAME_FIELDS + 1);
+    benchReport("vehicle_info", "frame encode + base64", (double)encodeNs / frame.messages, "ns/message");
+    benchReport("vehicle_info", "frame round trip errors", roundTripErrors, "");
+    benchReport("vehicle_info", "frame voltage error max", 1000.0 * maxRoundTripErr, "mV");
+}
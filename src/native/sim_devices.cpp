@@ -0,0 +1,324 @@
+#include "sim_devices.h"
+#include "../../include/header.h"
+#include <sim/virtual_bus.h>
+#include <mutex>
+
+// Charger module CAN IDs (requests are what the firmware sends)
+#define SIM_ID_CTRL_REQ 0x068181FEUL
+#define SIM_ID_TELEM_REQ 0x068182FEUL
+
+// BMS pack parameters (Pro model: Imax 55 A → 60 Ah pack)
+#define SIM_BMS_VMAX 84.0f
+#define SIM_BMS_IMAX 55.0f
+#define SIM_PACK_EMPTY_V 66.0f
+#define SIM_PACK_CAPACITY_AH 60.0f
+#define SIM_PACK_R_OHM 0.02f
+#define SIM_TAPER_AH 6.0f // CV phase: current tapers to zero over the last 10 %
+
+namespace
+{
+    std::mutex stateMutex;
+
+    int chargerNode = -1;
+    int bmsNode = -1;
+
+    bool plugged = false;
+    bool bmsSafe = true;
+    bool chargerPowered = true;
+
+    bool outputEnabled = false;
+    float setVoltage = 0.0f;
+    float setCurrent = 0.0f;
+    double packAh = 34.5;
+    double chargeMah = 1234567.0;
+    uint32_t dischargeMah = 1200067;
+
+    uint32_t lastTickMs = 0;
+    uint32_t termPowerSentMs = 0;
+    uint32_t termStatusSentMs = 0;
+    uint32_t heartbeatSentMs = 0;
+    uint32_t bmsRequestSentMs = 0;
+
+    inline void putU32(uint8_t *b, uint32_t v)
+    {
+        b[0] = (uint8_t)(v >> 24);
+        b[1] = (uint8_t)(v >> 16);
+        b[2] = (uint8_t)(v >> 8);
+        b[3] = (uint8_t)v;
+    }
+
+    inline void putFloatBE(uint8_t *b, float f)
+    {
+        uint32_t v;
+        memcpy(&v, &f, sizeof(v));
+        putU32(b, v);
+    }
+
+    inline uint32_t getU32(const uint8_t *b)
+    {
+        return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+    }
+
+    sim::BusFrame makeFrame(uint32_t id)
+    {
+        sim::BusFrame f = {};
+        f.id = id;
+        f.dlc = 8;
+        f.extended = true;
+        return f;
+    }
+
+    // Caller holds stateMutex
+    float packVoltage()
+    {
+        return SIM_PACK_EMPTY_V + (SIM_BMS_VMAX - SIM_PACK_EMPTY_V) * (float)(packAh / SIM_PACK_CAPACITY_AH);
+    }
+
+    float currentNow()
+    {
+        if (!plugged || !chargerPowered || !outputEnabled)
+            return 0.0f;
+        float limit = setCurrent < SIM_BMS_IMAX ? setCurrent : SIM_BMS_IMAX;
+        float headroom = (float)((SIM_PACK_CAPACITY_AH - packAh) / SIM_TAPER_AH);
+        if (headroom < 1.0f)
+            limit *= headroom > 0.0f ? headroom : 0.0f;
+        return limit;
+    }
+
+    float terminalVoltageNow()
+    {
+        return plugged ? packVoltage() + currentNow() * SIM_PACK_R_OHM : 0.0f;
+    }
+
+    // ========== CHARGER MODULE ==========
+    void onChargerBus(const sim::BusFrame &rx, void *)
+    {
+        if (!rx.extended || (rx.id != SIM_ID_CTRL_REQ && rx.id != SIM_ID_TELEM_REQ))
+            return;
+
+        sim::BusFrame tx = makeFrame(rx.id == SIM_ID_CTRL_REQ ? ID_CTRL_RESP : ID_TELEM_RESP);
+        const uint8_t func = rx.data[1];
+        tx.data[0] = 0x01;
+        tx.data[1] = func;
+
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (!chargerPowered)
+                return;
+
+            if (rx.id == SIM_ID_CTRL_REQ)
+            {
+                if (func == 0x32)
+                {
+                    outputEnabled = rx.data[3] == 0x00;
+                    tx.data[3] = outputEnabled ? 0x00 : 0x01;
+                }
+                else if (func == 0x00)
+                {
+                    setVoltage = getU32(&rx.data[4]) / 1024.0f;
+                    putU32(&tx.data[4], (uint32_t)(setVoltage * 1024.0f));
+                }
+                else if (func == 0x03)
+                {
+                    setCurrent = getU32(&rx.data[4]) / 30.5f;
+                    putU32(&tx.data[4], (uint32_t)(setCurrent * 30.5f));
+                }
+            }
+            else
+            {
+                if (func == 0x84)
+                {
+                    putU32(&tx.data[4], (uint32_t)(terminalVoltageNow() * 1024.0f));
+                }
+                else if (func == 0x82)
+                {
+                    uint16_t raw = (uint16_t)(currentNow() * 10.0f);
+                    tx.data[6] = raw >> 8;
+                    tx.data[7] = raw & 0xFF;
+                }
+                else if (func == 0x80)
+                {
+                    uint16_t raw = (uint16_t)((30.0f + currentNow() * 0.2f) * 1000.0f);
+                    tx.data[6] = raw >> 8;
+                    tx.data[7] = raw & 0xFF;
+                }
+                else if (func == 0x79)
+                {
+                    tx.data[6] = 0x01;
+                    tx.data[7] = 0x2C;
+                }
+                else if (func == 0x83)
+                {
+                    putFloatBE(&tx.data[4], 0.97f);
+                }
+            }
+        }
+
+        sim::busSend(sim::BUS_CHARGER, tx, chargerNode);
+    }
+
+    // ========== BMS ==========
+    void onBmsBus(const sim::BusFrame &rx, void *)
+    {
+        if (!rx.extended)
+            return;
+
+        uint32_t respId;
+        uint32_t value;
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (!plugged)
+                return;
+            if (rx.id == ID_CHARGE_AH_REQUEST)
+            {
+                respId = ID_CHARGE_AH_RESPONSE;
+                value = (uint32_t)chargeMah;
+            }
+            else if (rx.id == ID_DISCHARGE_AH_REQUEST)
+            {
+                respId = ID_DISCHARGE_AH_RESPONSE;
+                value = dischargeMah;
+            }
+            else
+            {
+                return;
+            }
+        }
+
+        sim::BusFrame tx = makeFrame(respId);
+        putU32(tx.data, value);
+        sim::busSend(sim::BUS_BMS, tx, bmsNode);
+    }
+}
+
+namespace SimDevices
+{
+    void attach()
+    {
+        chargerNode = sim::busAttach(sim::BUS_CHARGER, onChargerBus, nullptr);
+        bmsNode = sim::busAttach(sim::BUS_BMS, onBmsBus, nullptr);
+    }
+
+    void tick(uint32_t now_ms)
+    {
+        sim::BusFrame out[4];
+        sim::BusId outBus[4];
+        int count = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+
+            // Charge the pack with whatever current is flowing
+            if (lastTickMs != 0 && now_ms > lastTickMs)
+            {
+                double ah = currentNow() * (now_ms - lastTickMs) / 3600000.0;
+                packAh += ah;
+                chargeMah += ah * 1000.0;
+                if (packAh > SIM_PACK_CAPACITY_AH)
+                    packAh = SIM_PACK_CAPACITY_AH;
+            }
+            lastTickMs = now_ms;
+
+            if (chargerPowered && now_ms - termPowerSentMs >= 100)
+            {
+                sim::BusFrame f = makeFrame(ID_TERM_POWER);
+                putFloatBE(&f.data[0], terminalVoltageNow());
+                putFloatBE(&f.data[4], currentNow());
+                out[count] = f;
+                outBus[count++] = sim::BUS_CHARGER;
+                termPowerSentMs = now_ms;
+            }
+
+            if (chargerPowered && now_ms - termStatusSentMs >= 500)
+            {
+                sim::BusFrame f = makeFrame(ID_TERM_STATUS);
+                f.data[6] = 0x03;
+                f.data[7] = currentNow() > 0.5f ? 0x02 : 0x01;
+                out[count] = f;
+                outBus[count++] = sim::BUS_CHARGER;
+                termStatusSentMs = now_ms;
+            }
+
+            if (chargerPowered && now_ms - heartbeatSentMs >= 1000)
+            {
+                sim::BusFrame f = makeFrame(ID_HEARTBEAT);
+                f.data[4] = 0x08; // alive
+                out[count] = f;
+                outBus[count++] = sim::BUS_CHARGER;
+                heartbeatSentMs = now_ms;
+            }
+
+            if (plugged && now_ms - bmsRequestSentMs >= 100)
+            {
+                sim::BusFrame f = makeFrame(ID_BMS_REQUEST);
+                uint16_t vmax = (uint16_t)(SIM_BMS_VMAX * 10.0f);
+                uint16_t imax = (uint16_t)(SIM_BMS_IMAX * 10.0f);
+                f.data[0] = vmax >> 8;
+                f.data[1] = vmax & 0xFF;
+                f.data[2] = imax >> 8;
+                f.data[3] = imax & 0xFF;
+                f.data[4] = bmsSafe ? 0x00 : 0x01;
+                f.data[5] = 0x00;
+                out[count] = f;
+                outBus[count++] = sim::BUS_BMS;
+                bmsRequestSentMs = now_ms;
+            }
+        }
+
+        for (int i = 0; i < count; i++)
+            sim::busSend(outBus[i], out[i], outBus[i] == sim::BUS_CHARGER ? chargerNode : bmsNode);
+    }
+
+    static void deviceTask(void *)
+    {
+        while (true)
+        {
+            tick(millis());
+            vTaskDelay(pdMS_TO_TICKS(5));
+        }
+    }
+
+    void startTask()
+    {
+        xTaskCreatePinnedToCore(deviceTask, "SIM_DEVICES", 4096, nullptr, 5, nullptr, 0);
+    }
+
+    void setPlugged(bool value)
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        plugged = value;
+    }
+
+    void setBmsSafeToCharge(bool safe)
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        bmsSafe = safe;
+    }
+
+    void setChargerPowered(bool powered)
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        chargerPowered = powered;
+        if (!powered)
+            outputEnabled = false;
+    }
+
+    bool isOutputEnabled()
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        return outputEnabled;
+    }
+
+    float outputVoltage()
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        return terminalVoltageNow();
+    }
+
+    float outputCurrent()
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        return currentNow();
+    }
+
+} // namespace SimDevices
@@ -0,0 +1,38 @@
+#pragma once
+
+/**
+ * @file sim_devices.h
+ * @brief Simulated charger module (CAN1) and vehicle BMS (CAN2) for the native build
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * The charger answers the 0x068181FE / 0x068182FE group requests and
+ * broadcasts terminal power (0x00433F01), terminal status (0x00473F01) and
+ * its heartbeat (0x18FF50E5). The BMS broadcasts its limits (0x1806E5F4)
+ * and answers the charging / discharging Ah requests. Output current follows
+ * the commanded limit while the charger is enabled and the gun is plugged.
+ */
+
+#include <stdint.h>
+
+namespace SimDevices
+{
+    /// Attach both devices to the virtual buses
+    void attach();
+
+    /// Broadcast whatever is due at time `now_ms` (call every few ms)
+    void tick(uint32_t now_ms);
+
+    /// Start a task that calls tick() every 5 ms
+    void startTask();
+
+    /// Vehicle side controls
+    void setPlugged(bool plugged);
+    void setBmsSafeToCharge(bool safe);
+    void setChargerPowered(bool powered);
+
+    bool isOutputEnabled();
+    float outputVoltage();
+    float outputCurrent();
+
+} // namespace SimDevices
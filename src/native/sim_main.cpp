@@ -0,0 +1,287 @@
+/**
+ * @file sim_main.cpp
+ * @brief Entry point of the host-native build (pio run -e native)
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * Usage:
+ *   program sim [seconds]        Run the CAN tasks against the simulated
+ *                                charger and BMS with a scripted session
+ *                                (plug in, RemoteStart, charge, unplug).
+ *                                The serial console menu reads stdin.
+ *   program bench [name|all]     Run micro-benchmarks (list without a name)
+ *   program replay <file> [--idle] [--quiet]
+ *                                Replay a .cantrace capture through the
+ *                                decoders and charging logic on the virtual
+ *                                clock (see sim_replay.h)
+ *   program tracegen <file> [minutes]
+ *                                Write a synthetic charging-session trace
+ */
+
+#include "../../include/header.h"
+#include "../../include/config/hardware.h"
+#include "../../include/drivers/can_twai_driver.h"
+#include "../../include/drivers/can_mcp2515_driver.h"
+#include "../../include/drivers/can_dispatcher.h"
+#include "../../include/drivers/can_tx_queue.h"
+#include "../../include/drivers/can_trace.h"
+#include "../../include/modules/charging_core.h"
+#include "../../include/core/telemetry.h"
+#include "../../include/core/energy_meter.h"
+#include "../../include/core/signal_history.h"
+#include "../../include/core/datatransfer_payload.h"
+#include "../../include/core/task_profiler.h"
+#include "../../include/core/perf_trace.h"
+#include "../../include/core/deferred_log.h"
+#include "../../include/drivers/charger_poll.h"
+#include "../../include/drivers/can_bus_stats.h"
+#include "../../include/ocpp/ocpp_client.h"
+#include "bench.h"
+#include "sim_devices.h"
+#include "sim_replay.h"
+#include <MicroOcpp.h>
+#include <sim/sim_mcp2515.h>
+#include <sim/sim_serial.h>
+#include <sim/sim_twai.h>
+#include <sim/virtual_bus.h>
+#include <unistd.h>
+#include <vector>
+
+// ========== BENCH REGISTRY ==========
+static std::vector<BenchCase> &benchRegistry()
+{
+    static std::vector<BenchCase> registry;
+    return registry;
+}
+
+BenchRegistrar::BenchRegistrar(const char *name, const char *description, void (*run)())
+{
+    benchRegistry().push_back({name, description, run});
+}
+
+const BenchCase *benchList(size_t *count)
+{
+    *count = benchRegistry().size();
+    return benchRegistry().data();
+}
+
+void benchReport(const char *bench, const char *metric, double value, const char *unit)
+{
+    printf("%-14s %-28s %14.2f %s\n", bench, metric, value, unit);
+    fflush(stdout);
+}
+
+static int runBench(const char *name)
+{
+    size_t count;
+    const BenchCase *cases = benchList(&count);
+
+    if (!name)
+    {
+        printf("Available benchmarks:\n");
+        for (size_t i = 0; i < count; i++)
+            printf("  %-14s %s\n", cases[i].name, cases[i].description);
+        return 0;
+    }
+
+    bool all = strcmp(name, "all") == 0;
+    bool found = false;
+    initGlobals();
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!all && strcmp(name, cases[i].name) != 0)
+            continue;
+        found = true;
+        sim::setSerialMuted(true);
+        cases[i].run();
+        sim::setSerialMuted(false);
+    }
+
+    if (!found)
+    {
+        fprintf(stderr, "Unknown benchmark '%s'\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+// ========== FIRMWARE BRING-UP (mirrors setup() in main.cpp) ==========
+static void startTask(TaskFunction_t fn, const char *name, uint32_t stackBytes, UBaseType_t priority)
+{
+    TaskHandle_t handle = nullptr;
+    if (xTaskCreatePinnedToCore(fn, name, stackBytes, nullptr, priority, &handle, 1) == pdPASS)
+        TASK_PROFILER::track(handle, stackBytes);
+}
+
+static void startFirmwareTasks()
+{
+    initGlobals();
+
+    sim::mcp2515SetIntPin(CAN2_INT_PIN);
+    if (!CAN_TWAI::init())
+        Serial.println("[System] ❌ CAN1 (Charger) init failed!");
+    if (!CAN_MCP2515::init())
+        Serial.println("[System] ❌ CAN2 (BMS) init failed!");
+
+    startTask(can1_rx_task, "CAN1_RX", TASK_STACK_SIZE_CAN_RX, 8);
+    startTask(can2_rx_task, "CAN2_RX", TASK_STACK_SIZE_CAN_RX, 8);
+    startTask(can1_tx_task, "CAN1_TX", TASK_STACK_SIZE_CAN_TX, 8);
+    startTask(can1_alert_task, "CAN1_ALERT", TASK_STACK_SIZE_CAN_ALERT, 9);
+    startTask(canDispatchTask, "CAN_DISPATCH", TASK_STACK_SIZE_CAN_DISPATCH, 7);
+    startTask(chargerCommTask, "CHARGER_COMM", TASK_STACK_SIZE_CHARGER_COMM, 7);
+
+    startTask(
+        [](void *arg)
+        {
+            while (true)
+            {
+                processSerialInput();
+                CAN_TRACE::pollStream();
+                vTaskDelay(pdMS_TO_TICKS(100));
+            }
+        },
+        "UI_TASK", TASK_STACK_SIZE_UI, 2);
+
+    DEFERRED_LOG::init();
+    TASK_PROFILER::init();
+}
+
+// Stand-in for the ocpp_manager start/stop callbacks
+static void setSession(bool active)
+{
+    if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(100)) == pdTRUE)
+    {
+        transactionActive = active;
+        activeTransactionId = active ? 1 : -1;
+        remoteStartAccepted = active;
+        chargingEnabled = active;
+        xSemaphoreGive(dataMutex);
+    }
+    sim::setOcppTransaction(active, active);
+}
+
+static int runSim(uint32_t seconds)
+{
+    Serial.printf("[SIM] Native simulation for %us (console menu on stdin)\n", seconds);
+
+    SimDevices::attach();
+    startFirmwareTasks();
+    SimDevices::startTask();
+    sim::startSerialStdinReader();
+
+    ChargingCore::reset();
+    ocppInitialized = true;
+
+    const uint32_t plugAt = 1000;
+    const uint32_t startAt = 3000;
+    const uint32_t unplugAt = seconds * 1000 > 6000 ? seconds * 1000 - 3000 : seconds * 1000;
+    const uint32_t busOffAt = startAt + 3000; // CAN1 bus-off mid-session, recovered in place
+    const uint32_t bmsBusOffAt = startAt + 4000; // same on CAN2
+    bool plugged = false, started = false, unplugged = false, busOff = false, bmsBusOff = false;
+
+    const uint32_t t0 = millis();
+    while (millis() - t0 < seconds * 1000)
+    {
+        uint32_t t = millis() - t0;
+
+        if (!plugged && t >= plugAt)
+        {
+            Serial.println("[SIM] 🔌 Vehicle plugged in");
+            SimDevices::setPlugged(true);
+            plugged = true;
+        }
+        if (!started && t >= startAt)
+        {
+            Serial.println("[SIM] ▶️  RemoteStartTransaction accepted");
+            setSession(true);
+            started = true;
+        }
+        if (!busOff && t >= busOffAt && busOffAt < unplugAt)
+        {
+            Serial.println("[SIM] ⚡ CAN1 bus-off injected");
+            sim::twaiInjectBusOff();
+            busOff = true;
+        }
+        if (!bmsBusOff && t >= bmsBusOffAt && bmsBusOffAt < unplugAt)
+        {
+            Serial.println("[SIM] ⚡ CAN2 bus-off injected");
+            sim::mcp2515InjectBusOff();
+            bmsBusOff = true;
+        }
+        if (!unplugged && t >= unplugAt)
+        {
+            Serial.println("[SIM] 🔌 Vehicle unplugged");
+            SimDevices::setPlugged(false);
+            unplugged = true;
+        }
+
+        // Firmware ended the transaction (disconnect / safety stop)
+        if (transactionActive && !isTransactionRunning(1))
+        {
+            Serial.printf("[SIM] ⏹️  Transaction ended: %s\n", sim::ocppLastStopReason());
+            setSession(false);
+        }
+
+        ChargingCore::poll();
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    DEFERRED_LOG::flush();
+    CanTwaiStatus s1 = CAN_TWAI::getStatus();
+    CanMcp2515Status s2 = CAN_MCP2515::getStatus();
+    Serial.println("\n========== SIM SUMMARY ==========");
+    const EnergyMeterStats em = ENERGY_METER::stats();
+    Serial.printf("Energy delivered : %.3f Wh (%u frames, %u gaps)\n", em.energyWh, em.samples, em.gaps);
+    Serial.printf("Terminal         : %.2f V / %.2f A\n", terminalVolt, terminalCurr);
+    Serial.printf("SOC / model      : %.1f %% / %u\n", socPercent, vehicleModel);
+    Serial.printf("Bus frames       : charger=%u bms=%u\n",
+                  sim::busFrameCount(sim::BUS_CHARGER), sim::busFrameCount(sim::BUS_BMS));
+    Serial.printf("CAN1 rx/tx/err/ovf/rej: %u/%u/%u/%u/%u\n", s1.total_rx_messages, s1.total_tx_messages, s1.error_count,
+                  s1.rx_overflows, s1.rx_rejected);
+    Serial.printf("CAN2 rx/tx/err/ovf: %u/%u/%u/%u (chip overruns %u)\n", s2.total_rx_messages, s2.total_tx_messages,
+                  s2.error_count, s2.rx_overflows, sim::mcp2515RxOverflowCount());
+    CAN_DISPATCH::printLatencyHistogram();
+    TELEMETRY::printSignalAges();
+    SIGNAL_HISTORY::print();
+    CHARGER_POLL::printStats();
+    CAN_STATS::print();
+    CAN_TWAI::printRecoveryStats();
+    CAN_MCP2515::printRecoveryStats();
+    TASK_PROFILER::sample();
+    TASK_PROFILER::print();
+    PERF_TRACE::printSummary();
+    DEFERRED_LOG::printStats();
+    ocpp::sendBusStats("SimEnd");
+    ocpp::sendDiagnostics("SimEnd");
+    ocpp::sendSessionSummary(socPercent, em.energyWh, seconds / 60.0f);
+    DATATRANSFER::printStats();
+    Serial.flush();
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+
+    const char *mode = argc > 1 ? argv[1] : "sim";
+
+    if (strcmp(mode, "bench") == 0)
+        return runBench(argc > 2 ? argv[2] : nullptr);
+
+    if (strcmp(mode, "replay") == 0)
+        return runReplay(argc, argv);
+
+    if (strcmp(mode, "tracegen") == 0)
+        return runTraceGen(argc, argv);
+
+    if (strcmp(mode, "sim") == 0)
+    {
+        uint32_t seconds = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 20;
+        int rc = runSim(seconds ? seconds : 20);
+        fflush(stdout);
+        _exit(rc); // firmware tasks never return
+    }
+
+    fprintf(stderr, "usage: %s sim [seconds] | bench [name|all] | replay <file> | tracegen <file> [minutes]\n", argv[0]);
+    return 2;
+}
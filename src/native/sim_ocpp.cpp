@@ -0,0 +1,94 @@
+#include "../../include/ocpp/ocpp_client.h"
+#include "../../include/drivers/can_bus_stats.h"
+#include "../../include/core/datatransfer_payload.h"
+#include "../../include/config/timing.h"
+#include <Arduino.h>
+
+// Native stand-ins for the CSMS side of ocpp_client.h. There is no WebSocket
+// backend on the host, so DataTransfer payloads are logged instead of sent.
+
+namespace ocpp
+{
+    void init()
+    {
+    }
+
+    void poll()
+    {
+        mocpp_loop();
+    }
+
+    bool isConnected()
+    {
+        return false;
+    }
+
+    // No OCPP task on the host: events are handled inline by the caller
+
+    void waitForWork()
+    {
+        vTaskDelay(pdMS_TO_TICKS(OCPP_TICK_ACTIVE_MS));
+    }
+
+    void notifyPlugChanged(bool plugged)
+    {
+    }
+
+    void notifyChargerHealth(bool healthy)
+    {
+    }
+
+    void notifyBMSAlert(const char *alertType, const char *message)
+    {
+        sendBMSAlert(alertType, message);
+    }
+
+    void notifyVehicleInfo(const VehicleInfoBatch &batch)
+    {
+        if (!batch.empty())
+            sendVehicleInfo(batch);
+    }
+
+    void sendVehicleInfo(const VehicleInfoBatch &batch)
+    {
+        const char *data = DATATRANSFER::data(DT_VEHICLE_TELEMETRY, DATATRANSFER::stageVehicleTelemetry(batch, millis()));
+        if (!data)
+            return;
+        const VehicleSample &s = batch.last();
+        Serial.printf("[SIM-OCPP] VehicleTelemetry n=%u soc=%.1f imax=%.1f V=%.1f I=%.1f T=%.1f model=%u range=%.1f data=%s\n",
+                      (unsigned)batch.count(), s.soc, s.maxCurrent, s.voltage, s.current, s.temperature,
+                      batch.model(), s.rangeKm, data);
+    }
+
+    void sendSessionSummary(float finalSoc, float energyDelivered, float duration)
+    {
+        const DataTransferTicket ticket = DATATRANSFER::stageSessionSummary(finalSoc, energyDelivered, duration);
+        Serial.printf("[SIM-OCPP] SessionSummary %s\n", ticket ? DATATRANSFER::data(DT_SESSION_SUMMARY, ticket) : "(too large)");
+    }
+
+    void sendBMSAlert(const char *alertType, const char *message)
+    {
+        DATATRANSFER::data(DT_BMS_ALERT, DATATRANSFER::stageBmsAlert(alertType, message, millis()));
+        Serial.printf("[SIM-OCPP] BMSAlert %s: %s\n", alertType, message);
+    }
+
+    void sendBusStats(const char *reason)
+    {
+        DATATRANSFER::data(DT_BUS_STATS, DATATRANSFER::stageBusStats(reason, millis() / 1000));
+        CanBusStats s;
+        for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++)
+        {
+            CAN_STATS::snapshot((CanBus)bus, s);
+            Serial.printf("[SIM-OCPP] CanBusStats %s bus=%u load=%.2f%% peak=%.2f%% rx=%u tx=%u drops=%u missed=%u ids=%u\n",
+                          reason, bus + 1, s.loadPercent, s.peakLoadPercent, s.rxFrames, s.txFrames,
+                          s.ringDrops, s.controllerMissed, s.idCount);
+        }
+    }
+
+    void sendDiagnostics(const char *reason)
+    {
+        const char *data = DATATRANSFER::data(DT_DIAGNOSTICS, DATATRANSFER::stageDiagnostics(reason, millis() / 1000));
+        Serial.printf("[SIM-OCPP] Diagnostics %s\n", data ? data : "(no profiler sample)");
+    }
+
+} // namespace ocpp
@@ -0,0 +1,313 @@
+#include "sim_replay.h"
+#include "sim_devices.h"
+#include "../../include/header.h"
+#include "../../include/drivers/can_dispatcher.h"
+#include "../../include/drivers/can_trace.h"
+#include "../../include/drivers/can_bus_stats.h"
+#include "../../include/modules/charging_core.h"
+#include "../../include/core/energy_meter.h"
+#include "../../include/core/deferred_log.h"
+#include <MicroOcpp.h>
+#include <esp_timer.h>
+#include <sim/sim_clock.h>
+#include <sim/sim_serial.h>
+#include <sim/virtual_bus.h>
+#include <chrono>
+#include <vector>
+
+// loop() period on target
+#define REPLAY_POLL_MS 10
+// Keep polling after the last frame so timeouts (BMS 3 s, health 2 s) fire
+#define REPLAY_TAIL_MS 5000
+#define REPLAY_MAX_EVENTS 64
+
+struct ReplayEvent
+{
+    uint32_t t_ms;
+    char text[64];
+};
+
+static std::vector<ReplayEvent> replayEvents;
+
+static void addEvent(uint32_t t_ms, const char *text)
+{
+    if (replayEvents.size() >= REPLAY_MAX_EVENTS)
+        return;
+    ReplayEvent e;
+    e.t_ms = t_ms;
+    snprintf(e.text, sizeof(e.text), "%s", text);
+    replayEvents.push_back(e);
+}
+
+static bool loadTrace(const char *path, std::vector<CanTraceRecord> &records, CanTraceFileHeader &hdr)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "replay: cannot open %s\n", path);
+        return false;
+    }
+
+    bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1 &&
+              hdr.magic == CAN_TRACE_FILE_MAGIC &&
+              hdr.version == CAN_TRACE_VERSION &&
+              hdr.record_size == sizeof(CanTraceRecord);
+    if (ok)
+    {
+        records.resize(hdr.record_count);
+        ok = fread(records.data(), sizeof(CanTraceRecord), hdr.record_count, f) == hdr.record_count;
+    }
+    fclose(f);
+
+    if (!ok)
+        fprintf(stderr, "replay: %s is not a v%d .cantrace file\n", path, CAN_TRACE_VERSION);
+    return ok;
+}
+
+// Stand-in for the OCPP start/stop callbacks that own the transaction gate
+static void setSession(bool active)
+{
+    transactionActive = active;
+    activeTransactionId = active ? 1 : -1;
+    chargingEnabled = active;
+    sim::setOcppTransaction(active, active);
+}
+
+int runReplay(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s replay <file.cantrace> [--idle] [--quiet]\n", argv[0]);
+        return 2;
+    }
+
+    bool session = true;
+    bool quiet = false;
+    for (int i = 3; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--idle") == 0)
+            session = false;
+        else if (strcmp(argv[i], "--quiet") == 0)
+            quiet = true;
+    }
+
+    std::vector<CanTraceRecord> records;
+    CanTraceFileHeader hdr;
+    if (!loadTrace(argv[2], records, hdr))
+        return 1;
+    if (records.empty())
+    {
+        printf("replay: empty trace\n");
+        return 0;
+    }
+
+    // Unwrap the 28-bit millisecond timestamps
+    std::vector<uint64_t> times(records.size());
+    uint64_t t = records[0].time_dlc & 0x0FFFFFFFUL;
+    uint32_t prevRaw = (uint32_t)t;
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        uint32_t raw = records[i].time_dlc & 0x0FFFFFFFUL;
+        t += (raw - prevRaw) & 0x0FFFFFFFUL;
+        prevRaw = raw;
+        times[i] = t;
+    }
+
+    sim::useVirtualClock(true);
+    sim::setClockUs(times[0] * 1000ULL);
+    sim::setSerialMuted(quiet);
+    initGlobals();
+    ChargingCore::reset();
+    ocppInitialized = true;
+    if (session)
+        setSession(true);
+
+    const uint64_t wall0 = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::steady_clock::now().time_since_epoch())
+                               .count();
+
+    const uint64_t start = times[0];
+    const uint64_t end = times.back() + REPLAY_TAIL_MS;
+    uint64_t nextPoll = start;
+    size_t next = 0;
+    bool plugState = false;
+    uint32_t disconnects = 0;
+
+    while (nextPoll <= end)
+    {
+        // Frames that arrived before this loop() tick
+        while (next < records.size() && times[next] <= nextPoll)
+        {
+            CanMessage msg;
+            CanBus bus = CAN_TRACE::unpack(records[next], msg);
+            msg.timestamp_us = times[next] * 1000ULL;
+            sim::setClockUs(msg.timestamp_us);
+            CAN_DISPATCH::dispatchFrame(bus, msg);
+            next++;
+        }
+
+        sim::setClockUs(nextPoll * 1000ULL);
+        ChargingCore::poll();
+        DEFERRED_LOG::flush(); // no LOG task here: keep decoder lines next to their frames
+
+        const uint32_t rel = (uint32_t)(nextPoll - start);
+        bool plugged = gunPhysicallyConnected && batteryConnected;
+        if (plugged != plugState)
+        {
+            addEvent(rel, plugged ? "plug connected" : "plug disconnected");
+            if (!plugged)
+                disconnects++;
+            plugState = plugged;
+        }
+
+        if (transactionActive && !isTransactionRunning(1))
+        {
+            char text[64];
+            snprintf(text, sizeof(text), "transaction ended (%s)", sim::ocppLastStopReason());
+            addEvent(rel, text);
+            setSession(false);
+        }
+
+        nextPoll += REPLAY_POLL_MS;
+    }
+
+    const uint64_t wall1 = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::steady_clock::now().time_since_epoch())
+                               .count();
+    sim::setSerialMuted(false);
+
+    const double traceS = (end - start) / 1000.0;
+    const double wallS = (wall1 - wall0) / 1e6;
+
+    printf("\n========== REPLAY SUMMARY ==========\n");
+    printf("Trace            : %s (%u records, %u dropped at capture)\n", argv[2], hdr.record_count, hdr.dropped);
+    printf("Trace duration   : %.1f s\n", traceS);
+    printf("Replay wall time : %.3f s (%.0fx real time)\n", wallS, wallS > 0 ? traceS / wallS : 0.0);
+    const EnergyMeterStats em = ENERGY_METER::stats();
+    printf("Energy           : %.3f Wh (metered %.1f s, %u frames, %u gaps / %.1f s skipped)\n",
+           em.energyWh, em.meteredSeconds, em.samples, em.gaps, em.gapSeconds);
+    printf("Final terminal   : %.2f V / %.2f A, SOC %.1f %%\n", terminalVolt, terminalCurr, socPercent);
+    printf("Plug disconnects : %u, endTransaction calls: %u\n", disconnects, sim::ocppEndTransactionCount());
+    printf("Events:\n");
+    for (const ReplayEvent &e : replayEvents)
+        printf("  %9.3f s  %s\n", e.t_ms / 1000.0, e.text);
+    printf("====================================\n");
+    CAN_STATS::print();
+    return 0;
+}
+
+// ========== SYNTHETIC TRACE GENERATION ==========
+static std::vector<CanTraceRecord> genRecords;
+
+// Only record what the firmware would receive, not its own requests
+static void recordCharger(const sim::BusFrame &frame, void *)
+{
+    if (frame.id == 0x068181FEUL || frame.id == 0x068182FEUL)
+        return;
+    CanMessage msg = {};
+    msg.id = frame.id;
+    msg.dlc = frame.dlc;
+    msg.extended = frame.extended;
+    memcpy(msg.data, frame.data, 8);
+    msg.timestamp_us = (uint64_t)esp_timer_get_time();
+    genRecords.push_back(CAN_TRACE::pack(CAN_BUS_CHARGER, msg));
+}
+
+static void recordBms(const sim::BusFrame &frame, void *)
+{
+    if (frame.id == ID_HEARTBEAT || frame.id == ID_CHARGE_AH_REQUEST || frame.id == ID_DISCHARGE_AH_REQUEST)
+        return;
+    CanMessage msg = {};
+    msg.id = frame.id;
+    msg.dlc = frame.dlc;
+    msg.extended = frame.extended;
+    memcpy(msg.data, frame.data, 8);
+    msg.timestamp_us = (uint64_t)esp_timer_get_time();
+    genRecords.push_back(CAN_TRACE::pack(CAN_BUS_BMS, msg));
+}
+
+static void sendRequest(sim::BusId bus, uint32_t id, uint8_t func, uint8_t b3, uint32_t value, int node)
+{
+    sim::BusFrame f = {};
+    f.id = id;
+    f.dlc = 8;
+    f.extended = true;
+    f.data[0] = 0x01;
+    f.data[1] = func;
+    f.data[3] = b3;
+    f.data[4] = (uint8_t)(value >> 24);
+    f.data[5] = (uint8_t)(value >> 16);
+    f.data[6] = (uint8_t)(value >> 8);
+    f.data[7] = (uint8_t)value;
+    sim::busSend(bus, f, node);
+}
+
+int runTraceGen(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s tracegen <file.cantrace> [minutes]\n", argv[0]);
+        return 2;
+    }
+    const uint32_t minutes = argc > 3 ? (uint32_t)strtoul(argv[3], nullptr, 10) : 120;
+    const uint32_t durationMs = (minutes ? minutes : 120) * 60000UL;
+
+    sim::useVirtualClock(true);
+    sim::setClockUs(0);
+    sim::setSerialMuted(true);
+
+    SimDevices::attach();
+    int chargerRec = sim::busAttach(sim::BUS_CHARGER, recordCharger, nullptr);
+    int bmsRec = sim::busAttach(sim::BUS_BMS, recordBms, nullptr);
+
+    // Fixed request cadence (the former group schedule: ctrl codes every
+    // 300 ms, telemetry codes every 200 ms, Ah requests every 2 s), kept so
+    // generated traces stay comparable between firmware versions
+    static const uint8_t CTRL_FUNCS[] = {0x32, 0x00, 0x03};
+    static const uint8_t TELEM_FUNCS[] = {0x84, 0x82, 0x79, 0x80, 0x83};
+    const uint32_t vRaw = (uint32_t)(84.0f * 1024.0f);
+    const uint32_t iRaw = (uint32_t)(55.0f * 30.5f);
+    const uint32_t plugAt = 2000, startAt = 5000, unplugAt = durationMs - 10000;
+    uint8_t ctrlIdx = 0, telemIdx = 0;
+
+    for (uint32_t t = 0; t < durationMs; t += 10)
+    {
+        sim::setClockUs((uint64_t)t * 1000ULL);
+        if (t == plugAt)
+            SimDevices::setPlugged(true);
+        if (t == unplugAt)
+            SimDevices::setPlugged(false);
+
+        SimDevices::tick(t);
+
+        const bool charging = t >= startAt && t < unplugAt;
+        if (t % 300 == 0)
+        {
+            uint8_t func = CTRL_FUNCS[ctrlIdx++ % 3];
+            uint32_t value = func == 0x00 ? vRaw : (func == 0x03 ? iRaw : 0);
+            sendRequest(sim::BUS_CHARGER, 0x068181FEUL, func, charging ? 0x00 : 0x01, value, chargerRec);
+        }
+        if (t % 200 == 0)
+            sendRequest(sim::BUS_CHARGER, 0x068182FEUL, TELEM_FUNCS[telemIdx++ % 5], 0, 0, chargerRec);
+        if (t % 2000 == 0)
+            sendRequest(sim::BUS_BMS, ID_CHARGE_AH_REQUEST, 0, 0, 0, bmsRec);
+        if (t % 2000 == 1000)
+            sendRequest(sim::BUS_BMS, ID_DISCHARGE_AH_REQUEST, 0, 0, 0, bmsRec);
+    }
+    sim::setSerialMuted(false);
+
+    FILE *f = fopen(argv[2], "wb");
+    if (!f)
+    {
+        fprintf(stderr, "tracegen: cannot write %s\n", argv[2]);
+        return 1;
+    }
+    CanTraceFileHeader hdr = {CAN_TRACE_FILE_MAGIC, CAN_TRACE_VERSION, sizeof(CanTraceRecord),
+                              (uint32_t)genRecords.size(), 0};
+    fwrite(&hdr, sizeof(hdr), 1, f);
+    fwrite(genRecords.data(), sizeof(CanTraceRecord), genRecords.size(), f);
+    fclose(f);
+
+    printf("tracegen: %u records, %u min session -> %s\n", (uint32_t)genRecords.size(), minutes, argv[2]);
+    return 0;
+}
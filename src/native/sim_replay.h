@@ -0,0 +1,20 @@
+#pragma once
+
+/**
+ * @file sim_replay.h
+ * @brief CAN trace replay and synthetic trace generation (native build)
+ * @author Rivot Motors
+ * @date 2026
+ *
+ * Replay runs on the virtual clock: each record sets the time to its RX
+ * timestamp and goes through CAN_DISPATCH::dispatchFrame(), and the
+ * charging logic is polled every 10 ms of trace time in between, exactly as
+ * loop() would on target. Nothing sleeps, so hours of traffic replay in
+ * seconds.
+ */
+
+/// program replay <file.cantrace> [--idle] [--quiet]
+int runReplay(int argc, char **argv);
+
+/// program tracegen <file.cantrace> [minutes]
+int runTraceGen(int argc, char **argv);